@@ -0,0 +1,76 @@
+/******************************************************************************
+ *  File Name:
+ *    audio_sim.cpp
+ *
+ *  Description:
+ *    Simulated audio input: a bass line pulsing at 120 BPM over a steady
+ *    high tone, sampled at the ADC rate on the virtual clock
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "audio.hpp"
+#include "pico/time.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Audio
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr double BEAT_PERIOD_S = 0.5;       // 120 BPM
+  static constexpr double BEAT_DECAY_S  = 0.12;      // Time constant of each bass hit
+  static constexpr double BASS_HZ       = 80.0;
+  static constexpr double TONE_HZ       = 2'500.0;
+  static constexpr double FULL_SCALE    = 32767.0;
+
+  /*---------------------------------------------------------------------------
+  Static Data
+  ---------------------------------------------------------------------------*/
+
+  static bool s_running;
+
+  /*---------------------------------------------------------------------------
+  Public Functions
+  ---------------------------------------------------------------------------*/
+
+  void start()
+  {
+    s_running = true;
+  }
+
+
+  void stop()
+  {
+    s_running = false;
+  }
+
+
+  bool readLatest( int16_t *const dst )
+  {
+    if( !s_running )
+    {
+      return false;
+    }
+
+    const int64_t newest = static_cast<int64_t>( ( time_us_64() * SAMPLE_RATE_HZ ) / 1'000'000 );
+    for( uint32_t i = 0; i < FFT_SIZE; i++ )
+    {
+      const int64_t sample = std::max<int64_t>( newest - ( FFT_SIZE - 1 - i ), 0 );
+      const double  t      = static_cast<double>( sample ) / SAMPLE_RATE_HZ;
+      const double  beat   = std::exp( -std::fmod( t, BEAT_PERIOD_S ) / BEAT_DECAY_S );
+      const double  bass   = 0.6 * beat * std::sin( 2.0 * M_PI * BASS_HZ * t );
+      const double  tone   = 0.1 * std::sin( 2.0 * M_PI * TONE_HZ * t );
+
+      dst[ i ] = static_cast<int16_t>( ( bass + tone ) * FULL_SCALE );
+    }
+
+    return true;
+  }
+
+}    // namespace Audio
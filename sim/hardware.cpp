@@ -0,0 +1,290 @@
+/******************************************************************************
+ *  File Name:
+ *    hardware.cpp
+ *
+ *  Description:
+ *    Simulated GPIO, UART and the odds and ends of the SDK the firmware
+ *    touches that have no behavior worth modelling
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "hardware/clocks.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "hardware/structs/systick.h"
+#include "hardware/structs/xip_ctrl.h"
+#include "hardware/uart.h"
+#include "pico/multicore.h"
+#include "pico/platform.h"
+#include "pico_debug.h"
+#include "sim.hpp"
+#include <cstdarg>
+#include <cstdio>
+
+/*-----------------------------------------------------------------------------
+Stack regions standing in for the ones reserved by the SDK linker script. The
+__Stack* symbols are pointed at these with --defsym.
+-----------------------------------------------------------------------------*/
+extern "C" uint32_t sim_core0_stack[ 512 ];
+extern "C" uint32_t sim_core1_stack[ 512 ];
+uint32_t            sim_core0_stack[ 512 ];
+uint32_t            sim_core1_stack[ 512 ];
+
+struct uart_inst
+{
+  uint64_t tx_bytes;
+};
+
+namespace Sim
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr uint     GPIO_COUNT = 30;
+  static constexpr uint32_t SYS_CLK_HZ = 125'000'000;
+
+  /*---------------------------------------------------------------------------
+  Static Data
+  ---------------------------------------------------------------------------*/
+
+  static bool                s_pin_level[ GPIO_COUNT ];
+  static uint32_t            s_pin_irq_mask[ GPIO_COUNT ];
+  static gpio_irq_callback_t s_gpio_callback;
+  static uart_inst           s_uarts[ 2 ];
+  static timer_hw_t          s_timer_hw;
+  static systick_hw_t        s_systick_hw;
+  static xip_ctrl_hw_t       s_xip_ctrl_hw;
+
+  /*---------------------------------------------------------------------------
+  Public Functions
+  ---------------------------------------------------------------------------*/
+
+  void setPin( const uint32_t pin, const bool level )
+  {
+    if( ( pin >= GPIO_COUNT ) || ( s_pin_level[ pin ] == level ) )
+    {
+      return;
+    }
+
+    s_pin_level[ pin ] = level;
+
+    const uint32_t event = level ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL;
+    if( ( s_pin_irq_mask[ pin ] & event ) && s_gpio_callback )
+    {
+      s_gpio_callback( pin, event );
+    }
+  }
+
+
+  uint64_t uartTxBytes()
+  {
+    return s_uarts[ 0 ].tx_bytes + s_uarts[ 1 ].tx_bytes;
+  }
+
+}    // namespace Sim
+
+/*-----------------------------------------------------------------------------
+SDK Data
+-----------------------------------------------------------------------------*/
+
+timer_hw_t *const    timer_hw    = &Sim::s_timer_hw;
+systick_hw_t *const  systick_hw  = &Sim::s_systick_hw;
+xip_ctrl_hw_t *const xip_ctrl_hw = &Sim::s_xip_ctrl_hw;
+uart_inst_t *const   sim_uart0   = &Sim::s_uarts[ 0 ];
+uart_inst_t *const   sim_uart1   = &Sim::s_uarts[ 1 ];
+
+/*-----------------------------------------------------------------------------
+SDK Functions: GPIO. Every pin idles high, as if pulled up with nothing
+pressing it low.
+-----------------------------------------------------------------------------*/
+
+void gpio_init( uint gpio )
+{
+  Sim::s_pin_level[ gpio ]    = true;
+  Sim::s_pin_irq_mask[ gpio ] = 0;
+}
+
+
+void gpio_set_dir( uint gpio, bool out )
+{
+  ( void )gpio;
+  ( void )out;
+}
+
+
+void gpio_pull_up( uint gpio )
+{
+  Sim::s_pin_level[ gpio ] = true;
+}
+
+
+void gpio_set_function( uint gpio, enum gpio_function fn )
+{
+  ( void )fn;
+  Sim::s_pin_level[ gpio ] = true;
+}
+
+
+bool gpio_get( uint gpio )
+{
+  return Sim::s_pin_level[ gpio ];
+}
+
+
+void gpio_set_irq_enabled( uint gpio, uint32_t event_mask, bool enabled )
+{
+  if( enabled )
+  {
+    Sim::s_pin_irq_mask[ gpio ] |= event_mask;
+  }
+  else
+  {
+    Sim::s_pin_irq_mask[ gpio ] &= ~event_mask;
+  }
+}
+
+
+void gpio_set_irq_enabled_with_callback( uint gpio, uint32_t event_mask, bool enabled, gpio_irq_callback_t callback )
+{
+  gpio_set_irq_enabled( gpio, event_mask, enabled );
+  Sim::s_gpio_callback = callback;
+}
+
+/*-----------------------------------------------------------------------------
+SDK Functions: IRQ. Only the GPIO bank delivers interrupts in the simulator.
+-----------------------------------------------------------------------------*/
+
+void irq_set_exclusive_handler( uint num, irq_handler_t handler )
+{
+  ( void )num;
+  ( void )handler;
+}
+
+
+void irq_set_enabled( uint num, bool enabled )
+{
+  ( void )num;
+  ( void )enabled;
+}
+
+/*-----------------------------------------------------------------------------
+SDK Functions: UART. Nothing is ever plugged in upstream.
+-----------------------------------------------------------------------------*/
+
+uint uart_init( uart_inst_t *uart, uint baudrate )
+{
+  uart->tx_bytes = 0;
+  return baudrate;
+}
+
+
+void uart_set_format( uart_inst_t *uart, uint data_bits, uint stop_bits, uart_parity_t parity )
+{
+  ( void )uart;
+  ( void )data_bits;
+  ( void )stop_bits;
+  ( void )parity;
+}
+
+
+void uart_set_fifo_enabled( uart_inst_t *uart, bool enabled )
+{
+  ( void )uart;
+  ( void )enabled;
+}
+
+
+void uart_set_irq_enables( uart_inst_t *uart, bool rx_has_data, bool tx_needs_data )
+{
+  ( void )uart;
+  ( void )rx_has_data;
+  ( void )tx_needs_data;
+}
+
+
+bool uart_is_readable( uart_inst_t *uart )
+{
+  ( void )uart;
+  return false;
+}
+
+
+char uart_getc( uart_inst_t *uart )
+{
+  ( void )uart;
+  return 0;
+}
+
+
+void uart_write_blocking( uart_inst_t *uart, const uint8_t *src, size_t len )
+{
+  ( void )src;
+  uart->tx_bytes += len;
+}
+
+/*-----------------------------------------------------------------------------
+SDK Functions: Everything else
+-----------------------------------------------------------------------------*/
+
+uint32_t clock_get_hz( enum clock_index clk_index )
+{
+  ( void )clk_index;
+  return Sim::SYS_CLK_HZ;
+}
+
+
+uint get_core_num()
+{
+  return 0;
+}
+
+
+void panic( const char *fmt, ... )
+{
+  char    message[ 256 ];
+  va_list args;
+
+  va_start( args, fmt );
+  vsnprintf( message, sizeof( message ), fmt, args );
+  va_end( args );
+
+  throw Sim::Panic{ message };
+}
+
+
+void multicore_launch_core1( void ( *entry )( void ) )
+{
+  ( void )entry;
+}
+
+
+void multicore_fifo_push_blocking( uint32_t data )
+{
+  panic( "FIFO push 0x%08x with no core1", data );
+}
+
+
+uint32_t multicore_fifo_pop_blocking()
+{
+  panic( "FIFO pop with no core1" );
+}
+
+
+void pico_debug_init()
+{
+}
+
+
+void pico_debug_core_x_thread()
+{
+}
+
+
+void pico_debug_configure_clocks()
+{
+}
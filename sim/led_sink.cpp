@@ -0,0 +1,378 @@
+/******************************************************************************
+ *  File Name:
+ *    led_sink.cpp
+ *
+ *  Description:
+ *    Simulated WS2812 string. Implements the LED driver API with the same
+ *    buffer handoff and wire timing as the PIO/DMA driver, and checks every
+ *    frame that reaches the wire for writes that strayed out of bounds.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "hardware/sync.h"
+#include "pico/time.h"
+#include "sim.hpp"
+#include "telemetry.hpp"
+#include "trace.hpp"
+#include "ws2812.hpp"
+#include "ws2812_timing.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace LED
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr size_t   GUARD_WORDS = 8;             // Words of padding on each side of a buffer
+  static constexpr uint32_t GUARD_VALUE = 0xDEADBEEF;    // Pattern the padding must keep
+
+  static constexpr uint32_t s_bit_rates[ TIMING_PROFILE_COUNT ] = { 800'000, 1'000'000, 1'200'000 };
+
+  /*---------------------------------------------------------------------------
+  Structures
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief LED buffer with guard words on either side to catch overruns
+   */
+  struct GuardedBuffer
+  {
+    uint32_t head[ GUARD_WORDS ];
+    uint32_t data[ WS2812_NUM_LEDS ];
+    uint32_t tail[ GUARD_WORDS ];
+  };
+
+  /*---------------------------------------------------------------------------
+  Variables
+  ---------------------------------------------------------------------------*/
+
+  static GuardedBuffer  s_canvas;               // Render canvas, persists between frames
+  static GuardedBuffer  s_raw_led_buffer[ 2 ];  // Double buffered LED data
+  static uint32_t      *sp_back_buffer;         // Pointer to the buffer being prepared
+  static uint32_t      *sp_display_buffer;      // Pointer to the current display buffer
+  static DirtyRegion    s_dirty;                // Canvas changes since the last swap
+  static DirtyRegion    s_prev_dirty;           // Canvas changes in the frame before that
+  static uint8_t        s_timing_profile;       // Profile currently driving the data line
+  static uint8_t        s_output_mode;          // How the main loop paces frames
+  static bool           s_wire_idle;            // Latch satisfied and nothing on the wire
+  static bool           s_frame_queued;         // A swapped frame is waiting for the latch gap
+  static uint64_t       s_dma_done_us;          // When the DMA finishes reading the display buffer
+  static uint32_t       s_render_us;            // Simulated cost of rendering a frame
+  static FILE          *s_dump;                 // Where presented frames are written, if anywhere
+  static Sim::LedStats  s_stats;
+
+  /*---------------------------------------------------------------------------
+  Static Function Declarations
+  ---------------------------------------------------------------------------*/
+
+  static int64_t latch_complete_callback( alarm_id_t id, void *user_data );
+
+  /*---------------------------------------------------------------------------
+  Static Functions
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Fills a buffer's guard words with the guard pattern
+   *
+   * @param buffer  Buffer to reset
+   */
+  static void reset_guards( GuardedBuffer &buffer )
+  {
+    std::fill( buffer.head, buffer.head + GUARD_WORDS, GUARD_VALUE );
+    std::fill( buffer.tail, buffer.tail + GUARD_WORDS, GUARD_VALUE );
+  }
+
+
+  /**
+   * @brief Counts and repairs damage to a buffer's guard words
+   *
+   * @param buffer  Buffer to check
+   */
+  static void check_guards( GuardedBuffer &buffer )
+  {
+    for( size_t i = 0; i < GUARD_WORDS; i++ )
+    {
+      s_stats.guard_faults += ( buffer.head[ i ] != GUARD_VALUE );
+      s_stats.guard_faults += ( buffer.tail[ i ] != GUARD_VALUE );
+    }
+
+    reset_guards( buffer );
+  }
+
+
+  /**
+   * @brief Puts the display buffer on the wire
+   *
+   * The data is checked here, as it is what the LEDs would actually receive.
+   */
+  static void start_transfer()
+  {
+    for( size_t i = 0; i < WS2812_NUM_LEDS; i++ )
+    {
+      s_stats.bad_pixels += ( ( sp_display_buffer[ i ] & ~WS2812_DATA_MSK ) != 0 );
+    }
+
+    if( s_dump )
+    {
+      fprintf( s_dump, "%llu", static_cast<unsigned long long>( time_us_64() ) );
+      for( size_t i = 0; i < WS2812_NUM_LEDS; i++ )
+      {
+        fprintf( s_dump, " %06x", sp_display_buffer[ i ] & WS2812_DATA_MSK );
+      }
+      fprintf( s_dump, "\n" );
+    }
+
+    const uint32_t wire_us = frameTimeUs() - WS2812B_2020_LIMITS.reset_min_us;
+
+    s_wire_idle   = false;
+    s_dma_done_us = time_us_64() + wire_us - std::min( wire_us, fifoDrainTimeUs( s_bit_rates[ s_timing_profile ] ) );
+    Trace::record( Trace::EVENT_DMA_START );
+    Sim::at( s_dma_done_us, []() { Trace::record( Trace::EVENT_DMA_DONE ); } );
+    add_alarm_in_us( frameTimeUs(), latch_complete_callback, nullptr, true );
+  }
+
+
+  /**
+   * @brief Alarm fired once the frame on the wire has shifted out and latched
+   *
+   * @param id          Unused
+   * @param user_data   Unused
+   * @return int64_t    Always zero, the alarm does not repeat
+   */
+  static int64_t latch_complete_callback( alarm_id_t id, void *user_data )
+  {
+    ( void )id;
+    ( void )user_data;
+
+    s_stats.presented++;
+    Telemetry::recordPresent( time_us_32() );
+    Trace::record( Trace::EVENT_LATCH );
+
+    if( s_frame_queued )
+    {
+      s_frame_queued = false;
+      start_transfer();
+    }
+    else
+    {
+      s_wire_idle = true;
+    }
+
+    __sev();
+    return 0;
+  }
+
+
+  /**
+   * @brief Spins until the DMA has finished reading the display buffer
+   */
+  static void wait_for_dma()
+  {
+    if( time_us_64() < s_dma_done_us )
+    {
+      busy_wait_us( s_dma_done_us - time_us_64() );
+    }
+  }
+
+  /*---------------------------------------------------------------------------
+  Public Functions
+  ---------------------------------------------------------------------------*/
+
+  void initialize()
+  {
+    s_timing_profile  = WS2812_DEFAULT_TIMING;
+    s_output_mode     = WS2812_DEFAULT_OUTPUT_MODE;
+    s_wire_idle       = true;
+    s_frame_queued    = false;
+    s_dma_done_us     = 0;
+    s_stats           = {};
+    sp_back_buffer    = s_raw_led_buffer[ 0 ].data;
+    sp_display_buffer = s_raw_led_buffer[ 1 ].data;
+    memset( &s_canvas, 0, sizeof( s_canvas ) );
+    memset( s_raw_led_buffer, 0, sizeof( s_raw_led_buffer ) );
+    reset_guards( s_canvas );
+    reset_guards( s_raw_led_buffer[ 0 ] );
+    reset_guards( s_raw_led_buffer[ 1 ] );
+    s_dirty.clear();
+    s_prev_dirty.clear();
+
+    swapBuffers();
+  }
+
+
+  uint32_t *getRenderBuffer()
+  {
+    return s_canvas.data;
+  }
+
+
+  void markDirty( const uint32_t first, const uint32_t count )
+  {
+    if( first < WS2812_NUM_LEDS )
+    {
+      s_dirty.add( first, first + std::min( count, WS2812_NUM_LEDS - first ) );
+    }
+    else
+    {
+      s_stats.dirty_out_of_range++;
+    }
+  }
+
+
+  void markAllDirty()
+  {
+    s_dirty.clear();
+    s_dirty.add( 0, WS2812_NUM_LEDS );
+  }
+
+
+  DirtyRegion getDamage()
+  {
+    DirtyRegion damage = s_dirty;
+    damage.merge( s_prev_dirty );
+    return damage;
+  }
+
+
+  uint32_t *getBackBuffer()
+  {
+    return sp_back_buffer;
+  }
+
+
+  const uint32_t *getDisplayBuffer()
+  {
+    return sp_display_buffer;
+  }
+
+
+  void swapBuffers()
+  {
+    /*-------------------------------------------------------------------------
+    Charge the frame's render time, then hand it off exactly like the driver
+    -------------------------------------------------------------------------*/
+    sleep_us( s_render_us );
+    wait_for_dma();
+
+    check_guards( s_canvas );
+    check_guards( s_raw_led_buffer[ 0 ] );
+    check_guards( s_raw_led_buffer[ 1 ] );
+    s_stats.swaps++;
+
+    s_prev_dirty = s_dirty;
+    s_dirty.clear();
+
+    uint32_t *p_temp  = sp_back_buffer;
+    sp_back_buffer    = sp_display_buffer;
+    sp_display_buffer = p_temp;
+
+    Trace::record( Trace::EVENT_SWAP, !s_wire_idle );
+    if( s_wire_idle )
+    {
+      start_transfer();
+    }
+    else
+    {
+      s_stats.replaced += s_frame_queued;
+      s_frame_queued = true;
+    }
+  }
+
+
+  bool readyForFrame()
+  {
+    return !s_frame_queued;
+  }
+
+
+  void setOutputMode( const OutputMode mode )
+  {
+    s_output_mode = mode;
+  }
+
+
+  OutputMode getOutputMode()
+  {
+    return static_cast<OutputMode>( s_output_mode );
+  }
+
+
+  bool setTimingProfile( const TimingProfile profile )
+  {
+    if( profile >= TIMING_PROFILE_COUNT )
+    {
+      return false;
+    }
+
+    s_timing_profile = profile;
+    return true;
+  }
+
+
+  TimingProfile getTimingProfile()
+  {
+    return static_cast<TimingProfile>( s_timing_profile );
+  }
+
+
+  uint32_t frameTimeUs()
+  {
+    return LED::frameTimeUs( s_bit_rates[ s_timing_profile ], WS2812_NUM_LEDS, WS2812B_2020_LIMITS );
+  }
+
+
+  void resetBuffers()
+  {
+    wait_for_dma();
+
+    memset( s_canvas.data, 0, sizeof( s_canvas.data ) );
+    memset( sp_back_buffer, 0, sizeof( uint32_t ) * WS2812_NUM_LEDS );
+    memset( sp_display_buffer, 0, sizeof( uint32_t ) * WS2812_NUM_LEDS );
+    markAllDirty();
+  }
+
+}    // namespace LED
+
+namespace Sim
+{
+  /*---------------------------------------------------------------------------
+  Public Functions
+  ---------------------------------------------------------------------------*/
+
+  void setRenderCost( const uint32_t render_us )
+  {
+    LED::s_render_us = render_us;
+  }
+
+
+  bool dumpFrames( const std::string &path )
+  {
+    if( LED::s_dump )
+    {
+      fclose( LED::s_dump );
+      LED::s_dump = nullptr;
+    }
+
+    if( !path.empty() )
+    {
+      LED::s_dump = fopen( path.c_str(), "w" );
+      return LED::s_dump != nullptr;
+    }
+
+    return true;
+  }
+
+
+  LedStats getLedStats()
+  {
+    return LED::s_stats;
+  }
+
+}    // namespace Sim
@@ -0,0 +1,419 @@
+/******************************************************************************
+ *  File Name:
+ *    main.cpp
+ *
+ *  Description:
+ *    Soak test harness. Runs the firmware against the simulated hardware on
+ *    a virtual clock, pressing buttons on a schedule, and reports how the
+ *    frame pipeline held up.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "animator.hpp"
+#include "animator_private.hpp"
+#include "buttons.hpp"
+#include "mirror.hpp"
+#include "sim.hpp"
+#include "sync.hpp"
+#include "telemetry.hpp"
+#include "trace.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+/*-----------------------------------------------------------------------------
+The firmware's main(), renamed by the build
+-----------------------------------------------------------------------------*/
+int firmware_main();
+
+namespace
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr uint32_t PIN_BRIGHT       = 19;         // Must match buttons.cpp
+  static constexpr uint32_t PIN_ACTION       = 25;         // Must match buttons.cpp
+  static constexpr uint32_t BOUNCE_US        = 300;        // Spacing of contact bounce edges
+  static constexpr uint32_t BOUNCE_EDGES     = 4;          // Extra edges on every press and release
+  static constexpr uint64_t SAMPLE_PERIOD_US = 100'000;    // How often the harness checks the animator
+  static constexpr uint64_t PUMP_PERIOD_US   = 1'000;      // How often the mirror is pumped, one USB frame
+
+  /*---------------------------------------------------------------------------
+  Structures
+  ---------------------------------------------------------------------------*/
+
+  struct Options
+  {
+    double      hours        = 24.0;    // Virtual time to run for
+    double      action_every = 600.0;   // Seconds between action presses, zero for never
+    double      bright_every = 900.0;   // Seconds between brightness presses, zero for never
+    uint32_t    hold_ms      = 80;      // How long scheduled presses are held
+    uint32_t    render_us    = 500;     // Simulated render cost per frame
+    std::string script;                 // Extra presses to make, see usage()
+    std::string dump;                   // File to write presented frames to
+    std::string trace;                  // File to write the trace buffer to at the end
+    std::string mirror;                 // File to write the USB mirror stream to
+    uint32_t    mirror_kbps  = 1000;    // Throughput of the simulated USB host
+  };
+
+  struct Usage
+  {
+    uint64_t switches;                                      // Animation changes seen
+    uint64_t brightness_changes;                            // Brightness changes seen
+    uint64_t presented[ Animator::ANIMATION_COUNT ];        // Frames on the wire, by animation
+    uint64_t last_presented;
+    uint8_t  animation;
+    uint8_t  brightness;
+    bool     started;
+  };
+
+  /*---------------------------------------------------------------------------
+  Static Data
+  ---------------------------------------------------------------------------*/
+
+  static Usage s_usage;
+
+  /*---------------------------------------------------------------------------
+  Static Functions
+  ---------------------------------------------------------------------------*/
+
+  static void usage( const char *name )
+  {
+    printf( "Usage: %s [options]\n"
+            "  --hours H          Virtual hours to run (default 24)\n"
+            "  --action-every S   Press the action key every S seconds, 0 for never (default 600)\n"
+            "  --bright-every S   Press the brightness key every S seconds, 0 for never (default 900)\n"
+            "  --hold-ms MS       How long scheduled presses are held (default 80)\n"
+            "  --render-us US     Virtual time charged for rendering each frame (default 500)\n"
+            "  --script FILE      Extra presses, one per line: <seconds> <action|bright> [hold ms]\n"
+            "  --dump FILE        Write every presented frame to FILE\n"
+            "  --trace FILE       Write the trace buffer to FILE at the end, for tools/trace_to_perfetto.py\n"
+            "  --mirror FILE      Connect a USB host that writes the mirror stream to FILE, for tools/mirror_decode.py\n"
+            "  --mirror-kbps K    Throughput the USB host reads at, in kbit/s (default 1000)\n",
+            name );
+  }
+
+
+  /**
+   * @brief Schedules one press and release of a key, with contact bounce on both edges
+   *
+   * @param pin       Key to press
+   * @param when_us   Time of the first edge
+   * @param hold_us   Time from the first press edge to the first release edge
+   */
+  static void schedule_press( const uint32_t pin, const uint64_t when_us, const uint64_t hold_us )
+  {
+    for( uint32_t edge = 0; edge <= BOUNCE_EDGES; edge++ )
+    {
+      const bool level = ( edge % 2 ) != 0;    // Active low: odd edges bounce back up
+      Sim::at( when_us + edge * BOUNCE_US, [ = ]() { Sim::setPin( pin, level ); } );
+      Sim::at( when_us + hold_us + edge * BOUNCE_US, [ = ]() { Sim::setPin( pin, !level ); } );
+    }
+  }
+
+
+  /**
+   * @brief Schedules a key to be pressed at a fixed period for the whole run
+   *
+   * @param pin       Key to press
+   * @param period_s  Seconds between presses
+   * @param opts      Run options
+   */
+  static void schedule_periodic( const uint32_t pin, const double period_s, const Options &opts )
+  {
+    if( period_s <= 0.0 )
+    {
+      return;
+    }
+
+    const uint64_t end_us    = static_cast<uint64_t>( opts.hours * 3600e6 );
+    const uint64_t period_us = static_cast<uint64_t>( period_s * 1e6 );
+    for( uint64_t t = period_us; t < end_us; t += period_us )
+    {
+      schedule_press( pin, t, opts.hold_ms * 1000ull );
+    }
+  }
+
+
+  /**
+   * @brief Schedules the presses listed in a script file
+   *
+   * @param path    Script to read
+   * @return bool   True if every line parsed
+   */
+  static bool schedule_script( const std::string &path )
+  {
+    std::ifstream file( path );
+    if( !file )
+    {
+      fprintf( stderr, "%s: cannot open\n", path.c_str() );
+      return false;
+    }
+
+    std::string line;
+    size_t      line_no = 0;
+    while( std::getline( file, line ) )
+    {
+      line_no++;
+      line = line.substr( 0, line.find( '#' ) );
+
+      std::istringstream fields( line );
+      double             when_s;
+      std::string        key;
+      uint32_t           hold_ms = 80;
+      if( !( fields >> when_s ) )
+      {
+        continue;
+      }
+
+      fields >> key >> hold_ms;
+      if( ( key != "action" ) && ( key != "bright" ) )
+      {
+        fprintf( stderr, "%s:%zu: expected <seconds> <action|bright> [hold ms]\n", path.c_str(), line_no );
+        return false;
+      }
+
+      const uint32_t pin = ( key == "action" ) ? PIN_ACTION : PIN_BRIGHT;
+      schedule_press( pin, static_cast<uint64_t>( when_s * 1e6 ), hold_ms * 1000ull );
+    }
+
+    return true;
+  }
+
+
+  /**
+   * @brief Periodically notes which animation is running and what it has put on the wire
+   */
+  static void sample_animator()
+  {
+    const uint64_t presented = Sim::getLedStats().presented;
+    s_usage.presented[ s_usage.animation ] += presented - s_usage.last_presented;
+    s_usage.last_presented = presented;
+
+    const uint8_t animation  = Animator::getAnimation();
+    const uint8_t brightness = Animator::getBrightness();
+    if( s_usage.started )
+    {
+      s_usage.switches += ( animation != s_usage.animation );
+      s_usage.brightness_changes += ( brightness != s_usage.brightness );
+    }
+
+    s_usage.animation  = animation;
+    s_usage.brightness = brightness;
+    s_usage.started    = true;
+
+    Sim::at( Sim::now() + SAMPLE_PERIOD_US, sample_animator );
+  }
+
+
+  /**
+   * @brief Stands in for core1's USB task, moving queued mirror frames to the host
+   */
+  static void pump_mirror()
+  {
+    Mirror::pump();
+    Sim::at( Sim::now() + PUMP_PERIOD_US, pump_mirror );
+  }
+
+
+  static bool parse_options( int argc, char **argv, Options &opts )
+  {
+    for( int i = 1; i < argc; i++ )
+    {
+      const char *arg   = argv[ i ];
+      const char *value = ( i + 1 < argc ) ? argv[ i + 1 ] : nullptr;
+
+      if( !strcmp( arg, "--help" ) || !value )
+      {
+        return false;
+      }
+
+      i++;
+      if( !strcmp( arg, "--hours" ) )
+      {
+        opts.hours = atof( value );
+      }
+      else if( !strcmp( arg, "--action-every" ) )
+      {
+        opts.action_every = atof( value );
+      }
+      else if( !strcmp( arg, "--bright-every" ) )
+      {
+        opts.bright_every = atof( value );
+      }
+      else if( !strcmp( arg, "--hold-ms" ) )
+      {
+        opts.hold_ms = static_cast<uint32_t>( atoi( value ) );
+      }
+      else if( !strcmp( arg, "--render-us" ) )
+      {
+        opts.render_us = static_cast<uint32_t>( atoi( value ) );
+      }
+      else if( !strcmp( arg, "--script" ) )
+      {
+        opts.script = value;
+      }
+      else if( !strcmp( arg, "--dump" ) )
+      {
+        opts.dump = value;
+      }
+      else if( !strcmp( arg, "--trace" ) )
+      {
+        opts.trace = value;
+      }
+      else if( !strcmp( arg, "--mirror" ) )
+      {
+        opts.mirror = value;
+      }
+      else if( !strcmp( arg, "--mirror-kbps" ) )
+      {
+        opts.mirror_kbps = static_cast<uint32_t>( atoi( value ) );
+      }
+      else
+      {
+        return false;
+      }
+    }
+
+    return opts.hours > 0.0;
+  }
+
+}    // namespace
+
+
+int main( int argc, char **argv )
+{
+  Options opts;
+  if( !parse_options( argc, argv, opts ) )
+  {
+    usage( argv[ 0 ] );
+    return 2;
+  }
+
+  /*---------------------------------------------------------------------------
+  Set up the run
+  ---------------------------------------------------------------------------*/
+  Sim::resetTime( static_cast<uint64_t>( opts.hours * 3600e6 ) );
+  Sim::setRenderCost( opts.render_us );
+  if( !Sim::dumpFrames( opts.dump ) )
+  {
+    fprintf( stderr, "%s: cannot open\n", opts.dump.c_str() );
+    return 2;
+  }
+
+  if( !Sim::mirrorTo( opts.mirror, opts.mirror_kbps ) )
+  {
+    fprintf( stderr, "%s: cannot open\n", opts.mirror.c_str() );
+    return 2;
+  }
+
+  schedule_periodic( PIN_ACTION, opts.action_every, opts );
+  schedule_periodic( PIN_BRIGHT, opts.bright_every, opts );
+  if( !opts.script.empty() && !schedule_script( opts.script ) )
+  {
+    return 2;
+  }
+
+  Sim::at( SAMPLE_PERIOD_US, sample_animator );
+  Sim::at( PUMP_PERIOD_US, pump_mirror );
+
+  /*---------------------------------------------------------------------------
+  Run the firmware until the clock runs out
+  ---------------------------------------------------------------------------*/
+  const auto  wall_start = std::chrono::steady_clock::now();
+  std::string panic_message;
+
+  try
+  {
+    firmware_main();
+  }
+  catch( const Sim::Finished & )
+  {
+  }
+  catch( const Sim::Panic &panic )
+  {
+    panic_message = panic.message;
+  }
+
+  const double wall_s = std::chrono::duration<double>( std::chrono::steady_clock::now() - wall_start ).count();
+
+  if( !opts.trace.empty() )
+  {
+    FILE *trace = fopen( opts.trace.c_str(), "wb" );
+    if( !trace )
+    {
+      fprintf( stderr, "%s: cannot open\n", opts.trace.c_str() );
+      return 2;
+    }
+
+    Trace::setEnabled( false );
+    fwrite( &Trace::getBuffer(), sizeof( Trace::Buffer ), 1, trace );
+    fclose( trace );
+  }
+
+  /*---------------------------------------------------------------------------
+  Report
+  ---------------------------------------------------------------------------*/
+  const Telemetry::FrameStats frames  = Telemetry::getFrameStats();
+  const Buttons::LatencyStats buttons = Buttons::getLatencyStats();
+  const Sync::LinkStats       link    = Sync::getLinkStats();
+  const Sim::TimeStats        time    = Sim::getTimeStats();
+  const Sim::LedStats         leds    = Sim::getLedStats();
+  const Mirror::Stats         mirror  = Mirror::getStats();
+  const double                virt_s  = Sim::now() / 1e6;
+
+  printf( "Simulated %.1f h in %.2f s (%.0fx)\n", virt_s / 3600.0, wall_s, virt_s / wall_s );
+  printf( "Frames\n" );
+  printf( "  rendered          %u\n", frames.frames );
+  printf( "  presented         %llu\n", static_cast<unsigned long long>( leds.presented ) );
+  printf( "  replaced          %llu\n", static_cast<unsigned long long>( leds.replaced ) );
+  printf( "  deadline misses   %u\n", frames.deadline_misses );
+  printf( "  present fps       %u\n", frames.present_fps );
+  printf( "Animations\n" );
+  printf( "  switches          %llu\n", static_cast<unsigned long long>( s_usage.switches ) );
+  printf( "  brightness steps  %llu\n", static_cast<unsigned long long>( s_usage.brightness_changes ) );
+  for( size_t i = 0; i < Animator::ANIMATION_COUNT; i++ )
+  {
+    printf( "  [%zu] presented     %llu\n", i, static_cast<unsigned long long>( s_usage.presented[ i ] ) );
+  }
+  printf( "Buttons\n" );
+  printf( "  dispatched        %u\n", buttons.dispatched );
+  printf( "  dropped edges     %u\n", buttons.dropped );
+  printf( "  max latency us    %u\n", buttons.max_us );
+  printf( "Timers\n" );
+  printf( "  alarms fired      %llu\n", static_cast<unsigned long long>( time.alarms_fired ) );
+  printf( "  alarms refused    %llu\n", static_cast<unsigned long long>( time.alarms_refused ) );
+  printf( "  event wakeups     %llu\n", static_cast<unsigned long long>( time.wakeups ) );
+  printf( "  busy wait us      %llu\n", static_cast<unsigned long long>( time.busy_wait_us ) );
+  printf( "Sync\n" );
+  printf( "  frames sent       %u\n", link.tx_frames );
+  printf( "  bytes sent        %llu\n", static_cast<unsigned long long>( Sim::uartTxBytes() ) );
+  printf( "Mirror\n" );
+  printf( "  frames sent       %u\n", mirror.frames_sent );
+  printf( "  frames dropped    %u\n", mirror.frames_dropped );
+  printf( "  bytes queued      %u\n", mirror.bytes_sent );
+  printf( "  bytes to host     %llu\n", static_cast<unsigned long long>( Sim::usbTxBytes() ) );
+  printf( "  mean bytes/s      %.0f\n", Sim::usbTxBytes() / virt_s );
+  printf( "Out of range writes\n" );
+  printf( "  markDirty         %llu\n", static_cast<unsigned long long>( leds.dirty_out_of_range ) );
+  printf( "  guard words       %llu\n", static_cast<unsigned long long>( leds.guard_faults ) );
+  printf( "  pixel bits        %llu\n", static_cast<unsigned long long>( leds.bad_pixels ) );
+
+  if( !panic_message.empty() )
+  {
+    printf( "PANIC at %.6f s: %s\n", virt_s, panic_message.c_str() );
+    return 1;
+  }
+
+  const bool clean = ( leds.dirty_out_of_range == 0 ) && ( leds.guard_faults == 0 ) && ( leds.bad_pixels == 0 );
+  return clean ? 0 : 1;
+}
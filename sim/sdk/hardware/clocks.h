@@ -0,0 +1,24 @@
+/******************************************************************************
+ *  File Name:
+ *    clocks.h
+ *
+ *  Description:
+ *    Host stand-in for the Pico SDK header of the same name
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+#pragma once
+#ifndef HOLLY_JOLLY_SIM_HARDWARE_CLOCKS_H
+#define HOLLY_JOLLY_SIM_HARDWARE_CLOCKS_H
+
+#include "pico/types.h"
+
+enum clock_index
+{
+  clk_sys = 5,
+};
+
+uint32_t clock_get_hz( enum clock_index clk_index );
+
+#endif /* !HOLLY_JOLLY_SIM_HARDWARE_CLOCKS_H */
@@ -0,0 +1,47 @@
+/******************************************************************************
+ *  File Name:
+ *    gpio.h
+ *
+ *  Description:
+ *    Host stand-in for the Pico SDK header of the same name
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+#pragma once
+#ifndef HOLLY_JOLLY_SIM_HARDWARE_GPIO_H
+#define HOLLY_JOLLY_SIM_HARDWARE_GPIO_H
+
+#include "pico/types.h"
+
+enum gpio_function
+{
+  GPIO_FUNC_SPI  = 1,
+  GPIO_FUNC_UART = 2,
+  GPIO_FUNC_PIO0 = 6,
+  GPIO_FUNC_SIO  = 5,
+  GPIO_FUNC_NULL = 0x1f,
+};
+
+enum gpio_irq_level
+{
+  GPIO_IRQ_LEVEL_LOW  = 0x1u,
+  GPIO_IRQ_LEVEL_HIGH = 0x2u,
+  GPIO_IRQ_EDGE_FALL  = 0x4u,
+  GPIO_IRQ_EDGE_RISE  = 0x8u,
+};
+
+#define GPIO_OUT 1
+#define GPIO_IN 0
+
+typedef void ( *gpio_irq_callback_t )( uint gpio, uint32_t event_mask );
+
+void gpio_init( uint gpio );
+void gpio_set_dir( uint gpio, bool out );
+void gpio_pull_up( uint gpio );
+void gpio_set_function( uint gpio, enum gpio_function fn );
+bool gpio_get( uint gpio );
+void gpio_set_irq_enabled( uint gpio, uint32_t event_mask, bool enabled );
+void gpio_set_irq_enabled_with_callback( uint gpio, uint32_t event_mask, bool enabled, gpio_irq_callback_t callback );
+
+#endif /* !HOLLY_JOLLY_SIM_HARDWARE_GPIO_H */
@@ -0,0 +1,32 @@
+/******************************************************************************
+ *  File Name:
+ *    irq.h
+ *
+ *  Description:
+ *    Host stand-in for the Pico SDK header of the same name
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+#pragma once
+#ifndef HOLLY_JOLLY_SIM_HARDWARE_IRQ_H
+#define HOLLY_JOLLY_SIM_HARDWARE_IRQ_H
+
+#include "pico/types.h"
+
+enum irq_num_rp2040
+{
+  TIMER_IRQ_0  = 0,
+  DMA_IRQ_0    = 11,
+  DMA_IRQ_1    = 12,
+  UART0_IRQ    = 20,
+  UART1_IRQ    = 21,
+  ADC_IRQ_FIFO = 22,
+};
+
+typedef void ( *irq_handler_t )( void );
+
+void irq_set_exclusive_handler( uint num, irq_handler_t handler );
+void irq_set_enabled( uint num, bool enabled );
+
+#endif /* !HOLLY_JOLLY_SIM_HARDWARE_IRQ_H */
@@ -0,0 +1,28 @@
+/******************************************************************************
+ *  File Name:
+ *    systick.h
+ *
+ *  Description:
+ *    Host stand-in for the Pico SDK header of the same name. The counter never
+ *    moves, so cycle measurements read as zero.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+#pragma once
+#ifndef HOLLY_JOLLY_SIM_HARDWARE_STRUCTS_SYSTICK_H
+#define HOLLY_JOLLY_SIM_HARDWARE_STRUCTS_SYSTICK_H
+
+#include "pico/types.h"
+
+typedef struct
+{
+  volatile uint32_t csr;
+  volatile uint32_t rvr;
+  volatile uint32_t cvr;
+  volatile uint32_t calib;
+} systick_hw_t;
+
+extern systick_hw_t *const systick_hw;
+
+#endif /* !HOLLY_JOLLY_SIM_HARDWARE_STRUCTS_SYSTICK_H */
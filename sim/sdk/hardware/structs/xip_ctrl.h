@@ -0,0 +1,32 @@
+/******************************************************************************
+ *  File Name:
+ *    xip_ctrl.h
+ *
+ *  Description:
+ *    Host stand-in for the Pico SDK header of the same name. Nothing runs
+ *    from flash, so the cache counters stay at zero.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+#pragma once
+#ifndef HOLLY_JOLLY_SIM_HARDWARE_STRUCTS_XIP_CTRL_H
+#define HOLLY_JOLLY_SIM_HARDWARE_STRUCTS_XIP_CTRL_H
+
+#include "pico/types.h"
+
+typedef struct
+{
+  volatile uint32_t ctrl;
+  volatile uint32_t flush;
+  volatile uint32_t stat;
+  volatile uint32_t ctr_hit;
+  volatile uint32_t ctr_acc;
+  volatile uint32_t stream_addr;
+  volatile uint32_t stream_ctr;
+  volatile uint32_t stream_fifo;
+} xip_ctrl_hw_t;
+
+extern xip_ctrl_hw_t *const xip_ctrl_hw;
+
+#endif /* !HOLLY_JOLLY_SIM_HARDWARE_STRUCTS_XIP_CTRL_H */
@@ -0,0 +1,35 @@
+/******************************************************************************
+ *  File Name:
+ *    sync.h
+ *
+ *  Description:
+ *    Host stand-in for the Pico SDK header of the same name. Interrupts only
+ *    fire while the firmware waits, so masking them is a no-op.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+#pragma once
+#ifndef HOLLY_JOLLY_SIM_HARDWARE_SYNC_H
+#define HOLLY_JOLLY_SIM_HARDWARE_SYNC_H
+
+#include "pico/types.h"
+
+void __sev( void );
+void __wfe( void );
+
+static inline void __dmb( void )
+{
+}
+
+static inline uint32_t save_and_disable_interrupts( void )
+{
+  return 0;
+}
+
+static inline void restore_interrupts( uint32_t status )
+{
+  ( void )status;
+}
+
+#endif /* !HOLLY_JOLLY_SIM_HARDWARE_SYNC_H */
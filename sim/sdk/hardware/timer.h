@@ -0,0 +1,28 @@
+/******************************************************************************
+ *  File Name:
+ *    timer.h
+ *
+ *  Description:
+ *    Host stand-in for the Pico SDK header of the same name
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+#pragma once
+#ifndef HOLLY_JOLLY_SIM_HARDWARE_TIMER_H
+#define HOLLY_JOLLY_SIM_HARDWARE_TIMER_H
+
+#include "pico/types.h"
+
+typedef struct
+{
+  volatile uint32_t dbgpause;
+} timer_hw_t;
+
+extern timer_hw_t *const timer_hw;
+
+uint64_t time_us_64( void );
+uint32_t time_us_32( void );
+void     busy_wait_us( uint64_t us );
+
+#endif /* !HOLLY_JOLLY_SIM_HARDWARE_TIMER_H */
@@ -0,0 +1,41 @@
+/******************************************************************************
+ *  File Name:
+ *    uart.h
+ *
+ *  Description:
+ *    Host stand-in for the Pico SDK header of the same name. Nothing is ever
+ *    received and everything sent is counted and dropped.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+#pragma once
+#ifndef HOLLY_JOLLY_SIM_HARDWARE_UART_H
+#define HOLLY_JOLLY_SIM_HARDWARE_UART_H
+
+#include "pico/types.h"
+
+typedef struct uart_inst uart_inst_t;
+
+extern uart_inst_t *const sim_uart0;
+extern uart_inst_t *const sim_uart1;
+
+#define uart0 sim_uart0
+#define uart1 sim_uart1
+
+typedef enum
+{
+  UART_PARITY_NONE,
+  UART_PARITY_EVEN,
+  UART_PARITY_ODD
+} uart_parity_t;
+
+uint uart_init( uart_inst_t *uart, uint baudrate );
+void uart_set_format( uart_inst_t *uart, uint data_bits, uint stop_bits, uart_parity_t parity );
+void uart_set_fifo_enabled( uart_inst_t *uart, bool enabled );
+void uart_set_irq_enables( uart_inst_t *uart, bool rx_has_data, bool tx_needs_data );
+bool uart_is_readable( uart_inst_t *uart );
+char uart_getc( uart_inst_t *uart );
+void uart_write_blocking( uart_inst_t *uart, const uint8_t *src, size_t len );
+
+#endif /* !HOLLY_JOLLY_SIM_HARDWARE_UART_H */
@@ -0,0 +1,24 @@
+/******************************************************************************
+ *  File Name:
+ *    multicore.h
+ *
+ *  Description:
+ *    Host stand-in for the Pico SDK header of the same name. Core1 is never
+ *    started in the simulator, so the render worker never reports ready and
+ *    nothing talks over the FIFOs.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+#pragma once
+#ifndef HOLLY_JOLLY_SIM_PICO_MULTICORE_H
+#define HOLLY_JOLLY_SIM_PICO_MULTICORE_H
+
+#include "pico/stdlib.h"
+#include "pico/types.h"
+
+void     multicore_launch_core1( void ( *entry )( void ) );
+void     multicore_fifo_push_blocking( uint32_t data );
+uint32_t multicore_fifo_pop_blocking();
+
+#endif /* !HOLLY_JOLLY_SIM_PICO_MULTICORE_H */
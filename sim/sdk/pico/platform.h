@@ -0,0 +1,24 @@
+/******************************************************************************
+ *  File Name:
+ *    platform.h
+ *
+ *  Description:
+ *    Host stand-in for the Pico SDK header of the same name
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+#pragma once
+#ifndef HOLLY_JOLLY_SIM_PICO_PLATFORM_H
+#define HOLLY_JOLLY_SIM_PICO_PLATFORM_H
+
+#include "pico/types.h"
+
+/**
+ * @brief Ends the simulation with a failure, reporting the message
+ */
+[[noreturn]] void panic( const char *fmt, ... );
+
+uint get_core_num( void );
+
+#endif /* !HOLLY_JOLLY_SIM_PICO_PLATFORM_H */
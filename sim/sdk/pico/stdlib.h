@@ -0,0 +1,22 @@
+/******************************************************************************
+ *  File Name:
+ *    stdlib.h
+ *
+ *  Description:
+ *    Host stand-in for the Pico SDK header of the same name
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+#pragma once
+#ifndef HOLLY_JOLLY_SIM_PICO_STDLIB_H
+#define HOLLY_JOLLY_SIM_PICO_STDLIB_H
+
+#include "hardware/gpio.h"
+#include "hardware/timer.h"
+#include "hardware/uart.h"
+#include "pico/platform.h"
+#include "pico/time.h"
+#include "pico/types.h"
+
+#endif /* !HOLLY_JOLLY_SIM_PICO_STDLIB_H */
@@ -0,0 +1,92 @@
+/******************************************************************************
+ *  File Name:
+ *    time.h
+ *
+ *  Description:
+ *    Host stand-in for the Pico SDK header of the same name. Time is virtual
+ *    and only moves when the firmware sleeps or waits for an event.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+#pragma once
+#ifndef HOLLY_JOLLY_SIM_PICO_TIME_H
+#define HOLLY_JOLLY_SIM_PICO_TIME_H
+
+#include "hardware/timer.h"
+#include "pico/types.h"
+
+#define nil_time ( ( absolute_time_t )0 )
+#define at_the_end_of_time ( ( absolute_time_t )INT64_MAX )
+
+typedef int32_t alarm_id_t;
+typedef int64_t ( *alarm_callback_t )( alarm_id_t id, void *user_data );
+
+static inline uint64_t to_us_since_boot( absolute_time_t t )
+{
+  return t;
+}
+
+static inline absolute_time_t from_us_since_boot( uint64_t us )
+{
+  return us;
+}
+
+static inline uint32_t to_ms_since_boot( absolute_time_t t )
+{
+  return static_cast<uint32_t>( t / 1000 );
+}
+
+static inline absolute_time_t get_absolute_time( void )
+{
+  return time_us_64();
+}
+
+static inline absolute_time_t delayed_by_us( absolute_time_t t, uint64_t us )
+{
+  return t + us;
+}
+
+static inline absolute_time_t delayed_by_ms( absolute_time_t t, uint32_t ms )
+{
+  return t + static_cast<uint64_t>( ms ) * 1000;
+}
+
+static inline absolute_time_t make_timeout_time_us( uint64_t us )
+{
+  return delayed_by_us( get_absolute_time(), us );
+}
+
+static inline absolute_time_t make_timeout_time_ms( uint32_t ms )
+{
+  return delayed_by_ms( get_absolute_time(), ms );
+}
+
+static inline int64_t absolute_time_diff_us( absolute_time_t from, absolute_time_t to )
+{
+  return static_cast<int64_t>( to - from );
+}
+
+static inline absolute_time_t absolute_time_min( absolute_time_t a, absolute_time_t b )
+{
+  return ( a < b ) ? a : b;
+}
+
+static inline bool is_nil_time( absolute_time_t t )
+{
+  return t == 0;
+}
+
+static inline bool time_reached( absolute_time_t t )
+{
+  return time_us_64() >= t;
+}
+
+void       sleep_us( uint64_t us );
+void       sleep_ms( uint32_t ms );
+void       sleep_until( absolute_time_t target );
+bool       best_effort_wfe_or_timeout( absolute_time_t timeout_timestamp );
+alarm_id_t add_alarm_in_us( uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past );
+bool       cancel_alarm( alarm_id_t alarm_id );
+
+#endif /* !HOLLY_JOLLY_SIM_PICO_TIME_H */
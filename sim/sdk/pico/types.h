@@ -0,0 +1,33 @@
+/******************************************************************************
+ *  File Name:
+ *    types.h
+ *
+ *  Description:
+ *    Host stand-in for the Pico SDK header of the same name
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+#pragma once
+#ifndef HOLLY_JOLLY_SIM_PICO_TYPES_H
+#define HOLLY_JOLLY_SIM_PICO_TYPES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef unsigned int uint;
+typedef uint64_t     absolute_time_t;
+
+#define __not_in_flash_func( func_name ) func_name
+#define __time_critical_func( func_name ) func_name
+#define __force_inline inline __attribute__( ( always_inline ) )
+#define __not_in_flash( group )
+#define __scratch_x( group )
+#define __scratch_y( group )
+
+static inline void tight_loop_contents( void )
+{
+}
+
+#endif /* !HOLLY_JOLLY_SIM_PICO_TYPES_H */
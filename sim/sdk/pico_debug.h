@@ -0,0 +1,19 @@
+/******************************************************************************
+ *  File Name:
+ *    pico_debug.h
+ *
+ *  Description:
+ *    Host stand-in for the pico-debug library, which has nothing to do here
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+#pragma once
+#ifndef HOLLY_JOLLY_SIM_PICO_DEBUG_H
+#define HOLLY_JOLLY_SIM_PICO_DEBUG_H
+
+void pico_debug_init( void );
+void pico_debug_core_x_thread( void );
+void pico_debug_configure_clocks( void );
+
+#endif /* !HOLLY_JOLLY_SIM_PICO_DEBUG_H */
@@ -0,0 +1,25 @@
+/******************************************************************************
+ *  File Name:
+ *    tusb.h
+ *
+ *  Description:
+ *    Host stand-in for the TinyUSB device CDC calls the mirror uses. The host
+ *    is only "connected" when the harness is writing the stream to a file.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+#pragma once
+#ifndef HOLLY_JOLLY_SIM_TUSB_H
+#define HOLLY_JOLLY_SIM_TUSB_H
+
+#include <cstdint>
+
+bool     tusb_init( void );
+void     tud_task( void );
+bool     tud_cdc_connected( void );
+uint32_t tud_cdc_write_available( void );
+uint32_t tud_cdc_write( const void *buffer, uint32_t bufsize );
+uint32_t tud_cdc_write_flush( void );
+
+#endif /* !HOLLY_JOLLY_SIM_TUSB_H */
@@ -0,0 +1,188 @@
+/******************************************************************************
+ *  File Name:
+ *    sim.hpp
+ *
+ *  Description:
+ *    Host simulation of the hardware the firmware runs on. Time is virtual:
+ *    it only moves forward while the firmware sleeps, waits for an event or
+ *    spins on a peripheral, and jumps straight to the next thing that can
+ *    happen. A day of operation runs in seconds.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+#pragma once
+#ifndef HOLLY_JOLLY_SIM_HPP
+#define HOLLY_JOLLY_SIM_HPP
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace Sim
+{
+  /*---------------------------------------------------------------------------
+  Exceptions
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Thrown out of whatever the firmware is waiting on once the run ends
+   */
+  struct Finished
+  {
+  };
+
+  /**
+   * @brief Thrown when the firmware calls panic()
+   */
+  struct Panic
+  {
+    std::string message;
+  };
+
+  /*---------------------------------------------------------------------------
+  Structures
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief What the virtual clock has been asked to do
+   */
+  struct TimeStats
+  {
+    uint64_t alarms_fired;      // Alarm pool callbacks run
+    uint64_t alarms_refused;    // add_alarm_in_us() calls rejected because the pool was full
+    uint64_t wakeups;           // Waits ended early by an event
+    uint64_t busy_wait_us;      // Time spent spinning rather than sleeping
+  };
+
+  /**
+   * @brief What the simulated LED string has seen
+   */
+  struct LedStats
+  {
+    uint64_t swaps;                 // Frames handed to the driver
+    uint64_t presented;             // Frames that made it onto the wire and latched
+    uint64_t replaced;              // Queued frames replaced by a newer one before reaching the wire
+    uint64_t dirty_out_of_range;    // markDirty() calls starting past the end of the string
+    uint64_t bad_pixels;            // Presented pixels with bits set outside the 24 color bits
+    uint64_t guard_faults;          // Buffer writes found past either end of a frame buffer
+  };
+
+  /*---------------------------------------------------------------------------
+  Virtual Time
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Resets the clock to zero and clears everything scheduled
+   *
+   * @param end_us  Time at which the run ends by throwing Finished
+   */
+  void resetTime( const uint64_t end_us );
+
+  /**
+   * @brief Current virtual time
+   * @return uint64_t   Microseconds since boot
+   */
+  uint64_t now();
+
+  /**
+   * @brief Schedules a stimulus, such as a button edge, to run at a point in time
+   *
+   * Stimuli run in the same context as alarm callbacks, i.e. like an ISR.
+   *
+   * @param when_us   Time to run at
+   * @param action    What to do
+   */
+  void at( const uint64_t when_us, std::function<void()> action );
+
+  /**
+   * @brief Advances time, running every alarm and stimulus that comes due
+   *
+   * @param target_us   Time to advance to
+   */
+  void runUntil( const uint64_t target_us );
+
+  /**
+   * @brief Gets the virtual clock statistics
+   * @return TimeStats
+   */
+  TimeStats getTimeStats();
+
+  /*---------------------------------------------------------------------------
+  GPIO
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Drives an input pin, raising its IRQ if the edge is enabled
+   *
+   * @param pin     GPIO number
+   * @param level   New level
+   */
+  void setPin( const uint32_t pin, const bool level );
+
+  /*---------------------------------------------------------------------------
+  UART
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Total bytes written to both UARTs
+   * @return uint64_t
+   */
+  uint64_t uartTxBytes();
+
+  /*---------------------------------------------------------------------------
+  LED String
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Sets how long each rendered frame is charged against virtual time
+   *
+   * The firmware runs instantly on the host, so without a cost it can never
+   * miss a deadline. Each swap advances the clock by this much first.
+   *
+   * @param render_us   Simulated time to render one frame
+   */
+  void setRenderCost( const uint32_t render_us );
+
+  /**
+   * @brief Writes every presented frame to a file, one line per frame
+   *
+   * @param path    File to write, or empty to stop dumping
+   * @return bool   True if the file could be opened
+   */
+  bool dumpFrames( const std::string &path );
+
+  /**
+   * @brief Gets the LED string statistics
+   * @return LedStats
+   */
+  LedStats getLedStats();
+
+  /*---------------------------------------------------------------------------
+  USB
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Connects a host to the USB CDC port that writes the stream to a file
+   *
+   * With no file open the port reads as disconnected, as when nothing on the
+   * host side has it open.
+   *
+   * @param path    File to write, or empty to disconnect
+   * @param kbps    Throughput the host reads the port at, in kilobits per second
+   * @return bool   True if the file could be opened
+   */
+  bool mirrorTo( const std::string &path, const uint32_t kbps );
+
+  /**
+   * @brief Total bytes the host has read from the USB CDC port
+   * @return uint64_t
+   */
+  uint64_t usbTxBytes();
+
+}    // namespace Sim
+
+#endif /* !HOLLY_JOLLY_SIM_HPP */
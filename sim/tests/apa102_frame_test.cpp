@@ -0,0 +1,165 @@
+/******************************************************************************
+ *  File Name:
+ *    apa102_frame_test.cpp
+ *
+ *  Description:
+ *    Checks the APA102/SK9822 frame encoder byte for byte: frame sizes, the
+ *    brightness mapping, a hand checked frame, and that patching the damaged
+ *    spans of a frame gives the same bytes as encoding it from scratch.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "apa102_frame.hpp"
+#include "test.hpp"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace LED;
+
+namespace
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr size_t  COUNTS[]     = { 1, 3, 15, 16, 17, 32, 300 };    // String lengths to encode
+  static constexpr uint8_t LEVELS[]     = { 0, 1, 5, 30, APA102_MAX_LEVEL };
+  static constexpr size_t  PATCH_ROUNDS = 100;                              // Random damage patterns per string
+
+  /*---------------------------------------------------------------------------
+  Static Functions
+  ---------------------------------------------------------------------------*/
+
+  static std::vector<uint8_t> encode( const std::vector<uint32_t> &colors, const uint8_t level )
+  {
+    std::vector<uint8_t> frame( apa102FrameBytes( colors.size() ), 0xA5 );
+    apa102EncodeFrame( colors.data(), colors.size(), level, frame.data() );
+    return frame;
+  }
+
+
+  /**
+   * @brief Encodes a small frame and then patches one LED of it
+   */
+  static void check_known_frame()
+  {
+    const uint32_t colors[ 3 ]  = { 0x00112233, 0x00FFFFFF, 0x00000000 };
+    const uint32_t patched[ 3 ] = { 0x00AAAAAA, 0x000000FF, 0x00AAAAAA };
+    const uint8_t  expected[]   = { 0x00, 0x00, 0x00, 0x00,    // Start
+                                    0xE5, 0x11, 0x33, 0x22,    // 0x00112233 is B 0x11, R 0x22, G 0x33
+                                    0xFF, 0x00, 0xFF, 0x00,    // Patched to green at full level
+                                    0xE5, 0x00, 0x00, 0x00,    // Black
+                                    0x00, 0x00, 0x00, 0x00,    // Reset
+                                    0x00 };                    // End
+
+    CHECK( sizeof( expected ) == apa102FrameBytes( 3 ) );
+
+    uint8_t frame[ sizeof( expected ) + 1 ];
+    std::fill( std::begin( frame ), std::end( frame ), 0xA5 );
+
+    apa102EncodeFrame( colors, 3, 5, frame );
+    apa102EncodeLeds( patched, 1, 2, APA102_MAX_LEVEL, frame );
+
+    CHECK( std::equal( std::begin( expected ), std::end( expected ), frame ) );
+    CHECK( frame[ sizeof( expected ) ] == 0xA5 );    // Nothing written past the end
+  }
+
+
+  /**
+   * @brief Checks every byte of a frame against the wire format
+   *
+   * @param colors  Colors the frame was encoded from
+   * @param level   Brightness it was encoded with
+   * @param frame   Encoded frame
+   */
+  static void check_layout( const std::vector<uint32_t> &colors, const uint8_t level, const std::vector<uint8_t> &frame )
+  {
+    const size_t leds_end = APA102_START_BYTES + ( colors.size() * APA102_LED_BYTES );
+
+    CHECK( std::all_of( frame.begin(), frame.begin() + APA102_START_BYTES, []( uint8_t b ) { return b == 0; } ) );
+    CHECK( std::all_of( frame.begin() + leds_end, frame.end(), []( uint8_t b ) { return b == 0; } ) );
+
+    for( size_t i = 0; i < colors.size(); i++ )
+    {
+      const uint8_t *const led = frame.data() + APA102_START_BYTES + ( i * APA102_LED_BYTES );
+
+      CHECK( led[ 0 ] == ( APA102_LED_HEADER | level ) );
+      CHECK( led[ 1 ] == ( ( colors[ i ] >> 16 ) & 0xFF ) );
+      CHECK( led[ 2 ] == ( colors[ i ] & 0xFF ) );
+      CHECK( led[ 3 ] == ( ( colors[ i ] >> 8 ) & 0xFF ) );
+    }
+  }
+
+}    // namespace
+
+
+int main()
+{
+  /*---------------------------------------------------------------------------
+  Frame sizes, with an end byte for every 16 LEDs or part of one
+  ---------------------------------------------------------------------------*/
+  CHECK( apa102FrameBytes( 1 ) == ( 4 + 4 + 4 + 1 ) );
+  CHECK( apa102FrameBytes( 16 ) == ( 4 + 64 + 4 + 1 ) );
+  CHECK( apa102FrameBytes( 17 ) == ( 4 + 68 + 4 + 2 ) );
+  CHECK( apa102FrameBytes( 32 ) == ( 4 + 128 + 4 + 2 ) );
+
+  /*---------------------------------------------------------------------------
+  Brightness mapping: full scale is full level, and anything lit stays lit
+  ---------------------------------------------------------------------------*/
+  CHECK( apa102Level( 0 ) == 0 );
+  CHECK( apa102Level( 1 ) == 1 );
+  CHECK( apa102Level( 128 ) == 16 );
+  CHECK( apa102Level( 256 ) == APA102_MAX_LEVEL );
+  CHECK( apa102Level( 1000 ) == APA102_MAX_LEVEL );
+
+  for( uint32_t scale = 1; scale <= 512; scale++ )
+  {
+    CHECK( apa102Level( scale ) >= apa102Level( scale - 1 ) );
+    CHECK( ( apa102Level( scale ) >= 1 ) && ( apa102Level( scale ) <= APA102_MAX_LEVEL ) );
+  }
+
+  /*---------------------------------------------------------------------------
+  A frame worked out by hand
+  ---------------------------------------------------------------------------*/
+  check_known_frame();
+
+  /*---------------------------------------------------------------------------
+  Whole frames follow the wire format, and patching the damaged spans of the
+  frame from two swaps ago gives the same bytes as a fresh encode
+  ---------------------------------------------------------------------------*/
+  std::mt19937 rng( 0x41504131 );
+
+  for( const size_t count : COUNTS )
+  {
+    for( const uint8_t level : LEVELS )
+    {
+      std::vector<uint32_t> colors( count );
+      std::generate( colors.begin(), colors.end(), [ & ]() { return rng() & 0x00FFFFFF; } );
+
+      std::vector<uint8_t> frame = encode( colors, level );
+      CHECK( frame.size() == apa102FrameBytes( count ) );
+      check_layout( colors, level, frame );
+
+      for( size_t round = 0; round < PATCH_ROUNDS; round++ )
+      {
+        const size_t first = rng() % count;
+        const size_t end   = first + 1 + ( rng() % ( count - first ) );
+
+        for( size_t i = first; i < end; i++ )
+        {
+          colors[ i ] = rng() & 0x00FFFFFF;
+        }
+
+        apa102EncodeLeds( colors.data(), first, end, level, frame.data() );
+        CHECK( frame == encode( colors, level ) );
+      }
+    }
+  }
+
+  return Test::result( "apa102_frame" );
+}
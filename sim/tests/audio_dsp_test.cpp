@@ -0,0 +1,293 @@
+/******************************************************************************
+ *  File Name:
+ *    audio_dsp_test.cpp
+ *
+ *  Description:
+ *    Plays a WAV file through the audio analyzer one frame at a time, the way
+ *    the spectrum animation calls it, and checks the bands, the beats and the
+ *    time each analysis takes.
+ *
+ *    With no section times on the command line only the time budget is
+ *    checked, so any recording can be profiled. The file from
+ *    make_audio_wav.py is run with its sections, which have known answers.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "audio_dsp.hpp"
+#include "holly_jolly_cfg.hpp"
+#include "test.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace Audio;
+
+namespace
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr uint32_t FRAME_US    = FRAME_REFRESH_RATE_MS * 1000;    // Time between analyses
+  static constexpr uint32_t HOP_SAMPLES = ( SAMPLE_RATE_HZ * FRAME_US ) / 1'000'000;
+  static constexpr uint32_t BUDGET_NS   = FRAME_US * 1000;    // One analysis must fit in a frame
+  static constexpr uint32_t BEAT_LAG_US = 50'000;             // Latest a beat may follow its kick
+  static constexpr uint32_t BASS_BANDS  = 3;                  // Bands lit by the kick, up to about 550Hz
+  static constexpr uint32_t TONE_BAND   = 5;                  // Band holding 2.5kHz
+  static constexpr uint32_t SETTLE_US   = 100'000;            // Time allowed to react to a new section
+
+  /*---------------------------------------------------------------------------
+  Structures
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Where the sections of make_audio_wav.py start
+   */
+  struct Sections
+  {
+    uint32_t kick_us;      // 120 BPM kick begins, silence before it
+    uint32_t tone_us;      // Steady tone begins, kick ends
+    uint32_t period_us;    // Time between kicks
+  };
+
+  /**
+   * @brief One call to the analyzer
+   */
+  struct Frame
+  {
+    uint32_t time_us;      // Time of the newest sample in the window
+    Spectrum spectrum;
+    double   cost_ns;
+  };
+
+  /*---------------------------------------------------------------------------
+  Static Functions
+  ---------------------------------------------------------------------------*/
+
+  static uint32_t read_le( const uint8_t *const p, const size_t bytes )
+  {
+    uint32_t value = 0;
+    for( size_t i = 0; i < bytes; i++ )
+    {
+      value |= static_cast<uint32_t>( p[ i ] ) << ( 8 * i );
+    }
+
+    return value;
+  }
+
+  /**
+   * @brief Loads a 16-bit PCM WAV file and resamples it to the ADC rate
+   *
+   * Channels are mixed down to mono. Linear interpolation is plenty here,
+   * since the analyzer only reports eight bands.
+   *
+   * @param path    File to read
+   * @return std::vector<int16_t>   Samples at SAMPLE_RATE_HZ, empty if unreadable
+   */
+  static std::vector<int16_t> load_wav( const std::string &path )
+  {
+    std::ifstream              file( path, std::ios::binary );
+    const std::vector<uint8_t> data( ( std::istreambuf_iterator<char>( file ) ), std::istreambuf_iterator<char>() );
+
+    if( ( data.size() < 12 ) || memcmp( data.data(), "RIFF", 4 ) || memcmp( data.data() + 8, "WAVE", 4 ) )
+    {
+      return {};
+    }
+
+    uint32_t       channels = 0;
+    uint32_t       rate_hz  = 0;
+    uint32_t       bits     = 0;
+    const uint8_t *pcm      = nullptr;
+    size_t         pcm_size = 0;
+
+    for( size_t pos = 12; pos + 8 <= data.size(); )
+    {
+      const uint8_t *chunk = data.data() + pos;
+      const size_t   size  = std::min<size_t>( read_le( chunk + 4, 4 ), data.size() - pos - 8 );
+
+      if( !memcmp( chunk, "fmt ", 4 ) && ( size >= 16 ) && ( read_le( chunk + 8, 2 ) == 1 ) )
+      {
+        channels = read_le( chunk + 10, 2 );
+        rate_hz  = read_le( chunk + 12, 4 );
+        bits     = read_le( chunk + 22, 2 );
+      }
+      else if( !memcmp( chunk, "data", 4 ) )
+      {
+        pcm      = chunk + 8;
+        pcm_size = size;
+      }
+
+      pos += 8 + size + ( size & 1 );
+    }
+
+    if( !pcm || ( channels == 0 ) || ( rate_hz == 0 ) || ( bits != 16 ) )
+    {
+      return {};
+    }
+
+    std::vector<double> mono( pcm_size / ( 2 * channels ) );
+    for( size_t i = 0; i < mono.size(); i++ )
+    {
+      double sum = 0;
+      for( uint32_t ch = 0; ch < channels; ch++ )
+      {
+        sum += static_cast<int16_t>( read_le( pcm + 2 * ( i * channels + ch ), 2 ) );
+      }
+      mono[ i ] = sum / channels;
+    }
+
+    std::vector<int16_t> out;
+    for( double src = 0; src + 1 < mono.size(); src += static_cast<double>( rate_hz ) / SAMPLE_RATE_HZ )
+    {
+      const size_t i    = static_cast<size_t>( src );
+      const double frac = src - i;
+      out.push_back( static_cast<int16_t>( mono[ i ] + ( mono[ i + 1 ] - mono[ i ] ) * frac ) );
+    }
+
+    return out;
+  }
+
+
+  /**
+   * @brief Runs every frame of the recording through one analyzer
+   *
+   * @param samples   Recording at SAMPLE_RATE_HZ
+   * @return std::vector<Frame>
+   */
+  static std::vector<Frame> analyze_all( const std::vector<int16_t> &samples )
+  {
+    Analyzer           analyzer;
+    std::vector<Frame> frames;
+
+    analyzer.reset();
+    for( size_t end = FFT_SIZE; end <= samples.size(); end += HOP_SAMPLES )
+    {
+      Frame frame;
+      frame.time_us = static_cast<uint32_t>( ( static_cast<uint64_t>( end ) * 1'000'000 ) / SAMPLE_RATE_HZ );
+      frame.cost_ns = Test::timeNs( 1, [ & ]() { frame.spectrum = analyzer.analyze( &samples[ end - FFT_SIZE ], FRAME_US ); } );
+      frames.push_back( frame );
+    }
+
+    return frames;
+  }
+
+
+  static void check_silence( const std::vector<Frame> &frames, const Sections &sections )
+  {
+    for( const Frame &frame : frames )
+    {
+      if( frame.time_us >= sections.kick_us )
+      {
+        break;
+      }
+
+      CHECK( !frame.spectrum.beat );
+      CHECK( std::all_of( frame.spectrum.bands, frame.spectrum.bands + BAND_COUNT, []( uint8_t b ) { return b == 0; } ) );
+    }
+  }
+
+
+  static void check_kick( const std::vector<Frame> &frames, const Sections &sections )
+  {
+    const uint32_t kicks = ( sections.tone_us - sections.kick_us ) / sections.period_us;
+    uint32_t       beats = 0;
+
+    for( const Frame &frame : frames )
+    {
+      if( ( frame.time_us < sections.kick_us ) || ( frame.time_us >= sections.tone_us ) )
+      {
+        continue;
+      }
+
+      /*-----------------------------------------------------------------------
+      An 80Hz kick only lights the bass bands, even across its onset
+      -----------------------------------------------------------------------*/
+      const uint8_t *bands = frame.spectrum.bands;
+      CHECK( std::all_of( bands + BASS_BANDS, bands + BAND_COUNT, []( uint8_t b ) { return b == 0; } ) );
+
+      /*-----------------------------------------------------------------------
+      Every beat lands shortly after a kick
+      -----------------------------------------------------------------------*/
+      if( frame.spectrum.beat )
+      {
+        beats++;
+        CHECK( ( ( frame.time_us - sections.kick_us ) % sections.period_us ) <= BEAT_LAG_US );
+      }
+    }
+
+    printf( "kick:    %u beats for %u kicks\n", beats, kicks );
+    CHECK( beats == kicks );
+  }
+
+
+  static void check_tone( const std::vector<Frame> &frames, const Sections &sections )
+  {
+    for( const Frame &frame : frames )
+    {
+      if( frame.time_us < sections.tone_us + SETTLE_US )
+      {
+        continue;
+      }
+
+      const uint8_t *bands = frame.spectrum.bands;
+
+      CHECK( !frame.spectrum.beat );
+      CHECK( bands[ TONE_BAND ] > 0 );
+      CHECK( bands[ TONE_BAND ] == *std::max_element( bands, bands + BAND_COUNT ) );
+    }
+  }
+
+}    // namespace
+
+
+int main( int argc, char **argv )
+{
+  if( ( argc != 2 ) && ( argc != 5 ) )
+  {
+    printf( "Usage: %s <file.wav> [<kick start ms> <tone start ms> <kick period ms>]\n", argv[ 0 ] );
+    return 2;
+  }
+
+  const std::vector<int16_t> samples = load_wav( argv[ 1 ] );
+  if( !CHECK( samples.size() >= FFT_SIZE ) )
+  {
+    return Test::result( "audio_dsp" );
+  }
+
+  const std::vector<Frame> frames = analyze_all( samples );
+
+  /*---------------------------------------------------------------------------
+  Every analysis has to finish inside the frame it was called in
+  ---------------------------------------------------------------------------*/
+  double total_ns = 0;
+  double worst_ns = 0;
+  for( const Frame &frame : frames )
+  {
+    total_ns += frame.cost_ns;
+    worst_ns = std::max( worst_ns, frame.cost_ns );
+  }
+
+  printf( "analyze: %zu frames, mean %.1fus, worst %.1fus, budget %uus\n", frames.size(),
+          total_ns / frames.size() / 1000.0, worst_ns / 1000.0, BUDGET_NS / 1000 );
+  CHECK( worst_ns < BUDGET_NS );
+
+  if( argc == 5 )
+  {
+    const Sections sections = { static_cast<uint32_t>( std::stoul( argv[ 2 ] ) * 1000 ),
+                                static_cast<uint32_t>( std::stoul( argv[ 3 ] ) * 1000 ),
+                                static_cast<uint32_t>( std::stoul( argv[ 4 ] ) * 1000 ) };
+
+    check_silence( frames, sections );
+    check_kick( frames, sections );
+    check_tone( frames, sections );
+  }
+
+  return Test::result( "audio_dsp" );
+}
@@ -0,0 +1,177 @@
+/******************************************************************************
+ *  File Name:
+ *    color_test.cpp
+ *
+ *  Description:
+ *    Checks the integer HSV conversions against each other: primaries, grays,
+ *    and round trips through every HSV color and a sweep of RGB colors.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "color.hpp"
+#include "test.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+using namespace Color;
+
+namespace
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr int32_t  HUE_SLACK  = 50;     // Hue error times the channel spread, from quantizing f to the spread
+  static constexpr int32_t  SAT_SLACK  = 128;    // Saturation error times the value, from quantizing the smallest channel
+  static constexpr int32_t  RGB_SLACK  = 4;      // Channel error after RGB -> HSV -> RGB, about half a hue step
+  static constexpr uint32_t RGB_STRIDE = 7;      // Step through the 2^24 colors for the RGB round trip
+
+  /*---------------------------------------------------------------------------
+  Structures
+  ---------------------------------------------------------------------------*/
+
+  struct Primary
+  {
+    uint32_t color;
+    uint8_t  hue;
+  };
+
+  /*---------------------------------------------------------------------------
+  Static Data
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Sector boundaries of the wheel, at 256 * k / 6 rounded
+   */
+  static constexpr Primary PRIMARIES[] = {
+    { rgb( 255, 0, 0 ), 0 },        // Red
+    { rgb( 255, 255, 0 ), 43 },     // Yellow
+    { rgb( 0, 255, 0 ), 85 },       // Green
+    { rgb( 0, 255, 255 ), 128 },    // Cyan
+    { rgb( 0, 0, 255 ), 171 },      // Blue
+    { rgb( 255, 0, 255 ), 213 },    // Magenta
+  };
+
+  /*---------------------------------------------------------------------------
+  Static Functions
+  ---------------------------------------------------------------------------*/
+
+  static int32_t channel( const uint32_t color, const uint32_t shift )
+  {
+    return ( color >> shift ) & 0xFF;
+  }
+
+
+  static int32_t spread( const uint32_t color )
+  {
+    const int32_t b = channel( color, 16 );
+    const int32_t r = channel( color, 8 );
+    const int32_t g = channel( color, 0 );
+
+    return std::max( { r, g, b } ) - std::min( { r, g, b } );
+  }
+
+
+  static int32_t hue_distance( const uint8_t a, const uint8_t b )
+  {
+    const int32_t d = std::abs( a - b );
+    return std::min( d, 256 - d );
+  }
+
+}    // namespace
+
+
+int main()
+{
+  /*---------------------------------------------------------------------------
+  mul255() rounds a * b / 255 to nearest for every input
+  ---------------------------------------------------------------------------*/
+  for( uint32_t a = 0; a < 256; a++ )
+  {
+    for( uint32_t b = 0; b < 256; b++ )
+    {
+      CHECK( mul255( a, b ) == ( ( 2 * a * b ) + 255 ) / 510 );
+    }
+  }
+
+  /*---------------------------------------------------------------------------
+  Primaries and secondaries sit on the sector boundaries both ways. Going
+  back to RGB, the rounded hue is at most 1/3 of a step off the boundary.
+  ---------------------------------------------------------------------------*/
+  for( const Primary &primary : PRIMARIES )
+  {
+    const Hsv hsv = rgbToHsv( primary.color );
+    CHECK( ( hsv.h == primary.hue ) && ( hsv.s == 255 ) && ( hsv.v == 255 ) );
+
+    const uint32_t back = hsvToRgb( hsv );
+    for( uint32_t shift = 0; shift < 24; shift += 8 )
+    {
+      CHECK( std::abs( channel( back, shift ) - channel( primary.color, shift ) ) <= 2 );
+    }
+  }
+
+  CHECK( hsvToRgb( { 0, 255, 255 } ) == rgb( 255, 0, 0 ) );
+  CHECK( hsvToRgb( { 128, 255, 255 } ) == rgb( 0, 255, 255 ) );
+
+  /*---------------------------------------------------------------------------
+  Zero saturation is gray at every hue, full value is white, and grays come
+  back with no hue or saturation
+  ---------------------------------------------------------------------------*/
+  for( uint32_t h = 0; h < 256; h++ )
+  {
+    for( uint32_t v = 0; v < 256; v++ )
+    {
+      CHECK( hsvToRgb( { static_cast<uint8_t>( h ), 0, static_cast<uint8_t>( v ) } ) == v * 0x010101 );
+    }
+  }
+
+  for( uint32_t v = 0; v < 256; v++ )
+  {
+    const Hsv hsv = rgbToHsv( v * 0x010101 );
+    CHECK( ( hsv.h == 0 ) && ( hsv.s == 0 ) && ( hsv.v == v ) );
+  }
+
+  /*---------------------------------------------------------------------------
+  HSV -> RGB -> HSV over every color. Value comes back exactly, and a fully
+  saturated, full value hue does too. Otherwise hue and saturation are only
+  as fine as the channels that carry them: a spread of d levels across the
+  channels can only place the hue to about 43 / d of a step.
+  ---------------------------------------------------------------------------*/
+  for( uint32_t h = 0; h < 256; h++ )
+  {
+    const Hsv vivid = rgbToHsv( hsvToRgb( { static_cast<uint8_t>( h ), 255, 255 } ) );
+    CHECK( ( vivid.h == h ) && ( vivid.s == 255 ) && ( vivid.v == 255 ) );
+
+    for( int32_t s = 0; s < 256; s++ )
+    {
+      for( int32_t v = 1; v < 256; v++ )
+      {
+        const uint32_t color = hsvToRgb( { static_cast<uint8_t>( h ), static_cast<uint8_t>( s ), static_cast<uint8_t>( v ) } );
+        const Hsv      back  = rgbToHsv( color );
+        const int32_t  d     = spread( color );
+
+        CHECK( back.v == v );
+        CHECK( std::abs( back.s - s ) * v <= SAT_SLACK + v );
+        CHECK( ( d == 0 ) || ( hue_distance( back.h, h ) * d <= HUE_SLACK + d ) );
+      }
+    }
+  }
+
+  /*---------------------------------------------------------------------------
+  RGB -> HSV -> RGB, off by no more than rounding the hue to 256 steps
+  ---------------------------------------------------------------------------*/
+  for( uint32_t color = 0; color <= 0x00FFFFFF; color += RGB_STRIDE )
+  {
+    const uint32_t back = hsvToRgb( rgbToHsv( color ) );
+    for( uint32_t shift = 0; shift < 24; shift += 8 )
+    {
+      CHECK( std::abs( channel( back, shift ) - channel( color, shift ) ) <= RGB_SLACK );
+    }
+  }
+
+  return Test::result( "color" );
+}
@@ -0,0 +1,274 @@
+/******************************************************************************
+ *  File Name:
+ *    coroutine_test.cpp
+ *
+ *  Description:
+ *    Checks the pacing and progress reporting of the CO_ macros, and times a
+ *    coroutine resume against an empty virtual process() call, the way the
+ *    animator would reach either one.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "coroutine.hpp"
+#include "test.hpp"
+#include <vector>
+
+using namespace Animator;
+
+namespace
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr uint32_t PERIOD_US   = 10'000;           // Sleep used by the pacing checks
+  static constexpr uint32_t LONG_US     = 1'000'000'000;    // Sleep the timing never wakes from
+  static constexpr uint32_t TIMING_RUNS = 10'000'000;       // Calls averaged for each timing
+
+  /*---------------------------------------------------------------------------
+  Structures
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief The part of Animator::FrameTime the CO_ macros read
+   */
+  struct FrameTime
+  {
+    uint32_t dt_us;
+  };
+
+  /*---------------------------------------------------------------------------
+  Classes
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Stand-in for IAnimation, so each call goes through a vtable
+   */
+  class Process
+  {
+  public:
+    virtual ~Process() = default;
+    virtual bool process( const FrameTime &time ) = 0;
+  };
+
+
+  class Empty : public Process
+  {
+  public:
+    bool process( const FrameTime &time ) final override
+    {
+      ( void )time;
+      return true;
+    }
+  };
+
+
+  /**
+   * @brief Counts a step every PERIOD_US, or sleeps for good when timing
+   */
+  class Sleeper : public Process
+  {
+  public:
+    Coroutine co;
+    uint32_t  period_us = PERIOD_US;
+    uint32_t  steps     = 0;
+
+    bool process( const FrameTime &time ) final override
+    {
+      CO_BEGIN( co, time );
+
+      while( true )
+      {
+        CO_SLEEP_US( co, period_us );
+        steps++;
+      }
+
+      CO_END( co );
+    }
+  };
+
+
+  /**
+   * @brief Counts a step on every frame
+   */
+  class Stepper : public Process
+  {
+  public:
+    Coroutine co;
+    uint32_t  steps = 0;
+
+    bool process( const FrameTime &time ) final override
+    {
+      CO_BEGIN( co, time );
+
+      while( true )
+      {
+        steps++;
+        CO_NEXT_FRAME( co );
+      }
+
+      CO_END( co );
+    }
+  };
+
+
+  /**
+   * @brief Runs three frames' worth of steps and then finishes
+   */
+  class Finite : public Process
+  {
+  public:
+    Coroutine co;
+    uint32_t  steps = 0;
+
+    bool process( const FrameTime &time ) final override
+    {
+      CO_BEGIN( co, time );
+
+      for( steps = 1; steps < 3; steps++ )
+      {
+        CO_NEXT_FRAME( co );
+      }
+
+      CO_END( co );
+    }
+  };
+
+  /*---------------------------------------------------------------------------
+  Static Data
+  ---------------------------------------------------------------------------*/
+
+  static Process *volatile s_target;    // Read on every call, so the compiler can't devirtualize it
+
+  /*---------------------------------------------------------------------------
+  Static Functions
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Frames on which a sleep loop woke, for a steady frame period
+   *
+   * @param dt_us   Frame period
+   * @param frames  Frames to run
+   * @return std::vector<uint32_t>  Frame numbers, counting from 1
+   */
+  static std::vector<uint32_t> wake_frames( const uint32_t dt_us, const uint32_t frames )
+  {
+    Sleeper               sleeper;
+    std::vector<uint32_t> woke;
+
+    sleeper.process( { 0 } );
+    for( uint32_t n = 1; n <= frames; n++ )
+    {
+      const uint32_t before   = sleeper.steps;
+      const bool     progress = sleeper.process( { dt_us } );
+
+      CHECK( progress == ( sleeper.steps != before ) );
+      if( sleeper.steps != before )
+      {
+        woke.push_back( n );
+      }
+    }
+
+    return woke;
+  }
+
+
+  static double time_calls( Process &target )
+  {
+    s_target = &target;
+    return Test::timeNs( TIMING_RUNS, []() { s_target->process( { 1 } ); } );
+  }
+
+}    // namespace
+
+
+int main()
+{
+  /*---------------------------------------------------------------------------
+  The first call runs up to the first suspension and counts as progress
+  ---------------------------------------------------------------------------*/
+  {
+    Sleeper sleeper;
+    CHECK( sleeper.process( { 0 } ) );
+    CHECK( sleeper.steps == 0 );
+  }
+
+  /*---------------------------------------------------------------------------
+  A 10ms sleep on 3ms frames wakes on the first frame at or past each 10ms
+  mark, since the overshoot is credited to the next sleep
+  ---------------------------------------------------------------------------*/
+  CHECK( wake_frames( 3'000, 10 ) == std::vector<uint32_t>( { 4, 7, 10 } ) );
+  CHECK( wake_frames( PERIOD_US, 3 ) == std::vector<uint32_t>( { 1, 2, 3 } ) );
+
+  /*---------------------------------------------------------------------------
+  A frame later than a whole sleep runs the loop through to catch up
+  ---------------------------------------------------------------------------*/
+  {
+    Sleeper sleeper;
+    sleeper.process( { 0 } );
+    CHECK( sleeper.process( { 25'000 } ) );
+    CHECK( sleeper.steps == 2 );
+    CHECK( !sleeper.process( { 4'000 } ) );
+    CHECK( sleeper.process( { 1'000 } ) );
+    CHECK( sleeper.steps == 3 );
+  }
+
+  /*---------------------------------------------------------------------------
+  CO_NEXT_FRAME steps once per frame and always presents
+  ---------------------------------------------------------------------------*/
+  {
+    Stepper stepper;
+    for( uint32_t n = 1; n <= 5; n++ )
+    {
+      CHECK( stepper.process( { 0 } ) );
+      CHECK( stepper.steps == n );
+    }
+  }
+
+  /*---------------------------------------------------------------------------
+  Running off the end finishes for good, until reset
+  ---------------------------------------------------------------------------*/
+  {
+    Finite finite;
+    CHECK( finite.process( { 0 } ) );
+    CHECK( finite.process( { 0 } ) );
+    CHECK( !finite.co.finished() );
+    CHECK( finite.process( { 0 } ) );
+    CHECK( finite.co.finished() );
+    CHECK( !finite.process( { 0 } ) );
+    CHECK( finite.steps == 3 );
+
+    finite.co.reset();
+    CHECK( !finite.co.finished() );
+    CHECK( finite.process( { 0 } ) );
+    CHECK( finite.steps == 1 );
+  }
+
+  /*---------------------------------------------------------------------------
+  Cost of a resume on top of the virtual call that reaches it. The sleeper
+  stays asleep, so each call resumes, counts down and suspends again.
+  ---------------------------------------------------------------------------*/
+  Empty   empty;
+  Sleeper sleeper;
+  Stepper stepper;
+
+  sleeper.period_us = LONG_US;
+  sleeper.process( { 0 } );
+
+  const double empty_ns = time_calls( empty );
+  const double sleep_ns = time_calls( sleeper );
+  const double frame_ns = time_calls( stepper );
+
+  printf( "empty virtual process(): %.2fns\n", empty_ns );
+  printf( "CO_SLEEP_US resume:      %.2fns (+%.2fns)\n", sleep_ns, sleep_ns - empty_ns );
+  printf( "CO_NEXT_FRAME resume:    %.2fns (+%.2fns)\n", frame_ns, frame_ns - empty_ns );
+
+  CHECK( sleeper.steps == 0 );
+  CHECK( stepper.steps == TIMING_RUNS );
+
+  return Test::result( "coroutine" );
+}
@@ -0,0 +1,346 @@
+/******************************************************************************
+ *  File Name:
+ *    draw_test.cpp
+ *
+ *  Description:
+ *    Checks how the drawing primitives blend into the canvas: the split of a
+ *    point between two LEDs, saturation when adding, gradient endpoints,
+ *    clipping at both ends of the string and partial coverage at the edges
+ *    of a band. Also checks that exactly the LEDs drawn are marked dirty.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "draw.hpp"
+#include "projection.hpp"
+#include "test.hpp"
+#include "ws2812.hpp"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace Draw;
+using namespace FixedPoint;
+
+namespace
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr uint32_t LEDS  = LED::count();
+  static constexpr uint32_t WHITE = 0x00FFFFFF;
+  static constexpr uint32_t GUARD = 0xDEADBEEF;    // Fills the words either side of the canvas
+
+  /*---------------------------------------------------------------------------
+  Static Data
+  ---------------------------------------------------------------------------*/
+
+  static uint32_t          s_canvas[ LEDS + 2 ];    // The render canvas, with a guard word at each end
+  static std::vector<bool> s_dirty( LEDS );         // LEDs marked dirty since the last reset()
+
+  /*---------------------------------------------------------------------------
+  Static Functions
+  ---------------------------------------------------------------------------*/
+
+  static uint32_t *canvas()
+  {
+    return s_canvas + 1;
+  }
+
+
+  /**
+   * @brief Clears the canvas to a color and forgets what was marked dirty
+   */
+  static void reset( const uint32_t color = 0 )
+  {
+    std::fill( std::begin( s_canvas ), std::end( s_canvas ), color );
+    s_canvas[ 0 ]        = GUARD;
+    s_canvas[ LEDS + 1 ] = GUARD;
+    std::fill( s_dirty.begin(), s_dirty.end(), false );
+  }
+
+
+  /**
+   * @brief Checks nothing was written past either end, and every LED changed from `background` is dirty
+   */
+  static void check_written( const uint32_t background = 0 )
+  {
+    CHECK( s_canvas[ 0 ] == GUARD );
+    CHECK( s_canvas[ LEDS + 1 ] == GUARD );
+
+    for( uint32_t i = 0; i < LEDS; i++ )
+    {
+      if( canvas()[ i ] != background )
+      {
+        CHECK( s_dirty[ i ] );
+      }
+    }
+  }
+
+
+  static uint32_t channel( const uint32_t color, const uint32_t shift )
+  {
+    return ( color >> shift ) & 0xFF;
+  }
+
+
+  /**
+   * @brief Added points light their two LEDs by exactly the color, in total, wherever they sit
+   */
+  static void check_point_split()
+  {
+    std::mt19937 rng( 0x504F494E );
+
+    for( uint32_t frac = 0; frac < Q16_ONE; frac += 37 )
+    {
+      const uint32_t color = rng() & 0x00FFFFFF;
+      const uint32_t upper = ( frac + 0x80 ) >> 8;    // Coverage of the second LED
+
+      reset();
+      point( toQ16( 10 ) + frac, color );
+      check_written();
+
+      for( uint32_t shift = 0; shift < 24; shift += 8 )
+      {
+        CHECK( channel( canvas()[ 10 ], shift ) + channel( canvas()[ 11 ], shift ) == channel( color, shift ) );
+        CHECK( channel( canvas()[ 11 ], shift ) == scale8( channel( color, shift ), upper ) );
+      }
+
+      CHECK( std::count( canvas(), canvas() + LEDS, 0u ) >= static_cast<long>( LEDS - 2 ) );
+    }
+
+    /*-------------------------------------------------------------------------
+    Replacing mixes each LED toward the color by its coverage, which still
+    adds up to one LED between the two
+    -------------------------------------------------------------------------*/
+    for( uint32_t frac = 0; frac < Q16_ONE; frac += 37 )
+    {
+      reset( WHITE );
+      point( toQ16( 10 ) + frac, 0, BLEND_REPLACE );
+
+      const uint32_t upper = ( frac + 0x80 ) >> 8;
+      CHECK( canvas()[ 10 ] == lerpColor( WHITE, 0, 256 - upper ) );
+      CHECK( canvas()[ 11 ] == lerpColor( WHITE, 0, upper ) );
+    }
+  }
+
+
+  /**
+   * @brief Adding saturates each channel on its own, and replacing fully covered LEDs takes the color exactly
+   */
+  static void check_blends()
+  {
+    reset( 0x00F01020 );
+    bar( toQ16( 4 ), toQ16( 6 ), 0x00208010, BLEND_ADD );
+    CHECK( canvas()[ 4 ] == 0x00FF9030 );
+    CHECK( canvas()[ 5 ] == 0x00FF9030 );
+    CHECK( canvas()[ 3 ] == 0x00F01020 );
+    CHECK( canvas()[ 6 ] == 0x00F01020 );
+    check_written( 0x00F01020 );
+
+    bar( toQ16( 4 ), toQ16( 5 ), WHITE, BLEND_ADD );
+    CHECK( canvas()[ 4 ] == WHITE );
+
+    point( toQ16( 5 ), 0x00FFFFFF );
+    point( toQ16( 5 ), 0x00FFFFFF );
+    CHECK( canvas()[ 5 ] == WHITE );
+
+    reset( 0x00123456 );
+    bar( toQ16( 2 ), toQ16( 5 ), 0x00ABCDEF );
+    CHECK( std::all_of( canvas() + 2, canvas() + 5, []( uint32_t c ) { return c == 0x00ABCDEF; } ) );
+    check_written( 0x00123456 );
+  }
+
+
+  /**
+   * @brief Each LED takes the color at its center, held at the endpoints past either end
+   */
+  static void check_gradient()
+  {
+    static constexpr uint32_t FROM = 0x00FF0000;
+    static constexpr uint32_t TO   = 0x000000FF;
+
+    /*-------------------------------------------------------------------------
+    Whole LEDs: centers at a quarter and three quarters of the way
+    -------------------------------------------------------------------------*/
+    reset();
+    gradient( toQ16( 4 ), toQ16( 6 ), FROM, TO );
+    CHECK( canvas()[ 4 ] == lerpColor( FROM, TO, 64 ) );
+    CHECK( canvas()[ 5 ] == lerpColor( FROM, TO, 192 ) );
+    check_written();
+
+    /*-------------------------------------------------------------------------
+    Partly covered end LEDs have their centers outside the gradient, so they
+    take the endpoint colors, blended by their coverage
+    -------------------------------------------------------------------------*/
+    reset();
+    gradient( toQ16( 4 ) + 3 * Q16_ONE / 4, toQ16( 7 ) + Q16_ONE / 4, FROM, TO );
+    CHECK( canvas()[ 4 ] == lerpColor( 0, FROM, 64 ) );
+    CHECK( canvas()[ 5 ] == lerpColor( FROM, TO, 76 ) );     // 0.75 of 2.5 LEDs in
+    CHECK( canvas()[ 6 ] == lerpColor( FROM, TO, 179 ) );    // 1.75 of 2.5 LEDs in
+    CHECK( canvas()[ 7 ] == lerpColor( 0, TO, 64 ) );
+    check_written();
+
+    /*-------------------------------------------------------------------------
+    Across the whole string, both ends and monotonic in between
+    -------------------------------------------------------------------------*/
+    reset();
+    gradient( 0, toQ16( LEDS ), FROM, TO );
+    CHECK( canvas()[ 0 ] == lerpColor( FROM, TO, 128 / LEDS ) );
+    CHECK( canvas()[ LEDS - 1 ] == lerpColor( FROM, TO, 256 - ( 128 / LEDS ) ) );
+    for( uint32_t i = 1; i < LEDS; i++ )
+    {
+      CHECK( channel( canvas()[ i ], 16 ) <= channel( canvas()[ i - 1 ], 16 ) );
+      CHECK( channel( canvas()[ i ], 0 ) >= channel( canvas()[ i - 1 ], 0 ) );
+    }
+
+    reset();
+    gradient( toQ16( 3 ), toQ16( 3 ), FROM, TO );
+    CHECK( std::count( canvas(), canvas() + LEDS, 0u ) == static_cast<long>( LEDS ) );
+    check_written();
+  }
+
+
+  /**
+   * @brief Only the part of a shape on the string is drawn
+   */
+  static void check_clipping()
+  {
+    reset();
+    bar( -toQ16( 3 ), toQ16( 2 ) + Q16_ONE / 2, WHITE );
+    CHECK( canvas()[ 0 ] == WHITE );
+    CHECK( canvas()[ 1 ] == WHITE );
+    CHECK( canvas()[ 2 ] == lerpColor( 0, WHITE, 128 ) );
+    CHECK( std::count( canvas(), canvas() + LEDS, 0u ) == static_cast<long>( LEDS - 3 ) );
+    check_written();
+
+    reset();
+    bar( toQ16( LEDS - 1 ) + Q16_ONE / 4, toQ16( LEDS + 5 ), WHITE );
+    CHECK( canvas()[ LEDS - 1 ] == lerpColor( 0, WHITE, 192 ) );
+    CHECK( std::count( canvas(), canvas() + LEDS, 0u ) == static_cast<long>( LEDS - 1 ) );
+    check_written();
+
+    /*-------------------------------------------------------------------------
+    A point hanging off either end keeps only its share on the string
+    -------------------------------------------------------------------------*/
+    reset();
+    point( -Q16_ONE / 4, WHITE );
+    point( toQ16( LEDS - 1 ) + Q16_ONE / 4, WHITE );
+    CHECK( canvas()[ 0 ] == scaleColor( WHITE, 192 ) );
+    CHECK( canvas()[ LEDS - 1 ] == WHITE - scaleColor( WHITE, 64 ) );
+    CHECK( std::count( canvas(), canvas() + LEDS, 0u ) == static_cast<long>( LEDS - 2 ) );
+    check_written();
+
+    /*-------------------------------------------------------------------------
+    Entirely off the string draws and marks nothing
+    -------------------------------------------------------------------------*/
+    reset();
+    point( -toQ16( 2 ), WHITE );
+    point( toQ16( LEDS ), WHITE );
+    point( toQ16( LEDS ), WHITE, BLEND_REPLACE );
+    bar( -toQ16( 5 ), -Q16_ONE / 2, WHITE );
+    bar( toQ16( LEDS ), toQ16( LEDS + 3 ), WHITE );
+    fill( { LEDS, LEDS + 4 }, WHITE );
+    CHECK( std::count( canvas(), canvas() + LEDS, 0u ) == static_cast<long>( LEDS ) );
+    CHECK( std::count( s_dirty.begin(), s_dirty.end(), true ) == 0 );
+    check_written();
+
+    /*-------------------------------------------------------------------------
+    Fill sets whole LEDs, clamped to the string
+    -------------------------------------------------------------------------*/
+    reset( WHITE );
+    fill( { LEDS - 3, LEDS + 4 }, 0x00010203 );
+    CHECK( std::all_of( canvas() + LEDS - 3, canvas() + LEDS, []( uint32_t c ) { return c == 0x00010203; } ) );
+    CHECK( canvas()[ LEDS - 4 ] == WHITE );
+    check_written( WHITE );
+  }
+
+
+  /**
+   * @brief A band's edge lights an LED by how much of its footprint it covers
+   */
+  static void check_band()
+  {
+    const q16_t width = static_cast<q16_t>( Projection::footprint() << 8 );
+    const q16_t far   = toQ16( 2 * Projection::IMAGE_SIZE );
+
+    for( uint32_t led = 0; led < LEDS; led++ )
+    {
+      const q16_t center = static_cast<q16_t>( Projection::position( led ).x << 8 );
+      const q16_t left   = center - width / 2;
+
+      /*-----------------------------------------------------------------------
+      Right three quarters, then left quarter, of the footprint
+      -----------------------------------------------------------------------*/
+      reset();
+      band( AXIS_X, left + width / 4, far, WHITE );
+      CHECK( canvas()[ led ] == lerpColor( 0, WHITE, 192 ) );
+      check_written();
+
+      reset();
+      band( AXIS_X, -far, left + width / 4, WHITE );
+      CHECK( canvas()[ led ] == lerpColor( 0, WHITE, 64 ) );
+      check_written();
+
+      /*-----------------------------------------------------------------------
+      Sweeping the edge across the footprint dims the LED steadily to dark,
+      and leaves it alone once past
+      -----------------------------------------------------------------------*/
+      uint32_t previous = 256;
+      for( q16_t edge = left - width / 8; edge <= left + width + width / 8; edge += width / 32 )
+      {
+        reset();
+        band( AXIS_X, edge, far, WHITE );
+
+        const uint32_t level = channel( canvas()[ led ], 0 );
+        CHECK( level <= previous );
+        CHECK( ( edge > left ) || ( canvas()[ led ] == WHITE ) );
+        CHECK( ( edge < left + width ) || ( !s_dirty[ led ] && ( canvas()[ led ] == 0 ) ) );
+        previous = level;
+      }
+    }
+
+    /*-------------------------------------------------------------------------
+    An empty band draws nothing
+    -------------------------------------------------------------------------*/
+    reset();
+    band( AXIS_Y, far, -far, WHITE );
+    CHECK( std::count( s_dirty.begin(), s_dirty.end(), true ) == 0 );
+  }
+
+}    // namespace
+
+/*-----------------------------------------------------------------------------
+Stand-ins for the LED driver
+-----------------------------------------------------------------------------*/
+
+namespace LED
+{
+  uint32_t *getRenderBuffer()
+  {
+    return canvas();
+  }
+
+
+  void markDirty( const uint32_t first, const uint32_t count )
+  {
+    CHECK( first + count <= LEDS );
+    std::fill( s_dirty.begin() + first, s_dirty.begin() + std::min( first + count, LEDS ), true );
+  }
+}    // namespace LED
+
+
+int main()
+{
+  check_point_split();
+  check_blends();
+  check_gradient();
+  check_clipping();
+  check_band();
+
+  return Test::result( "draw" );
+}
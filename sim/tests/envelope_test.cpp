@@ -0,0 +1,286 @@
+/******************************************************************************
+ *  File Name:
+ *    envelope_test.cpp
+ *
+ *  Description:
+ *    Checks that an envelope's swing takes the time its rate asks for, no
+ *    matter how finely the frame loop slices it up, that it decays to idle,
+ *    retriggers from where it is and carries the part of a level it can't
+ *    step yet. Also times update() across banks of a few sizes.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "envelope.hpp"
+#include "test.hpp"
+#include <memory>
+
+using namespace Animator;
+
+namespace
+{
+  /*---------------------------------------------------------------------------
+  Aliases
+  ---------------------------------------------------------------------------*/
+
+  using Bank = EnvelopeBank<1>;
+
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr uint32_t DURATIONS_US[] = { 80'000, 900'000, 796'875, 6'375'000 };    // Swings used by the animations
+  static constexpr uint32_t STEPS_US[]     = { 50, 333, 1'000, 10'000, 16'667 };         // Update periods to slice them into
+  static constexpr uint64_t TIMEOUT_US     = 120'000'000;                                 // Give up on a swing that stalls
+  static constexpr uint32_t FRAME_US       = 10'000;                                      // Update period for the timing
+  static constexpr uint32_t TIMING_RUNS    = 20'000;                                      // Updates averaged for each bank size
+
+  /*---------------------------------------------------------------------------
+  Static Functions
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Time for one envelope to rise from dark to fully lit
+   *
+   * @param rate      Attack rate
+   * @param step_us   Time between updates
+   * @return uint64_t Time the attack ended, or TIMEOUT_US if it never did
+   */
+  static uint64_t attack_time( const uint16_t rate, const uint32_t step_us )
+  {
+    Bank bank;
+    bank.trigger( 0, rate, rate );
+
+    for( uint64_t now_us = step_us; now_us < TIMEOUT_US; now_us += step_us )
+    {
+      bank.update( step_us );
+      if( bank.phase( 0 ) != Bank::PHASE_ATTACK )
+      {
+        return now_us;
+      }
+    }
+
+    return TIMEOUT_US;
+  }
+
+
+
+  /**
+   * @brief Exact time a swing of `levels` takes at `rate`
+   */
+  static uint64_t swing_us( const uint32_t levels, const uint16_t rate )
+  {
+    return ( ( static_cast<uint64_t>( levels ) << 10 ) + rate - 1 ) / rate;
+  }
+
+
+  /**
+   * @brief Runs one envelope until it leaves `phase`
+   *
+   * @return uint64_t Time it left, or TIMEOUT_US if it never did
+   */
+  static uint64_t run_phase( Bank &bank, const Bank::Phase phase, const uint32_t step_us )
+  {
+    for( uint64_t now_us = step_us; now_us < TIMEOUT_US; now_us += step_us )
+    {
+      bank.update( step_us );
+      if( bank.phase( 0 ) != phase )
+      {
+        return now_us;
+      }
+    }
+
+    return TIMEOUT_US;
+  }
+
+
+  /**
+   * @brief A full cycle ends idle and dark, and stays there
+   */
+  static void check_decay_to_idle()
+  {
+    const uint16_t attack = Bank::rateFromUs( 80'000 );
+    const uint16_t decay  = Bank::rateFromUs( 900'000 );
+    const uint32_t step   = 1'000;
+
+    Bank bank;
+    bank.trigger( 0, attack, decay );
+
+    CHECK( run_phase( bank, Bank::PHASE_ATTACK, step ) < swing_us( Bank::LEVEL_MAX, attack ) + step );
+    CHECK( bank.phase( 0 ) == Bank::PHASE_DECAY );
+    CHECK( bank.level( 0 ) == Bank::LEVEL_MAX );
+
+    const uint64_t decay_us = run_phase( bank, Bank::PHASE_DECAY, step );
+    CHECK( decay_us >= swing_us( Bank::LEVEL_MAX, decay ) - step );
+    CHECK( decay_us < swing_us( Bank::LEVEL_MAX, decay ) + step );
+    CHECK( bank.idle( 0 ) );
+    CHECK( bank.level( 0 ) == 0 );
+
+    for( uint32_t n = 0; n < 100; n++ )
+    {
+      bank.update( Bank::MAX_DT_US );
+    }
+    CHECK( bank.idle( 0 ) );
+    CHECK( bank.level( 0 ) == 0 );
+  }
+
+
+  /**
+   * @brief A trigger part way down the decay rises again from that level
+   */
+  static void check_retrigger()
+  {
+    const uint16_t attack = Bank::rateFromUs( 80'000 );
+    const uint16_t decay  = Bank::rateFromUs( 900'000 );
+    const uint32_t step   = 1'000;
+
+    Bank bank;
+    bank.start( 0, Bank::LEVEL_MAX, Bank::PHASE_DECAY, attack, decay );
+    for( uint32_t n = 0; n < 300; n++ )
+    {
+      bank.update( step );
+    }
+
+    const uint16_t level = bank.level( 0 );
+    CHECK( bank.phase( 0 ) == Bank::PHASE_DECAY );
+    CHECK( ( level > 0 ) && ( level < Bank::LEVEL_MAX ) );
+
+    bank.trigger( 0, attack, decay );
+    CHECK( bank.phase( 0 ) == Bank::PHASE_ATTACK );
+    CHECK( bank.level( 0 ) == level );
+
+    const uint64_t rise_us = run_phase( bank, Bank::PHASE_ATTACK, step );
+    CHECK( rise_us >= swing_us( Bank::LEVEL_MAX - level, attack ) );
+    CHECK( rise_us < swing_us( Bank::LEVEL_MAX - level, attack ) + step );
+    CHECK( bank.phase( 0 ) == Bank::PHASE_DECAY );
+  }
+
+
+  /**
+   * @brief Steps too small to move a level still add up, to the exact level
+   */
+  static void check_remainder()
+  {
+    static constexpr uint16_t RATES[]    = { 1, 3, 7, 100, 1'000 };
+    static constexpr uint32_t STEPS_US[] = { 1, 7, 100, 1'023 };
+
+    for( const uint16_t rate : RATES )
+    {
+      for( const uint32_t step_us : STEPS_US )
+      {
+        Bank bank;
+        bank.start( 0, 0, Bank::PHASE_ATTACK, rate, rate );
+
+        for( uint64_t n = 1; n <= 2'000; n++ )
+        {
+          const uint64_t expected = ( rate * step_us * n ) >> 10;
+          if( expected >= Bank::LEVEL_MAX )
+          {
+            break;    // Turned around at the top
+          }
+
+          bank.update( step_us );
+          if( !CHECK( bank.level( 0 ) == expected ) )
+          {
+            return;
+          }
+        }
+      }
+    }
+
+    /*-------------------------------------------------------------------------
+    A trigger starts a fresh swing, without the remainder of the last one
+    -------------------------------------------------------------------------*/
+    Bank bank;
+    bank.start( 0, 0, Bank::PHASE_ATTACK, 1, 1 );
+    bank.update( 1'000 );
+    bank.trigger( 0, 1, 1 );
+    bank.update( 1'000 );
+    CHECK( bank.level( 0 ) == 0 );
+    bank.update( 24 );
+    CHECK( bank.level( 0 ) == 1 );
+  }
+
+
+  /**
+   * @brief Cost of one update() over a whole bank, every envelope moving
+   */
+  template<size_t COUNT>
+  static void time_update()
+  {
+    using Sized = EnvelopeBank<COUNT>;
+
+    std::unique_ptr<Sized> bank = std::make_unique<Sized>();
+    for( size_t i = 0; i < COUNT; i++ )
+    {
+      bank->start( i, static_cast<uint16_t>( i * 977 ), ( i & 1 ) ? Sized::PHASE_ATTACK : Sized::PHASE_DECAY,
+                   Sized::rateFromUs( 50'000 + 997 * i ), Sized::rateFromUs( 80'000 + 1'531 * i ) );
+    }
+
+    const double ns = Test::timeNs( TIMING_RUNS, [ & ]() {
+      bank->update( FRAME_US );
+      for( size_t i = 0; i < COUNT; i += 64 )
+      {
+        if( bank->idle( i ) )
+        {
+          bank->trigger( i, Sized::rateFromUs( 50'000 ), Sized::rateFromUs( 80'000 ) );
+        }
+      }
+    } );
+
+    printf( "update: %5zu envelopes, %8.0fns, %.2fns per envelope, %zu bytes\n", COUNT, ns, ns / COUNT, sizeof( Sized ) );
+  }
+
+}    // namespace
+
+
+int main()
+{
+  printf( "%10s %6s %12s", "swing", "rate", "exact" );
+  for( const uint32_t step_us : STEPS_US )
+  {
+    printf( " %8uus", step_us );
+  }
+  printf( "\n" );
+
+  for( const uint32_t duration_us : DURATIONS_US )
+  {
+    /*-------------------------------------------------------------------------
+    The rate is quantized, so the swing is held to the time that rate gives
+    rather than the time asked for. Slicing it up may only add the partial
+    update at the end.
+    -------------------------------------------------------------------------*/
+    const uint16_t rate     = Bank::rateFromUs( duration_us );
+    const uint64_t exact_us = ( ( static_cast<uint64_t>( Bank::LEVEL_MAX ) << 10 ) + rate - 1 ) / rate;
+
+    printf( "%8.3fs %6u %10.3fs", duration_us / 1e6, rate, exact_us / 1e6 );
+    for( const uint32_t step_us : STEPS_US )
+    {
+      const uint64_t actual_us = attack_time( rate, step_us );
+      printf( " %9.3fs", actual_us / 1e6 );
+
+      CHECK( actual_us >= exact_us );
+      CHECK( actual_us < exact_us + step_us );
+    }
+    printf( "\n" );
+  }
+
+  check_decay_to_idle();
+  check_retrigger();
+  check_remainder();
+
+  /*---------------------------------------------------------------------------
+  9 bytes of state per envelope: level, carried remainder, two rates and a
+  phase. SoftGlow adds a 4 byte color, for 13 bytes per LED.
+  ---------------------------------------------------------------------------*/
+  CHECK( sizeof( EnvelopeBank<32> ) == 9 * 32 );
+
+  time_update<32>();
+  time_update<512>();
+  time_update<4096>();
+
+  return Test::result( "envelope" );
+}
@@ -0,0 +1,60 @@
+#!/usr/bin/env python3
+"""
+Writes the WAV file the audio DSP test listens to.
+
+Three sections, each with a known right answer:
+
+  0-2s    Silence                  Every band dark, no beats
+  2-6s    80Hz kick at 120 BPM     Bass leads, one beat per kick
+  6-8s    Steady 2.5kHz tone       The band holding 2.5kHz leads, no beats
+
+It is 16-bit mono at 44.1kHz rather than the ADC rate, so the test's
+resampling is exercised the same way it is for a real recording.
+
+2024 | Brandon Braun | brandonbraun653@protonmail.com
+"""
+
+import argparse
+import math
+import struct
+import wave
+
+RATE_HZ = 44_100
+KICK_START_S = 2.0
+TONE_START_S = 6.0
+END_S = 8.0
+BEAT_PERIOD_S = 0.5
+KICK_DECAY_S = 0.12
+KICK_HZ = 80.0
+TONE_HZ = 2_500.0
+
+
+def sample(t):
+    if t < KICK_START_S:
+        return 0.0
+
+    if t < TONE_START_S:
+        phase = (t - KICK_START_S) % BEAT_PERIOD_S
+        return 0.6 * math.exp(-phase / KICK_DECAY_S) * math.sin(2.0 * math.pi * KICK_HZ * phase)
+
+    return 0.3 * math.sin(2.0 * math.pi * TONE_HZ * t)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--output", required=True, help="WAV file to write")
+    args = parser.parse_args()
+
+    frames = bytearray()
+    for i in range(int(END_S * RATE_HZ)):
+        frames += struct.pack("<h", int(sample(i / RATE_HZ) * 32767))
+
+    with wave.open(args.output, "wb") as f:
+        f.setnchannels(1)
+        f.setsampwidth(2)
+        f.setframerate(RATE_HZ)
+        f.writeframes(bytes(frames))
+
+
+if __name__ == "__main__":
+    main()
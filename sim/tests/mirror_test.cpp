@@ -0,0 +1,608 @@
+/******************************************************************************
+ *  File Name:
+ *    mirror_test.cpp
+ *
+ *  Description:
+ *    Streams frame sequences through the USB mirror and decodes them again
+ *    with a copy of tools/mirror_decode.py's decoder, checking every frame
+ *    that arrives bit for bit. Covers key frames, frames the producer drops
+ *    when the host falls behind, hosts leaving and rejoining mid-frame, and
+ *    capture() racing pump() on two threads. Also times the encode on the
+ *    host.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "mirror.hpp"
+#include "telemetry.hpp"
+#include "test.hpp"
+#include "tusb.h"
+#include "ws2812.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace Mirror;
+
+namespace
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr uint32_t LEDS          = LED::count();
+  static constexpr uint32_t COLOR_MASK    = 0x00FFFFFF;
+  static constexpr uint8_t  TOKEN_DATA    = 0x80;
+  static constexpr uint32_t RUN_MAX       = 128;
+  static constexpr uint32_t MAX_LEDS      = 4096;       // Largest string the decoder accepts
+  static constexpr uint32_t ROUND_FRAMES  = 20'000;     // Frames in the single threaded round trip
+  static constexpr uint32_t RACE_FRAMES   = 50'000;     // Frames captured while another thread pumps
+  static constexpr uint32_t TIMING_FRAMES = 100'000;    // Frames averaged for each encode timing
+
+  /*---------------------------------------------------------------------------
+  Enumerations
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief How much of the string changes from one frame to the next
+   */
+  enum Motion : uint8_t
+  {
+    MOTION_STILL,     // Nothing changes
+    MOTION_SPARSE,    // Each LED changes every 1 to 8 frames
+    MOTION_ALL,       // Every LED changes every frame
+  };
+
+  /*---------------------------------------------------------------------------
+  Structures
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Copy of frames() and decode_payload() from tools/mirror_decode.py
+   */
+  struct Decoder
+  {
+    std::vector<uint8_t>  buf;
+    std::vector<uint32_t> frame;
+    bool                  synced  = false;    // frame holds the host's picture
+    uint32_t              frames  = 0;
+    uint32_t              keys    = 0;
+    uint32_t              missed  = 0;        // Sequence gaps
+    uint32_t              skipped = 0;        // Bytes thrown away to resync
+    int32_t               last_sequence = -1;
+
+    static bool decode_payload( const uint8_t *payload, const size_t length, std::vector<uint32_t> &out )
+    {
+      size_t i   = 0;
+      size_t led = 0;
+      while( i < length )
+      {
+        const uint8_t token = payload[ i++ ];
+        const size_t  count = ( token & ( TOKEN_DATA - 1 ) ) + 1;
+        if( led + count > out.size() )
+        {
+          return false;
+        }
+
+        if( !( token & TOKEN_DATA ) )
+        {
+          led += count;
+          continue;
+        }
+
+        if( i + ( 3 * count ) > length )
+        {
+          return false;
+        }
+
+        for( size_t n = 0; n < count; n++ )
+        {
+          out[ led++ ] ^= ( payload[ i ] << 16 ) | ( payload[ i + 1 ] << 8 ) | payload[ i + 2 ];
+          i += 3;
+        }
+      }
+
+      return true;
+    }
+
+    /**
+     * @brief Adds bytes from the port, calling on_frame( header, frame ) for each frame that decodes
+     */
+    template<typename Fn>
+    void feed( const std::vector<uint8_t> &bytes, Fn &&on_frame )
+    {
+      static constexpr uint8_t MAGIC[ 2 ] = { MIRROR_MAGIC & 0xFF, MIRROR_MAGIC >> 8 };
+
+      buf.insert( buf.end(), bytes.begin(), bytes.end() );
+      while( true )
+      {
+        const auto start = std::search( buf.begin(), buf.end(), std::begin( MAGIC ), std::end( MAGIC ) );
+        if( start == buf.end() )
+        {
+          const size_t keep = ( !buf.empty() && ( buf.back() == MAGIC[ 0 ] ) ) ? 1 : 0;
+          if( buf.size() > keep )
+          {
+            skipped += buf.size() - keep;
+            synced = false;
+            buf.erase( buf.begin(), buf.end() - keep );
+          }
+          return;
+        }
+
+        if( start != buf.begin() )
+        {
+          skipped += start - buf.begin();
+          synced = false;
+          buf.erase( buf.begin(), start );
+        }
+        if( buf.size() < sizeof( Header ) )
+        {
+          return;
+        }
+
+        Header header;
+        memcpy( &header, buf.data(), sizeof( header ) );
+        if( ( header.reserved != 0 ) || ( header.leds == 0 ) || ( header.leds > MAX_LEDS ) ||
+            ( header.length > ( 3 * header.leds ) + ( ( header.leds + RUN_MAX - 1 ) / RUN_MAX ) ) )
+        {
+          skipped++;
+          synced = false;
+          buf.erase( buf.begin() );
+          continue;
+        }
+
+        const size_t size = sizeof( Header ) + header.length;
+        if( buf.size() < size )
+        {
+          return;
+        }
+
+        std::vector<uint32_t> candidate;
+        bool                  have = true;
+        if( header.flags & FLAG_KEY )
+        {
+          candidate.assign( header.leds, 0 );
+        }
+        else if( synced && ( frame.size() == header.leds ) )
+        {
+          candidate = frame;
+        }
+        else
+        {
+          have = false;    // Joined mid-stream, wait for a key frame
+        }
+
+        if( have && !decode_payload( buf.data() + sizeof( Header ), header.length, candidate ) )
+        {
+          skipped++;
+          synced = false;
+          buf.erase( buf.begin() );
+          continue;
+        }
+
+        buf.erase( buf.begin(), buf.begin() + size );
+        if( last_sequence >= 0 )
+        {
+          missed += ( header.sequence - last_sequence - 1 ) & 0xFFFF;
+        }
+        last_sequence = header.sequence;
+        frames++;
+        keys += ( header.flags & FLAG_KEY ) ? 1 : 0;
+
+        if( have )
+        {
+          frame  = candidate;
+          synced = true;
+          on_frame( header, frame );
+        }
+      }
+    }
+  };
+
+  /*---------------------------------------------------------------------------
+  Static Data
+  ---------------------------------------------------------------------------*/
+
+  static std::atomic<bool>                  s_connected;    // A host has the port open
+  static std::atomic<uint32_t>              s_room;         // Bytes the port takes per pump
+  static std::vector<uint8_t>               s_wire;         // What the port took, consumer thread only
+  static std::vector<std::vector<uint32_t>> s_history;      // Frame captured under each sequence number
+  static uint16_t                           s_sequence;     // Mirror's sequence number for the last capture
+
+  /*---------------------------------------------------------------------------
+  Static Functions
+  ---------------------------------------------------------------------------*/
+
+  static uint32_t hash( uint32_t x )
+  {
+    x ^= x >> 16;
+    x *= 0x7FEB352D;
+    x ^= x >> 15;
+    x *= 0x846CA68B;
+    return x ^ ( x >> 16 );
+  }
+
+
+  /**
+   * @brief Draws frame number n, records it under its sequence number, and captures it
+   *
+   * The top byte is noise the mirror must not send.
+   */
+  static void capture_frame( const uint32_t n, const Motion motion )
+  {
+    std::vector<uint32_t> &frame = s_history[ ++s_sequence ];
+    for( uint32_t i = 0; i < LEDS; i++ )
+    {
+      const uint32_t period = ( motion == MOTION_ALL ) ? 1 : ( ( i * 5 ) % 8 ) + 1;
+      const uint32_t step   = ( motion == MOTION_STILL ) ? 0 : ( n / period );
+
+      frame[ i ] = ( hash( ( i << 20 ) ^ step ) & COLOR_MASK ) | ( hash( n ) << 24 );
+    }
+
+    capture( frame.data() );
+  }
+
+
+  /**
+   * @brief Pumps until the port has taken everything queued
+   */
+  static void drain()
+  {
+    size_t before;
+    do
+    {
+      before = s_wire.size();
+      pump();
+    } while( s_wire.size() != before );
+  }
+
+
+  /**
+   * @brief Decodes what the port took and checks every frame against what was captured
+   *
+   * @return uint32_t   Frames that decoded
+   */
+  static uint32_t check_wire( Decoder &decoder )
+  {
+    uint32_t decoded = 0;
+    decoder.feed( s_wire, [ & ]( const Header &header, const std::vector<uint32_t> &frame ) {
+      const std::vector<uint32_t> &sent = s_history[ header.sequence ];
+
+      CHECK( header.leds == LEDS );
+      CHECK( std::equal( frame.begin(), frame.end(), sent.begin(),
+                         []( uint32_t a, uint32_t b ) { return a == ( b & COLOR_MASK ); } ) );
+      decoded++;
+    } );
+
+    s_wire.clear();
+    return decoded;
+  }
+
+
+  /**
+   * @brief Random frames and a random port rate, with drops and key frames along the way
+   */
+  static void check_round_trip( std::mt19937 &rng )
+  {
+    const Stats before = getStats();
+    Decoder     decoder;
+
+    s_connected = true;
+    pump();    // Opens the port, and waits there for a key frame
+
+    uint32_t since_key = 0;
+    uint32_t decoded   = 0;
+    for( uint32_t n = 0; n < ROUND_FRAMES; n++ )
+    {
+      capture_frame( n, static_cast<Motion>( rng() % 3 ) );
+
+      s_room = ( rng() % 4 == 0 ) ? 0 : ( rng() % 200 );
+      pump();
+
+      decoder.feed( s_wire, [ & ]( const Header &header, const std::vector<uint32_t> &frame ) {
+        const std::vector<uint32_t> &sent = s_history[ header.sequence ];
+        CHECK( std::equal( frame.begin(), frame.end(), sent.begin(),
+                           []( uint32_t a, uint32_t b ) { return a == ( b & COLOR_MASK ); } ) );
+
+        since_key = ( header.flags & FLAG_KEY ) ? 0 : ( since_key + 1 );
+        CHECK( since_key <= KEY_INTERVAL );
+        decoded++;
+      } );
+      s_wire.clear();
+    }
+
+    s_room = UINT32_MAX;
+    drain();
+    decoded += check_wire( decoder );
+
+    const Stats after   = getStats();
+    const uint32_t sent    = after.frames_sent - before.frames_sent;
+    const uint32_t dropped = after.frames_dropped - before.frames_dropped;
+
+    printf( "round trip: %u frames, %u sent (%u key), %u dropped\n", ROUND_FRAMES, sent, decoder.keys, dropped );
+    CHECK( sent + dropped == ROUND_FRAMES );
+    CHECK( decoded == sent );
+    CHECK( decoder.missed == dropped );
+    CHECK( dropped > 0 );
+    CHECK( decoder.keys > ROUND_FRAMES / ( KEY_INTERVAL + 1 ) / 2 );
+    CHECK( decoder.skipped == 0 );
+  }
+
+
+  /**
+   * @brief A frame dropped when the queue is full leaves the next one coded against the last one sent
+   */
+  static void check_dropped_frame()
+  {
+    Decoder decoder;
+    s_room = UINT32_MAX;
+    drain();
+    s_wire.clear();
+
+    s_connected = false;    // A new host, so the stream starts on a key frame
+    pump();
+    s_connected = true;
+    pump();
+
+    const Stats before = getStats();
+    uint32_t    n      = 0;
+    while( getStats().frames_dropped == before.frames_dropped )
+    {
+      capture_frame( n++, MOTION_ALL );
+    }
+
+    capture_frame( n++, MOTION_SPARSE );    // Dropped too, the queue is still full
+    drain();
+    capture_frame( n++, MOTION_SPARSE );    // Sent, against the last frame that got through
+    drain();
+
+    const uint32_t decoded = check_wire( decoder );
+    CHECK( getStats().frames_dropped - before.frames_dropped == 2 );
+    CHECK( decoded == n - 2 );
+    CHECK( decoder.missed == 2 );
+    CHECK( decoder.skipped == 0 );
+  }
+
+
+  /**
+   * @brief A host that leaves partway through a frame, and one that joins after, gets a clean stream from a key frame
+   */
+  static void check_rejoin()
+  {
+    s_room = UINT32_MAX;
+    drain();
+    s_wire.clear();
+
+    for( uint32_t n = 0; n < 5; n++ )
+    {
+      capture_frame( n, MOTION_ALL );
+    }
+
+    s_room = sizeof( Header ) + 7;    // Cut off inside the first frame
+    pump();
+    s_wire.clear();
+
+    s_connected = false;
+    pump();
+    capture_frame( 0, MOTION_ALL );    // Nobody listening, not queued
+
+    s_connected = true;
+    s_room      = UINT32_MAX;
+    pump();
+    CHECK( s_wire.empty() );    // Nothing stale goes to the new host
+
+    capture_frame( 1, MOTION_SPARSE );
+    capture_frame( 2, MOTION_SPARSE );
+    drain();
+
+    CHECK( s_wire.size() > sizeof( Header ) );
+    CHECK( ( s_wire[ 0 ] | ( s_wire[ 1 ] << 8 ) ) == MIRROR_MAGIC );
+    CHECK( s_wire[ 4 ] & FLAG_KEY );
+
+    Decoder decoder;
+    CHECK( check_wire( decoder ) == 2 );
+    CHECK( decoder.keys == 1 );
+    CHECK( decoder.skipped == 0 );
+  }
+
+
+  /**
+   * @brief capture() on one thread while pump() runs on another and the host comes and goes
+   */
+  static void check_race()
+  {
+    std::atomic<bool> done( false );
+    std::mt19937      rng( 0x52414345 );
+
+    s_connected = false;    // The first host is new too
+    pump();
+    s_wire.clear();
+    s_connected = true;
+
+    std::thread core0( [ & ]() {
+      for( uint32_t n = 0; n < RACE_FRAMES; n++ )
+      {
+        capture_frame( n, ( n % 3 ) ? MOTION_SPARSE : MOTION_ALL );
+        std::this_thread::yield();
+      }
+      done = true;
+    } );
+
+    uint32_t connections = 0;
+    uint32_t decoded     = 0;
+    bool     joined      = true;    // Nothing has reached this host yet
+    Decoder  decoder;
+
+    while( !done )
+    {
+      if( rng() % 64 == 0 )
+      {
+        /*---------------------------------------------------------------------
+        The host leaves, maybe mid-frame, and a new one joins. Its stream has
+        to start on a key frame.
+        ---------------------------------------------------------------------*/
+        s_connected = false;
+        pump();
+        s_wire.clear();
+        s_connected = true;
+
+        CHECK( decoder.skipped == 0 );
+        decoder = Decoder();
+        joined  = true;
+        connections++;
+      }
+
+      s_room = rng() % 300;
+      pump();
+
+      if( s_wire.size() >= sizeof( Header ) )
+      {
+        if( joined )
+        {
+          CHECK( ( s_wire[ 0 ] | ( s_wire[ 1 ] << 8 ) ) == MIRROR_MAGIC );
+          CHECK( s_wire[ 4 ] & FLAG_KEY );
+          joined = false;
+        }
+
+        decoded += check_wire( decoder );
+      }
+      std::this_thread::yield();
+    }
+
+    core0.join();
+    s_room = UINT32_MAX;
+    drain();
+    decoded += check_wire( decoder );
+
+    printf( "race: %u frames captured, %u decoded over %u connections\n", RACE_FRAMES, decoded, connections + 1 );
+    CHECK( decoder.skipped == 0 );
+    CHECK( decoded > 0 );
+  }
+
+
+  /**
+   * @brief Encode cost per frame, from the cycles the mirror puts in each header
+   *
+   * The worst case on a host is whatever the scheduler did, so the 99th
+   * percentile is reported instead.
+   */
+  static void time_encode( const char *const name, const Motion motion )
+  {
+    Decoder               decoder;
+    std::vector<uint32_t> costs;
+
+    s_room = UINT32_MAX;
+    drain();
+    s_wire.clear();
+
+    const Stats before = getStats();
+    for( uint32_t n = 0; n < TIMING_FRAMES; n++ )
+    {
+      capture_frame( n, motion );
+      drain();
+
+      decoder.feed( s_wire, [ & ]( const Header &header, const std::vector<uint32_t> & ) {
+        costs.push_back( header.encode_cycles );
+      } );
+      s_wire.clear();
+    }
+
+    const Stats after = getStats();
+    CHECK( decoder.frames == TIMING_FRAMES );    // The ones before the first key frame aren't decoded
+    CHECK( decoder.skipped == 0 );
+
+    std::sort( costs.begin(), costs.end() );
+    printf( "encode %-6s %4uns median, %4uns p99, %5.1f bytes per frame\n", name, costs[ costs.size() / 2 ],
+            costs[ ( costs.size() * 99 ) / 100 ],
+            static_cast<double>( after.bytes_sent - before.bytes_sent ) / ( after.frames_sent - before.frames_sent ) );
+  }
+
+}    // namespace
+
+/*-----------------------------------------------------------------------------
+Stand-ins for TinyUSB and the cycle counter. Host nanoseconds stand in for
+cycles, so the encode cost in each header is in ns.
+-----------------------------------------------------------------------------*/
+
+bool tusb_init( void )
+{
+  return true;
+}
+
+
+void tud_task( void )
+{
+}
+
+
+bool tud_cdc_connected( void )
+{
+  return s_connected;
+}
+
+
+uint32_t tud_cdc_write_available( void )
+{
+  return s_room;
+}
+
+
+uint32_t tud_cdc_write( const void *buffer, uint32_t bufsize )
+{
+  const uint8_t *const bytes = static_cast<const uint8_t *>( buffer );
+  s_wire.insert( s_wire.end(), bytes, bytes + bufsize );
+  return bufsize;
+}
+
+
+uint32_t tud_cdc_write_flush( void )
+{
+  return 0;
+}
+
+
+namespace Telemetry
+{
+  uint32_t cycles()
+  {
+    return static_cast<uint32_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count() );
+  }
+
+
+  uint32_t cyclesSince( const uint32_t start )
+  {
+    return cycles() - start;
+  }
+}    // namespace Telemetry
+
+
+int main()
+{
+  std::mt19937 rng( 0x4D495252 );
+  s_history.assign( UINT16_MAX + 1, std::vector<uint32_t>( LEDS ) );
+
+  /*---------------------------------------------------------------------------
+  Nothing is coded or queued until a host opens the port
+  ---------------------------------------------------------------------------*/
+  capture_frame( 0, MOTION_ALL );
+  CHECK( getStats().frames_sent == 0 );
+
+  check_round_trip( rng );
+  check_dropped_frame();
+  check_rejoin();
+  check_race();
+
+  time_encode( "still", MOTION_STILL );
+  time_encode( "sparse", MOTION_SPARSE );
+  time_encode( "all", MOTION_ALL );
+
+  return Test::result( "mirror" );
+}
@@ -0,0 +1,290 @@
+/******************************************************************************
+ *  File Name:
+ *    noise_test.cpp
+ *
+ *  Description:
+ *    Samples each noise function densely and checks its range, continuity
+ *    and lattice values. The Perlin output gains are derived here from the
+ *    samples, so a change that clips or dims the noise fails the test. Also
+ *    times one sample of each function on the host.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "noise.hpp"
+#include "test.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <numeric>
+#include <vector>
+
+using namespace Noise;
+
+namespace
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr uint32_t PERIOD      = 256 * CELL;    // Noise repeats after this many cells
+  static constexpr uint32_t FINE_STEP   = CELL >> 12;    // Smallest step the noise resolves
+  static constexpr double   CLIP_LIMIT  = 1e-4;          // Largest share of samples a gain may clip
+  static constexpr double   RANGE_FILL  = 0.9;           // Share of each half of the range the noise must reach
+  static constexpr int32_t  MAX_DELTA   = 64;            // Largest Perlin change over one FINE_STEP
+  static constexpr uint32_t MAX_GAIN    = 32;            // Largest gain considered
+  static constexpr uint32_t TIMING_RUNS = 1'000'000;     // Samples averaged for each timing
+
+  /*---------------------------------------------------------------------------
+  Structures
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief How often each output value came up
+   */
+  struct Histogram
+  {
+    std::vector<uint64_t> counts = std::vector<uint64_t>( 65536 );
+    uint64_t              total  = 0;
+
+    void add( const int16_t value )
+    {
+      counts[ static_cast<uint16_t>( value ) ]++;
+      total++;
+    }
+
+    uint64_t count( const int32_t value ) const
+    {
+      return counts[ static_cast<uint16_t>( value ) ];
+    }
+  };
+
+  /*---------------------------------------------------------------------------
+  Static Functions
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Gain the output was scaled by, the GCD of every value that wasn't clamped
+   */
+  static uint32_t applied_gain( const Histogram &histogram )
+  {
+    uint32_t gain = 0;
+    for( int32_t value = INT16_MIN + 1; value < INT16_MAX; value++ )
+    {
+      if( histogram.count( value ) )
+      {
+        gain = std::gcd( gain, static_cast<uint32_t>( std::abs( value ) ) );
+      }
+    }
+
+    return gain;
+  }
+
+
+  /**
+   * @brief Largest gain that clips no more than CLIP_LIMIT of the samples
+   *
+   * Works back to the raw noise from the output. Samples clamped at the
+   * applied gain are counted as clipped at every gain, which is exact for
+   * the applied gain and anything above it.
+   *
+   * @param histogram   Output of the noise function
+   * @param applied     Gain the output was scaled by
+   * @return uint32_t
+   */
+  static uint32_t best_gain( const Histogram &histogram, const uint32_t applied )
+  {
+    uint32_t best = 0;
+    for( int32_t gain = 1; gain <= static_cast<int32_t>( MAX_GAIN ); gain++ )
+    {
+      uint64_t clipped = histogram.count( INT16_MIN ) + histogram.count( INT16_MAX );
+      for( int32_t value = INT16_MIN + 1; value < INT16_MAX; value++ )
+      {
+        const int32_t raw = value / static_cast<int32_t>( applied );
+        if( ( raw * gain > INT16_MAX ) || ( raw * gain < INT16_MIN ) )
+        {
+          clipped += histogram.count( value );
+        }
+      }
+
+      if( clipped <= histogram.total * CLIP_LIMIT )
+      {
+        best = gain;
+      }
+    }
+
+    return best;
+  }
+
+
+  /**
+   * @brief Checks one Perlin dimension's range and gain
+   */
+  static void check_perlin_range( const char *const name, const Histogram &histogram )
+  {
+    int32_t lowest  = INT16_MAX;
+    int32_t highest = INT16_MIN;
+    for( int32_t value = INT16_MIN; value <= INT16_MAX; value++ )
+    {
+      if( histogram.count( value ) )
+      {
+        lowest  = std::min( lowest, value );
+        highest = std::max( highest, value );
+      }
+    }
+
+    const uint32_t gain = applied_gain( histogram );
+    const uint32_t best = best_gain( histogram, gain );
+    const double   clip = static_cast<double>( histogram.count( INT16_MIN ) + histogram.count( INT16_MAX ) ) / histogram.total;
+
+    printf( "%s: %llu samples, %d to %d, gain %u (best %u), %.1e at the rails\n", name,
+            static_cast<unsigned long long>( histogram.total ), lowest, highest, gain, best, clip );
+
+    CHECK( highest >= RANGE_FILL * INT16_MAX );
+    CHECK( lowest <= RANGE_FILL * INT16_MIN );
+    CHECK( gain == best );
+  }
+
+
+  /**
+   * @brief Largest change between neighbouring samples along x, cell edges included
+   */
+  template<typename Fn>
+  static int32_t max_delta( Fn &&fn, const uint32_t y )
+  {
+    int32_t worst = 0;
+    int32_t prev  = fn( 0, y );
+
+    for( uint32_t x = FINE_STEP; x < 16 * CELL; x += FINE_STEP )
+    {
+      const int32_t next = fn( x, y );
+      worst              = std::max( worst, std::abs( next - prev ) );
+      prev               = next;
+    }
+
+    return worst;
+  }
+
+
+  template<typename Fn>
+  static double time_samples( Fn &&fn )
+  {
+    volatile int32_t sink  = 0;
+    uint32_t         coord = 0;
+
+    return Test::timeNs( TIMING_RUNS, [ & ]() {
+      coord += 0x1234;
+      sink = sink + fn( coord );
+    } );
+  }
+
+}    // namespace
+
+
+int main()
+{
+  /*---------------------------------------------------------------------------
+  Range and gain. 1D is sampled at every position it resolves, 2D on a
+  16 x 16 grid in every cell, and 3D on a 4 x 4 x 4 grid in a quarter of the
+  cells along each axis.
+  ---------------------------------------------------------------------------*/
+  Histogram p1, p2, p3;
+
+  for( uint32_t x = 0; x < PERIOD; x += FINE_STEP )
+  {
+    p1.add( perlin1( x ) );
+  }
+
+  for( uint32_t y = 0; y < PERIOD; y += CELL / 16 )
+  {
+    for( uint32_t x = 0; x < PERIOD; x += CELL / 16 )
+    {
+      p2.add( perlin2( x, y ) );
+    }
+  }
+
+  for( uint32_t z = 0; z < PERIOD / 4; z += CELL / 4 )
+  {
+    for( uint32_t y = 0; y < PERIOD / 4; y += CELL / 4 )
+    {
+      for( uint32_t x = 0; x < PERIOD / 4; x += CELL / 4 )
+      {
+        p3.add( perlin3( x, y, z ) );
+      }
+    }
+  }
+
+  check_perlin_range( "perlin1", p1 );
+  check_perlin_range( "perlin2", p2 );
+  check_perlin_range( "perlin3", p3 );
+
+  /*---------------------------------------------------------------------------
+  Value noise passes through the lattice bytes, so it spans them exactly
+  ---------------------------------------------------------------------------*/
+  uint8_t lowest  = UINT8_MAX;
+  uint8_t highest = 0;
+  for( uint32_t i = 0; i < 256; i++ )
+  {
+    lowest  = std::min( { lowest, value1( i * CELL ), value2( i * CELL, 0 ), value3( 0, 0, i * CELL ) } );
+    highest = std::max( { highest, value1( i * CELL ), value2( i * CELL, 0 ), value3( 0, 0, i * CELL ) } );
+  }
+  CHECK( lowest == 0 );
+  CHECK( highest == UINT8_MAX );
+
+  /*---------------------------------------------------------------------------
+  Continuity, so nothing jumps across a cell edge
+  ---------------------------------------------------------------------------*/
+  int32_t perlin_delta = 0;
+  int32_t value_delta  = 0;
+  for( uint32_t y = 0; y < 8 * CELL; y += 4099 )
+  {
+    perlin_delta = std::max( { perlin_delta, max_delta( []( uint32_t x, uint32_t ) { return perlin1( x ); }, y ),
+                               max_delta( []( uint32_t x, uint32_t y ) { return perlin2( x, y ); }, y ),
+                               max_delta( []( uint32_t x, uint32_t y ) { return perlin3( x, y, 3 * y ); }, y ) } );
+    value_delta  = std::max( { value_delta, max_delta( []( uint32_t x, uint32_t ) { return value1( x ); }, y ),
+                               max_delta( []( uint32_t x, uint32_t y ) { return value2( x, y ); }, y ),
+                               max_delta( []( uint32_t x, uint32_t y ) { return value3( x, y, 3 * y ); }, y ) } );
+  }
+
+  printf( "largest step of 1/4096 cell: perlin %d, value %d\n", perlin_delta, value_delta );
+  CHECK( perlin_delta <= MAX_DELTA );
+  CHECK( value_delta <= 1 );
+
+  /*---------------------------------------------------------------------------
+  Lattice values come from the fixed permutation, and the noise repeats
+  ---------------------------------------------------------------------------*/
+  static constexpr uint8_t PERM_START[] = { 151, 160, 137, 91, 90, 15, 131, 13 };
+  for( uint32_t i = 0; i < sizeof( PERM_START ); i++ )
+  {
+    CHECK( value1( i * CELL ) == PERM_START[ i ] );
+    CHECK( perlin1( i * CELL ) == 0 );
+    CHECK( perlin2( i * CELL, 5 * CELL ) == 0 );
+    CHECK( perlin3( i * CELL, 5 * CELL, 9 * CELL ) == 0 );
+  }
+
+  CHECK( value2( 0, 0 ) == 17 );
+  CHECK( value3( 0, 0, 0 ) == 36 );
+  CHECK( perlin1( CELL / 2 ) == 14336 );
+  CHECK( perlin2( CELL / 2, CELL / 2 ) == -18432 );
+  CHECK( perlin3( CELL / 2, CELL / 2, CELL / 2 ) == -9216 );
+
+  for( uint32_t x = 0x3A5C; x < 4 * CELL; x += 0x2F01 )
+  {
+    CHECK( perlin2( x, 7 * x ) == perlin2( x + PERIOD, 7 * x + PERIOD ) );
+    CHECK( value3( x, 3 * x, 5 * x ) == value3( x + PERIOD, 3 * x, 5 * x + PERIOD ) );
+  }
+
+  /*---------------------------------------------------------------------------
+  Cost of one sample
+  ---------------------------------------------------------------------------*/
+  printf( "value1 %.1fns, value2 %.1fns, value3 %.1fns\n", time_samples( []( uint32_t c ) { return value1( c ); } ),
+          time_samples( []( uint32_t c ) { return value2( c, c * 3 ); } ),
+          time_samples( []( uint32_t c ) { return value3( c, c * 3, c * 5 ); } ) );
+  printf( "perlin1 %.1fns, perlin2 %.1fns, perlin3 %.1fns\n", time_samples( []( uint32_t c ) { return perlin1( c ); } ),
+          time_samples( []( uint32_t c ) { return perlin2( c, c * 3 ); } ),
+          time_samples( []( uint32_t c ) { return perlin3( c, c * 3, c * 5 ); } ) );
+
+  return Test::result( "noise" );
+}
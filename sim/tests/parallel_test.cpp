@@ -0,0 +1,266 @@
+/******************************************************************************
+ *  File Name:
+ *    parallel_test.cpp
+ *
+ *  Description:
+ *    Runs the frame kernel, envelope update, render and post-process, through
+ *    Parallel::forEach() with a thread standing in for core1, and checks the
+ *    split frame matches the serial one. Then reports what each string length
+ *    costs serially against the longer of the two halves a split leaves on
+ *    each core. Those are host times, not RP2040 cycles.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "envelope.hpp"
+#include "parallel.hpp"
+#include "pico/multicore.h"
+#include "post_process.hpp"
+#include "test.hpp"
+#include "ws2812.hpp"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace Animator;
+
+namespace
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr uint32_t MAX_LEDS      = 1'000;     // Longest string checked
+  static constexpr uint32_t FRAME_DT_US   = 10'000;    // Time between frames
+  static constexpr uint32_t CHECK_FRAMES  = 200;       // Frames compared between the split and serial runs
+  static constexpr uint32_t TIMING_FRAMES = 20'000;    // Frames averaged for each timing
+
+  static constexpr uint32_t COUNTS[] = { 2 * Parallel::MIN_SPLIT - 1,
+                                         2 * Parallel::MIN_SPLIT,
+                                         LED::count(),
+                                         64,
+                                         128,
+                                         300,
+                                         MAX_LEDS };
+
+  /*---------------------------------------------------------------------------
+  Aliases
+  ---------------------------------------------------------------------------*/
+
+  using Bank = EnvelopeBank<MAX_LEDS>;
+
+  /*---------------------------------------------------------------------------
+  Structures
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Everything one frame reads and writes, laid out as the animator has it
+   */
+  struct Frame
+  {
+    Bank                  envelopes;
+    PostProcess           post_process;
+    std::vector<uint32_t> colors;
+    std::vector<uint32_t> canvas;
+    std::vector<uint32_t> back;
+
+    Frame() : colors( MAX_LEDS ), canvas( MAX_LEDS ), back( MAX_LEDS )
+    {
+      envelopes.clear();
+      for( uint32_t i = 0; i < MAX_LEDS; i++ )
+      {
+        colors[ i ] = ( i * 0x9E3779B1u ) & LED::WS2812_DATA_MSK;
+        envelopes.trigger( i, Bank::rateFromUs( 50'000 + 997 * i ), Bank::rateFromUs( 80'000 + 1'531 * i ) );
+      }
+
+      if constexpr( !LED::HARDWARE_BRIGHTNESS )
+      {
+        post_process.stage<BrightnessStage>().scale = 200;
+      }
+    }
+
+    /**
+     * @brief Draws and post-processes [first, end), as present_frame() does for SoftGlow
+     */
+    void run( const uint32_t first, const uint32_t end )
+    {
+      envelopes.update( FRAME_DT_US, first, end );
+      envelopes.render( colors.data(), canvas.data(), first, end );
+      post_process.run( canvas.data(), back.data(), { first, end } );
+    }
+  };
+
+  /*---------------------------------------------------------------------------
+  Static Data
+  ---------------------------------------------------------------------------*/
+
+  static std::atomic<uint32_t> s_to_core1;    // One word FIFO from core0, 0 when empty
+  static std::atomic<uint32_t> s_to_core0;    // One word FIFO from core1, 0 when empty
+  static thread_local bool     s_on_core1;    // Set on the thread standing in for core1
+
+  /*---------------------------------------------------------------------------
+  Static Functions
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief One word FIFOs like the SIO's. A word is never 0, so 0 marks an empty slot.
+   */
+  static void fifo_push( std::atomic<uint32_t> &fifo, const uint32_t data )
+  {
+    uint32_t empty = 0;
+    while( !fifo.compare_exchange_weak( empty, data, std::memory_order_release ) )
+    {
+      empty = 0;
+      std::this_thread::yield();
+    }
+  }
+
+
+  static uint32_t fifo_pop( std::atomic<uint32_t> &fifo )
+  {
+    uint32_t data;
+    while( ( data = fifo.exchange( 0, std::memory_order_acquire ) ) == 0 )
+    {
+      std::this_thread::yield();
+    }
+
+    return data;
+  }
+
+
+  /**
+   * @brief Runs a split frame and a serial frame side by side and compares them
+   *
+   * @param count   Length of the string
+   */
+  static void check_split( const uint32_t count )
+  {
+    Frame    split;
+    Frame    serial;
+    uint32_t core1_first = count;
+    uint32_t core1_end   = count;
+
+    for( uint32_t n = 0; n < CHECK_FRAMES; n++ )
+    {
+      Parallel::forEach( count, [ & ]( const uint32_t first, const uint32_t end ) {
+        if( s_on_core1 )
+        {
+          core1_first = first;
+          core1_end   = end;
+        }
+        split.run( first, end );
+      } );
+      serial.run( 0, count );
+
+      CHECK( std::equal( split.back.begin(), split.back.begin() + count, serial.back.begin() ) );
+    }
+
+    /*-------------------------------------------------------------------------
+    Core1 takes the upper half once it is running and the string is long
+    enough to split
+    -------------------------------------------------------------------------*/
+    if( Parallel::workerReady() && ( count >= 2 * Parallel::MIN_SPLIT ) )
+    {
+      CHECK( core1_first == count / 2 );
+      CHECK( core1_end == count );
+    }
+    else
+    {
+      CHECK( core1_first == count );
+    }
+  }
+
+}    // namespace
+
+/*-----------------------------------------------------------------------------
+Stand-ins for the SDK
+-----------------------------------------------------------------------------*/
+
+void multicore_fifo_push_blocking( uint32_t data )
+{
+  fifo_push( s_on_core1 ? s_to_core0 : s_to_core1, data );
+}
+
+
+uint32_t multicore_fifo_pop_blocking()
+{
+  return fifo_pop( s_on_core1 ? s_to_core1 : s_to_core0 );
+}
+
+
+int main()
+{
+  /*---------------------------------------------------------------------------
+  The shipping string has to split, or the worker never does anything
+  ---------------------------------------------------------------------------*/
+  CHECK( LED::count() >= 2 * Parallel::MIN_SPLIT );
+
+  /*---------------------------------------------------------------------------
+  Without the worker everything stays on the calling core
+  ---------------------------------------------------------------------------*/
+  CHECK( !Parallel::workerReady() );
+  check_split( MAX_LEDS );
+
+  /*---------------------------------------------------------------------------
+  Start core1. It never returns, so it is left running until the test exits.
+  ---------------------------------------------------------------------------*/
+  std::thread core1( []() {
+    s_on_core1 = true;
+    Parallel::workerEntry();
+  } );
+  core1.detach();
+
+  while( !Parallel::workerReady() )
+  {
+    std::this_thread::yield();
+  }
+
+  for( const uint32_t count : COUNTS )
+  {
+    check_split( count );
+  }
+
+  /*---------------------------------------------------------------------------
+  Serial frame against the longer half of a split one. A split frame costs
+  that half plus one FIFO round trip, so the difference is what the round
+  trip has to beat. The split itself is only timed with a spare host CPU for
+  the worker, since on one CPU every hand off is a context switch.
+  ---------------------------------------------------------------------------*/
+  const bool two_cpus = std::thread::hardware_concurrency() >= 2;
+
+  printf( "%6s %12s %12s %12s %12s\n", "LEDs", "serial", "longer half", "saved", "split" );
+  for( const uint32_t count : COUNTS )
+  {
+    Frame          frame;
+    const uint32_t half = count / 2;
+
+    const double serial_ns = Test::timeNs( TIMING_FRAMES, [ & ]() { frame.run( 0, count ); } );
+    const double lower_ns  = Test::timeNs( TIMING_FRAMES, [ & ]() { frame.run( 0, half ); } );
+    const double upper_ns  = Test::timeNs( TIMING_FRAMES, [ & ]() { frame.run( half, count ); } );
+    const double half_ns   = std::max( lower_ns, upper_ns );
+
+    printf( "%6u %10.0fns %10.0fns %10.0fns", count, serial_ns, half_ns, serial_ns - half_ns );
+    if( two_cpus )
+    {
+      const double split_ns = Test::timeNs( TIMING_FRAMES, [ & ]() {
+        Parallel::forEach( count, [ & ]( const uint32_t first, const uint32_t end ) { frame.run( first, end ); } );
+      } );
+      printf( " %10.0fns\n", split_ns );
+    }
+    else
+    {
+      printf( " %12s\n", "-" );
+    }
+  }
+
+  if( !two_cpus )
+  {
+    printf( "split not timed: the host has one CPU\n" );
+  }
+
+  return Test::result( "parallel" );
+}
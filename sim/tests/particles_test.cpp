@@ -0,0 +1,221 @@
+/******************************************************************************
+ *  File Name:
+ *    particles_test.cpp
+ *
+ *  Description:
+ *    Checks the particle pool's bookkeeping and the colors it draws, and
+ *    times a Sparks sized pool on the host.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "particles.hpp"
+#include "test.hpp"
+#include "ws2812.hpp"
+#include <algorithm>
+#include <vector>
+
+using namespace Animator;
+using namespace FixedPoint;
+
+namespace
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr uint32_t LEDS          = LED::count();
+  static constexpr uint32_t WHITE         = 0x00FFFFFF;
+  static constexpr uint32_t LONG_US       = 1'000'000;    // Lifetime of particles that should outlast a check
+  static constexpr uint32_t FRAME_US      = 10'000;       // Frame period for the timing
+  static constexpr size_t   SPARKS        = 384;          // Capacity of Sparks::State
+  static constexpr uint32_t TIMING_FRAMES = 100'000;      // Frames averaged for the timing
+
+  /*---------------------------------------------------------------------------
+  Static Functions
+  ---------------------------------------------------------------------------*/
+
+  static uint32_t gray( const uint32_t level )
+  {
+    return level * 0x010101;
+  }
+
+
+  template<size_t CAPACITY>
+  static std::vector<uint32_t> draw( const ParticleSystem<CAPACITY> &particles )
+  {
+    std::vector<uint32_t> leds( LEDS, 0 );
+    particles.render( leds.data() );
+    return leds;
+  }
+
+
+  /**
+   * @brief Pool fills up to its capacity and no further
+   */
+  static void check_capacity()
+  {
+    ParticleSystem<8> particles;
+
+    CHECK( !particles.spawn( 0, 0, 0, WHITE ) );    // A particle that never lives isn't added
+    for( size_t i = 0; i < particles.capacity(); i++ )
+    {
+      CHECK( particles.spawn( toQ16( i ), 0, LONG_US, WHITE ) );
+    }
+
+    CHECK( particles.size() == particles.capacity() );
+    CHECK( !particles.spawn( 0, 0, LONG_US, WHITE ) );
+    CHECK( particles.size() == particles.capacity() );
+
+    particles.clear();
+    CHECK( particles.size() == 0 );
+    CHECK( particles.spawn( 0, 0, LONG_US, WHITE ) );
+  }
+
+
+  /**
+   * @brief Retiring keeps the survivors and only the survivors, packed at the front
+   *
+   * Each particle sits on its own LED, so what is drawn shows who is alive.
+   */
+  static void check_retire()
+  {
+    ParticleSystem<16> particles;
+
+    /*-------------------------------------------------------------------------
+    Even LEDs expire on the first update. Runs of expiring particles at the
+    end and in the middle make the swapped-in particle expire too.
+    -------------------------------------------------------------------------*/
+    std::vector<bool> alive( particles.capacity() );
+    for( size_t i = 0; i < particles.capacity(); i++ )
+    {
+      alive[ i ] = ( ( i % 2 ) == 1 ) && ( i != 15 ) && ( i != 7 );
+      CHECK( particles.spawn( toQ16( i ), 0, alive[ i ] ? LONG_US : FRAME_US, WHITE ) );
+    }
+
+    particles.update( FRAME_US );
+
+    const size_t survivors = std::count( alive.begin(), alive.end(), true );
+    CHECK( particles.size() == survivors );
+
+    const std::vector<uint32_t> leds = draw( particles );
+    for( size_t i = 0; i < particles.capacity(); i++ )
+    {
+      CHECK( ( leds[ i ] != 0 ) == alive[ i ] );
+    }
+
+    /*-------------------------------------------------------------------------
+    The freed slots can all be spawned into again
+    -------------------------------------------------------------------------*/
+    for( size_t i = survivors; i < particles.capacity(); i++ )
+    {
+      CHECK( particles.spawn( toQ16( 20 ), 0, LONG_US, WHITE ) );
+    }
+    CHECK( !particles.spawn( toQ16( 20 ), 0, LONG_US, WHITE ) );
+
+    /*-------------------------------------------------------------------------
+    Leaving either end of the string retires a particle too
+    -------------------------------------------------------------------------*/
+    particles.clear();
+    particles.spawn( toQ16( LEDS - 1 ), toQ16( 200 ), LONG_US, WHITE );    // Two LEDs on in 10ms, off the end
+    particles.spawn( 0, -toQ16( 200 ), LONG_US, WHITE );                    // Two LEDs back, past -1
+    particles.spawn( toQ16( 10 ), toQ16( 50 ), LONG_US, WHITE );            // Half an LED on, still on the string
+    particles.update( FRAME_US );
+    CHECK( particles.size() == 1 );
+  }
+
+
+  /**
+   * @brief Linear fade over the lifetime, and the split across two LEDs
+   */
+  static void check_colors()
+  {
+    ParticleSystem<4> particles;
+
+    /*-------------------------------------------------------------------------
+    Full brightness at spawn, then fading with the lifetime left
+    -------------------------------------------------------------------------*/
+    particles.spawn( toQ16( 2 ), 0, LONG_US, WHITE );
+    CHECK( draw( particles )[ 2 ] == WHITE );
+
+    particles.update( LONG_US / 2 );
+    CHECK( draw( particles )[ 2 ] == gray( 127 ) );    // 255 * 128 / 256
+
+    particles.update( LONG_US / 4 );
+    CHECK( draw( particles )[ 2 ] == gray( 63 ) );    // 255 * 64 / 256
+
+    /*-------------------------------------------------------------------------
+    A quarter of the way to the next LED gives it a quarter of the color
+    -------------------------------------------------------------------------*/
+    particles.clear();
+    particles.spawn( toQ16( 3 ) + Q16_ONE / 4, 0, LONG_US, WHITE );
+
+    std::vector<uint32_t> leds = draw( particles );
+    CHECK( leds[ 3 ] == gray( 191 ) );    // 255 * 192 / 256
+    CHECK( leds[ 4 ] == gray( 63 ) );     // 255 * 64 / 256
+    CHECK( std::count( leds.begin(), leds.end(), 0u ) == static_cast<long>( LEDS - 2 ) );
+
+    /*-------------------------------------------------------------------------
+    Only the half on the string is drawn past either end
+    -------------------------------------------------------------------------*/
+    particles.clear();
+    particles.spawn( -Q16_ONE / 2, 0, LONG_US, WHITE );
+    particles.spawn( toQ16( LEDS - 1 ) + Q16_ONE / 2, 0, LONG_US, WHITE );
+
+    leds = draw( particles );
+    CHECK( leds[ 0 ] == gray( 127 ) );
+    CHECK( leds[ LEDS - 1 ] == gray( 127 ) );
+    CHECK( std::count( leds.begin(), leds.end(), 0u ) == static_cast<long>( LEDS - 2 ) );
+
+    /*-------------------------------------------------------------------------
+    Overlapping particles add, each channel saturating on its own
+    -------------------------------------------------------------------------*/
+    particles.clear();
+    particles.spawn( toQ16( 5 ), 0, LONG_US, 0x00C01020 );
+    particles.spawn( toQ16( 5 ), 0, LONG_US, 0x00C01020 );
+    particles.spawn( toQ16( 5 ) + Q16_ONE / 2, 0, LONG_US, 0x00800000 );
+
+    leds = draw( particles );
+    CHECK( leds[ 5 ] == 0x00FF2040 );    // Blue 0xC0 + 0xC0 + 0x40 clamps, red and green just add
+    CHECK( leds[ 6 ] == 0x00400000 );
+  }
+
+}    // namespace
+
+
+int main()
+{
+  check_capacity();
+  check_retire();
+  check_colors();
+
+  /*---------------------------------------------------------------------------
+  A full Sparks pool, moving, fading and topped back up to capacity before
+  every render
+  ---------------------------------------------------------------------------*/
+  ParticleSystem<SPARKS> particles;
+  std::vector<uint32_t>  leds( LEDS );
+  uint32_t               seed = 1;
+
+  const auto frame = [ & ]() {
+    particles.update( FRAME_US );
+
+    while( particles.size() < particles.capacity() )
+    {
+      seed = ( seed * 1'103'515'245u ) + 12'345u;
+      particles.spawn( static_cast<q16_t>( seed % toQ16( LEDS / 4 ) ), toQ16( 4 ) + ( seed >> 12 ) % toQ16( 12 ),
+                       600'000 + ( seed % 1'400'000 ), 0x001C06 );
+    }
+
+    std::fill( leds.begin(), leds.end(), 0 );
+    particles.render( leds.data() );
+  };
+
+  const double ns = Test::timeNs( TIMING_FRAMES, frame );
+  printf( "update + render: %.0fns per frame, %.2fns per particle, %zu particles\n", ns, ns / SPARKS, SPARKS );
+
+  return Test::result( "particles" );
+}
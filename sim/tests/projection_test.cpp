@@ -0,0 +1,299 @@
+/******************************************************************************
+ *  File Name:
+ *    projection_test.cpp
+ *
+ *  Description:
+ *    Projects known images through the map generated for the ver1 board and
+ *    compares every LED against checked-in expected colors. The expected
+ *    colors are themselves held to a floating point area average, so a
+ *    regenerated golden file can't quietly bless a broken map.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "projection.hpp"
+#include "test.hpp"
+#include "ws2812.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace Projection;
+
+namespace
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr uint32_t LEDS        = LED::count();
+  static constexpr uint32_t PIXELS      = IMAGE_SIZE * IMAGE_SIZE;
+  static constexpr uint32_t TIMING_RUNS = 100'000;    // Calls averaged for the timing
+
+  static constexpr uint32_t UNIFORM_COLORS[] = { 0x000000, 0xFFFFFF, 0x010101, 0xFF0000, 0x00FF00,
+                                                 0x0000FF, 0x123456, 0xFEDCBA, 0x7F807F };
+
+  /*---------------------------------------------------------------------------
+  Structures
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief One image and scroll to project
+   */
+  struct Case
+  {
+    const char *name;
+    uint32_t ( *pixel )( uint32_t x, uint32_t y );
+    uint32_t    scroll_x;
+    uint32_t    scroll_y;
+    int         tolerance;    // Largest channel error allowed against the float reference
+  };
+
+  using Golden = std::map<std::string, std::vector<uint32_t>>;
+
+  /*---------------------------------------------------------------------------
+  Static Functions
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Blue grows to the right, red grows downward, green along the diagonal
+   */
+  static uint32_t gradient( const uint32_t x, const uint32_t y )
+  {
+    return ( ( x * 4 ) << 16 ) | ( ( y * 4 ) << 8 ) | ( ( x + y ) * 2 );
+  }
+
+
+  /**
+   * @brief 8 pixel red and green squares, sharp edges for the footprints to straddle
+   */
+  static uint32_t checker( const uint32_t x, const uint32_t y )
+  {
+    return ( ( ( x >> 3 ) ^ ( y >> 3 ) ) & 1 ) ? 0x00FF00 : 0x0000FF;
+  }
+
+
+  /*---------------------------------------------------------------------------
+  Each tap's weight is rounded to 1/256 and the sum is truncated, so a smooth
+  image is within a count or two of exact. A hard edge under a footprint
+  scales the rounding by the size of the step, which the scrolled gradient
+  gets where it wraps from 252 back to 0.
+  ---------------------------------------------------------------------------*/
+  static const Case CASES[] = {
+    { "gradient", gradient, 0, 0, 2 },
+    { "gradient_scrolled", gradient, 21, 9, 6 },
+    { "checker", checker, 3, 5, 6 },
+  };
+
+
+  static std::vector<uint32_t> make_image( uint32_t ( *pixel )( uint32_t, uint32_t ) )
+  {
+    std::vector<uint32_t> image( PIXELS );
+    for( uint32_t y = 0; y < IMAGE_SIZE; y++ )
+    {
+      for( uint32_t x = 0; x < IMAGE_SIZE; x++ )
+      {
+        image[ y * IMAGE_SIZE + x ] = pixel( x, y );
+      }
+    }
+
+    return image;
+  }
+
+
+  /**
+   * @brief Area weighted average of the pixels under an LED's footprint, in floating point
+   *
+   * Works from the LED centers and footprint alone, not the generated taps.
+   * The footprint is clipped to the image, as the generator does.
+   */
+  static uint32_t reference( const std::vector<uint32_t> &image, const Case &c, const uint32_t led )
+  {
+    const Position pos  = position( led );
+    const double   half = footprint() / 512.0;
+    const double   u    = pos.x / 256.0;
+    const double   v    = pos.y / 256.0;
+
+    double sum[ 3 ] = {};
+    double total    = 0;
+
+    for( uint32_t py = 0; py < IMAGE_SIZE; py++ )
+    {
+      const double h = std::max( 0.0, std::min( v + half, py + 1.0 ) - std::max( v - half, double( py ) ) );
+      for( uint32_t px = 0; px < IMAGE_SIZE && h > 0; px++ )
+      {
+        const double w = h * std::max( 0.0, std::min( u + half, px + 1.0 ) - std::max( u - half, double( px ) ) );
+        if( w <= 0 )
+        {
+          continue;
+        }
+
+        const uint32_t x     = ( px + c.scroll_x ) & ( IMAGE_SIZE - 1 );
+        const uint32_t y     = ( py + c.scroll_y ) & ( IMAGE_SIZE - 1 );
+        const uint32_t color = image[ y * IMAGE_SIZE + x ];
+        for( uint32_t ch = 0; ch < 3; ch++ )
+        {
+          sum[ ch ] += w * ( ( color >> ( 8 * ch ) ) & 0xFF );
+        }
+        total += w;
+      }
+    }
+
+    uint32_t out = 0;
+    for( uint32_t ch = 0; ch < 3; ch++ )
+    {
+      out |= static_cast<uint32_t>( std::lround( sum[ ch ] / total ) ) << ( 8 * ch );
+    }
+
+    return out;
+  }
+
+
+  static int channel_error( const uint32_t a, const uint32_t b )
+  {
+    int worst = 0;
+    for( uint32_t ch = 0; ch < 3; ch++ )
+    {
+      const int diff = static_cast<int>( ( a >> ( 8 * ch ) ) & 0xFF ) - static_cast<int>( ( b >> ( 8 * ch ) ) & 0xFF );
+      worst          = std::max( worst, std::abs( diff ) );
+    }
+
+    return worst;
+  }
+
+
+  /**
+   * @brief Reads "<case> <led> <color>" lines, skipping comments
+   */
+  static Golden load_golden( const std::string &path )
+  {
+    Golden        golden;
+    std::ifstream file( path );
+    std::string   line;
+
+    while( std::getline( file, line ) )
+    {
+      std::istringstream in( line );
+      std::string        name;
+      uint32_t           led;
+      std::string        color;
+
+      if( line.empty() || ( line[ 0 ] == '#' ) || !( in >> name >> led >> color ) )
+      {
+        continue;
+      }
+
+      std::vector<uint32_t> &leds = golden[ name ];
+      leds.resize( std::max<size_t>( leds.size(), led + 1 ) );
+      leds[ led ] = static_cast<uint32_t>( std::stoul( color, nullptr, 16 ) );
+    }
+
+    return golden;
+  }
+
+
+  static void write_golden( const std::string &path, const Golden &golden )
+  {
+    std::ofstream file( path );
+    file << "# LED colors expected from projecting the images in projection_test.cpp\n"
+         << "# through the map for hw/ver1/production/positions.csv.\n"
+         << "# Rewrite with: projection_test <this file> --write\n";
+
+    for( const Case &c : CASES )
+    {
+      const std::vector<uint32_t> &leds = golden.at( c.name );
+      for( uint32_t led = 0; led < leds.size(); led++ )
+      {
+        char line[ 64 ];
+        snprintf( line, sizeof( line ), "%s %u 0x%06X\n", c.name, led, leds[ led ] );
+        file << line;
+      }
+    }
+  }
+
+}    // namespace
+
+
+int main( int argc, char **argv )
+{
+  if( ( argc < 2 ) || ( argc > 3 ) || ( ( argc == 3 ) && strcmp( argv[ 2 ], "--write" ) ) )
+  {
+    printf( "Usage: %s <golden.txt> [--write]\n", argv[ 0 ] );
+    return 2;
+  }
+
+  /*---------------------------------------------------------------------------
+  Known images against the golden colors and the float reference
+  ---------------------------------------------------------------------------*/
+  const Golden golden = load_golden( argv[ 1 ] );
+  Golden       actual;
+
+  for( const Case &c : CASES )
+  {
+    const std::vector<uint32_t> image = make_image( c.pixel );
+    std::vector<uint32_t>       leds( LEDS );
+    int                         worst = 0;
+
+    project( image.data(), c.scroll_x, c.scroll_y, leds.data() );
+    for( uint32_t led = 0; led < LEDS; led++ )
+    {
+      worst = std::max( worst, channel_error( leds[ led ], reference( image, c, led ) ) );
+    }
+
+    printf( "%-18s worst channel error vs float reference %d\n", c.name, worst );
+    CHECK( worst <= c.tolerance );
+
+    actual[ c.name ] = leds;
+    if( ( argc == 2 ) && CHECK( golden.count( c.name ) ) )
+    {
+      const std::vector<uint32_t> &expected = golden.at( c.name );
+      CHECK( expected.size() == LEDS );
+
+      for( uint32_t led = 0; led < std::min<size_t>( LEDS, expected.size() ); led++ )
+      {
+        if( !CHECK( leds[ led ] == expected[ led ] ) )
+        {
+          printf( "  %s LED %u: got 0x%06X, expected 0x%06X\n", c.name, led, leds[ led ], expected[ led ] );
+        }
+      }
+    }
+  }
+
+  if( argc == 3 )
+  {
+    write_golden( argv[ 1 ], actual );
+    printf( "wrote %s\n", argv[ 1 ] );
+  }
+
+  /*---------------------------------------------------------------------------
+  A flat image lands on every LED as exactly its own color, whatever the scroll
+  ---------------------------------------------------------------------------*/
+  for( const uint32_t color : UNIFORM_COLORS )
+  {
+    const std::vector<uint32_t> image( PIXELS, color );
+    std::vector<uint32_t>       leds( LEDS );
+
+    project( image.data(), color & ( IMAGE_SIZE - 1 ), ( color >> 8 ) & ( IMAGE_SIZE - 1 ), leds.data() );
+    CHECK( std::all_of( leds.begin(), leds.end(), [ color ]( uint32_t led ) { return led == color; } ) );
+  }
+
+  /*---------------------------------------------------------------------------
+  Cost of one projection
+  ---------------------------------------------------------------------------*/
+  const std::vector<uint32_t> image = make_image( gradient );
+  std::vector<uint32_t>       leds( LEDS );
+  uint32_t                    scroll = 0;
+
+  const double ns = Test::timeNs( TIMING_RUNS, [ & ]() { project( image.data(), scroll++, 0, leds.data() ); } );
+  printf( "project: %.1fns per call, %.1fns per LED, %u LEDs\n", ns, ns / LEDS, LEDS );
+
+  return Test::result( "projection" );
+}
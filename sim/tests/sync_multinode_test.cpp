@@ -0,0 +1,272 @@
+/******************************************************************************
+ *  File Name:
+ *    sync_multinode_test.cpp
+ *
+ *  Description:
+ *    Runs a daisy chain of trees through the sync protocol on the host. Every
+ *    link is a pipe carrying the encoded frames, each tree's crystal runs at
+ *    its own rate, and each hop can add latency the follower doesn't know
+ *    about. The chain has to pull every clock to within one frame of the
+ *    leader and keep it there.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "holly_jolly_cfg.hpp"
+#include "sync_protocol.hpp"
+#include "test.hpp"
+#include <algorithm>
+#include <deque>
+#include <fcntl.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace Sync;
+
+namespace
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr uint32_t BAUD_RATE    = 115'200;    // Link speed, as in sync.cpp
+  static constexpr uint32_t TX_PERIOD_US = 100'000;    // Time between periodic broadcasts, as in sync.cpp
+  static constexpr uint32_t TRANSIT_US   = ( SYNC_FRAME_SIZE * 10 * 1'000'000 ) / BAUD_RATE;
+
+  static constexpr int64_t  FRAME_US  = FRAME_REFRESH_RATE_MS * 1000;    // Largest skew allowed once converged
+  static constexpr uint64_t TICK_US   = 100;                             // Resolution of the simulation
+  static constexpr uint64_t RUN_US    = 20'000'000;                      // Length of each run
+  static constexpr uint64_t SETTLE_US = 10'000'000;                      // Latest a chain may converge
+
+  /*---------------------------------------------------------------------------
+  Structures
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief One tree in the chain
+   */
+  struct Node
+  {
+    int64_t   skew_ppm;      // Crystal error, positive runs fast
+    uint64_t  boot_us;       // Local clock at the start of the run
+    int       rx_fd;         // Read end of the link from upstream, -1 for the leader
+    int       tx_fd;         // Write end of the link downstream, -1 for the last tree
+    Decoder   decoder;
+    ClockSlew clock;
+    uint64_t  next_tx_us;    // Local time of the next broadcast
+  };
+
+  /**
+   * @brief A frame still on the wire
+   */
+  struct InFlight
+  {
+    uint64_t arrive_us;    // True time the last byte reaches the follower
+    int      fd;           // Link it travels on
+    uint8_t  bytes[ SYNC_FRAME_SIZE ];
+  };
+
+  /**
+   * @brief One chain to run
+   */
+  struct Scenario
+  {
+    const char          *name;
+    std::vector<int64_t> skew_ppm;    // Crystal error of each tree, leader first
+    std::vector<int64_t> start_us;    // Boot time of each tree relative to the leader
+    uint32_t             delay_us;    // Latency each hop adds beyond TRANSIT_US
+  };
+
+  /**
+   * @brief What a run measured
+   */
+  struct Result
+  {
+    bool     converged;        // Every clock stayed within a frame of the leader from SETTLE_US on
+    uint64_t converge_us;      // Time of the first tick after the last one out of bounds
+    int64_t  worst_skew_us;    // Largest skew of any tree from SETTLE_US on
+    int64_t  final_skew_us;    // Largest skew at the end of the run
+  };
+
+  /*---------------------------------------------------------------------------
+  Static Functions
+  ---------------------------------------------------------------------------*/
+
+  static uint64_t local_time( const Node &node, const uint64_t true_us )
+  {
+    return node.boot_us + true_us + static_cast<uint64_t>( ( static_cast<int64_t>( true_us ) * node.skew_ppm ) / 1'000'000 );
+  }
+
+
+  /**
+   * @brief Drains a tree's upstream link, correcting its clock the way sync.cpp does
+   *
+   * @param node      Tree to update
+   * @param local_us  Its local time now
+   */
+  static void receive( Node &node, const uint64_t local_us )
+  {
+    uint8_t byte;
+    while( ( node.rx_fd >= 0 ) && ( read( node.rx_fd, &byte, 1 ) == 1 ) )
+    {
+      if( node.decoder.push( byte ) )
+      {
+        node.clock.correct( clockError( node.decoder.state(), TRANSIT_US, node.clock.now( local_us ) ) );
+      }
+    }
+  }
+
+
+  /**
+   * @brief Runs one chain and measures how far each tree drifts from the leader
+   *
+   * @param scenario  Chain to run
+   * @return Result
+   */
+  static Result run( const Scenario &scenario )
+  {
+    const size_t         count = scenario.skew_ppm.size();
+    std::vector<Node>    nodes( count );
+    std::deque<InFlight> wire;
+
+    for( size_t i = 0; i < count; i++ )
+    {
+      nodes[ i ].skew_ppm   = scenario.skew_ppm[ i ];
+      nodes[ i ].boot_us    = static_cast<uint64_t>( 10'000'000 + scenario.start_us[ i ] );
+      nodes[ i ].rx_fd      = -1;
+      nodes[ i ].tx_fd      = -1;
+      nodes[ i ].next_tx_us = 0;
+    }
+
+    for( size_t i = 0; i + 1 < count; i++ )
+    {
+      int fds[ 2 ];
+      CHECK( pipe( fds ) == 0 );
+      fcntl( fds[ 0 ], F_SETFL, O_NONBLOCK );
+
+      nodes[ i + 1 ].rx_fd = fds[ 0 ];
+      nodes[ i ].tx_fd     = fds[ 1 ];
+    }
+
+    Result   result      = { false, 0, 0, 0 };
+    uint64_t last_bad_us = 0;
+    bool     ever_bad    = false;
+
+    for( uint64_t true_us = 0; true_us <= RUN_US; true_us += TICK_US )
+    {
+      /*-----------------------------------------------------------------------
+      Land the frames whose last byte has arrived
+      -----------------------------------------------------------------------*/
+      while( !wire.empty() && ( wire.front().arrive_us <= true_us ) )
+      {
+        CHECK( write( wire.front().fd, wire.front().bytes, SYNC_FRAME_SIZE ) == SYNC_FRAME_SIZE );
+        wire.pop_front();
+      }
+
+      /*-----------------------------------------------------------------------
+      Each tree takes in what upstream sent and broadcasts on its own period
+      -----------------------------------------------------------------------*/
+      int64_t skew_us = 0;
+      int64_t leader  = 0;
+
+      for( size_t i = 0; i < count; i++ )
+      {
+        Node          &node     = nodes[ i ];
+        const uint64_t local_us = local_time( node, true_us );
+
+        receive( node, local_us );
+        const int64_t shared_us = static_cast<int64_t>( node.clock.now( local_us ) );
+
+        if( ( node.tx_fd >= 0 ) && ( local_us >= node.next_tx_us ) )
+        {
+          InFlight  frame;
+          SyncState state = {};
+
+          state.clock_us  = static_cast<uint32_t>( shared_us );
+          frame.arrive_us = true_us + TRANSIT_US + scenario.delay_us;
+          frame.fd        = node.tx_fd;
+          encode( state, frame.bytes );
+          wire.push_back( frame );
+
+          node.next_tx_us = local_us + TX_PERIOD_US;
+        }
+
+        if( i == 0 )
+        {
+          leader = shared_us;
+        }
+        skew_us = std::max( skew_us, std::abs( shared_us - leader ) );
+      }
+
+      /*-----------------------------------------------------------------------
+      Converged from the first tick after the last one out of bounds
+      -----------------------------------------------------------------------*/
+      if( skew_us > FRAME_US )
+      {
+        last_bad_us = true_us;
+        ever_bad    = true;
+      }
+      else if( true_us >= SETTLE_US )
+      {
+        result.worst_skew_us = std::max( result.worst_skew_us, skew_us );
+      }
+
+      result.final_skew_us = skew_us;
+    }
+
+    result.converge_us = ever_bad ? last_bad_us + TICK_US : 0;
+    result.converged   = result.converge_us <= SETTLE_US;
+
+    for( const Node &node : nodes )
+    {
+      if( node.tx_fd >= 0 )
+      {
+        close( node.tx_fd );
+      }
+
+      if( node.rx_fd >= 0 )
+      {
+        close( node.rx_fd );
+      }
+    }
+
+    return result;
+  }
+
+  /*---------------------------------------------------------------------------
+  Scenarios
+  ---------------------------------------------------------------------------*/
+
+  static const Scenario SCENARIOS[] = {
+    { "pair", { 0, 100 }, { 0, 3'000'000 }, 0 },
+    { "slewed", { 0, -200, 200 }, { 0, 200'000, -150'000 }, 0 },
+    { "four", { 0, 500, -500, 250 }, { 0, 1'000'000, -2'000'000, 40'000 }, 500 },
+    { "eight", { 0, 1000, -1000, 1000, -1000, 1000, -1000, 1000 },
+      { 0, 5'000'000, -5'000'000, 100'000, -100'000, 7'000, 0, 2'500'000 }, 1000 },
+  };
+
+}    // namespace
+
+
+int main()
+{
+  printf( "%-8s %5s %8s %12s %12s %12s\n", "chain", "trees", "delay", "converge", "worst skew", "final skew" );
+
+  for( const Scenario &scenario : SCENARIOS )
+  {
+    const Result result = run( scenario );
+
+    printf( "%-8s %5zu %6uus %10.1fms %10lldus %10lldus\n", scenario.name, scenario.skew_ppm.size(),
+            scenario.delay_us, result.converge_us / 1000.0, static_cast<long long>( result.worst_skew_us ),
+            static_cast<long long>( result.final_skew_us ) );
+
+    CHECK( result.converged );
+    CHECK( result.worst_skew_us <= FRAME_US );
+    CHECK( result.final_skew_us <= FRAME_US );
+  }
+
+  return Test::result( "sync_multinode" );
+}
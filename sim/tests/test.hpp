@@ -0,0 +1,94 @@
+/******************************************************************************
+ *  File Name:
+ *    test.hpp
+ *
+ *  Description:
+ *    Minimal checks for the host tests. Each test is its own executable that
+ *    returns non-zero if any check failed, which is all ctest needs.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+#pragma once
+#ifndef HOLLY_JOLLY_SIM_TEST_HPP
+#define HOLLY_JOLLY_SIM_TEST_HPP
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+namespace Test
+{
+  /*---------------------------------------------------------------------------
+  Public Functions
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Number of checks that have failed so far
+   * @return uint32_t&
+   */
+  inline uint32_t &failures()
+  {
+    static uint32_t s_failures;
+    return s_failures;
+  }
+
+  /**
+   * @brief Records the outcome of one check, printing it if it failed
+   *
+   * @param ok      Outcome
+   * @param expr    Text of the check
+   * @param file    Source file
+   * @param line    Source line
+   * @return bool   The outcome, so callers can skip what depends on it
+   */
+  inline bool check( const bool ok, const char *const expr, const char *const file, const int line )
+  {
+    if( !ok )
+    {
+      failures()++;
+      printf( "FAIL %s:%d: %s\n", file, line, expr );
+    }
+
+    return ok;
+  }
+
+  /**
+   * @brief Prints the summary line and gives the exit code for main()
+   *
+   * @param name  Test name
+   * @return int  Zero if every check passed
+   */
+  inline int result( const char *const name )
+  {
+    printf( "%s: %s\n", name, failures() ? "FAILED" : "passed" );
+    return failures() ? 1 : 0;
+  }
+
+  /**
+   * @brief Wall clock time of a callable, averaged over a number of runs
+   *
+   * @param runs    Times to call it
+   * @param fn      Callable to time
+   * @return double Nanoseconds per call
+   */
+  template<typename Fn>
+  double timeNs( const uint32_t runs, Fn &&fn )
+  {
+    const auto start = std::chrono::steady_clock::now();
+    for( uint32_t i = 0; i < runs; i++ )
+    {
+      fn();
+    }
+
+    return std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now() - start ).count() / runs;
+  }
+
+}    // namespace Test
+
+#define CHECK( expr ) Test::check( static_cast<bool>( expr ), #expr, __FILE__, __LINE__ )
+
+#endif /* !HOLLY_JOLLY_SIM_TEST_HPP */
@@ -0,0 +1,132 @@
+/******************************************************************************
+ *  File Name:
+ *    trace_test.cpp
+ *
+ *  Description:
+ *    Checks the trace ring's bookkeeping and boot calibration, and times
+ *    record() on the host. The timer and cycle counter are stand-ins here,
+ *    so the clock only moves when the trace reads it.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "hardware/timer.h"
+#include "pico/platform.h"
+#include "telemetry.hpp"
+#include "test.hpp"
+#include "trace.hpp"
+
+using namespace Trace;
+
+namespace
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr uint32_t CYCLES_PER_READ = 7;            // Cycles the stand-in counter loses per timestamp
+  static constexpr uint32_t CYCLE_MASK      = 0x00FFFFFF;    // The counter is 24 bits, like the SysTick
+  static constexpr uint32_t TIMING_RUNS     = 1'000'000;     // Events averaged for the timing
+
+  /*---------------------------------------------------------------------------
+  Static Data
+  ---------------------------------------------------------------------------*/
+
+  static uint32_t s_now_us;
+  static uint32_t s_cycles = 100;    // Starts low so the calibration has to wrap
+
+}    // namespace
+
+/*-----------------------------------------------------------------------------
+Stand-ins for the SDK and telemetry
+-----------------------------------------------------------------------------*/
+
+uint32_t time_us_32()
+{
+  s_cycles = ( s_cycles - CYCLES_PER_READ ) & CYCLE_MASK;
+  return s_now_us++;
+}
+
+
+uint get_core_num()
+{
+  return 0;
+}
+
+
+namespace Telemetry
+{
+  uint32_t cycles()
+  {
+    return s_cycles;
+  }
+
+
+  uint32_t cyclesSince( const uint32_t start )
+  {
+    return ( start - s_cycles ) & CYCLE_MASK;
+  }
+}    // namespace Telemetry
+
+
+int main()
+{
+  /*---------------------------------------------------------------------------
+  Boot leaves an empty trace with the calibration in the header
+  ---------------------------------------------------------------------------*/
+  initialize();
+
+  const Buffer &buffer = getBuffer();
+  CHECK( buffer.magic == TRACE_MAGIC );
+  CHECK( buffer.version == TRACE_VERSION );
+  CHECK( buffer.record_cycles == CYCLES_PER_READ );
+  CHECK( buffer.enabled == 1 );
+
+  for( size_t core = 0; core < TRACE_CORES; core++ )
+  {
+    CHECK( buffer.head[ core ] == 0 );
+    for( size_t i = 0; i < TRACE_DEPTH; i++ )
+    {
+      CHECK( buffer.records[ core ][ i ].timestamp_us == 0 );
+    }
+  }
+
+  /*---------------------------------------------------------------------------
+  Lap the ring a few times, then walk it oldest first
+  ---------------------------------------------------------------------------*/
+  const uint32_t events = 3 * TRACE_DEPTH + 17;
+  for( uint32_t i = 0; i < events; i++ )
+  {
+    record( EVENT_DMA_DONE, static_cast<uint16_t>( i ) );
+  }
+
+  CHECK( buffer.head[ 0 ] == events );
+  for( uint32_t n = events - TRACE_DEPTH + 1; n < events; n++ )
+  {
+    const Record &prev = buffer.records[ 0 ][ ( n - 1 ) & ( TRACE_DEPTH - 1 ) ];
+    const Record &curr = buffer.records[ 0 ][ n & ( TRACE_DEPTH - 1 ) ];
+
+    CHECK( curr.timestamp_us > prev.timestamp_us );
+    CHECK( curr.arg == static_cast<uint16_t>( n ) );
+    CHECK( curr.event == EVENT_DMA_DONE );
+  }
+
+  /*---------------------------------------------------------------------------
+  Frozen traces don't move
+  ---------------------------------------------------------------------------*/
+  setEnabled( false );
+  record( EVENT_SWAP );
+  CHECK( buffer.head[ 0 ] == events );
+  setEnabled( true );
+
+  /*---------------------------------------------------------------------------
+  Host cost of one event. The boot calibration gives the cost on the board.
+  ---------------------------------------------------------------------------*/
+  const double ns = Test::timeNs( TIMING_RUNS, []() { record( EVENT_FRAME_END, 1 ); } );
+  printf( "record(): %.1fns per event on the host\n", ns );
+
+  return Test::result( "trace" );
+}
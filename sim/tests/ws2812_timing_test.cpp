@@ -0,0 +1,184 @@
+/******************************************************************************
+ *  File Name:
+ *    ws2812_timing_test.cpp
+ *
+ *  Description:
+ *    Runs the WS2812 timing profiles through the PIO cycle model on the host.
+ *    The delays are read straight from ws2812.pio, so editing the program
+ *    without keeping it in spec fails here rather than on the board.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "test.hpp"
+#include "ws2812_timing.hpp"
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+
+using namespace LED;
+
+namespace
+{
+  /*---------------------------------------------------------------------------
+  Structures
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief What the model needs from one program in the .pio file
+   */
+  struct PioSource
+  {
+    std::map<std::string, uint32_t> defines;             // .define public values
+    uint32_t                        instructions = 0;    // Instructions in the program
+    uint32_t                        wrap_target  = 0;    // Instruction index of .wrap_target
+    uint32_t                        wrap         = 0;    // Instruction index .wrap jumps back from
+  };
+
+  /**
+   * @brief A timing profile as set up in ws2812.cpp
+   */
+  struct Profile
+  {
+    const char *name;
+    const char *program;
+    uint32_t    bit_rate_hz;
+  };
+
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static const Profile PROFILES[] = {
+    { "800kHz", "ws2812", 800'000 },
+    { "1MHz", "ws2812_fast", 1'000'000 },
+    { "1.2MHz", "ws2812_fast", 1'200'000 },
+  };
+
+  static constexpr uint32_t SYS_CLOCKS[] = { 48'000'000, 125'000'000, 133'000'000 };
+
+  /*---------------------------------------------------------------------------
+  Static Functions
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Pulls the defines and wrap points of every program out of a .pio file
+   *
+   * @param path    File to read
+   * @return std::map<std::string, PioSource>   Programs by name, empty if unreadable
+   */
+  static std::map<std::string, PioSource> parse_pio( const std::string &path )
+  {
+    std::map<std::string, PioSource> programs;
+    std::ifstream                    file( path );
+    std::string                      line;
+    PioSource                       *current = nullptr;
+
+    while( std::getline( file, line ) )
+    {
+      line = line.substr( 0, line.find( ';' ) );
+
+      std::istringstream fields( line );
+      std::string        word;
+      if( !( fields >> word ) )
+      {
+        continue;
+      }
+
+      if( word == ".program" )
+      {
+        fields >> word;
+        current = &programs[ word ];
+      }
+      else if( !current || ( word.back() == ':' ) || ( word == ".side_set" ) )
+      {
+        continue;
+      }
+      else if( word == ".define" )
+      {
+        std::string name;
+        uint32_t    value = 0;
+        fields >> word >> name >> value;
+        current->defines[ name ] = value;
+      }
+      else if( word == ".wrap_target" )
+      {
+        current->wrap_target = current->instructions;
+      }
+      else if( word == ".wrap" )
+      {
+        current->wrap = current->instructions - 1;
+      }
+      else
+      {
+        current->instructions++;
+      }
+    }
+
+    return programs;
+  }
+
+}    // namespace
+
+
+int main( int argc, char **argv )
+{
+  if( argc != 2 )
+  {
+    printf( "Usage: %s <ws2812.pio>\n", argv[ 0 ] );
+    return 2;
+  }
+
+  const auto programs = parse_pio( argv[ 1 ] );
+  if( !CHECK( programs.count( "ws2812" ) && programs.count( "ws2812_fast" ) ) )
+  {
+    return Test::result( "ws2812_timing" );
+  }
+
+  printf( "%-8s %-12s", "profile", "program" );
+  for( const uint32_t sys_hz : SYS_CLOCKS )
+  {
+    printf( " %6uMHz", sys_hz / 1'000'000 );
+  }
+  printf( "\n" );
+
+  for( const Profile &profile : PROFILES )
+  {
+    const PioSource &src = programs.at( profile.program );
+    CHECK( src.instructions == WS2812_PROGRAM_LENGTH );
+
+    const PioProgram    model  = assembleWS2812Program( src.defines.at( "T1" ), src.defines.at( "T2" ),
+                                                        src.defines.at( "T3" ) );
+    const ProgramTiming timing = emulateWS2812Program( model, src.wrap_target, src.wrap );
+    CHECK( timing.valid );
+
+    printf( "%-8s %-12s", profile.name, profile.program );
+    for( const uint32_t sys_hz : SYS_CLOCKS )
+    {
+      const bool ok = validateTiming( timing, profile.bit_rate_hz, sys_hz, WS2812B_2020_LIMITS );
+      printf( " %9s", ok ? "ok" : "-" );
+
+      /*-----------------------------------------------------------------------
+      The standard profiles must hold at both clocks the board runs at, the
+      SDK default and pico-debug's 48MHz. Faster ones are checked at boot.
+      -----------------------------------------------------------------------*/
+      if( ( profile.bit_rate_hz <= 1'000'000 ) && ( ( sys_hz == 48'000'000 ) || ( sys_hz == 125'000'000 ) ) )
+      {
+        CHECK( ok );
+      }
+    }
+    printf( "\n" );
+  }
+
+  /*---------------------------------------------------------------------------
+  Frame time must cover the bits and the latch
+  ---------------------------------------------------------------------------*/
+  CHECK( frameTimeUs( 800'000, 32, WS2812B_2020_LIMITS ) == ( 960 + WS2812B_2020_LIMITS.reset_min_us ) );
+  CHECK( fifoDrainTimeUs( 800'000 ) == 270 );
+
+  return Test::result( "ws2812_timing" );
+}
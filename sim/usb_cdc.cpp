@@ -0,0 +1,140 @@
+/******************************************************************************
+ *  File Name:
+ *    usb_cdc.cpp
+ *
+ *  Description:
+ *    Simulated USB CDC port. Bytes written by the firmware go to a file, and
+ *    the port only takes as many as the link could carry in the time since
+ *    it was last asked, so a slow host shows up as dropped mirror frames.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "sim.hpp"
+#include "tusb.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace Sim
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr uint32_t FIFO_BYTES = 256;    // TinyUSB's default CDC transmit FIFO
+
+  /*---------------------------------------------------------------------------
+  Static Data
+  ---------------------------------------------------------------------------*/
+
+  static FILE    *s_usb_file;         // Where the stream goes, nullptr when no host is connected
+  static uint32_t s_usb_kbps;         // Link throughput the host manages
+  static uint64_t s_usb_last_us;      // Time the budget was last topped up
+  static uint64_t s_usb_budget;       // Bytes the link can take right now
+  static uint64_t s_usb_tx_bytes;
+
+  /*---------------------------------------------------------------------------
+  Static Functions
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Credits the link with what it could have sent since the last call
+   */
+  static void refill_budget()
+  {
+    const uint64_t now_us = now();
+    s_usb_budget += ( ( now_us - s_usb_last_us ) * s_usb_kbps ) / 8'000;
+    s_usb_budget  = std::min<uint64_t>( s_usb_budget, FIFO_BYTES );
+    s_usb_last_us = now_us;
+  }
+
+  /*---------------------------------------------------------------------------
+  Public Functions
+  ---------------------------------------------------------------------------*/
+
+  bool mirrorTo( const std::string &path, const uint32_t kbps )
+  {
+    if( s_usb_file )
+    {
+      fclose( s_usb_file );
+      s_usb_file = nullptr;
+    }
+
+    s_usb_kbps     = kbps;
+    s_usb_last_us  = now();
+    s_usb_budget   = 0;
+    s_usb_tx_bytes = 0;
+
+    if( !path.empty() )
+    {
+      s_usb_file = fopen( path.c_str(), "wb" );
+      return s_usb_file != nullptr;
+    }
+
+    return true;
+  }
+
+
+  uint64_t usbTxBytes()
+  {
+    return s_usb_tx_bytes;
+  }
+
+}    // namespace Sim
+
+/*-----------------------------------------------------------------------------
+SDK Functions: TinyUSB
+-----------------------------------------------------------------------------*/
+
+bool tusb_init( void )
+{
+  return true;
+}
+
+
+void tud_task( void )
+{
+}
+
+
+bool tud_cdc_connected( void )
+{
+  return Sim::s_usb_file != nullptr;
+}
+
+
+uint32_t tud_cdc_write_available( void )
+{
+  if( !Sim::s_usb_file )
+  {
+    return 0;
+  }
+
+  Sim::refill_budget();
+  return static_cast<uint32_t>( Sim::s_usb_budget );
+}
+
+
+uint32_t tud_cdc_write( const void *buffer, uint32_t bufsize )
+{
+  if( !Sim::s_usb_file )
+  {
+    return 0;
+  }
+
+  bufsize = static_cast<uint32_t>( std::min<uint64_t>( bufsize, Sim::s_usb_budget ) );
+  fwrite( buffer, 1, bufsize, Sim::s_usb_file );
+
+  Sim::s_usb_budget -= bufsize;
+  Sim::s_usb_tx_bytes += bufsize;
+  return bufsize;
+}
+
+
+uint32_t tud_cdc_write_flush( void )
+{
+  return 0;
+}
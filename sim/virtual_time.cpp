@@ -0,0 +1,306 @@
+/******************************************************************************
+ *  File Name:
+ *    virtual_time.cpp
+ *
+ *  Description:
+ *    Virtual clock, alarm pool and event register standing in for the
+ *    RP2040 timer and the SDK time functions built on it
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+#include "pico/time.h"
+#include "sim.hpp"
+#include <algorithm>
+#include <map>
+#include <utility>
+
+namespace Sim
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr size_t ALARM_POOL_SIZE = 16;    // Matches PICO_TIME_DEFAULT_ALARM_POOL_MAX_TIMERS
+
+  /*---------------------------------------------------------------------------
+  Structures
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Something scheduled to happen at a point in virtual time
+   */
+  struct Timer
+  {
+    alarm_id_t            id;           // Alarm ID, or zero for a stimulus
+    alarm_callback_t      callback;     // Alarm callback, if an alarm
+    void                 *user_data;    // Alarm callback argument
+    std::function<void()> action;       // Stimulus, if not an alarm
+  };
+
+  /**
+   * @brief Timers are ordered by due time, then by the order they were added
+   */
+  using TimerKey = std::pair<uint64_t, uint64_t>;
+
+  /*---------------------------------------------------------------------------
+  Static Data
+  ---------------------------------------------------------------------------*/
+
+  static uint64_t                  s_now_us;
+  static uint64_t                  s_end_us;
+  static uint64_t                  s_sequence;
+  static alarm_id_t                s_next_alarm_id;
+  static size_t                    s_alarms_pending;
+  static bool                      s_event;
+  static std::map<TimerKey, Timer> s_timers;
+  static TimeStats                 s_stats;
+
+  /*---------------------------------------------------------------------------
+  Static Functions
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Adds a timer to the schedule
+   *
+   * @param when_us   Time it comes due
+   * @param timer     What to do
+   */
+  static void schedule( const uint64_t when_us, Timer &&timer )
+  {
+    if( timer.callback )
+    {
+      s_alarms_pending++;
+    }
+
+    s_timers.emplace( TimerKey( when_us, s_sequence++ ), std::move( timer ) );
+  }
+
+
+  /**
+   * @brief Checks if anything is due at or before a point in time
+   *
+   * @param limit_us  Latest time to consider
+   * @return bool
+   */
+  static bool timer_due( const uint64_t limit_us )
+  {
+    return !s_timers.empty() && ( s_timers.begin()->first.first <= limit_us );
+  }
+
+
+  /**
+   * @brief Advances to the earliest timer and runs it
+   *
+   * Alarms follow the SDK's rescheduling rules: a positive return reschedules
+   * relative to when the alarm was due, a negative one relative to now.
+   */
+  static void fire_next()
+  {
+    auto   node  = s_timers.extract( s_timers.begin() );
+    Timer &timer = node.mapped();
+
+    s_now_us = std::max( s_now_us, node.key().first );
+
+    if( !timer.callback )
+    {
+      timer.action();
+      return;
+    }
+
+    s_alarms_pending--;
+    s_stats.alarms_fired++;
+
+    const int64_t again = timer.callback( timer.id, timer.user_data );
+    if( again > 0 )
+    {
+      schedule( node.key().first + static_cast<uint64_t>( again ), std::move( timer ) );
+    }
+    else if( again < 0 )
+    {
+      schedule( s_now_us + static_cast<uint64_t>( -again ), std::move( timer ) );
+    }
+  }
+
+
+  /**
+   * @brief Ends the run if the clock has reached the end time
+   */
+  static void check_finished()
+  {
+    if( s_now_us >= s_end_us )
+    {
+      throw Finished{};
+    }
+  }
+
+
+  /**
+   * @brief Waits for an event or a deadline, whichever comes first
+   *
+   * @param deadline_us   Time to give up waiting
+   * @return bool         True if woken by an event
+   */
+  static bool wait_for_event( const uint64_t deadline_us )
+  {
+    const uint64_t stop_us = std::min( deadline_us, s_end_us );
+    while( !s_event && timer_due( stop_us ) )
+    {
+      fire_next();
+    }
+
+    if( s_event )
+    {
+      s_event = false;
+      s_stats.wakeups++;
+      return true;
+    }
+
+    s_now_us = std::max( s_now_us, stop_us );
+    check_finished();
+    return false;
+  }
+
+  /*---------------------------------------------------------------------------
+  Public Functions
+  ---------------------------------------------------------------------------*/
+
+  void resetTime( const uint64_t end_us )
+  {
+    s_now_us         = 0;
+    s_end_us         = end_us;
+    s_sequence       = 0;
+    s_next_alarm_id  = 1;
+    s_alarms_pending = 0;
+    s_event          = false;
+    s_stats          = {};
+    s_timers.clear();
+  }
+
+
+  uint64_t now()
+  {
+    return s_now_us;
+  }
+
+
+  void at( const uint64_t when_us, std::function<void()> action )
+  {
+    schedule( std::max( when_us, s_now_us ), Timer{ 0, nullptr, nullptr, std::move( action ) } );
+  }
+
+
+  void runUntil( const uint64_t target_us )
+  {
+    const uint64_t stop_us = std::min( target_us, s_end_us );
+    while( timer_due( stop_us ) )
+    {
+      fire_next();
+    }
+
+    s_now_us = std::max( s_now_us, stop_us );
+    check_finished();
+  }
+
+
+  TimeStats getTimeStats()
+  {
+    return s_stats;
+  }
+
+}    // namespace Sim
+
+/*-----------------------------------------------------------------------------
+SDK Functions
+-----------------------------------------------------------------------------*/
+
+uint64_t time_us_64()
+{
+  return Sim::s_now_us;
+}
+
+
+uint32_t time_us_32()
+{
+  return static_cast<uint32_t>( Sim::s_now_us );
+}
+
+
+void busy_wait_us( uint64_t us )
+{
+  Sim::s_stats.busy_wait_us += us;
+  Sim::runUntil( Sim::s_now_us + us );
+}
+
+
+void sleep_us( uint64_t us )
+{
+  Sim::runUntil( Sim::s_now_us + us );
+}
+
+
+void sleep_ms( uint32_t ms )
+{
+  sleep_us( static_cast<uint64_t>( ms ) * 1000 );
+}
+
+
+void sleep_until( absolute_time_t target )
+{
+  Sim::runUntil( target );
+}
+
+
+bool best_effort_wfe_or_timeout( absolute_time_t timeout_timestamp )
+{
+  return !Sim::wait_for_event( timeout_timestamp );
+}
+
+
+void __sev()
+{
+  Sim::s_event = true;
+}
+
+
+void __wfe()
+{
+  Sim::wait_for_event( at_the_end_of_time );
+}
+
+
+alarm_id_t add_alarm_in_us( uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past )
+{
+  ( void )fire_if_past;    // Virtual time never passes a deadline while scheduling it
+
+  if( Sim::s_alarms_pending >= Sim::ALARM_POOL_SIZE )
+  {
+    Sim::s_stats.alarms_refused++;
+    return -1;
+  }
+
+  const alarm_id_t id = Sim::s_next_alarm_id++;
+  Sim::schedule( Sim::s_now_us + us, Sim::Timer{ id, callback, user_data, nullptr } );
+  return id;
+}
+
+
+bool cancel_alarm( alarm_id_t alarm_id )
+{
+  for( auto it = Sim::s_timers.begin(); it != Sim::s_timers.end(); it++ )
+  {
+    if( it->second.callback && ( it->second.id == alarm_id ) )
+    {
+      Sim::s_timers.erase( it );
+      Sim::s_alarms_pending--;
+      return true;
+    }
+  }
+
+  return false;
+}
@@ -0,0 +1,129 @@
+/******************************************************************************
+ *  File Name:
+ *    audio_spectrum.cpp
+ *
+ *  Description:
+ *    Audio reactive animation. The tree is split into frequency bands from
+ *    bass to treble, each lit by how loud that band is, and bass beats flash
+ *    the whole tree.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "animator_private.hpp"
+#include "audio.hpp"
+#include "fixed_point.hpp"
+
+namespace Animator
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr uint32_t LEVEL_RELEASE_US = 400'000;     // Time for a band to fall from full to dark
+  static constexpr uint32_t FLASH_DECAY_US   = 200'000;     // Time for a beat flash to fade out
+  static constexpr uint32_t FLASH_COLOR      = 0x404040;    // Color blended in on a beat
+
+  /**
+   * @brief Color of each band, bass first, as 0x00BBRRGG
+   */
+  static constexpr uint32_t BAND_COLORS[ Audio::BAND_COUNT ] = {
+    0x00FF00,    // Red
+    0x00FF80,    // Orange
+    0x00FFFF,    // Yellow
+    0x0000FF,    // Green
+    0xFF00FF,    // Cyan
+    0xFF0000,    // Blue
+    0xFF8000,    // Violet
+    0xFFFF00,    // Magenta
+  };
+
+  /*---------------------------------------------------------------------------
+  Static Functions
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Moves a level down by the amount a full scale fall covers in dt_us
+   *
+   * @param level       Current level, 0 to 255
+   * @param dt_us       Time elapsed
+   * @param full_us     Time to fall from 255 to 0
+   * @return uint8_t
+   */
+  static uint8_t release( const uint8_t level, const uint32_t dt_us, const uint32_t full_us )
+  {
+    const uint32_t step = ( std::min( dt_us, full_us ) * 255 ) / full_us;
+    return static_cast<uint8_t>( ( level > step ) ? ( level - step ) : 0 );
+  }
+
+  /*---------------------------------------------------------------------------
+  Audio Spectrum Animation Class
+  ---------------------------------------------------------------------------*/
+
+  AudioSpectrum::AudioSpectrum() : m_ticker(), m_state( nullptr )
+  {
+  }
+
+
+  AudioSpectrum::~AudioSpectrum()
+  {
+  }
+
+
+  void AudioSpectrum::initialize()
+  {
+    m_state = acquire_state<State>();
+    m_state->analyzer.reset();
+
+    Audio::start();
+  }
+
+
+  bool AudioSpectrum::process( const FrameTime &time )
+  {
+    if( !Audio::readLatest( m_state->samples ) )
+    {
+      return false;
+    }
+
+    /*-------------------------------------------------------------------------
+    Bands jump up instantly and fall back slowly, which reads as a meter
+    rather than flicker.
+    -------------------------------------------------------------------------*/
+    const Audio::Spectrum &spectrum = m_state->analyzer.analyze( m_state->samples, time.dt_us );
+
+    for( uint32_t band = 0; band < Audio::BAND_COUNT; band++ )
+    {
+      const uint8_t fallen     = release( m_state->levels[ band ], time.dt_us, LEVEL_RELEASE_US );
+      m_state->levels[ band ] = std::max( fallen, spectrum.bands[ band ] );
+    }
+
+    m_state->flash = spectrum.beat ? 255 : release( m_state->flash, time.dt_us, FLASH_DECAY_US );
+
+    /*-------------------------------------------------------------------------
+    Spread the bands evenly along the string
+    -------------------------------------------------------------------------*/
+    uint32_t *p_render_buffer = LED::getRenderBuffer();
+    for( uint32_t i = 0; i < LED::count(); i++ )
+    {
+      const uint32_t band  = ( i * Audio::BAND_COUNT ) / LED::count();
+      const uint32_t color = FixedPoint::lerpColor( 0, BAND_COLORS[ band ], m_state->levels[ band ] );
+
+      p_render_buffer[ i ] = FixedPoint::lerpColor( color, FLASH_COLOR, m_state->flash );
+    }
+
+    LED::markAllDirty();
+    return true;
+  }
+
+
+  void AudioSpectrum::stop()
+  {
+    Audio::stop();
+    release_state( m_state );
+  }
+
+}    // namespace Animator
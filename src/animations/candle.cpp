@@ -0,0 +1,88 @@
+/******************************************************************************
+ *  File Name:
+ *    candle.cpp
+ *
+ *  Description:
+ *    Every LED flickers like its own candle flame. Driven by gradient noise,
+ *    so the flicker is smooth in time rather than random from frame to frame.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "animator_private.hpp"
+#include "fixed_point.hpp"
+#include "noise.hpp"
+#include "pico/platform.h"
+
+namespace Animator
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr FixedPoint::q16_t FLICKER_RATE = FixedPoint::toQ16( 3 );    // Noise cells per second
+  static constexpr FixedPoint::q16_t DRAFT_RATE   = FixedPoint::Q16_HALF;      // Speed of the shared draft
+  static constexpr uint32_t          LED_SPACING  = 2 * Noise::CELL;           // Noise distance between LEDs
+
+  static constexpr uint32_t FLAME_DIM    = 0x00FF30;    // Flame color when burning low, 0x00BBRRGG
+  static constexpr uint32_t FLAME_BRIGHT = 0x10FF80;    // Flame color when burning high
+  static constexpr uint32_t LEVEL_BASE   = 150;         // Average brightness, 0 to 255
+  static constexpr uint32_t LEVEL_SWING  = 90;          // Maximum flicker above or below the average
+
+  /*---------------------------------------------------------------------------
+  Candle Animation Class
+  ---------------------------------------------------------------------------*/
+
+  Candle::Candle() : m_ticker(), m_state( nullptr )
+  {
+  }
+
+
+  Candle::~Candle()
+  {
+  }
+
+
+  void Candle::initialize()
+  {
+    m_state = acquire_state<State>();
+  }
+
+
+  bool __not_in_flash_func( Candle::process )( const FrameTime &time )
+  {
+    m_state->flicker_time += static_cast<uint32_t>( FixedPoint::mul( time.dt, FLICKER_RATE ) );
+    m_state->draft_time += static_cast<uint32_t>( FixedPoint::mul( time.dt, DRAFT_RATE ) );
+
+    /*-------------------------------------------------------------------------
+    A slow draft moves every flame a little together, on top of each flame's
+    own flicker.
+    -------------------------------------------------------------------------*/
+    const int32_t draft = Noise::perlin1( m_state->draft_time ) >> 2;
+
+    uint32_t *p_render_buffer = LED::getRenderBuffer();
+    for( uint32_t i = 0; i < LED::count(); i++ )
+    {
+      const int32_t  noise = std::clamp<int32_t>( Noise::perlin2( i * LED_SPACING, m_state->flicker_time ) + draft,
+                                                  INT16_MIN, INT16_MAX );
+      const uint32_t level = static_cast<uint32_t>( static_cast<int32_t>( LEVEL_BASE ) +
+                                                    ( ( noise * static_cast<int32_t>( LEVEL_SWING ) ) >> 15 ) );
+      const uint32_t color = FixedPoint::lerpColor( FLAME_DIM, FLAME_BRIGHT, level );
+
+      p_render_buffer[ i ] = FixedPoint::scaleColor( color, level );
+    }
+
+    LED::markAllDirty();
+    return true;
+  }
+
+
+  void Candle::stop()
+  {
+    release_state( m_state );
+  }
+
+}    // namespace Animator
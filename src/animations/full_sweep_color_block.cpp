@@ -16,9 +16,7 @@ Includes
 
 namespace Animator
 {
-  static uint32_t color;
-
-  FullSweepColorBlock::FullSweepColorBlock()
+  FullSweepColorBlock::FullSweepColorBlock() : m_ticker(), m_state( nullptr )
   {
   }
 
@@ -30,34 +28,35 @@ namespace Animator
 
   void FullSweepColorBlock::initialize()
   {
-    color         = 0;
-    m_next_update = delayed_by_ms( get_absolute_time(), 500 );
+    m_state = acquire_state<State>();
+    m_ticker.start( 500'000, 1'000'000 );
   }
 
 
-  bool FullSweepColorBlock::process()
+  bool FullSweepColorBlock::process( const FrameTime &time )
   {
-    if( absolute_time_diff_us( get_absolute_time(), m_next_update ) > 0 )
+    const uint32_t steps = m_ticker.advance( time );
+    if( steps == 0 )
     {
       return false;
     }
 
-    m_next_update = delayed_by_ms( get_absolute_time(), 1000 );
+    m_state->color = ( m_state->color + steps - 1 ) % 3;
 
     uint32_t next_color = 0;
-    switch( color )
+    switch( m_state->color )
     {
       case 0:
         next_color = 0x110000;    // b
-        color++;
+        m_state->color++;
         break;
       case 1:
         next_color = 0x001100;    // r
-        color++;
+        m_state->color++;
         break;
       case 2:
-        next_color = 0x00000A;    // g
-        color      = 0;
+        next_color     = 0x00000A;    // g
+        m_state->color = 0;
         break;
     }
 
@@ -66,6 +65,7 @@ namespace Animator
     {
       p_render_buffer[ i ] = next_color;
     }
+    LED::markAllDirty();
 
     return true;
   }
@@ -73,6 +73,7 @@ namespace Animator
 
   void FullSweepColorBlock::stop()
   {
+    release_state( m_state );
   }
 
 }    // namespace Animator
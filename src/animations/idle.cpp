@@ -3,9 +3,8 @@
  *    idle.cpp
  *
  *  Description:
- *    Implementation of the idle animation, which iterates through each LED in
- *    the strip one by one, changing the color of each LED to red, green, and
- *    blue in sequence.
+ *    Implementation of the idle animation, a single light that glides along
+ *    the strip, fading from red to green to blue as it passes each LED.
  *
  *  2024 | Brandon Braun | brandonbraun653@protonmail.com
  *****************************************************************************/
@@ -14,22 +13,25 @@
 Includes
 -----------------------------------------------------------------------------*/
 #include "animator_private.hpp"
+#include "coroutine.hpp"
+#include "draw.hpp"
 #include "pico/time.h"
 
 namespace Animator
 {
   /*---------------------------------------------------------------------------
-  Static Data
+  Constants
   ---------------------------------------------------------------------------*/
 
-  static uint32_t led_idx;
-  static uint32_t color;
+  static constexpr uint32_t          COLORS[]    = { 0x110000 /* b */, 0x001100 /* r */, 0x00000A /* g */ };
+  static constexpr uint32_t          COLOR_COUNT = sizeof( COLORS ) / sizeof( COLORS[ 0 ] );
+  static constexpr FixedPoint::q16_t CHASE_SPEED = FixedPoint::toQ16( 10 );    // LEDs per second
 
   /*---------------------------------------------------------------------------
   Idle Animation Class
   ---------------------------------------------------------------------------*/
 
-  IdleAnimation::IdleAnimation()
+  IdleAnimation::IdleAnimation() : m_ticker(), m_state( nullptr )
   {
   }
 
@@ -41,46 +43,64 @@ namespace Animator
 
   void IdleAnimation::initialize()
   {
-    led_idx       = 0;
-    color         = 0;
-    m_next_update = delayed_by_ms( get_absolute_time(), 500 );
+    m_state = acquire_state<State>();
   }
 
 
-  bool IdleAnimation::process()
+  bool IdleAnimation::process( const FrameTime &time )
   {
-    if( absolute_time_diff_us( get_absolute_time(), m_next_update ) > 0 )
-    {
-      return false;
-    }
+    static constexpr FixedPoint::q16_t LENGTH = FixedPoint::toQ16( LED::count() );
 
-    m_next_update = delayed_by_ms( get_absolute_time(), 100 );
+    State &state = *m_state;
 
-    uint32_t *p_render_buffer = LED::getRenderBuffer();
-    memset( p_render_buffer, 0, sizeof( uint32_t ) * LED::count() );
+    CO_BEGIN( state.co, time );
+    CO_SLEEP_US( state.co, 500'000 );
 
-    switch( color )
+    while( true )
     {
-      case 0:
-        p_render_buffer[ led_idx ] = 0x110000;    // b
-        color++;
-        break;
-      case 1:
-        p_render_buffer[ led_idx ] = 0x001100;    // r
-        color++;
-        break;
-      case 2:
-        p_render_buffer[ led_idx ] = 0x00000A;    // g
-        color                      = 0;
-        break;
+      {
+        /*---------------------------------------------------------------------
+        Only the two LEDs under the light change. Clear where it was, then
+        move it and blend it across the two LEDs it now straddles.
+        ---------------------------------------------------------------------*/
+        const uint32_t next = ( state.lit_idx + 1 ) % LED::count();
+
+        Draw::fill( { state.lit_idx, state.lit_idx + 1 }, 0 );
+        Draw::fill( { next, next + 1 }, 0 );
+
+        state.position = ( state.position + FixedPoint::mul( CHASE_SPEED, time.dt ) ) % LENGTH;
+
+        const uint32_t led  = static_cast<uint32_t>( FixedPoint::fromQ16( state.position ) );
+        const uint32_t frac = static_cast<uint32_t>( state.position & ( FixedPoint::Q16_ONE - 1 ) ) >> 8;
+
+        if( led != state.lit_idx )
+        {
+          state.lit_idx = led;
+          state.color   = ( state.color + 1 ) % COLOR_COUNT;
+        }
+
+        /*---------------------------------------------------------------------
+        The color fades toward the next one as the light moves, so it has
+        fully changed by the time the light is centered on the next LED. Past
+        the last LED the light wraps around onto the first.
+        ---------------------------------------------------------------------*/
+        const uint32_t from  = COLORS[ state.color ];
+        const uint32_t to    = COLORS[ ( state.color + 1 ) % COLOR_COUNT ];
+        const uint32_t color = FixedPoint::lerpColor( from, to, frac );
+
+        Draw::point( state.position, color );
+        Draw::point( state.position - LENGTH, color );
+      }
+
+      CO_NEXT_FRAME( state.co );
     }
 
-    led_idx = ( led_idx + 1 ) % LED::count();
-    return true;
+    CO_END( state.co );
   }
 
 
   void IdleAnimation::stop()
   {
+    release_state( m_state );
   }
 }    // namespace Animator
@@ -0,0 +1,103 @@
+/******************************************************************************
+ *  File Name:
+ *    image_scroll.cpp
+ *
+ *  Description:
+ *    Scrolls a candy cane striped image across the tree, projected onto the
+ *    physical position of each LED.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "animator_private.hpp"
+#include "color.hpp"
+#include "fixed_point.hpp"
+#include "projection.hpp"
+
+namespace Animator
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr FixedPoint::q16_t SCROLL_RATE   = FixedPoint::toQ16( 12 );    // Pixels per second
+  static constexpr uint32_t          STRIPE_PERIOD = 16;                         // Pixels from one red stripe to the next
+
+  static constexpr uint32_t STRIPE_RED   = Color::rgb( 255, 0, 0 );
+  static constexpr uint32_t STRIPE_WHITE = Color::rgb( 255, 255, 255 );
+
+  static_assert( ( Projection::IMAGE_SIZE % STRIPE_PERIOD ) == 0, "Stripes must tile the image so it wraps cleanly" );
+
+  /*---------------------------------------------------------------------------
+  Image
+  ---------------------------------------------------------------------------*/
+
+  struct Image
+  {
+    uint32_t pixels[ Projection::IMAGE_SIZE * Projection::IMAGE_SIZE ];
+  };
+
+  /**
+   * @brief Draws diagonal red and white stripes with soft edges
+   */
+  static constexpr Image make_candy_cane()
+  {
+    Image image{};
+    for( uint32_t y = 0; y < Projection::IMAGE_SIZE; y++ )
+    {
+      for( uint32_t x = 0; x < Projection::IMAGE_SIZE; x++ )
+      {
+        const uint32_t phase = ( x + y ) % STRIPE_PERIOD;
+        const uint32_t ramp  = ( phase < ( STRIPE_PERIOD / 2 ) ) ? phase : ( STRIPE_PERIOD - 1 - phase );
+        const uint32_t t     = ( ramp * 256 ) / ( ( STRIPE_PERIOD / 2 ) - 1 );
+
+        image.pixels[ y * Projection::IMAGE_SIZE + x ] = FixedPoint::lerpColor( STRIPE_WHITE, STRIPE_RED, t );
+      }
+    }
+
+    return image;
+  }
+
+  static constexpr Image CANDY_CANE = make_candy_cane();
+
+  /*---------------------------------------------------------------------------
+  Image Scroll Animation Class
+  ---------------------------------------------------------------------------*/
+
+  ImageScroll::ImageScroll() : m_ticker(), m_state( nullptr )
+  {
+  }
+
+
+  ImageScroll::~ImageScroll()
+  {
+  }
+
+
+  void ImageScroll::initialize()
+  {
+    m_state = acquire_state<State>();
+  }
+
+
+  bool ImageScroll::process( const FrameTime &time )
+  {
+    m_state->scroll += static_cast<uint32_t>( FixedPoint::mul( time.dt, SCROLL_RATE ) );
+
+    const uint32_t offset = m_state->scroll >> 16;
+    Projection::project( CANDY_CANE.pixels, offset, 0, LED::getRenderBuffer() );
+
+    LED::markAllDirty();
+    return true;
+  }
+
+
+  void ImageScroll::stop()
+  {
+    release_state( m_state );
+  }
+
+}    // namespace Animator
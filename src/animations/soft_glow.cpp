@@ -20,28 +20,35 @@ Includes
 namespace Animator
 {
   /*---------------------------------------------------------------------------
-  Structures
+  Aliases
   ---------------------------------------------------------------------------*/
 
-  struct LedState
-  {
-    uint32_t color;
-    uint32_t fade;
-    uint32_t fade_rate;
-    bool fading_out;  // New field to track fade direction
-  };
+  using Envelopes = EnvelopeBank<LED::count()>;
 
   /*---------------------------------------------------------------------------
-  Static Data
+  Constants
   ---------------------------------------------------------------------------*/
 
-  static LedState s_led_states[ LED::count() ];
+  static constexpr uint32_t SLOWEST_FADE_US = 6'375'000;    // Time for the slowest LEDs to fade fully in or out
+  static constexpr uint32_t FADE_SPEEDS     = 5;            // LEDs fade at 1x to 5x the slowest speed
+
+  /*---------------------------------------------------------------------------
+  Static Functions
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Picks one of the fade speeds at random
+   */
+  static uint16_t random_rate()
+  {
+    return Envelopes::rateFromUs( SLOWEST_FADE_US / ( ( rand() % FADE_SPEEDS ) + 1 ) );
+  }
 
   /*---------------------------------------------------------------------------
   Soft Glow Animation Class
   ---------------------------------------------------------------------------*/
 
-  SoftGlow::SoftGlow()
+  SoftGlow::SoftGlow() : m_ticker(), m_state( nullptr )
   {
   }
 
@@ -53,100 +60,72 @@ namespace Animator
 
   void SoftGlow::initialize()
   {
+    m_state = acquire_state<State>();
+
     /*-------------------------------------------------------------------------
-    Randomize the initial state of each LED
+    Randomize the initial state of each LED. Each one fades in and out at the
+    same speed, so both rates are the same.
     -------------------------------------------------------------------------*/
     for( uint32_t i = 0; i < LED::count(); i++ )
     {
-      s_led_states[ i ].color     = rand();
-      s_led_states[ i ].fade      = rand() % 256;  // Random starting fade value
-      s_led_states[ i ].fade_rate = (rand() % 5) + 1;  // Random fade rate between 1 and 5
-      s_led_states[ i ].fading_out = (rand() % 2) == 0;  // Randomize fade direction
+      const uint16_t         rate  = random_rate();
+      const uint16_t         level = static_cast<uint16_t>( rand() & Envelopes::LEVEL_MAX );
+      const Envelopes::Phase phase = ( rand() % 2 ) ? Envelopes::PHASE_ATTACK : Envelopes::PHASE_DECAY;
+
+      m_state->colors[ i ] = palette()[ rand() & 0xFF ];
+      m_state->envelopes.start( i, level, phase, rate, rate );
     }
 
-    m_next_update = delayed_by_ms( get_absolute_time(), 500 );
+    m_ticker.start( 500'000, 0 );
   }
 
 
-  bool SoftGlow::process()
+  bool SoftGlow::process( const FrameTime &time )
   {
-    if( absolute_time_diff_us( get_absolute_time(), m_next_update ) > 0 )
+    if( ( m_ticker.advance( time ) == 0 ) && !m_state->running )
     {
       return false;
     }
 
-    m_next_update = delayed_by_ms( get_absolute_time(), 25 );
+    m_state->running = true;
 
     /*-------------------------------------------------------------------------
-    Copy the current display buffer to the render buffer
+    LEDs that faded out on the last frame pick a new color and fade back in.
+    This uses rand(), so it stays here rather than in render().
     -------------------------------------------------------------------------*/
-    auto p_render_buffer = LED::getRenderBuffer();
-    auto p_display_buffer = LED::getDisplayBuffer();
-    memcpy( p_render_buffer, p_display_buffer, sizeof( uint32_t ) * LED::count() );
+    const Color::Palette256 &theme = palette();
 
-    /*-------------------------------------------------------------------------
-    Tweak the color of each LED and fade it in or out
-    -------------------------------------------------------------------------*/
     for( uint32_t i = 0; i < LED::count(); i++ )
     {
-      auto &led = s_led_states[ i ];
-
-      /*-----------------------------------------------------------------------
-      Randomize the color of the LED
-      -----------------------------------------------------------------------*/
-      if( led.fade == 0 )
+      if( m_state->envelopes.idle( i ) )
       {
-        led.color = rand();
-      }
+        const uint16_t rate = random_rate();
 
-      /*-----------------------------------------------------------------------
-      Adjust the color of the LED
-      -----------------------------------------------------------------------*/
-      uint8_t red   = ( led.color & LED::WS2812_RED_MSK ) >> 8;
-      uint8_t green = ( led.color & LED::WS2812_GREEN_MSK );
-      uint8_t blue  = ( led.color & LED::WS2812_BLUE_MSK ) >> 16;
-
-      red   = static_cast<uint8_t>( red * led.fade / 255 );
-      green = static_cast<uint8_t>( green * led.fade / 255 );
-      blue  = static_cast<uint8_t>( blue * led.fade / 255 );
-
-      p_render_buffer[ i ] = ( ( blue << 16 ) | ( red << 8 ) | green ) & LED::WS2812_DATA_MSK;
-
-      /*-----------------------------------------------------------------------
-      Update the fade state
-      -----------------------------------------------------------------------*/
-      if( led.fading_out )
-      {
-        if( led.fade > led.fade_rate )
-        {
-          led.fade -= led.fade_rate;
-        }
-        else
-        {
-          led.fade = 0;
-          led.fading_out = false;  // Switch to fading in
-        }
-      }
-      else
-      {
-        if( led.fade < 255 - led.fade_rate )
-        {
-          led.fade += led.fade_rate;
-        }
-        else
-        {
-          led.fade = 255;
-          led.fading_out = true;  // Switch to fading out
-        }
+        m_state->colors[ i ] = theme[ rand() & 0xFF ];
+        m_state->envelopes.trigger( i, rate, rate );
       }
     }
 
+    /*-------------------------------------------------------------------------
+    Fades move continuously with elapsed time, so every LED is redrawn on
+    every frame
+    -------------------------------------------------------------------------*/
+    LED::markAllDirty();
+
     return true;
   }
 
 
+  void __not_in_flash_func( SoftGlow::render )( const FrameTime &time, const uint32_t first, const uint32_t end )
+  {
+    m_state->envelopes.update( time.dt_us, first, end );
+    m_state->envelopes.render( m_state->colors, LED::getRenderBuffer(), first, end );
+  }
+
+
   void SoftGlow::stop()
   {
+    release_state( m_state );
   }
 
 }  // namespace Animator
@@ -0,0 +1,101 @@
+/******************************************************************************
+ *  File Name:
+ *    sparks.cpp
+ *
+ *  Description:
+ *    Particle animation of warm sparks rising up the tree and fading out,
+ *    like embers off a fire.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "animator_private.hpp"
+#include "fixed_point.hpp"
+#include "pico/platform.h"
+#include <cstdlib>
+
+namespace Animator
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr uint32_t SPAWN_INTERVAL_US = 4'000;        // One new spark this often
+  static constexpr uint32_t MIN_LIFETIME_US   = 600'000;      // Shortest a spark lives
+  static constexpr uint32_t LIFETIME_RANGE_US = 1'400'000;    // Random extra lifetime
+  static constexpr int32_t  MIN_SPEED         = 4;            // Slowest rise in LEDs per second
+  static constexpr int32_t  SPEED_RANGE       = 12;           // Random extra speed in LEDs per second
+
+  /**
+   * @brief Spark colors at full intensity, as 0x00BBRRGG
+   *
+   * Kept dim since hundreds of them stack up additively.
+   */
+  static constexpr uint32_t SPARK_COLORS[] = { 0x001C06, 0x001A0E, 0x02140C };
+
+  static constexpr uint32_t SPARK_COLORS_SIZE = sizeof( SPARK_COLORS ) / sizeof( SPARK_COLORS[ 0 ] );
+
+  /*---------------------------------------------------------------------------
+  Sparks Animation Class
+  ---------------------------------------------------------------------------*/
+
+  Sparks::Sparks() : m_ticker(), m_state( nullptr )
+  {
+  }
+
+
+  Sparks::~Sparks()
+  {
+  }
+
+
+  void Sparks::initialize()
+  {
+    m_state = acquire_state<State>();
+  }
+
+
+  bool __not_in_flash_func( Sparks::process )( const FrameTime &time )
+  {
+    auto &particles = m_state->particles;
+
+    /*-------------------------------------------------------------------------
+    Emit at a steady rate no matter how often frames are drawn. Sparks start
+    in the bottom quarter of the string.
+    -------------------------------------------------------------------------*/
+    m_state->spawn_credit_us += time.dt_us;
+    while( m_state->spawn_credit_us >= SPAWN_INTERVAL_US )
+    {
+      m_state->spawn_credit_us -= SPAWN_INTERVAL_US;
+
+      const FixedPoint::q16_t position = static_cast<FixedPoint::q16_t>( rand() % FixedPoint::toQ16( LED::count() / 4 ) );
+      const FixedPoint::q16_t velocity = FixedPoint::toQ16( MIN_SPEED ) + ( rand() % FixedPoint::toQ16( SPEED_RANGE ) );
+      const uint32_t          lifetime = MIN_LIFETIME_US + ( rand() % LIFETIME_RANGE_US );
+      const uint32_t          color    = SPARK_COLORS[ rand() % SPARK_COLORS_SIZE ];
+
+      particles.spawn( position, velocity, lifetime, color );
+    }
+
+    particles.update( time.dt_us );
+
+    /*-------------------------------------------------------------------------
+    Sparks are everywhere, so redraw the whole string
+    -------------------------------------------------------------------------*/
+    uint32_t *p_render_buffer = LED::getRenderBuffer();
+    memset( p_render_buffer, 0, sizeof( uint32_t ) * LED::count() );
+    particles.render( p_render_buffer );
+    LED::markAllDirty();
+
+    return true;
+  }
+
+
+  void Sparks::stop()
+  {
+    release_state( m_state );
+  }
+
+}    // namespace Animator
@@ -4,8 +4,8 @@
  *
  *  Description:
  *    Implementation of the Twinkle animation. This animation will randomly
- *    select a few LEDs to turn on with a random color. The LEDs will remain on
- *    for a short period of time before turning off and selecting new LEDs.
+ *    select a few LEDs to flash with a random color. Each one brightens
+ *    quickly and then fades out slowly while new LEDs are picked.
  *
  *  2024 | Brandon Braun | brandonbraun653@protonmail.com
  *****************************************************************************/
@@ -15,24 +15,28 @@ Includes
 -----------------------------------------------------------------------------*/
 #include "animator_private.hpp"
 #include "pico/time.h"
-#include "holly_jolly_cfg.hpp"
 #include <cstdlib>
-#include <cstring>
 
 namespace Animator
 {
   /*---------------------------------------------------------------------------
-  Static Data
+  Aliases
   ---------------------------------------------------------------------------*/
 
-  static uint32_t led_idx;
-  static uint32_t color;
+  using Envelopes = EnvelopeBank<LED::count()>;
 
   /*---------------------------------------------------------------------------
-  Idle Animation Class
+  Constants
   ---------------------------------------------------------------------------*/
 
-  Twinkle::Twinkle()
+  static constexpr uint16_t ATTACK_RATE = Envelopes::rateFromUs( 80'000 );     // Quick flash on
+  static constexpr uint16_t DECAY_RATE  = Envelopes::rateFromUs( 900'000 );    // Slow fade out
+
+  /*---------------------------------------------------------------------------
+  Twinkle Animation Class
+  ---------------------------------------------------------------------------*/
+
+  Twinkle::Twinkle() : m_ticker(), m_state( nullptr )
   {
   }
 
@@ -44,37 +48,48 @@ namespace Animator
 
   void Twinkle::initialize()
   {
-    led_idx       = 0;
-    color         = 0;
-    m_next_update = delayed_by_ms( get_absolute_time(), 500 );
+    m_state = acquire_state<State>();
+    m_ticker.start( 500'000, 250'000 );
   }
 
 
-  bool Twinkle::process()
+  bool Twinkle::process( const FrameTime &time )
   {
-    if( absolute_time_diff_us( get_absolute_time(), m_next_update ) > 0 )
+    /*-------------------------------------------------------------------------
+    Flash a new set of LEDs on every tick. One that is still fading out
+    brightens again from where it is.
+    -------------------------------------------------------------------------*/
+    if( m_ticker.advance( time ) != 0 )
     {
-      return false;
-    }
-
-    m_next_update = delayed_by_ms( get_absolute_time(), 250 );
+      const Color::Palette256 &theme = palette();
 
-    uint32_t *p_render_buffer = LED::getRenderBuffer();
-    memset( p_render_buffer, 0, sizeof( uint32_t ) * LED::count() );
+      for( uint32_t i = 0; i < State::LIT_COUNT; i++ )
+      {
+        const uint32_t led_idx = rand() % LED::count();
 
-    for( uint32_t i = 0; i < 10; i++ )
-    {
-      led_idx = rand() % LED::count();
-      color   = COLOR_LIST[ rand() % COLOR_LIST_SIZE ];
-
-      p_render_buffer[ led_idx ] = color;
+        m_state->colors[ led_idx ] = theme[ ( rand() & 0x0F ) << 4 ];    // Keyframes only, so colors stay crisp
+        m_state->envelopes.trigger( led_idx, ATTACK_RATE, DECAY_RATE );
+      }
     }
 
+    /*-------------------------------------------------------------------------
+    Every LED is redrawn on every frame, since fades are always in flight
+    -------------------------------------------------------------------------*/
+    LED::markAllDirty();
+
     return true;
   }
 
 
+  void __not_in_flash_func( Twinkle::render )( const FrameTime &time, const uint32_t first, const uint32_t end )
+  {
+    m_state->envelopes.update( time.dt_us, first, end );
+    m_state->envelopes.render( m_state->colors, LED::getRenderBuffer(), first, end );
+  }
+
+
   void Twinkle::stop()
   {
+    release_state( m_state );
   }
 }    // namespace Animator
@@ -14,6 +14,14 @@ Includes
 #include "animator.hpp"
 #include "animator_private.hpp"
 #include "buttons.hpp"
+#include "holly_jolly_cfg.hpp"
+#include "mirror.hpp"
+#include "parallel.hpp"
+#include "pico/platform.h"
+#include "post_process.hpp"
+#include "sync.hpp"
+#include "telemetry.hpp"
+#include "trace.hpp"
 #include "ws2812.hpp"
 
 namespace Animator
@@ -26,20 +34,38 @@ namespace Animator
   static constexpr float MIN_BRIGHTNESS  = 0.1f;
   static constexpr float BRIGHTNESS_STEP = 0.1f;
 
+  /**
+   * @brief Longest time step an animation will be asked to take in one frame.
+   * Guards against huge jumps after the core was halted by a debugger.
+   */
+  static constexpr uint32_t MAX_FRAME_DT_US = 1'000'000;
+
   /*---------------------------------------------------------------------------
   Static Data
   ---------------------------------------------------------------------------*/
-  static IAnimation      *s_animators[ AnimationIndex::COUNT ];
+  static Animations       s_animations;
   static volatile uint8_t s_animation_idx;
   static volatile float   s_global_brightness;
+  static bool             s_state_in_use;
+  static FrameTime        s_frame_time;
+  static PostProcess      s_post_process;
+  static volatile uint8_t s_palette_id;
+  static uint32_t         s_animation_seed;
+  static uint8_t          s_generation;
+
+  alignas( Animations::stateAlignment() ) static uint8_t s_state_arena[ Animations::stateSize() ];
 
   /*---------------------------------------------------------------------------
   Static Function Declarations
   ---------------------------------------------------------------------------*/
-  static IAnimation *get_current_animation();
-  static void        scale_global_brightness();
-  static void        on_button_bright_press();
-  static void        on_button_action_press();
+  static void post_process( const uint32_t *const src, uint32_t *const dst, const LED::DirtyRegion &damage,
+                            const uint32_t first, const uint32_t end );
+  static void present_frame();
+  template<typename Render>
+  static void present_frame( Render &&render );
+  static void switch_animation( const uint8_t idx, const uint32_t seed );
+  static void on_button_bright_press();
+  static void on_button_action_press();
 
   /*---------------------------------------------------------------------------
   Public Functions
@@ -50,17 +76,20 @@ namespace Animator
     /*-------------------------------------------------------------------------
     Initialize the static variables
     -------------------------------------------------------------------------*/
-    memset( s_animators, 0, sizeof( IAnimation * ) * AnimationIndex::COUNT );
-    s_animation_idx = AnimationIndex::IDLE;
+    s_animation_idx     = Animations::indexOf<IdleAnimation>();
     s_global_brightness = 0.2f;
+    s_palette_id        = Color::PALETTE_CLASSIC;
+    s_state_in_use      = false;
+    s_animation_seed    = 1;
+    s_generation        = 0;
+    s_frame_time        = { Sync::now(), 0, 0 };
+    Telemetry::initialize();
 
     /*-------------------------------------------------------------------------
-    Bind the animations to their respective indexes
+    Start the first animation so that it owns the state arena
     -------------------------------------------------------------------------*/
-    s_animators[ AnimationIndex::IDLE ]         = new IdleAnimation();
-    s_animators[ AnimationIndex::COLOR_BLOCKS ] = new FullSweepColorBlock();
-    s_animators[ AnimationIndex::TWINKLE ]      = new Twinkle();
-    s_animators[ AnimationIndex::SOFT_GLOW ]    = new SoftGlow();
+    srand( s_animation_seed );
+    s_animations.visit( s_animation_idx, []( auto &animation ) { animation.initialize(); } );
 
     /*-------------------------------------------------------------------------
     Register the button callbacks
@@ -75,25 +104,116 @@ namespace Animator
     bool draw_frame = false;
 
     /*-------------------------------------------------------------------------
-    Process the current animation, drawing the next frame to the render buffer.
+    Advance the animation clock by however much shared time has passed. When
+    following another tree, this runs slightly fast or slow until the two
+    clocks agree.
     -------------------------------------------------------------------------*/
-    IAnimation *current = get_current_animation();
-    if( current != nullptr )
-    {
-      draw_frame = current->process();
-      scale_global_brightness();
-    }
+    const absolute_time_t now     = Sync::now();
+    const int64_t         elapsed = absolute_time_diff_us( s_frame_time.timestamp, now );
+
+    s_frame_time.timestamp = now;
+    s_frame_time.dt_us     = static_cast<uint32_t>( std::clamp<int64_t>( elapsed, 0, MAX_FRAME_DT_US ) );
+    s_frame_time.dt        = FixedPoint::secondsFromUs( s_frame_time.dt_us );
 
     /*-------------------------------------------------------------------------
-    Swap the render buffers to display the new frame.
+    Process the current animation, drawing the next frame to the render buffer,
+    then post-process and display it. Ranged animations draw their LEDs in the
+    same pass as post-processing, split across both cores when possible.
     -------------------------------------------------------------------------*/
-    if( draw_frame )
+    Trace::record( Trace::EVENT_FRAME_BEGIN, s_animation_idx );
+
+    const uint32_t frame_start = Telemetry::cycles();
+    Telemetry::beginFrame();
+
+    const bool valid = s_animations.visit( s_animation_idx, [ &draw_frame ]( auto &animation ) {
+      const uint32_t start = Telemetry::cycles();
+      draw_frame           = animation.process( s_frame_time );
+      Telemetry::recordDispatch( Telemetry::cyclesSince( start ) );
+
+      if( !draw_frame )
+      {
+        return;
+      }
+
+      if constexpr( HasRangeRender<std::decay_t<decltype( animation )>>::value )
+      {
+        present_frame( [ &animation ]( const uint32_t first, const uint32_t end ) {
+          animation.render( s_frame_time, first, end );
+        } );
+      }
+      else
+      {
+        present_frame();
+      }
+    } );
+
+    Telemetry::recordFrame( Telemetry::cyclesSince( frame_start ) );
+    Trace::record( Trace::EVENT_FRAME_END, valid && draw_frame );
+  }
+
+
+  void setPalette( const Color::PaletteId id )
+  {
+    if( id < Color::PALETTE_COUNT )
     {
-      LED::swapBuffers();
+      s_palette_id = id;
     }
   }
 
 
+  Color::PaletteId getPalette()
+  {
+    return static_cast<Color::PaletteId>( s_palette_id );
+  }
+
+
+  void startAnimation( const uint8_t idx, const uint32_t seed, const uint8_t generation )
+  {
+    if( idx < ANIMATION_COUNT )
+    {
+      switch_animation( idx, seed );
+      s_generation = generation;
+    }
+  }
+
+
+  uint8_t getAnimation()
+  {
+    return s_animation_idx;
+  }
+
+
+  uint32_t getAnimationSeed()
+  {
+    return s_animation_seed;
+  }
+
+
+  uint8_t getGeneration()
+  {
+    return s_generation;
+  }
+
+
+  void setBrightness( const uint8_t level )
+  {
+    s_global_brightness = level / 255.0f;
+    LED::resetBuffers();
+  }
+
+
+  uint8_t getBrightness()
+  {
+    return static_cast<uint8_t>( s_global_brightness * 255.0f + 0.5f );
+  }
+
+
+  const Color::Palette256 &palette()
+  {
+    return Color::getPalette( static_cast<Color::PaletteId>( s_palette_id ) );
+  }
+
+
   void set_led_properties( uint32_t *const buffer, const uint32_t index, const uint32_t color, const float brightness )
   {
     uint8_t blue  = ( color & LED::WS2812_BLUE_MSK ) >> 16;
@@ -107,51 +227,107 @@ namespace Animator
     buffer[ index ] = ( ( blue << 16 ) | ( red << 8 ) | green ) & LED::WS2812_DATA_MSK;
   }
 
+  void *acquire_state_memory( const size_t size, const size_t alignment )
+  {
+    /*-------------------------------------------------------------------------
+    The arena is sized at compile time from every registered State, so these
+    can only trip if an animation asks for something it didn't declare.
+    -------------------------------------------------------------------------*/
+    if( s_state_in_use || ( size > sizeof( s_state_arena ) ) || ( alignment > Animations::stateAlignment() ) )
+    {
+      panic( "Animation state arena misuse" );
+    }
+
+    s_state_in_use = true;
+    return s_state_arena;
+  }
+
+
+  void release_state_memory()
+  {
+    s_state_in_use = false;
+  }
+
   /*---------------------------------------------------------------------------
   Static Function Implementations
   ---------------------------------------------------------------------------*/
 
   /**
-   * @brief Safely retrieves the current animation object.
+   * @brief Brings the back buffer up to date with the render canvas and displays it
    *
-   * Animations are updated inside an ISR context, so the current selection
-   * can be changed at any time. This function ensures that the current
-   * animation is retrieved in a ISR safe manner.
+   * Only the spans that changed since the back buffer was last written are
+   * processed. The rest of it already holds the right post-processed colors.
+   */
+  static void present_frame()
+  {
+    present_frame( []( const uint32_t, const uint32_t ) {} );
+  }
+
+
+  /**
+   * @brief Draws a range of the render canvas, then post-processes and displays it
    *
-   * @return IAnimation*
+   * The string is split into ranges that may run on both cores at once. Each
+   * range is drawn and then post-processed where it overlaps the damage, so
+   * the only wait between the cores is the one before the swap.
+   *
+   * @param render  Callable taking ( uint32_t first, uint32_t end ) that draws that range
    */
-  static IAnimation *get_current_animation()
+  template<typename Render>
+  static void present_frame( Render &&render )
   {
-    IAnimation *current = nullptr;
-    if( s_animation_idx < AnimationIndex::COUNT )
+    const uint32_t brightness = static_cast<uint32_t>( s_global_brightness * 256.0f );
+    if constexpr( LED::HARDWARE_BRIGHTNESS )
+    {
+      LED::setGlobalBrightness( brightness );
+    }
+    else
     {
-      current = s_animators[ s_animation_idx ];
+      s_post_process.stage<BrightnessStage>().scale = brightness;
     }
 
-    return current;
+    const LED::DirtyRegion damage   = LED::getDamage();
+    const uint32_t *const  p_canvas = LED::getRenderBuffer();
+    uint32_t *const        p_back   = LED::getBackBuffer();
+
+    Parallel::forEach( LED::count(), [ & ]( const uint32_t first, const uint32_t end ) {
+      render( first, end );
+      post_process( p_canvas, p_back, damage, first, end );
+    } );
+
+    LED::swapBuffers();
+
+    if constexpr( USB_MIRROR )
+    {
+      Mirror::capture( LED::getDisplayBuffer() );
+    }
   }
 
 
   /**
-   * @brief Scales the global brightness of the LED string
+   * @brief Post-processes the damaged LEDs within [first, end)
+   *
+   * Runs from RAM, since this is the brightness pass over every changed LED.
+   *
+   * @param src     Render canvas to read from
+   * @param dst     Back buffer to write to
+   * @param damage  LEDs that need processing
+   * @param first   First LED to process
+   * @param end     One past the last LED to process
    */
-  static void scale_global_brightness()
+  static void __not_in_flash_func( post_process )( const uint32_t *const src, uint32_t *const dst,
+                                                   const LED::DirtyRegion &damage, const uint32_t first,
+                                                   const uint32_t end )
   {
-    uint32_t *p_render_buffer = LED::getRenderBuffer();
-
-    for( uint32_t i = 0; i < LED::count(); i++ )
+    for( size_t i = 0; i < damage.size(); i++ )
     {
-      uint32_t color = p_render_buffer[ i ];
-
-      uint8_t blue  = ( color & LED::WS2812_BLUE_MSK ) >> 16;
-      uint8_t red   = ( color & LED::WS2812_RED_MSK ) >> 8;
-      uint8_t green = ( color & LED::WS2812_GREEN_MSK );
-
-      red   = static_cast<uint8_t>( red * s_global_brightness );
-      green = static_cast<uint8_t>( green * s_global_brightness );
-      blue  = static_cast<uint8_t>( blue * s_global_brightness );
+      const LED::Span span = { std::max<uint32_t>( damage[ i ].first, first ),
+                               std::min<uint32_t>( damage[ i ].end, end ) };
 
-      p_render_buffer[ i ] = ( ( blue << 16 ) | ( red << 8 ) | green ) & LED::WS2812_DATA_MSK;
+      if( span.first < span.end )
+      {
+        s_post_process.run( src, dst, span );
+      }
     }
   }
 
@@ -169,33 +345,50 @@ namespace Animator
 
     /*-------------------------------------------------------------------------
     Clear out the buffer data to ensure a clean transition to the new
-    brightness level.
+    brightness level. This also marks every LED dirty, since the brightness
+    applies to all of them.
     -------------------------------------------------------------------------*/
     LED::resetBuffers();
   }
 
 
   /**
-   * @brief Switches to the next animation in the list
+   * @brief Stops the current animation and starts another from a known seed
+   *
+   * @param idx     Index of the animation to start
+   * @param seed    Seed for the random number generator
    */
-  static void on_button_action_press()
+  static void switch_animation( const uint8_t idx, const uint32_t seed )
   {
     /*-------------------------------------------------------------------------
     Stop the current animation and clear the render buffer
     -------------------------------------------------------------------------*/
-    IAnimation *current = s_animators[ s_animation_idx ];
-    if( current != nullptr )
+    if( s_animations.visit( s_animation_idx, []( auto &animation ) { animation.stop(); } ) )
     {
-      current->stop();
       memset( LED::getRenderBuffer(), 0, LED::count() * sizeof( uint32_t ) );
-      LED::swapBuffers();
+      LED::markAllDirty();
+      present_frame();
     }
 
     /*-------------------------------------------------------------------------
-    Switch to the next animation in the list
+    Seed before initializing, since most animations pick their starting state
+    at random. Trees started with the same seed draw the same frames.
     -------------------------------------------------------------------------*/
-    s_animation_idx = ( s_animation_idx + 1 ) % AnimationIndex::COUNT;
-    s_animators[ s_animation_idx ]->initialize();
+    s_animation_idx  = idx;
+    s_animation_seed = seed;
+    srand( seed );
+    Trace::record( Trace::EVENT_ANIMATION_SWITCH, idx );
+    s_animations.visit( s_animation_idx, []( auto &animation ) { animation.initialize(); } );
+  }
+
+
+  /**
+   * @brief Switches to the next animation in the list
+   */
+  static void on_button_action_press()
+  {
+    switch_animation( ( s_animation_idx + 1 ) % ANIMATION_COUNT, time_us_32() );
+    s_generation++;
   }
 
 }    // namespace Animator
@@ -12,6 +12,12 @@
 #ifndef HOLLY_JOLLY_ANIMATION_HPP
 #define HOLLY_JOLLY_ANIMATION_HPP
 
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "color.hpp"
+#include <cstdint>
+
 namespace Animator
 {
   /*---------------------------------------------------------------------------
@@ -28,6 +34,67 @@ namespace Animator
    */
   void process();
 
+  /**
+   * @brief Selects the color theme used by palette driven animations
+   *
+   * Takes effect on the next frame drawn.
+   *
+   * @param id  Palette to use
+   */
+  void setPalette( const Color::PaletteId id );
+
+  /**
+   * @brief Gets the current color theme
+   * @return Color::PaletteId
+   */
+  Color::PaletteId getPalette();
+
+  /**
+   * @brief Stops the current animation and starts another
+   *
+   * Used to follow another tree, so the new animation draws exactly what the
+   * other tree's copy of it draws.
+   *
+   * @param idx         Index of the animation to start
+   * @param seed        Seed for the random number generator
+   * @param generation  Generation counter to adopt
+   */
+  void startAnimation( const uint8_t idx, const uint32_t seed, const uint8_t generation );
+
+  /**
+   * @brief Gets the index of the running animation
+   * @return uint8_t
+   */
+  uint8_t getAnimation();
+
+  /**
+   * @brief Gets the seed the running animation was started with
+   * @return uint32_t
+   */
+  uint32_t getAnimationSeed();
+
+  /**
+   * @brief Gets a counter that changes every time an animation is started
+   *
+   * Lets another tree tell a restart apart from the same animation running on.
+   *
+   * @return uint8_t
+   */
+  uint8_t getGeneration();
+
+  /**
+   * @brief Sets the global brightness
+   *
+   * @param level   Brightness from 0 to 255
+   */
+  void setBrightness( const uint8_t level );
+
+  /**
+   * @brief Gets the global brightness
+   * @return uint8_t
+   */
+  uint8_t getBrightness();
+
 }    // namespace Animator
 
 #endif /* !HOLLY_JOLLY_ANIMATION_HPP */
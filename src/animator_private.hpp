@@ -15,10 +15,22 @@
 /*-----------------------------------------------------------------------------
 Includes
 -----------------------------------------------------------------------------*/
+#include "audio_dsp.hpp"
+#include "color.hpp"
+#include "coroutine.hpp"
+#include "envelope.hpp"
+#include "fixed_point.hpp"
+#include "particles.hpp"
 #include "pico/time.h"
 #include "ws2812.hpp"
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 
 
 /*-----------------------------------------------------------------------------
@@ -27,40 +39,159 @@ Literals
 
 /**
  * @brief Helper macro to declare a basic animation class conforming to the IAnimation interface
+ *
+ * Each class must also define a nested State structure holding its working
+ * memory. See the Animation State section below.
+ */
+#define DECLARE_ANIMATION_CLASS( name )                    \
+  class name : public IAnimation                           \
+  {                                                        \
+  public:                                                  \
+    struct State;                                          \
+                                                           \
+    name();                                                \
+    ~name();                                               \
+    void initialize() final override;                      \
+    bool process( const FrameTime &time ) final override;  \
+    void stop() final override;                            \
+                                                           \
+  protected:                                               \
+    Ticker m_ticker;                                       \
+    State *m_state;                                        \
+  }
+
+/**
+ * @brief Declares an animation whose per-LED drawing can be split across cores
+ *
+ * process() runs first on core0 and does everything that must happen once per
+ * frame: advancing shared state, anything using rand(), and marking what will
+ * change. render() then draws ranges of LEDs, possibly on both cores at once,
+ * so it may only write its own range. See Parallel::run().
  */
-#define DECLARE_ANIMATION_CLASS( name ) \
-  class name : public IAnimation        \
-  {                                     \
-  public:                               \
-    name();                             \
-    ~name();                            \
-    void initialize() final override;   \
-    bool process() final override;      \
-    void stop() final override;         \
-                                        \
-  protected:                            \
-    absolute_time_t m_next_update;      \
+#define DECLARE_RANGED_ANIMATION_CLASS( name )                                      \
+  class name : public IAnimation                                                    \
+  {                                                                                 \
+  public:                                                                           \
+    struct State;                                                                   \
+                                                                                    \
+    name();                                                                         \
+    ~name();                                                                        \
+    void initialize() final override;                                               \
+    bool process( const FrameTime &time ) final override;                           \
+    void render( const FrameTime &time, const uint32_t first, const uint32_t end ); \
+    void stop() final override;                                                     \
+                                                                                    \
+  protected:                                                                        \
+    Ticker m_ticker;                                                                \
+    State *m_state;                                                                 \
   }
 
 namespace Animator
 {
   /*---------------------------------------------------------------------------
-  Enumerations
+  Structures
   ---------------------------------------------------------------------------*/
 
-  enum AnimationIndex : uint8_t
+  /**
+   * @brief Timing information for the frame being drawn
+   *
+   * Every animation sees the same clock for a given frame. Animations should
+   * derive all motion from this rather than reading the system time, so that
+   * their speed doesn't depend on FRAME_REFRESH_RATE_MS or on skipped frames.
+   */
+  struct FrameTime
   {
-    IDLE,
-    COLOR_BLOCKS,
-    TWINKLE,
-    SOFT_GLOW,
-    COUNT
+    absolute_time_t   timestamp;    // Animation clock time of this frame
+    uint32_t          dt_us;        // Time elapsed since the previous frame
+    FixedPoint::q16_t dt;           // Same as dt_us, in seconds
   };
 
   /*---------------------------------------------------------------------------
   Private Classes
   ---------------------------------------------------------------------------*/
 
+  /**
+   * @brief Converts elapsed frame time into a whole number of fixed period steps
+   *
+   * Use this for effects that change in discrete jumps. Steps are never lost,
+   * so if several periods elapse in one frame they are all reported. A period
+   * of zero makes the ticker one shot: it steps once after the delay and then
+   * goes quiet.
+   */
+  class Ticker
+  {
+  public:
+    Ticker() : m_remaining_us( 0 ), m_period_us( 0 )
+    {
+    }
+
+    /**
+     * @brief Restarts the ticker
+     *
+     * @param delay_us    Time until the first step
+     * @param period_us   Time between each following step
+     */
+    void start( const uint32_t delay_us, const uint32_t period_us )
+    {
+      m_remaining_us = delay_us;
+      m_period_us    = period_us;
+    }
+
+    /**
+     * @brief Advances the ticker by a frame's worth of time
+     *
+     * @param time        Frame timing
+     * @return uint32_t   Number of steps that elapsed during the frame
+     */
+    uint32_t advance( const FrameTime &time )
+    {
+      uint32_t steps = 0;
+      uint32_t dt    = time.dt_us;
+
+      if( ( m_period_us == 0 ) && ( m_remaining_us == 0 ) )
+      {
+        return 0;
+      }
+
+      while( dt >= m_remaining_us )
+      {
+        dt -= m_remaining_us;
+        steps++;
+
+        m_remaining_us = m_period_us;
+        if( m_period_us == 0 )
+        {
+          return steps;
+        }
+      }
+
+      m_remaining_us -= dt;
+      return steps;
+    }
+
+    /**
+     * @brief How far through the current period the ticker is
+     *
+     * Useful as the factor for FixedPoint::lerp8() when blending between the
+     * previous and next step.
+     *
+     * @return uint32_t   Progress from 0 to 256
+     */
+    uint32_t progress() const
+    {
+      if( m_period_us == 0 )
+      {
+        return 0;
+      }
+
+      return ( ( m_period_us - m_remaining_us ) << 8 ) / m_period_us;
+    }
+
+  private:
+    uint32_t m_remaining_us;
+    uint32_t m_period_us;
+  };
+
   /**
    * @brief Virtual interface to an animation object
    *
@@ -81,9 +212,10 @@ namespace Animator
     /**
      * @brief Process any animation updates
      * This is called periodically to update the animation state.
+     * @param time   Animation clock for the frame being drawn
      * @return bool  True if a new frame was drawn, false otherwise
      */
-    virtual bool process() = 0;
+    virtual bool process( const FrameTime &time ) = 0;
 
     /**
      * @brief Stops the animation, bringing it to an idle state.
@@ -92,16 +224,198 @@ namespace Animator
     virtual void stop() = 0;
   };
 
-  /* Make sure to add these animation classes to the initialize() method of animator.cpp */
+  /**
+   * @brief Compile time list of animations with static storage
+   *
+   * Every animation is constructed in place inside the registry, so nothing is
+   * heap allocated. Dispatch expands into a chain of index compares that call
+   * the concrete type directly, letting the compiler devirtualize and inline
+   * each animation's methods.
+   *
+   * @tparam Animations   Animation classes, in the order they are cycled through
+   */
+  template<typename... Animations>
+  class AnimationRegistry
+  {
+  public:
+    /**
+     * @brief Number of animations in the registry
+     * @return size_t
+     */
+    static constexpr size_t size()
+    {
+      return sizeof...( Animations );
+    }
+
+    /**
+     * @brief Looks up the index of an animation type
+     * @return size_t
+     */
+    template<typename T>
+    static constexpr size_t indexOf()
+    {
+      constexpr bool matches[] = { std::is_same_v<T, Animations>... };
+      for( size_t i = 0; i < size(); i++ )
+      {
+        if( matches[ i ] )
+        {
+          return i;
+        }
+      }
+
+      return size();
+    }
+
+    /**
+     * @brief Size of the largest State structure across all animations
+     * @return size_t
+     */
+    static constexpr size_t stateSize()
+    {
+      return std::max( { sizeof( typename Animations::State )... } );
+    }
+
+    /**
+     * @brief Strictest alignment of any State structure across all animations
+     * @return size_t
+     */
+    static constexpr size_t stateAlignment()
+    {
+      return std::max( { alignof( typename Animations::State )... } );
+    }
+
+    /**
+     * @brief Invokes a visitor on the animation at an index
+     *
+     * @param index     Which animation to visit
+     * @param visitor   Callable taking the concrete animation type by reference
+     * @return bool     True if the index was valid
+     */
+    template<typename Visitor>
+    bool visit( const size_t index, Visitor &&visitor )
+    {
+      return visit_impl( index, visitor, std::index_sequence_for<Animations...>{} );
+    }
+
+  private:
+    std::tuple<Animations...> m_storage;
+
+    template<typename Visitor, size_t... Is>
+    bool visit_impl( const size_t index, Visitor &visitor, std::index_sequence<Is...> )
+    {
+      return ( ( ( index == Is ) ? ( visitor( std::get<Is>( m_storage ) ), true ) : false ) || ... );
+    }
+  };
+
+  /**
+   * @brief Checks if an animation was declared with DECLARE_RANGED_ANIMATION_CLASS
+   */
+  template<typename T, typename = void>
+  struct HasRangeRender : std::false_type
+  {
+  };
+
+  template<typename T>
+  struct HasRangeRender<T, std::void_t<decltype( std::declval<T &>().render( std::declval<const FrameTime &>(), 0u, 0u ) )>>
+      : std::true_type
+  {
+  };
+
   DECLARE_ANIMATION_CLASS( IdleAnimation );
   DECLARE_ANIMATION_CLASS( FullSweepColorBlock );
-  DECLARE_ANIMATION_CLASS( Twinkle );
-  DECLARE_ANIMATION_CLASS( SoftGlow );
+  DECLARE_RANGED_ANIMATION_CLASS( Twinkle );
+  DECLARE_RANGED_ANIMATION_CLASS( SoftGlow );
+  DECLARE_ANIMATION_CLASS( AudioSpectrum );
+  DECLARE_ANIMATION_CLASS( Sparks );
+  DECLARE_ANIMATION_CLASS( Candle );
+  DECLARE_ANIMATION_CLASS( ImageScroll );
+
+  /**
+   * @brief All animations available on the tree.
+   * Add new animation classes here. The action button cycles through them in order.
+   */
+  using Animations = AnimationRegistry<IdleAnimation, FullSweepColorBlock, Twinkle, SoftGlow, AudioSpectrum, Sparks,
+                                       Candle, ImageScroll>;
+
+  static constexpr size_t ANIMATION_COUNT = Animations::size();
+
+  /*---------------------------------------------------------------------------
+  Animation State
+
+  Working memory for each animation. Only one animation runs at a time, so
+  all of them share a single arena sized to the largest State. Anything that
+  must survive between frames belongs here rather than in file static data.
+  ---------------------------------------------------------------------------*/
+
+  struct IdleAnimation::State
+  {
+    Coroutine         co;          // Resume point of the chase sequence
+    FixedPoint::q16_t position;    // Where the chasing light is, in LEDs
+    uint32_t          lit_idx;     // First of the two LEDs it covers, cleared before the next draw
+    uint32_t          color;       // Index of the color it is fading away from
+  };
+
+  struct FullSweepColorBlock::State
+  {
+    uint32_t color;    // Index of the next color to sweep
+  };
+
+  struct Twinkle::State
+  {
+    static constexpr uint32_t LIT_COUNT = 10;    // LEDs lit on each step
+
+    EnvelopeBank<LED::count()> envelopes;
+    uint32_t                   colors[ LED::count() ];
+  };
+
+  struct SoftGlow::State
+  {
+    bool                       running;    // Initial delay has elapsed
+    EnvelopeBank<LED::count()> envelopes;
+    uint32_t                   colors[ LED::count() ];
+  };
+
+  struct AudioSpectrum::State
+  {
+    Audio::Analyzer analyzer;                       // FFT working memory and gain history
+    int16_t         samples[ Audio::FFT_SIZE ];     // Latest window copied out of the capture ring
+    uint8_t         levels[ Audio::BAND_COUNT ];    // Displayed level of each band
+    uint8_t         flash;                          // Beat flash intensity
+  };
+
+  struct Sparks::State
+  {
+    static constexpr size_t CAPACITY = 384;    // Enough for a steady stream of sparks
+
+    ParticleSystem<CAPACITY> particles;
+    uint32_t                 spawn_credit_us;    // Time banked toward the next spawn
+  };
+
+  struct Candle::State
+  {
+    uint32_t flicker_time;    // Noise coordinate for each flame's flicker
+    uint32_t draft_time;      // Noise coordinate for the draft shared by every flame
+  };
+
+  struct ImageScroll::State
+  {
+    uint32_t scroll;    // Horizontal image offset in pixels, 16.16 fixed point
+  };
 
   /*---------------------------------------------------------------------------
   Private Functions
   ---------------------------------------------------------------------------*/
 
+  /**
+   * @brief Gets the palette of the current color theme
+   *
+   * Animations should sample this rather than hardcoding colors, so that
+   * switching themes is a single pointer lookup.
+   *
+   * @return const Color::Palette256&
+   */
+  const Color::Palette256 &palette();
+
   /**
    * @brief Set the brightness of a specific LED in the string
    *
@@ -112,6 +426,51 @@ namespace Animator
    */
   void set_led_properties( uint32_t *const buffer, const uint32_t index, const uint32_t color, const float brightness );
 
+  /**
+   * @brief Hands out the shared animation state arena
+   *
+   * Only one animation may hold the arena at a time. The Animator guarantees
+   * this by stopping the current animation before starting the next one.
+   *
+   * @param size      Number of bytes required
+   * @param alignment Required alignment of the memory
+   * @return void*    Start of the arena
+   */
+  void *acquire_state_memory( const size_t size, const size_t alignment );
+
+  /**
+   * @brief Returns the shared animation state arena
+   */
+  void release_state_memory();
+
+  /**
+   * @brief Acquires the state arena and constructs an animation's State in it
+   *
+   * @tparam T    State structure to construct
+   * @return T*   Value initialized State object
+   */
+  template<typename T>
+  T *acquire_state()
+  {
+    return new( acquire_state_memory( sizeof( T ), alignof( T ) ) ) T();
+  }
+
+  /**
+   * @brief Destroys an animation's State and returns the arena
+   *
+   * @param state   State previously returned from acquire_state()
+   */
+  template<typename T>
+  void release_state( T *&state )
+  {
+    if( state )
+    {
+      state->~T();
+      state = nullptr;
+      release_state_memory();
+    }
+  }
+
 }  // namespace Animator
 
 #endif  /* !HOLLY_JOLLY_INTERNAL_ANIMATOR_HPP */
@@ -0,0 +1,426 @@
+/******************************************************************************
+ *  File Name:
+ *    apa102.cpp
+ *
+ *  Description:
+ *    Driver implementation for a string of clocked APA102/SK9822 LEDs, fed
+ *    from SPI by DMA. Selected in place of ws2812.cpp with the
+ *    HOLLY_JOLLY_LED_APA102 CMake option.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "apa102_frame.hpp"
+#include "hardware/dma.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "hardware/spi.h"
+#include "hardware/sync.h"
+#include "pico/platform.h"
+#include "pico/time.h"
+#include "telemetry.hpp"
+#include "trace.hpp"
+#include "ws2812.hpp"
+#include <algorithm>
+#include <cstring>
+
+/*---------------------------------------------------------------------------
+Literals
+---------------------------------------------------------------------------*/
+
+#define SPI_INSTANCE ( spi0 )   // SPI instance to use for driving the LEDs
+
+namespace LED
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr uint     APA102_CLOCK_PIN  = 22;            // GPIO for the clock line, SPI0 SCK
+  static constexpr uint     APA102_DATA_PIN   = 23;            // GPIO for the data line, SPI0 TX, same as the WS2812 data
+  static constexpr uint32_t APA102_CLOCK_HZ   = 12'000'000;    // Requested data clock, kept down for long cable runs
+  static constexpr uint32_t SPI_TX_FIFO_BYTES = 8;             // Bytes the SPI holds after the DMA is done
+  static constexpr size_t   FRAME_BYTES       = apa102FrameBytes( WS2812_NUM_LEDS );
+
+  /*---------------------------------------------------------------------------
+  Structures
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief One of the two display buffers and the wire frame encoded from it
+   */
+  struct FrameBuffer
+  {
+    uint32_t colors[ WS2812_NUM_LEDS ];    // Post-processed colors, 0x00BBRRGG
+    uint8_t  wire[ FRAME_BYTES ];          // What the DMA sends
+    uint8_t  level;                        // Global brightness the wire frame was encoded with
+  };
+
+  /*---------------------------------------------------------------------------
+  Variables
+  ---------------------------------------------------------------------------*/
+
+  static uint32_t     s_canvas[ WS2812_NUM_LEDS ];    // Render canvas, persists between frames
+  static FrameBuffer  s_frames[ 2 ];                  // Double buffered LED data
+  static FrameBuffer *sp_back;                        // Buffer being prepared
+  static FrameBuffer *sp_display;                     // Buffer on the wire
+  static DirtyRegion  s_dirty;                        // Canvas changes since the last swap
+  static DirtyRegion  s_prev_dirty;                   // Canvas changes in the frame before that
+  static int          s_dma_channel;                  // DMA channel for transferring data to the SPI
+  static uint32_t     s_clock_hz;                     // Data clock the SPI actually runs at
+  static uint8_t      s_level;                        // Global brightness for the next frame
+  static uint8_t      s_output_mode;                  // How the main loop paces frames
+
+  static volatile bool s_wire_idle;       // Last frame fully shifted out, a transfer may start now
+  static volatile bool s_frame_queued;    // A swapped frame is waiting for the wire
+
+  /*---------------------------------------------------------------------------
+  Static Function Declarations
+  ---------------------------------------------------------------------------*/
+
+  static void    dma_complete_callback();
+  static int64_t latch_complete_callback( alarm_id_t id, void *user_data );
+  static void    start_transfer();
+  static void    encode_back_buffer();
+  static void    init_spi();
+  static void    init_dma();
+
+  /*---------------------------------------------------------------------------
+  Public Functions
+  ---------------------------------------------------------------------------*/
+
+  void initialize()
+  {
+    /*-------------------------------------------------------------------------
+    Initialize the LED buffers and set the initial buffer pointers
+    -------------------------------------------------------------------------*/
+    s_dma_channel  = 0;
+    s_level        = APA102_MAX_LEVEL;
+    s_output_mode  = WS2812_DEFAULT_OUTPUT_MODE;
+    s_wire_idle    = true;
+    s_frame_queued = false;
+    sp_back        = &s_frames[ 0 ];
+    sp_display     = &s_frames[ 1 ];
+    memset( s_canvas, 0, sizeof( s_canvas ) );
+    s_dirty.clear();
+    s_prev_dirty.clear();
+
+    for( FrameBuffer &frame : s_frames )
+    {
+      memset( frame.colors, 0, sizeof( frame.colors ) );
+      apa102EncodeFrame( frame.colors, WS2812_NUM_LEDS, s_level, frame.wire );
+      frame.level = s_level;
+    }
+
+    /*-------------------------------------------------------------------------
+    Initialize the SPI and DMA peripherals
+    -------------------------------------------------------------------------*/
+    init_spi();
+    init_dma();
+
+    /*-------------------------------------------------------------------------
+    Start the first frame transfer by clearing the display buffer
+    -------------------------------------------------------------------------*/
+    swapBuffers();
+  }
+
+
+  uint32_t *getRenderBuffer()
+  {
+    return s_canvas;
+  }
+
+
+  void markDirty( const uint32_t first, const uint32_t count )
+  {
+    if( first < WS2812_NUM_LEDS )
+    {
+      s_dirty.add( first, first + std::min( count, WS2812_NUM_LEDS - first ) );
+    }
+  }
+
+
+  void markAllDirty()
+  {
+    s_dirty.clear();
+    s_dirty.add( 0, WS2812_NUM_LEDS );
+  }
+
+
+  DirtyRegion getDamage()
+  {
+    DirtyRegion damage = s_dirty;
+    damage.merge( s_prev_dirty );
+    return damage;
+  }
+
+
+  uint32_t *getBackBuffer()
+  {
+    return sp_back->colors;
+  }
+
+
+  const uint32_t *getDisplayBuffer()
+  {
+    return sp_display->colors;
+  }
+
+
+  void swapBuffers()
+  {
+    /*---------------------------------------------------------------------------
+    Encode before the damage is rotated out, it says which LEDs to update. The
+    back buffer finished its last transfer before the previous swap and only
+    the display buffer is ever started since, so this can't race the DMA.
+    ---------------------------------------------------------------------------*/
+    encode_back_buffer();
+
+    /*---------------------------------------------------------------------------
+    Wait for the DMA to finish reading the display buffer so it can be handed
+    back for rendering. The data may still be shifting out of the SPI. The
+    latch alarm can start a queued frame between the wait and the swap, so
+    only go ahead once the DMA is seen idle with interrupts off.
+    ---------------------------------------------------------------------------*/
+    uint32_t irq_state = 0;
+    while( true )
+    {
+      dma_channel_wait_for_finish_blocking( s_dma_channel );
+
+      irq_state = save_and_disable_interrupts();
+      if( !dma_channel_is_busy( s_dma_channel ) )
+      {
+        break;
+      }
+
+      restore_interrupts( irq_state );
+    }
+
+    s_prev_dirty = s_dirty;
+    s_dirty.clear();
+
+    /*---------------------------------------------------------------------------
+    Swap and either start the transfer now or leave it for the alarm to start
+    once the last frame is out. If a frame was already queued it is replaced
+    by this newer one.
+    ---------------------------------------------------------------------------*/
+    FrameBuffer *p_temp = sp_back;
+    sp_back             = sp_display;
+    sp_display          = p_temp;
+
+    Trace::record( Trace::EVENT_SWAP, !s_wire_idle );
+    if( s_wire_idle )
+    {
+      start_transfer();
+    }
+    else
+    {
+      s_frame_queued = true;
+    }
+
+    restore_interrupts( irq_state );
+  }
+
+
+  bool readyForFrame()
+  {
+    return !s_frame_queued;
+  }
+
+
+  void setOutputMode( const OutputMode mode )
+  {
+    s_output_mode = mode;
+  }
+
+
+  OutputMode getOutputMode()
+  {
+    return static_cast<OutputMode>( s_output_mode );
+  }
+
+
+  bool setTimingProfile( const TimingProfile profile )
+  {
+    return profile == WS2812_DEFAULT_TIMING;
+  }
+
+
+  TimingProfile getTimingProfile()
+  {
+    return WS2812_DEFAULT_TIMING;
+  }
+
+
+  uint32_t frameTimeUs()
+  {
+    return static_cast<uint32_t>( ( ( FRAME_BYTES * 8ull * 1'000'000u ) + s_clock_hz - 1 ) / s_clock_hz );
+  }
+
+
+  void setGlobalBrightness( const uint32_t scale )
+  {
+    s_level = apa102Level( scale );
+  }
+
+
+  void resetBuffers()
+  {
+    dma_channel_wait_for_finish_blocking( s_dma_channel );
+
+    memset( s_canvas, 0, sizeof( s_canvas ) );
+    memset( sp_back->colors, 0, sizeof( sp_back->colors ) );
+    memset( sp_display->colors, 0, sizeof( sp_display->colors ) );
+    markAllDirty();
+  }
+
+  /*---------------------------------------------------------------------------
+  Static Functions
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Brings the back buffer's wire frame up to date with its colors
+   *
+   * The wire frame was encoded when its colors were last written, two frames
+   * ago, so only the damaged LEDs need encoding again. A brightness change
+   * touches every LED record instead.
+   */
+  static void encode_back_buffer()
+  {
+    const uint8_t level = s_level;
+    if( sp_back->level != level )
+    {
+      apa102EncodeLeds( sp_back->colors, 0, WS2812_NUM_LEDS, level, sp_back->wire );
+      sp_back->level = level;
+      return;
+    }
+
+    const DirtyRegion damage = getDamage();
+    for( size_t i = 0; i < damage.size(); i++ )
+    {
+      apa102EncodeLeds( sp_back->colors, damage[ i ].first, damage[ i ].end, level, sp_back->wire );
+    }
+  }
+
+
+  /**
+   * @brief Initializes the SPI to clock data out to the LEDs
+   *
+   * The LEDs sample data on the rising clock edge with the clock idling low,
+   * which is SPI mode 0. Nothing is read back, so only SCK and TX are used.
+   */
+  static void init_spi()
+  {
+    s_clock_hz = spi_init( SPI_INSTANCE, APA102_CLOCK_HZ );
+    spi_set_format( SPI_INSTANCE, 8, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST );
+
+    gpio_set_function( APA102_CLOCK_PIN, GPIO_FUNC_SPI );
+    gpio_set_function( APA102_DATA_PIN, GPIO_FUNC_SPI );
+  }
+
+
+  /**
+   * @brief Initializes the DMA channel for transferring data to the SPI.
+   *
+   * The wire frame is already in byte order, so each transfer is a single
+   * burst of bytes into the SPI data register, restarted manually for every
+   * new frame.
+   */
+  static void init_dma()
+  {
+    s_dma_channel = dma_claim_unused_channel( true );
+    auto dma_cfg  = dma_channel_get_default_config( s_dma_channel );
+
+    channel_config_set_dreq( &dma_cfg, spi_get_dreq( SPI_INSTANCE, true ) );
+    channel_config_set_transfer_data_size( &dma_cfg, DMA_SIZE_8 );
+    channel_config_set_read_increment( &dma_cfg, true );
+    channel_config_set_write_increment( &dma_cfg, false );
+
+    dma_channel_configure( s_dma_channel, &dma_cfg, &spi_get_hw( SPI_INSTANCE )->dr, sp_display->wire, FRAME_BYTES,
+                           false );
+
+    /*---------------------------------------------------------------------------
+    Handle the transfer complete event
+    ---------------------------------------------------------------------------*/
+    dma_channel_set_irq0_enabled( s_dma_channel, true );
+    irq_set_exclusive_handler( DMA_IRQ_0, dma_complete_callback );
+    irq_set_enabled( DMA_IRQ_0, true );
+  }
+
+
+  /**
+   * @brief Acknowledge the DMA transfer complete event and wait out the SPI
+   *
+   * The DMA completes once the last byte is in the SPI FIFO. There is no latch
+   * gap on a clocked string, so the frame is done as soon as the FIFO drains.
+   */
+  static void __not_in_flash_func( dma_complete_callback )()
+  {
+    dma_channel_acknowledge_irq0( s_dma_channel );
+    Trace::record( Trace::EVENT_DMA_DONE );
+
+    const uint32_t drain_us = ( ( SPI_TX_FIFO_BYTES + 1 ) * 8u * 1'000'000u + s_clock_hz - 1 ) / s_clock_hz;
+
+    if( add_alarm_in_us( drain_us, latch_complete_callback, nullptr, true ) < 0 )
+    {
+      /*-----------------------------------------------------------------------
+      No alarm available. Wait for the SPI right here.
+      -----------------------------------------------------------------------*/
+      while( spi_is_busy( SPI_INSTANCE ) )
+      {
+        tight_loop_contents();
+      }
+
+      latch_complete_callback( 0, nullptr );
+    }
+  }
+
+
+  /**
+   * @brief Runs once the last frame has shifted out of the SPI
+   *
+   * Starts the next frame immediately if one was queued.
+   *
+   * @param id          Alarm that fired
+   * @param user_data   Unused
+   * @return int64_t    Always zero, the alarm is one shot
+   */
+  static int64_t __not_in_flash_func( latch_complete_callback )( alarm_id_t id, void *user_data )
+  {
+    ( void )id;
+    ( void )user_data;
+
+    Telemetry::recordPresent( time_us_32() );
+    Trace::record( Trace::EVENT_LATCH );
+
+    if( s_frame_queued )
+    {
+      s_frame_queued = false;
+      start_transfer();
+    }
+    else
+    {
+      s_wire_idle = true;
+    }
+
+    __sev();    // Wake the frame loop if it's waiting on the wire
+    return 0;
+  }
+
+
+  /**
+   * @brief Kicks off the DMA transfer of the display buffer's wire frame
+   *
+   * Must be called with interrupts disabled or from the latch alarm.
+   */
+  static void __not_in_flash_func( start_transfer )()
+  {
+    s_wire_idle = false;
+    Trace::record( Trace::EVENT_DMA_START );
+    dma_channel_set_trans_count( s_dma_channel, FRAME_BYTES, false );
+    dma_channel_set_read_addr( s_dma_channel, sp_display->wire, true );
+  }
+}    // namespace LED
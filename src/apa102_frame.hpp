@@ -0,0 +1,140 @@
+/******************************************************************************
+ *  File Name:
+ *    apa102_frame.hpp
+ *
+ *  Description:
+ *    Frame encoder for clocked APA102/SK9822 LEDs. Everything here is
+ *    constexpr and free of SDK dependencies, so the wire format can be
+ *    checked on a host machine, see sim/tests/apa102_frame_test.cpp.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+#pragma once
+#ifndef HOLLY_JOLLY_APA102_FRAME_HPP
+#define HOLLY_JOLLY_APA102_FRAME_HPP
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include <cstddef>
+#include <cstdint>
+
+/*-----------------------------------------------------------------------------
+A frame on the wire, every byte MSB first:
+
+  Start       4 bytes of 0x00
+  LED         0b111LLLLL, blue, green, red, where L is the 5-bit global brightness
+  Reset       4 bytes of 0x00, so SK9822s latch this frame now instead of on the next
+  End         One more 0x00 for every 16 LEDs, since each LED delays the data
+              by half a clock and the last ones need the extra edges
+
+Zeros are used for the end frame rather than the 0xFF in the APA102 datasheet,
+so any LEDs past the end of the string read it as a dark pixel.
+-----------------------------------------------------------------------------*/
+
+namespace LED
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr size_t   APA102_START_BYTES = 4;       // Zeros ahead of the first LED
+  static constexpr size_t   APA102_LED_BYTES   = 4;       // Header and three color bytes
+  static constexpr size_t   APA102_RESET_BYTES = 4;       // SK9822 latch frame after the last LED
+  static constexpr uint8_t  APA102_LED_HEADER  = 0xE0;    // Top three bits of every LED record
+  static constexpr uint32_t APA102_MAX_LEVEL   = 31;      // Largest 5-bit global brightness
+
+  /*---------------------------------------------------------------------------
+  Public Functions
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Size of a complete frame for a string of LEDs
+   *
+   * @param num_leds    LEDs in the string
+   * @return size_t     Bytes on the wire
+   */
+  static constexpr size_t apa102FrameBytes( const size_t num_leds )
+  {
+    return APA102_START_BYTES + ( num_leds * APA102_LED_BYTES ) + APA102_RESET_BYTES + ( ( num_leds + 15 ) / 16 );
+  }
+
+  /**
+   * @brief Converts a brightness scale into the 5-bit global brightness field
+   *
+   * Anything above zero stays lit at the lowest level rather than rounding
+   * down to off.
+   *
+   * @param scale       Brightness from 0 to 256, as used by the post-processing stages
+   * @return uint8_t    Level from 0 to APA102_MAX_LEVEL
+   */
+  static constexpr uint8_t apa102Level( const uint32_t scale )
+  {
+    if( scale == 0 )
+    {
+      return 0;
+    }
+
+    const uint32_t level = ( ( ( scale > 256 ? 256 : scale ) * APA102_MAX_LEVEL ) + 128 ) >> 8;
+    return static_cast<uint8_t>( level == 0 ? 1 : level );
+  }
+
+  /**
+   * @brief Encodes one LED record from a packed 0x00BBRRGG color
+   *
+   * @param color   Color to encode
+   * @param level   5-bit global brightness
+   * @param out     Where to write the APA102_LED_BYTES of the record
+   */
+  static constexpr void apa102EncodeLed( const uint32_t color, const uint8_t level, uint8_t *const out )
+  {
+    out[ 0 ] = static_cast<uint8_t>( APA102_LED_HEADER | ( level & APA102_MAX_LEVEL ) );
+    out[ 1 ] = static_cast<uint8_t>( color >> 16 );    // Blue
+    out[ 2 ] = static_cast<uint8_t>( color );          // Green
+    out[ 3 ] = static_cast<uint8_t>( color >> 8 );     // Red
+  }
+
+  /**
+   * @brief Re-encodes the LEDs in [first, end) of a frame that was already built
+   *
+   * Only the LED records are touched, so this can patch the spans of a frame
+   * that changed and leave the rest as it was.
+   *
+   * @param colors  Packed 0x00BBRRGG colors for the whole string
+   * @param first   First LED to encode
+   * @param end     One past the last LED to encode
+   * @param level   5-bit global brightness
+   * @param frame   Frame built by apa102EncodeFrame()
+   */
+  static constexpr void apa102EncodeLeds( const uint32_t *const colors, const size_t first, const size_t end,
+                                          const uint8_t level, uint8_t *const frame )
+  {
+    for( size_t i = first; i < end; i++ )
+    {
+      apa102EncodeLed( colors[ i ], level, frame + APA102_START_BYTES + ( i * APA102_LED_BYTES ) );
+    }
+  }
+
+  /**
+   * @brief Encodes a complete frame, start to end
+   *
+   * @param colors    Packed 0x00BBRRGG colors
+   * @param num_leds  LEDs in the string
+   * @param level     5-bit global brightness
+   * @param frame     Where to write apa102FrameBytes( num_leds ) bytes
+   */
+  static constexpr void apa102EncodeFrame( const uint32_t *const colors, const size_t num_leds, const uint8_t level,
+                                           uint8_t *const frame )
+  {
+    for( size_t i = 0; i < apa102FrameBytes( num_leds ); i++ )
+    {
+      frame[ i ] = 0;
+    }
+
+    apa102EncodeLeds( colors, 0, num_leds, level, frame );
+  }
+
+}    // namespace LED
+
+#endif /* !HOLLY_JOLLY_APA102_FRAME_HPP */
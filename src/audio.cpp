@@ -0,0 +1,144 @@
+/******************************************************************************
+ *  File Name:
+ *    audio.cpp
+ *
+ *  Description:
+ *    Continuous audio capture from an analog input for the audio reactive
+ *    animations.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "audio.hpp"
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+
+namespace Audio
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr uint     AUDIO_ADC_PIN     = 26;                   // GPIO with the analog audio input
+  static constexpr uint     AUDIO_ADC_INPUT   = AUDIO_ADC_PIN - 26;   // ADC mux input for that GPIO
+  static constexpr uint32_t ADC_CLOCK_HZ      = 48'000'000;           // ADC runs from the USB PLL
+  static constexpr uint32_t ADC_MIDSCALE      = 2048;                 // 12-bit reading of a centered signal
+  static constexpr uint32_t RING_SAMPLES      = 2 * FFT_SIZE;         // Room for a full window plus the next one arriving
+  static constexpr uint32_t RING_BYTES        = RING_SAMPLES * sizeof( uint16_t );
+  static constexpr uint32_t RING_SIZE_BITS    = 10;                   // log2( RING_BYTES ), for the DMA ring wrap
+  static constexpr uint32_t DMA_MAX_TRANSFERS = 0xFFFFFFFF;           // Several days of samples before a restart
+
+  static_assert( ( 1u << RING_SIZE_BITS ) == RING_BYTES, "Ring wrap must match the buffer size" );
+
+  /*---------------------------------------------------------------------------
+  Static Data
+  ---------------------------------------------------------------------------*/
+
+  alignas( RING_BYTES ) static uint16_t s_ring[ RING_SAMPLES ];    // DMA wraps writes around this
+  static int s_dma_channel = -1;                                    // Claimed channel, negative when stopped
+
+  /*---------------------------------------------------------------------------
+  Static Function Declarations
+  ---------------------------------------------------------------------------*/
+
+  static void start_dma();
+
+  /*---------------------------------------------------------------------------
+  Public Functions
+  ---------------------------------------------------------------------------*/
+
+  void start()
+  {
+    if( s_dma_channel >= 0 )
+    {
+      return;
+    }
+
+    /*-------------------------------------------------------------------------
+    Free run the ADC into its FIFO, requesting DMA on every sample
+    -------------------------------------------------------------------------*/
+    adc_init();
+    adc_gpio_init( AUDIO_ADC_PIN );
+    adc_select_input( AUDIO_ADC_INPUT );
+    adc_fifo_setup( true, true, 1, false, false );
+    adc_set_clkdiv( static_cast<float>( ADC_CLOCK_HZ / SAMPLE_RATE_HZ - 1 ) );
+
+    /*-------------------------------------------------------------------------
+    Stream the FIFO into the ring buffer and start converting
+    -------------------------------------------------------------------------*/
+    s_dma_channel = dma_claim_unused_channel( true );
+    start_dma();
+    adc_run( true );
+  }
+
+
+  void stop()
+  {
+    if( s_dma_channel < 0 )
+    {
+      return;
+    }
+
+    adc_run( false );
+    dma_channel_abort( s_dma_channel );
+    adc_fifo_drain();
+    dma_channel_unclaim( s_dma_channel );
+    s_dma_channel = -1;
+  }
+
+
+  bool readLatest( int16_t *const dst )
+  {
+    if( s_dma_channel < 0 )
+    {
+      return false;
+    }
+
+    /*-------------------------------------------------------------------------
+    The transfer count is huge, but not infinite. Pick back up if it ran out.
+    -------------------------------------------------------------------------*/
+    if( !dma_channel_is_busy( s_dma_channel ) )
+    {
+      start_dma();
+    }
+
+    /*-------------------------------------------------------------------------
+    The DMA write address points at the slot the next sample will land in,
+    so the newest window ends just before it.
+    -------------------------------------------------------------------------*/
+    const uintptr_t write_addr = dma_channel_hw_addr( s_dma_channel )->write_addr;
+    const uint32_t  next       = ( write_addr - reinterpret_cast<uintptr_t>( s_ring ) ) / sizeof( uint16_t );
+
+    for( uint32_t i = 0; i < FFT_SIZE; i++ )
+    {
+      const uint32_t raw = s_ring[ ( next - FFT_SIZE + i ) & ( RING_SAMPLES - 1 ) ] & 0x0FFF;
+      dst[ i ]           = static_cast<int16_t>( ( static_cast<int32_t>( raw ) - static_cast<int32_t>( ADC_MIDSCALE ) ) * 16 );
+    }
+
+    return true;
+  }
+
+  /*---------------------------------------------------------------------------
+  Static Functions
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Points the DMA channel at the ring buffer and starts it
+   */
+  static void start_dma()
+  {
+    dma_channel_config cfg = dma_channel_get_default_config( s_dma_channel );
+
+    channel_config_set_transfer_data_size( &cfg, DMA_SIZE_16 );
+    channel_config_set_read_increment( &cfg, false );
+    channel_config_set_write_increment( &cfg, true );
+    channel_config_set_ring( &cfg, true, RING_SIZE_BITS );
+    channel_config_set_dreq( &cfg, DREQ_ADC );
+
+    dma_channel_configure( s_dma_channel, &cfg, s_ring, &adc_hw->fifo, DMA_MAX_TRANSFERS, true );
+  }
+
+}    // namespace Audio
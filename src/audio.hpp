@@ -0,0 +1,51 @@
+/******************************************************************************
+ *  File Name:
+ *    audio.hpp
+ *
+ *  Description:
+ *    Continuous audio capture from an analog input for the audio reactive
+ *    animations.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+#pragma once
+#ifndef HOLLY_JOLLY_AUDIO_HPP
+#define HOLLY_JOLLY_AUDIO_HPP
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "audio_dsp.hpp"
+#include <cstdint>
+
+namespace Audio
+{
+  /*---------------------------------------------------------------------------
+  Public Functions
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Starts sampling the audio input
+   *
+   * The ADC free runs at SAMPLE_RATE_HZ and DMA streams every sample into a
+   * ring buffer, so the CPU does nothing per sample.
+   */
+  void start();
+
+  /**
+   * @brief Stops sampling and releases the ADC and DMA channel
+   */
+  void stop();
+
+  /**
+   * @brief Copies out the most recent FFT_SIZE samples
+   *
+   * @param dst     Where to write the samples as signed Q15, oldest first
+   * @return bool   True if sampling is running and dst was filled
+   */
+  bool readLatest( int16_t *const dst );
+
+}    // namespace Audio
+
+#endif /* !HOLLY_JOLLY_AUDIO_HPP */
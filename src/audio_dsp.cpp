@@ -0,0 +1,281 @@
+/******************************************************************************
+ *  File Name:
+ *    audio_dsp.cpp
+ *
+ *  Description:
+ *    Fixed point spectrum analysis for the audio reactive animations
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "audio_dsp.hpp"
+#include <algorithm>
+
+namespace Audio
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr double PI = 3.14159265358979323846;
+
+  static constexpr uint32_t NOISE_FLOOR       = 32;         // Bin magnitude treated as silence
+  static constexpr uint32_t PEAK_DECAY_US     = 160'000;    // Time for a band's gain reference to fall by 1/16
+  static constexpr uint32_t BEAT_HOLDOFF_US   = 250'000;    // Minimum time between reported beats
+  static constexpr uint32_t BASS_AVG_SHIFT    = 4;          // Smoothing of the running bass average
+
+  /**
+   * @brief First FFT bin of each band, plus the end of the last band
+   *
+   * Spaced roughly logarithmically, since that's how pitch is heard. At 20kHz
+   * and 256 points each bin is about 78Hz wide. Bin 0 is DC and is skipped.
+   */
+  static constexpr uint32_t BAND_EDGES[ BAND_COUNT + 1 ] = { 1, 2, 4, 7, 12, 20, 34, 58, FFT_SIZE / 2 };
+
+  /*---------------------------------------------------------------------------
+  Tables
+
+  Generated at compile time so they live in flash and can't drift from
+  FFT_SIZE. The sine is evaluated with a Taylor series, which converges well
+  within Q15 precision once the angle is folded into [-pi/2, pi/2].
+  ---------------------------------------------------------------------------*/
+
+  static constexpr double taylor_sin( const double x )
+  {
+    double term   = x;
+    double result = x;
+    for( int n = 1; n < 10; n++ )
+    {
+      term *= -x * x / ( ( 2 * n ) * ( 2 * n + 1 ) );
+      result += term;
+    }
+
+    return result;
+  }
+
+  static constexpr double folded_sin( const double angle )
+  {
+    return ( angle > PI / 2 ) ? taylor_sin( PI - angle ) : taylor_sin( angle );
+  }
+
+  static constexpr int16_t to_q15( const double value )
+  {
+    const double scaled = value * 32767.0;
+    return static_cast<int16_t>( ( scaled >= 0 ) ? ( scaled + 0.5 ) : ( scaled - 0.5 ) );
+  }
+
+  /**
+   * @brief sin( 2 * pi * i / FFT_SIZE ) for three quarters of a period
+   *
+   * The cosine of the same angle is read a quarter period further on.
+   */
+  struct SineTable
+  {
+    int16_t value[ FFT_SIZE * 3 / 4 ];
+  };
+
+  static constexpr SineTable make_sine_table()
+  {
+    SineTable table{};
+    for( uint32_t i = 0; i < FFT_SIZE * 3 / 4; i++ )
+    {
+      table.value[ i ] = to_q15( folded_sin( 2.0 * PI * i / FFT_SIZE ) );
+    }
+
+    return table;
+  }
+
+  /**
+   * @brief Hann window, sin^2( pi * i / FFT_SIZE )
+   */
+  struct WindowTable
+  {
+    int16_t value[ FFT_SIZE ];
+  };
+
+  static constexpr WindowTable make_window_table()
+  {
+    WindowTable table{};
+    for( uint32_t i = 0; i < FFT_SIZE; i++ )
+    {
+      const double s   = folded_sin( PI * i / FFT_SIZE );
+      table.value[ i ] = to_q15( s * s );
+    }
+
+    return table;
+  }
+
+  static constexpr SineTable   SINE   = make_sine_table();
+  static constexpr WindowTable WINDOW = make_window_table();
+
+  static_assert( SINE.value[ FFT_SIZE / 4 ] == 32767, "Sine table is off" );
+  static_assert( WINDOW.value[ FFT_SIZE / 2 ] == 32767, "Window table is off" );
+
+  /*---------------------------------------------------------------------------
+  Static Functions
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Approximates the magnitude of a complex number
+   *
+   * Alpha max plus beta min, with alpha = 31/32 and beta = 13/32. The worst
+   * case error is about 4%, which is invisible on an LED.
+   *
+   * @param re    Real part
+   * @param im    Imaginary part
+   * @return uint32_t
+   */
+  static uint32_t magnitude( const int16_t re, const int16_t im )
+  {
+    const uint32_t a = static_cast<uint32_t>( ( re < 0 ) ? -re : re );
+    const uint32_t b = static_cast<uint32_t>( ( im < 0 ) ? -im : im );
+
+    return ( a > b ) ? ( ( a * 31 + b * 13 ) >> 5 ) : ( ( b * 31 + a * 13 ) >> 5 );
+  }
+
+  /*---------------------------------------------------------------------------
+  Public Functions
+  ---------------------------------------------------------------------------*/
+
+  void fft( int16_t *const re, int16_t *const im )
+  {
+    /*-------------------------------------------------------------------------
+    Bit reverse the input order
+    -------------------------------------------------------------------------*/
+    for( uint32_t i = 1, j = 0; i < FFT_SIZE; i++ )
+    {
+      uint32_t bit = FFT_SIZE >> 1;
+      for( ; j & bit; bit >>= 1 )
+      {
+        j ^= bit;
+      }
+      j ^= bit;
+
+      if( i < j )
+      {
+        std::swap( re[ i ], re[ j ] );
+        std::swap( im[ i ], im[ j ] );
+      }
+    }
+
+    /*-------------------------------------------------------------------------
+    Butterflies. Every stage halves its outputs, which keeps the worst case
+    growth of two bits per stage from ever overflowing 16 bits.
+    -------------------------------------------------------------------------*/
+    for( uint32_t len = 2; len <= FFT_SIZE; len <<= 1 )
+    {
+      const uint32_t half = len >> 1;
+      const uint32_t step = FFT_SIZE / len;
+
+      for( uint32_t k = 0; k < half; k++ )
+      {
+        const int32_t w_sin = SINE.value[ k * step ];
+        const int32_t w_cos = SINE.value[ k * step + FFT_SIZE / 4 ];
+
+        for( uint32_t i = k; i < FFT_SIZE; i += len )
+        {
+          const uint32_t j = i + half;
+
+          /*-------------------------------------------------------------------
+          t = x[j] * e^(-i*theta)
+          -------------------------------------------------------------------*/
+          const int32_t t_re = ( w_cos * re[ j ] + w_sin * im[ j ] ) >> 15;
+          const int32_t t_im = ( w_cos * im[ j ] - w_sin * re[ j ] ) >> 15;
+
+          re[ j ] = static_cast<int16_t>( ( re[ i ] - t_re ) >> 1 );
+          im[ j ] = static_cast<int16_t>( ( im[ i ] - t_im ) >> 1 );
+          re[ i ] = static_cast<int16_t>( ( re[ i ] + t_re ) >> 1 );
+          im[ i ] = static_cast<int16_t>( ( im[ i ] + t_im ) >> 1 );
+        }
+      }
+    }
+  }
+
+  /*---------------------------------------------------------------------------
+  Analyzer
+  ---------------------------------------------------------------------------*/
+
+  void Analyzer::reset()
+  {
+    std::fill( m_peak, m_peak + BAND_COUNT, NOISE_FLOOR );
+    m_bass_avg      = 0;
+    m_since_beat_us = BEAT_HOLDOFF_US;
+    m_spectrum      = {};
+  }
+
+
+  const Spectrum &Analyzer::analyze( const int16_t *const samples, const uint32_t dt_us )
+  {
+    /*-------------------------------------------------------------------------
+    Remove the DC bias of the input and apply the window
+    -------------------------------------------------------------------------*/
+    int32_t sum = 0;
+    for( uint32_t i = 0; i < FFT_SIZE; i++ )
+    {
+      sum += samples[ i ];
+    }
+
+    const int32_t mean = sum >> FFT_LOG2;
+    for( uint32_t i = 0; i < FFT_SIZE; i++ )
+    {
+      const int32_t centered = std::clamp<int32_t>( samples[ i ] - mean, INT16_MIN, INT16_MAX );
+
+      m_re[ i ] = static_cast<int16_t>( ( centered * WINDOW.value[ i ] ) >> 15 );
+      m_im[ i ] = 0;
+    }
+
+    fft( m_re, m_im );
+
+    /*-------------------------------------------------------------------------
+    Average the bins in each band and scale against the band's recent peak
+    -------------------------------------------------------------------------*/
+    const uint32_t decay_us = std::min( dt_us, PEAK_DECAY_US );
+    uint32_t       level[ BAND_COUNT ];
+
+    for( uint32_t band = 0; band < BAND_COUNT; band++ )
+    {
+      uint32_t total = 0;
+      for( uint32_t bin = BAND_EDGES[ band ]; bin < BAND_EDGES[ band + 1 ]; bin++ )
+      {
+        total += magnitude( m_re[ bin ], m_im[ bin ] );
+      }
+
+      level[ band ] = total / ( BAND_EDGES[ band + 1 ] - BAND_EDGES[ band ] );
+
+      uint32_t &peak = m_peak[ band ];
+      peak -= ( ( peak >> 4 ) * decay_us ) / PEAK_DECAY_US;
+      peak = std::max( { peak, level[ band ], NOISE_FLOOR } );
+
+      if( level[ band ] <= NOISE_FLOOR )
+      {
+        m_spectrum.bands[ band ] = 0;
+      }
+      else
+      {
+        m_spectrum.bands[ band ] = static_cast<uint8_t>( ( ( level[ band ] - NOISE_FLOOR ) * 255 ) / ( peak - NOISE_FLOOR ) );
+      }
+    }
+
+    /*-------------------------------------------------------------------------
+    A beat is a jump in bass energy well above its recent average
+    -------------------------------------------------------------------------*/
+    const uint32_t bass = level[ 0 ] + level[ 1 ];
+
+    m_since_beat_us = std::min( m_since_beat_us + dt_us, BEAT_HOLDOFF_US );
+    m_spectrum.beat = ( bass > 2 * NOISE_FLOOR ) && ( 2 * bass > 3 * m_bass_avg ) && ( m_since_beat_us >= BEAT_HOLDOFF_US );
+    if( m_spectrum.beat )
+    {
+      m_since_beat_us = 0;
+    }
+
+    m_bass_avg = static_cast<uint32_t>( static_cast<int32_t>( m_bass_avg ) +
+                                        ( ( static_cast<int32_t>( bass ) - static_cast<int32_t>( m_bass_avg ) ) >>
+                                          static_cast<int32_t>( BASS_AVG_SHIFT ) ) );
+
+    return m_spectrum;
+  }
+
+}    // namespace Audio
@@ -0,0 +1,100 @@
+/******************************************************************************
+ *  File Name:
+ *    audio_dsp.hpp
+ *
+ *  Description:
+ *    Fixed point spectrum analysis for the audio reactive animations. Nothing
+ *    in here touches the hardware, so it builds and runs the same on a host.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+#pragma once
+#ifndef HOLLY_JOLLY_AUDIO_DSP_HPP
+#define HOLLY_JOLLY_AUDIO_DSP_HPP
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include <cstddef>
+#include <cstdint>
+
+namespace Audio
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr uint32_t SAMPLE_RATE_HZ = 20'000;    // ADC sample rate
+  static constexpr uint32_t FFT_LOG2       = 8;         // log2 of the FFT size
+  static constexpr uint32_t FFT_SIZE       = 1u << FFT_LOG2;
+  static constexpr uint32_t BAND_COUNT     = 8;         // Number of frequency bands reported
+
+  /*---------------------------------------------------------------------------
+  Structures
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Result of analyzing one window of audio
+   */
+  struct Spectrum
+  {
+    uint8_t bands[ BAND_COUNT ];    // Level of each band from 0 to 255, lowest frequency first
+    bool    beat;                   // A bass onset was detected in this window
+  };
+
+  /*---------------------------------------------------------------------------
+  Public Functions
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief In place radix-2 FFT of FFT_SIZE Q15 samples
+   *
+   * Each stage halves its output to stay in range, so the result is scaled
+   * by 1 / FFT_SIZE.
+   *
+   * @param re    Real part, replaced with the real part of the spectrum
+   * @param im    Imaginary part, replaced with the imaginary part of the spectrum
+   */
+  void fft( int16_t *const re, int16_t *const im );
+
+  /*---------------------------------------------------------------------------
+  Classes
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Turns windows of raw samples into band levels and beats
+   *
+   * Each band has its own automatic gain, so quiet and loud music both span
+   * the full output range. Signals below a fixed noise floor read as silence,
+   * which keeps an unconnected input dark.
+   */
+  class Analyzer
+  {
+  public:
+    /**
+     * @brief Clears all of the gain and beat history
+     */
+    void reset();
+
+    /**
+     * @brief Analyzes the most recent window of samples
+     *
+     * @param samples   FFT_SIZE signed Q15 samples, oldest first
+     * @param dt_us     Time since the previous call
+     * @return const Spectrum&
+     */
+    const Spectrum &analyze( const int16_t *const samples, const uint32_t dt_us );
+
+  private:
+    int16_t  m_re[ FFT_SIZE ];
+    int16_t  m_im[ FFT_SIZE ];
+    uint32_t m_peak[ BAND_COUNT ];    // Automatic gain reference for each band
+    uint32_t m_bass_avg;              // Running average of the bass energy
+    uint32_t m_since_beat_us;         // Time since the last reported beat
+    Spectrum m_spectrum;
+  };
+
+}    // namespace Audio
+
+#endif /* !HOLLY_JOLLY_AUDIO_DSP_HPP */
@@ -13,8 +13,13 @@ Includes
 -----------------------------------------------------------------------------*/
 #include "buttons.hpp"
 #include "hardware/gpio.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+#include "pico/platform.h"
 #include "pico/time.h"
 #include "pico/types.h"
+#include "spsc_queue.hpp"
+#include "trace.hpp"
 #include <cstdint>
 
 namespace Buttons
@@ -25,54 +30,320 @@ namespace Buttons
 
   static constexpr uint     s_pin_input_bright = 19;
   static constexpr uint     s_pin_input_action = 25;
-  static constexpr uint32_t s_debounce_ms      = 50;
+  static constexpr uint32_t s_settle_us        = 8'000;      // Time the pin must be quiet before a level is trusted
+  static constexpr uint32_t s_long_press_us    = 600'000;    // Hold time before a long press fires
+  static constexpr uint32_t s_repeat_us        = 150'000;    // Period of repeats while held after a long press
+  static constexpr uint32_t s_double_press_us  = 300'000;    // Max release to press gap for a double press
+  static constexpr size_t   s_event_queue_size = 16;
+
+  static constexpr uint     s_key_pins[ KEY_COUNT ] = { s_pin_input_bright, s_pin_input_action };
+  static constexpr uint32_t s_key_edges           = GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE;
+
+  /*---------------------------------------------------------------------------
+  Structures
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Debounced edge confirmed by the settle timer
+   */
+  struct EdgeEvent
+  {
+    uint32_t timestamp_us;    // Time the first edge of the transition occurred
+    uint8_t  key;             // Which key generated the edge
+    bool     pressed;         // Logical key state after the edge
+  };
+
+  /**
+   * @brief Hardware debounce state for a single key. Owned by the IRQ handlers.
+   */
+  struct SettleState
+  {
+    bool     level;       // Last level confirmed by the settle timer
+    uint32_t edge_us;     // Time of the first edge that armed the settle timer
+  };
+
+  /**
+   * @brief Gesture tracking state for a single key
+   */
+  struct KeyState
+  {
+    bool     pressed;        // Debounced key state
+    bool     long_fired;     // A long press already fired for the current hold
+    bool     suppress;       // Current press completed a double press, don't emit a short
+    bool     await_double;   // Released once, waiting to see if a second press arrives
+    uint32_t edge_us;        // Time of the last accepted edge
+    uint32_t press_us;       // Time the current press began
+    uint32_t next_repeat_us; // Time the next hold repeat should fire
+  };
 
   /*---------------------------------------------------------------------------
   Static Variables
   ---------------------------------------------------------------------------*/
 
-  static volatile ButtonCallback s_bright_press_cb;
-  static volatile ButtonCallback s_action_press_cb;
-  static volatile uint32_t       s_last_bright_press_time;
-  static volatile uint32_t       s_last_action_press_time;
-  static volatile bool           s_pending_bright_press;
-  static volatile bool           s_pending_action_press;
+  static volatile ButtonCallback                        s_callbacks[ KEY_COUNT ][ GESTURE_COUNT ];
+  static Util::SPSCQueue<EdgeEvent, s_event_queue_size> s_edge_queue;
+  static KeyState                                       s_key_state[ KEY_COUNT ];
+  static SettleState                                    s_settle_state[ KEY_COUNT ];
+  static LatencyStats                                   s_latency;
+  static volatile uint32_t                              s_dropped_edges;
 
   /*---------------------------------------------------------------------------
   Static Function Definitions
   ---------------------------------------------------------------------------*/
 
+  /**
+   * @brief Alarm handler that samples a key once its contacts have settled
+   *
+   * Runs s_settle_us after the first edge of a transition. If the level differs
+   * from the last confirmed level, the transition is real and is queued for the
+   * main loop. Bounces that return to the original level are discarded here.
+   *
+   * @param id          Alarm that fired
+   * @param user_data   Index of the key being debounced
+   * @return int64_t    Microseconds until the alarm should fire again, or zero
+   */
+  static int64_t alarm_key_settled( alarm_id_t id, void *user_data )
+  {
+    ( void )id;
+
+    const uint8_t key   = static_cast<uint8_t>( reinterpret_cast<uintptr_t>( user_data ) );
+    SettleState  &state = s_settle_state[ key ];
+
+    /*-------------------------------------------------------------------------
+    Per the hardware schematic, the buttons are active low
+    -------------------------------------------------------------------------*/
+    const bool level = ( gpio_get( s_key_pins[ key ] ) == 0 );
+    if( level != state.level )
+    {
+      state.level = level;
+      Trace::record( Trace::EVENT_BUTTON_SETTLED, key | ( level << 8 ) );
+
+      if( s_edge_queue.push( { state.edge_us, key, level } ) )
+      {
+        __sev();    // Wake the main loop if it's parked in WFE
+      }
+      else
+      {
+        s_dropped_edges = s_dropped_edges + 1;
+      }
+    }
+
+    /*-------------------------------------------------------------------------
+    Listen for the next transition. Re-enabling clears any edges latched
+    during the settle period, so check if the level moved while we weren't
+    looking and start another settle cycle if so.
+    -------------------------------------------------------------------------*/
+    gpio_set_irq_enabled( s_key_pins[ key ], s_key_edges, true );
+    if( ( gpio_get( s_key_pins[ key ] ) == 0 ) != state.level )
+    {
+      gpio_set_irq_enabled( s_key_pins[ key ], s_key_edges, false );
+      state.edge_us = time_us_32();
+      return s_settle_us;
+    }
+
+    return 0;
+  }
+
+
   /**
    * @brief IRQ handler to process button press events
    *
+   * The first edge of a transition masks further edges on that pin and arms a
+   * one shot alarm. The alarm decides if the transition was real once the
+   * contacts have settled, so debouncing costs nothing in the main loop.
+   *
    * @param gpio  The GPIO pin that triggered the event
    * @param event_mask  The type of event that occurred
    */
-  static void irqh_button_press( uint gpio, uint32_t event_mask )
+  static void __not_in_flash_func( irqh_button_press )( uint gpio, uint32_t event_mask )
+  {
+    ( void )event_mask;
+
+    uint8_t key = KEY_COUNT;
+    if( gpio == s_pin_input_bright )
+    {
+      key = KEY_BRIGHT;
+    }
+    else if( gpio == s_pin_input_action )
+    {
+      key = KEY_ACTION;
+    }
+    else
+    {
+      return;
+    }
+
+    gpio_set_irq_enabled( gpio, s_key_edges, false );
+    s_settle_state[ key ].edge_us = time_us_32();
+    Trace::record( Trace::EVENT_BUTTON_EDGE, key );
+
+    void *user_data = reinterpret_cast<void *>( static_cast<uintptr_t>( key ) );
+    if( add_alarm_in_us( s_settle_us, alarm_key_settled, user_data, true ) < 0 )
+    {
+      /*-----------------------------------------------------------------------
+      No alarm slots available. Sample right away rather than going deaf.
+      -----------------------------------------------------------------------*/
+      if( alarm_key_settled( 0, user_data ) != 0 )
+      {
+        gpio_set_irq_enabled( gpio, s_key_edges, true );
+      }
+    }
+  }
+
+
+  /**
+   * @brief Invokes the callback registered for a gesture, if any
+   *
+   * @param key       Key the gesture occurred on
+   * @param gesture   Gesture that was recognized
+   */
+  static void dispatch( const uint8_t key, const Gesture gesture )
+  {
+    ButtonCallback callback = s_callbacks[ key ][ gesture ];
+    if( callback )
+    {
+      Trace::record( Trace::EVENT_DISPATCH, key | ( gesture << 8 ) );
+      callback();
+    }
+  }
+
+
+  /**
+   * @brief Invokes a callback triggered directly by an edge and records latency
+   *
+   * @param key       Key the gesture occurred on
+   * @param gesture   Gesture that was recognized
+   * @param edge_us   Timestamp of the edge that caused the gesture
+   */
+  static void dispatch_edge( const uint8_t key, const Gesture gesture, const uint32_t edge_us )
+  {
+    if( !s_callbacks[ key ][ gesture ] )
+    {
+      return;
+    }
+
+    const uint32_t latency = time_us_32() - edge_us;
+    s_latency.last_us      = latency;
+    s_latency.dispatched++;
+    if( latency > s_latency.max_us )
+    {
+      s_latency.max_us = latency;
+    }
+
+    dispatch( key, gesture );
+  }
+
+
+  /**
+   * @brief Advances the gesture state machine with a debounced edge
+   *
+   * @param event   Edge to apply
+   */
+  static void apply_edge( const EdgeEvent &event )
+  {
+    KeyState &state = s_key_state[ event.key ];
+    if( event.pressed == state.pressed )
+    {
+      return;
+    }
+
+    state.pressed = event.pressed;
+    state.edge_us = event.timestamp_us;
+
+    if( event.pressed )
+    {
+      state.press_us   = event.timestamp_us;
+      state.long_fired = false;
+      state.suppress   = false;
+
+      dispatch_edge( event.key, GESTURE_PRESS, event.timestamp_us );
+
+      if( state.await_double )
+      {
+        state.await_double = false;
+        state.suppress     = true;
+        dispatch_edge( event.key, GESTURE_DOUBLE, event.timestamp_us );
+      }
+    }
+    else if( !state.long_fired && !state.suppress )
+    {
+      /*-----------------------------------------------------------------------
+      Only hold back the short press if someone is listening for doubles
+      -----------------------------------------------------------------------*/
+      if( s_callbacks[ event.key ][ GESTURE_DOUBLE ] )
+      {
+        state.await_double = true;
+      }
+      else
+      {
+        dispatch_edge( event.key, GESTURE_SHORT, event.timestamp_us );
+      }
+    }
+  }
+
+
+  /**
+   * @brief Runs the time based parts of the gesture state machine
+   *
+   * @param key   Key to update
+   * @param now   Current time in microseconds
+   */
+  static void update_timers( const uint8_t key, const uint32_t now )
   {
+    KeyState &state = s_key_state[ key ];
+
     /*-------------------------------------------------------------------------
-    Only process falling edge events. Per the hardware schematic, the buttons
-    are active low.
+    Long press and hold repeat
     -------------------------------------------------------------------------*/
-    if( ( event_mask & GPIO_IRQ_EDGE_FALL ) != GPIO_IRQ_EDGE_FALL )
+    if( state.pressed && !state.suppress )
     {
-      return;
+      if( !state.long_fired && ( ( now - state.press_us ) >= s_long_press_us ) )
+      {
+        state.long_fired     = true;
+        state.next_repeat_us = state.press_us + s_long_press_us + s_repeat_us;
+        dispatch( key, GESTURE_LONG );
+      }
+      else if( state.long_fired && ( static_cast<int32_t>( now - state.next_repeat_us ) >= 0 ) )
+      {
+        state.next_repeat_us += s_repeat_us;
+        dispatch( key, GESTURE_REPEAT );
+      }
     }
 
     /*-------------------------------------------------------------------------
-    Determine which button was pressed and record the time. Actual processing
-    will occur in the main loop.
+    Double press window expired, so it was a single short press after all
     -------------------------------------------------------------------------*/
-    if( ( gpio == s_pin_input_bright ) && !s_pending_bright_press )
+    if( state.await_double && !state.pressed && ( ( now - state.edge_us ) >= s_double_press_us ) )
+    {
+      state.await_double = false;
+      dispatch( key, GESTURE_SHORT );
+    }
+  }
+
+  /**
+   * @brief Finds when the gesture state machine next needs to run for a key
+   *
+   * @param key       Key to inspect
+   * @param deadline  Updated with the key's deadline if it has one
+   * @return bool     True if the key has a pending timed gesture
+   */
+  static bool key_deadline( const uint8_t key, uint32_t &deadline )
+  {
+    const KeyState &state = s_key_state[ key ];
+
+    if( state.pressed && !state.suppress )
     {
-      s_pending_bright_press   = true;
-      s_last_bright_press_time = to_ms_since_boot( get_absolute_time() );
+      deadline = state.long_fired ? state.next_repeat_us : ( state.press_us + s_long_press_us );
+      return true;
     }
-    else if( ( gpio == s_pin_input_action ) && !s_pending_action_press )
+
+    if( state.await_double )
     {
-      s_pending_action_press   = true;
-      s_last_action_press_time = to_ms_since_boot( get_absolute_time() );
+      deadline = state.edge_us + s_double_press_us;
+      return true;
     }
+
+    return false;
   }
 
   /*---------------------------------------------------------------------------
@@ -84,69 +355,120 @@ namespace Buttons
     /*-------------------------------------------------------------------------
     Initialize the static variables
     -------------------------------------------------------------------------*/
-    s_bright_press_cb        = nullptr;
-    s_action_press_cb        = nullptr;
-    s_last_bright_press_time = 0;
-    s_last_action_press_time = 0;
-    s_pending_bright_press   = false;
-    s_pending_action_press   = false;
+    for( uint8_t key = 0; key < KEY_COUNT; key++ )
+    {
+      for( uint8_t gesture = 0; gesture < GESTURE_COUNT; gesture++ )
+      {
+        s_callbacks[ key ][ gesture ] = nullptr;
+      }
+
+      s_key_state[ key ]    = {};
+      s_settle_state[ key ] = {};
+    }
+
+    s_latency       = {};
+    s_dropped_edges = 0;
+    s_edge_queue.clear();
 
     /*-------------------------------------------------------------------------
-    Initialize the GPIO pins for button inputs
+    Initialize the GPIO pins for button inputs. Both edges are captured so the
+    press and release timing can be measured.
     -------------------------------------------------------------------------*/
     gpio_init( s_pin_input_bright );
     gpio_set_dir( s_pin_input_bright, GPIO_IN );
     gpio_pull_up( s_pin_input_bright );
-    gpio_set_irq_enabled_with_callback( s_pin_input_bright, GPIO_IRQ_EDGE_FALL, true, irqh_button_press );
+    gpio_set_irq_enabled_with_callback( s_pin_input_bright, s_key_edges, true, irqh_button_press );
 
     gpio_init( s_pin_input_action );
     gpio_set_dir( s_pin_input_action, GPIO_IN );
     gpio_pull_up( s_pin_input_action );
-    gpio_set_irq_enabled_with_callback( s_pin_input_action, GPIO_IRQ_EDGE_FALL, true, irqh_button_press );
+    gpio_set_irq_enabled_with_callback( s_pin_input_action, s_key_edges, true, irqh_button_press );
   }
 
 
   void process()
   {
-    const uint32_t current_time = to_ms_since_boot( get_absolute_time() );
+    /*-------------------------------------------------------------------------
+    Drain every edge captured since the last call, in the order they occurred
+    -------------------------------------------------------------------------*/
+    EdgeEvent event;
+    while( s_edge_queue.pop( event ) )
+    {
+      apply_edge( event );
+    }
 
     /*-------------------------------------------------------------------------
-    Process the brightness control input
+    Handle the gestures that depend on elapsed time rather than an edge
     -------------------------------------------------------------------------*/
-    if( s_pending_bright_press && ( ( current_time - s_last_bright_press_time ) >= s_debounce_ms ) )
+    const uint32_t now = time_us_32();
+    for( uint8_t key = 0; key < KEY_COUNT; key++ )
     {
-      if( s_bright_press_cb && ( gpio_get( s_pin_input_bright ) == 0 ) )
-      {
-        s_bright_press_cb();
-      }
+      update_timers( key, now );
+    }
+  }
+
 
-      s_pending_bright_press = false;
+  absolute_time_t nextDeadline()
+  {
+    /*-------------------------------------------------------------------------
+    Edges waiting in the queue need servicing right away
+    -------------------------------------------------------------------------*/
+    if( !s_edge_queue.empty() )
+    {
+      return get_absolute_time();
     }
 
     /*-------------------------------------------------------------------------
-    Process the action control input
+    Otherwise wake for the earliest timed gesture, if any
     -------------------------------------------------------------------------*/
-    if( s_pending_action_press && ( ( current_time - s_last_action_press_time ) >= s_debounce_ms ) )
+    const uint32_t now      = time_us_32();
+    int32_t        wait_us  = INT32_MAX;
+    uint32_t       deadline = 0;
+
+    for( uint8_t key = 0; key < KEY_COUNT; key++ )
     {
-      if( s_action_press_cb && ( gpio_get( s_pin_input_action ) == 0 ) )
+      if( key_deadline( key, deadline ) )
       {
-        s_action_press_cb();
+        const int32_t delta = static_cast<int32_t>( deadline - now );
+        wait_us             = ( delta < wait_us ) ? delta : wait_us;
       }
+    }
+
+    if( wait_us == INT32_MAX )
+    {
+      return at_the_end_of_time;
+    }
+
+    return delayed_by_us( get_absolute_time(), ( wait_us > 0 ) ? wait_us : 0 );
+  }
 
-      s_pending_action_press = false;
+
+  void onGesture( const Key key, const Gesture gesture, ButtonCallback callback )
+  {
+    if( ( key < KEY_COUNT ) && ( gesture < GESTURE_COUNT ) )
+    {
+      s_callbacks[ key ][ gesture ] = callback;
     }
   }
 
 
   void onBrightKeyPress( ButtonCallback callback )
   {
-    s_bright_press_cb = callback;
+    onGesture( KEY_BRIGHT, GESTURE_PRESS, callback );
   }
 
 
   void onActionKeyPress( ButtonCallback callback )
   {
-    s_action_press_cb = callback;
+    onGesture( KEY_ACTION, GESTURE_PRESS, callback );
+  }
+
+
+  LatencyStats getLatencyStats()
+  {
+    LatencyStats stats = s_latency;
+    stats.dropped      = s_dropped_edges;
+    return stats;
   }
 
 }    // namespace Buttons
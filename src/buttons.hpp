@@ -15,6 +15,7 @@
 /*-----------------------------------------------------------------------------
 Includes
 -----------------------------------------------------------------------------*/
+#include "pico/types.h"
 #include <cstdint>
 
 namespace Buttons
@@ -25,6 +26,50 @@ namespace Buttons
 
   using ButtonCallback = void ( * )( void );
 
+  /*---------------------------------------------------------------------------
+  Enumerations
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Physical keys on the board
+   */
+  enum Key : uint8_t
+  {
+    KEY_BRIGHT,
+    KEY_ACTION,
+
+    KEY_COUNT
+  };
+
+  /**
+   * @brief Gestures that can be recognized on a single key
+   */
+  enum Gesture : uint8_t
+  {
+    GESTURE_PRESS,     // Key went down. Fires immediately on the first edge.
+    GESTURE_SHORT,     // Key was pressed and released before the long press threshold
+    GESTURE_LONG,      // Key has been held past the long press threshold
+    GESTURE_DOUBLE,    // Second press arrived within the double press window
+    GESTURE_REPEAT,    // Key is still held after a long press. Fires periodically.
+
+    GESTURE_COUNT
+  };
+
+  /*---------------------------------------------------------------------------
+  Structures
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Edge to callback latency measurements
+   */
+  struct LatencyStats
+  {
+    uint32_t last_us;       // Latency of the most recently dispatched edge
+    uint32_t max_us;        // Worst case latency seen since boot
+    uint32_t dispatched;    // Number of edge triggered callbacks that have run
+    uint32_t dropped;       // Edges lost because the event queue was full
+  };
+
   /*---------------------------------------------------------------------------
   Public Functions
   ---------------------------------------------------------------------------*/
@@ -36,9 +81,35 @@ namespace Buttons
 
   /**
    * @brief Periodic processing of button events
+   *
+   * Drains the queue of debounced edges confirmed by the settle timers, runs
+   * the gesture state machine and dispatches any registered callbacks.
    */
   void process();
 
+  /**
+   * @brief Gets the next time process() has work to do
+   *
+   * Debouncing happens entirely in hardware timers, so the main loop only
+   * needs to call process() when an edge has been queued (signalled with SEV)
+   * or a timed gesture such as a long press is about to fire.
+   *
+   * @return absolute_time_t  Deadline, or at_the_end_of_time if nothing is pending
+   */
+  absolute_time_t nextDeadline();
+
+  /**
+   * @brief Registers a callback for a specific gesture on a key
+   *
+   * Registering a GESTURE_DOUBLE callback delays GESTURE_SHORT on that key by
+   * the double press window, since a single press can't be confirmed sooner.
+   *
+   * @param key       Which key to listen to
+   * @param gesture   Which gesture to listen for
+   * @param callback  Function to call when the gesture is recognized
+   */
+  void onGesture( const Key key, const Gesture gesture, ButtonCallback callback );
+
   /**
    * @brief Registers a callback for when the brightness button is pressed
    *
@@ -53,6 +124,12 @@ namespace Buttons
    */
   void onActionKeyPress( ButtonCallback callback );
 
+  /**
+   * @brief Gets the measured latency between a GPIO edge and its callback
+   * @return LatencyStats
+   */
+  LatencyStats getLatencyStats();
+
 }    // namespace Buttons
 
 #endif /* !HOLLY_JOLLY_BUTTONS_HPP */
@@ -0,0 +1,172 @@
+/******************************************************************************
+ *  File Name:
+ *    color.cpp
+ *
+ *  Description:
+ *    Integer HSV conversion and the named gradient palettes
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "color.hpp"
+#include "holly_jolly_cfg.hpp"
+#include <algorithm>
+
+namespace Color
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr uint32_t SECTOR_SPAN = 256;      // Hue * 6 across one sixth of the wheel, as hsvToRgb() splits it
+  static constexpr uint32_t SIXTH_Q16   = 10923;    // 65536 / 6, rounded up so whole multiples of 6 divide exactly
+
+  /*---------------------------------------------------------------------------
+  Tables
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief 65536 / i, so runtime division becomes a multiply and a shift
+   */
+  struct ReciprocalTable
+  {
+    uint32_t value[ 256 ];
+  };
+
+  static constexpr ReciprocalTable make_reciprocal_table()
+  {
+    ReciprocalTable table{};
+    for( uint32_t i = 1; i < 256; i++ )
+    {
+      table.value[ i ] = 65536u / i;
+    }
+
+    return table;
+  }
+
+  static constexpr ReciprocalTable RECIPROCAL = make_reciprocal_table();
+
+  /*---------------------------------------------------------------------------
+  Palette Keyframes
+  ---------------------------------------------------------------------------*/
+
+  static constexpr Palette16 make_rainbow()
+  {
+    Palette16 keys{};
+    for( uint32_t i = 0; i < 16; i++ )
+    {
+      keys.keys[ i ] = hsvToRgb( { static_cast<uint8_t>( i * 16 ), 255, 255 } );
+    }
+
+    return keys;
+  }
+
+  static constexpr Palette16 CLASSIC_KEYS = { {
+    COLOR_RED, COLOR_GREEN, COLOR_BLUE, COLOR_YELLOW, COLOR_MAGENTA, COLOR_CYAN, COLOR_ORANGE, COLOR_PURPLE,
+    COLOR_LIME, COLOR_PINK, COLOR_RED, COLOR_GREEN, COLOR_BLUE, COLOR_YELLOW, COLOR_MAGENTA, COLOR_CYAN,
+  } };
+
+  static constexpr uint32_t RED   = rgb( 255, 0, 0 );
+  static constexpr uint32_t GREEN = rgb( 0, 160, 0 );
+  static constexpr uint32_t GOLD  = rgb( 255, 150, 0 );
+  static constexpr uint32_t WHITE = rgb( 255, 255, 255 );
+  static constexpr uint32_t FROST = rgb( 180, 200, 255 );
+  static constexpr uint32_t ICE   = rgb( 60, 120, 255 );
+  static constexpr uint32_t DEEP  = rgb( 0, 20, 160 );
+
+  static constexpr Palette16 FESTIVE_KEYS = { {
+    RED, RED, GOLD, GREEN, GREEN, GOLD, RED, RED, GREEN, GREEN, GOLD, RED, RED, GOLD, GREEN, GREEN,
+  } };
+
+  static constexpr Palette16 ICE_KEYS = { {
+    WHITE, FROST, ICE, DEEP, ICE, FROST, WHITE, FROST, DEEP, DEEP, ICE, FROST, WHITE, WHITE, ICE, DEEP,
+  } };
+
+  static constexpr Palette16 CANDY_CANE_KEYS = { {
+    RED, RED, RED, WHITE, WHITE, WHITE, RED, RED, RED, WHITE, WHITE, WHITE, RED, RED, WHITE, WHITE,
+  } };
+
+  static constexpr Palette16 EMBERS_KEYS = { {
+    rgb( 0, 0, 0 ), rgb( 40, 0, 0 ), rgb( 100, 0, 0 ), rgb( 160, 10, 0 ), rgb( 220, 30, 0 ), rgb( 255, 60, 0 ),
+    rgb( 255, 100, 0 ), rgb( 255, 140, 0 ), rgb( 255, 180, 20 ), rgb( 255, 210, 60 ), rgb( 255, 180, 20 ),
+    rgb( 255, 120, 0 ), rgb( 220, 60, 0 ), rgb( 160, 20, 0 ), rgb( 80, 0, 0 ), rgb( 20, 0, 0 ),
+  } };
+
+  /*---------------------------------------------------------------------------
+  Expanded at compile time, so these only cost flash
+  ---------------------------------------------------------------------------*/
+  static constexpr Palette256 PALETTES[ PALETTE_COUNT ] = {
+    /* PALETTE_CLASSIC    */ expand( CLASSIC_KEYS ),
+    /* PALETTE_RAINBOW    */ expand( make_rainbow() ),
+    /* PALETTE_FESTIVE    */ expand( FESTIVE_KEYS ),
+    /* PALETTE_ICE        */ expand( ICE_KEYS ),
+    /* PALETTE_CANDY_CANE */ expand( CANDY_CANE_KEYS ),
+    /* PALETTE_EMBERS     */ expand( EMBERS_KEYS ),
+  };
+
+  /*---------------------------------------------------------------------------
+  Public Functions
+  ---------------------------------------------------------------------------*/
+
+  Hsv rgbToHsv( const uint32_t color )
+  {
+    const int32_t b = ( color >> 16 ) & 0xFF;
+    const int32_t r = ( color >> 8 ) & 0xFF;
+    const int32_t g = color & 0xFF;
+
+    const int32_t max   = std::max( { r, g, b } );
+    const int32_t min   = std::min( { r, g, b } );
+    const int32_t delta = max - min;
+
+    if( delta == 0 )
+    {
+      return { 0, 0, static_cast<uint8_t>( max ) };
+    }
+
+    /*-------------------------------------------------------------------------
+    Saturation is delta / max, via the table.
+    -------------------------------------------------------------------------*/
+    const uint32_t s = std::min<uint32_t>( ( delta * 255 * RECIPROCAL.value[ max ] + 0x8000 ) >> 16, 255 );
+
+    /*-------------------------------------------------------------------------
+    The largest and smallest channels pick the sector. Within it, hsvToRgb()
+    moves one channel between them by delta * f / 255, so f is that channel's
+    distance from the sector start over delta.
+    -------------------------------------------------------------------------*/
+    const uint32_t inv      = RECIPROCAL.value[ delta ];
+    const auto     position = [ inv ]( const int32_t distance ) -> uint32_t {
+      return ( static_cast<uint32_t>( distance ) * 255u * inv + 0x8000 ) >> 16;
+    };
+
+    uint32_t h6 = 0;
+    if( max == r )
+    {
+      h6 = ( min == b ) ? position( g - b ) : ( 5 * SECTOR_SPAN ) + position( r - b );
+    }
+    else if( max == g )
+    {
+      h6 = ( min == b ) ? SECTOR_SPAN + position( g - r ) : ( 2 * SECTOR_SPAN ) + position( b - r );
+    }
+    else
+    {
+      h6 = ( min == r ) ? ( 3 * SECTOR_SPAN ) + position( b - g ) : ( 4 * SECTOR_SPAN ) + position( r - g );
+    }
+
+    /*-------------------------------------------------------------------------
+    Undo the scaling by 6, rounding to the nearest hue
+    -------------------------------------------------------------------------*/
+    const uint32_t h = ( ( h6 + 3 ) * SIXTH_Q16 ) >> 16;
+
+    return { static_cast<uint8_t>( h & 0xFF ), static_cast<uint8_t>( s ), static_cast<uint8_t>( max ) };
+  }
+
+
+  const Palette256 &getPalette( const PaletteId id )
+  {
+    return PALETTES[ ( id < PALETTE_COUNT ) ? id : PALETTE_CLASSIC ];
+  }
+
+}    // namespace Color
@@ -0,0 +1,187 @@
+/******************************************************************************
+ *  File Name:
+ *    color.hpp
+ *
+ *  Description:
+ *    Integer HSV conversion and gradient palettes. All colors are packed as
+ *    0x00BBRRGG, the same as the LED buffers.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+#pragma once
+#ifndef HOLLY_JOLLY_COLOR_HPP
+#define HOLLY_JOLLY_COLOR_HPP
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "fixed_point.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace Color
+{
+  /*---------------------------------------------------------------------------
+  Enumerations
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Named color themes
+   */
+  enum PaletteId : uint8_t
+  {
+    PALETTE_CLASSIC,       // The original mixed color list
+    PALETTE_RAINBOW,       // Full hue wheel
+    PALETTE_FESTIVE,       // Red, green and gold
+    PALETTE_ICE,           // Whites and blues
+    PALETTE_CANDY_CANE,    // Red and white stripes
+    PALETTE_EMBERS,        // Black through red and orange to yellow
+
+    PALETTE_COUNT
+  };
+
+  /*---------------------------------------------------------------------------
+  Structures
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief A color in hue, saturation, value form, each 0 to 255
+   */
+  struct Hsv
+  {
+    uint8_t h;
+    uint8_t s;
+    uint8_t v;
+  };
+
+  /**
+   * @brief Keyframes of a gradient palette, evenly spaced and wrapping around
+   */
+  struct Palette16
+  {
+    uint32_t keys[ 16 ];
+  };
+
+  /**
+   * @brief A gradient palette expanded to one entry per 8-bit index
+   */
+  struct Palette256
+  {
+    uint32_t entries[ 256 ];
+
+    /**
+     * @brief Samples the palette
+     *
+     * @param index       Position along the gradient, wrapping at 256
+     * @return uint32_t
+     */
+    constexpr uint32_t operator[]( const uint8_t index ) const
+    {
+      return entries[ index ];
+    }
+  };
+
+  /*---------------------------------------------------------------------------
+  Public Functions
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Packs 8-bit channels into a 0x00BBRRGG color
+   */
+  static constexpr uint32_t rgb( const uint8_t r, const uint8_t g, const uint8_t b )
+  {
+    return ( static_cast<uint32_t>( b ) << 16 ) | ( static_cast<uint32_t>( r ) << 8 ) | g;
+  }
+
+  /**
+   * @brief Multiplies two 8-bit values where 255 means 1.0, rounding to nearest
+   *
+   * Exact for every pair of inputs, so full scale by full scale stays at 255.
+   */
+  static constexpr uint8_t mul255( const uint8_t a, const uint8_t b )
+  {
+    const uint32_t x = ( a * b ) + 128u;
+    return static_cast<uint8_t>( ( x + ( x >> 8 ) ) >> 8 );
+  }
+
+  /**
+   * @brief Converts HSV to a packed color using only shifts and multiplies
+   *
+   * The hue is scaled by 6, so the top byte is one of six sectors of the
+   * wheel and the low byte is the position within it. rgbToHsv() works back
+   * through the same scaling.
+   *
+   * @param hsv   Color to convert
+   * @return uint32_t
+   */
+  static constexpr uint32_t hsvToRgb( const Hsv hsv )
+  {
+    const uint32_t sector = ( hsv.h * 6u ) >> 8;
+    const uint8_t  f      = ( hsv.h * 6u ) & 0xFF;
+
+    const uint8_t v = hsv.v;
+    const uint8_t p = mul255( v, 255u - hsv.s );
+    const uint8_t q = mul255( v, 255u - mul255( hsv.s, f ) );
+    const uint8_t t = mul255( v, 255u - mul255( hsv.s, 255u - f ) );
+
+    switch( sector )
+    {
+      case 0:
+        return rgb( v, t, p );
+      case 1:
+        return rgb( q, v, p );
+      case 2:
+        return rgb( p, v, t );
+      case 3:
+        return rgb( p, q, v );
+      case 4:
+        return rgb( t, p, v );
+      default:
+        return rgb( v, p, q );
+    }
+  }
+
+  /**
+   * @brief Converts a packed color to HSV without dividing at runtime
+   *
+   * Division is replaced by a reciprocal table generated at build time.
+   *
+   * @param color   Color to convert
+   * @return Hsv
+   */
+  Hsv rgbToHsv( const uint32_t color );
+
+  /**
+   * @brief Expands 16 keyframes into 256 entries by linear interpolation
+   *
+   * Meant to run at compile time, so palettes cost only flash.
+   *
+   * @param keys    Keyframes, the last one blending back into the first
+   * @return Palette256
+   */
+  static constexpr Palette256 expand( const Palette16 &keys )
+  {
+    Palette256 palette{};
+    for( uint32_t i = 0; i < 256; i++ )
+    {
+      const uint32_t key = i >> 4;
+      const uint32_t t   = ( i & 0x0F ) << 4;
+
+      palette.entries[ i ] = FixedPoint::lerpColor( keys.keys[ key ], keys.keys[ ( key + 1 ) & 0x0F ], t );
+    }
+
+    return palette;
+  }
+
+  /**
+   * @brief Looks up a named palette
+   *
+   * @param id    Palette to get
+   * @return const Palette256&
+   */
+  const Palette256 &getPalette( const PaletteId id );
+
+}    // namespace Color
+
+#endif /* !HOLLY_JOLLY_COLOR_HPP */
@@ -0,0 +1,201 @@
+/******************************************************************************
+ *  File Name:
+ *    coroutine.hpp
+ *
+ *  Description:
+ *    Stackless coroutines for writing animations as sequential code
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+#pragma once
+#ifndef HOLLY_JOLLY_COROUTINE_HPP
+#define HOLLY_JOLLY_COROUTINE_HPP
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include <cstdint>
+
+/*-----------------------------------------------------------------------------
+Literals
+
+Use these inside an animation's process() to turn it into a coroutine. The
+body between CO_BEGIN and CO_END runs as straight line code, suspending at
+each CO_SLEEP_US or CO_NEXT_FRAME and picking up right after it on a later
+frame. Resuming is a single jump table lookup, the same as any switch, and
+costs about as much again as the virtual call to process() that reaches it
+(see sim/tests/coroutine_test.cpp).
+
+Rules, since this is built on a switch statement:
+  - Local variables do not survive a suspension. Keep anything that must in
+    the animation's State, which lives in the shared state arena.
+  - Only one CO_ macro per source line.
+  - Don't suspend from inside another switch statement.
+-----------------------------------------------------------------------------*/
+
+/**
+ * @brief Starts the coroutine body
+ *
+ * @param co      Coroutine object holding the resume point
+ * @param time    FrameTime passed to process()
+ */
+#define CO_BEGIN( co, time )        \
+  ( co ).resume( ( time ).dt_us );  \
+  switch( ( co ).resumePoint() )    \
+  {                                 \
+    case 0:
+
+/**
+ * @brief Suspends until the given time has passed on the animation clock
+ *
+ * Time overshot by a late frame is credited to the next sleep, so a loop of
+ * sleeps keeps its pace. If a frame is late by more than a whole sleep, the
+ * coroutine runs through it without returning to catch up.
+ *
+ * @param co      Coroutine object holding the resume point
+ * @param us      Time to sleep in microseconds
+ */
+#define CO_SLEEP_US( co, us )           \
+  do                                    \
+  {                                     \
+    ( co ).sleep( us );                 \
+    ( co ).suspend( __LINE__ );         \
+    [[fallthrough]];                    \
+    case __LINE__:                      \
+      if( ( co ).waiting() )            \
+      {                                 \
+        return ( co ).progressed();     \
+      }                                 \
+  } while( 0 )
+
+/**
+ * @brief Suspends until the next frame, presenting whatever was drawn
+ *
+ * @param co      Coroutine object holding the resume point
+ */
+#define CO_NEXT_FRAME( co )         \
+  do                                \
+  {                                 \
+    ( co ).suspend( __LINE__ );     \
+    return true;                    \
+    case __LINE__:                  \
+      ( co ).markProgress();        \
+  } while( 0 )
+
+/**
+ * @brief Ends the coroutine body. Once it gets here it stays finished.
+ *
+ * @param co      Coroutine object holding the resume point
+ */
+#define CO_END( co )                \
+    default:                        \
+      break;                        \
+  }                                 \
+  ( co ).finish();                  \
+  return ( co ).progressed()
+
+namespace Animator
+{
+  /*---------------------------------------------------------------------------
+  Classes
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Resume point and timer for a coroutine written with the CO_ macros
+   *
+   * Lives in the animation's State, so it starts zeroed whenever the
+   * animation is initialized.
+   */
+  class Coroutine
+  {
+  public:
+    static constexpr uint32_t FINISHED = UINT32_MAX;
+
+    Coroutine() : m_resume( 0 ), m_timer_us( 0 ), m_sleeping( false ), m_progressed( false )
+    {
+    }
+
+    /**
+     * @brief Restarts the coroutine from the top
+     */
+    void reset()
+    {
+      *this = Coroutine();
+    }
+
+    /**
+     * @brief Checks if the coroutine ran to CO_END
+     * @return bool
+     */
+    bool finished() const
+    {
+      return m_resume == FINISHED;
+    }
+
+    /*-------------------------------------------------------------------------
+    Used by the CO_ macros
+    -------------------------------------------------------------------------*/
+
+    void resume( const uint32_t dt_us )
+    {
+      m_progressed = ( m_resume == 0 );
+      if( m_sleeping )
+      {
+        m_timer_us -= static_cast<int32_t>( dt_us );
+      }
+    }
+
+    uint32_t resumePoint() const
+    {
+      return m_resume;
+    }
+
+    void suspend( const uint32_t line )
+    {
+      m_resume = line;
+    }
+
+    void sleep( const uint32_t us )
+    {
+      m_timer_us += static_cast<int32_t>( us );
+      m_sleeping = true;
+    }
+
+    bool waiting()
+    {
+      if( m_timer_us > 0 )
+      {
+        return true;
+      }
+
+      m_sleeping   = false;
+      m_progressed = true;
+      return false;
+    }
+
+    void markProgress()
+    {
+      m_progressed = true;
+    }
+
+    bool progressed() const
+    {
+      return m_progressed;
+    }
+
+    void finish()
+    {
+      m_resume = FINISHED;
+    }
+
+  private:
+    uint32_t m_resume;        // Line number to resume at, zero to start from the top
+    int32_t  m_timer_us;      // Sleep remaining, negative if the last sleep overshot
+    bool     m_sleeping;      // Timer is counting down
+    bool     m_progressed;    // Code ran since the last suspension, so a frame was drawn
+  };
+
+}    // namespace Animator
+
+#endif /* !HOLLY_JOLLY_COROUTINE_HPP */
@@ -0,0 +1,199 @@
+/******************************************************************************
+ *  File Name:
+ *    dirty_region.hpp
+ *
+ *  Description:
+ *    Tracks which spans of the LED string changed during a frame, so later
+ *    stages only need to touch those pixels.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+#pragma once
+#ifndef HOLLY_JOLLY_DIRTY_REGION_HPP
+#define HOLLY_JOLLY_DIRTY_REGION_HPP
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include <cstddef>
+#include <cstdint>
+
+namespace LED
+{
+  /*---------------------------------------------------------------------------
+  Structures
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Half open range of LED indices [first, end)
+   */
+  struct Span
+  {
+    uint32_t first;
+    uint32_t end;
+  };
+
+  /*---------------------------------------------------------------------------
+  Classes
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Sorted, non-overlapping set of dirty spans with a fixed capacity
+   *
+   * Overlapping and adjacent spans are merged as they are added. Once the
+   * capacity is exceeded the two spans with the smallest gap between them are
+   * merged, so the region may over-approximate but never misses a pixel.
+   */
+  class DirtyRegion
+  {
+  public:
+    static constexpr size_t MAX_SPANS = 8;
+
+    DirtyRegion() : m_count( 0 )
+    {
+    }
+
+    /**
+     * @brief Marks everything clean
+     */
+    void clear()
+    {
+      m_count = 0;
+    }
+
+    /**
+     * @brief Marks a range of LEDs dirty
+     *
+     * @param first   First LED index
+     * @param end     One past the last LED index
+     */
+    void add( const uint32_t first, const uint32_t end )
+    {
+      if( first >= end )
+      {
+        return;
+      }
+
+      /*-----------------------------------------------------------------------
+      Insert in sorted position. There is always room for one extra span,
+      which is folded back in below if needed.
+      -----------------------------------------------------------------------*/
+      size_t idx = m_count;
+      while( ( idx > 0 ) && ( m_spans[ idx - 1 ].first > first ) )
+      {
+        m_spans[ idx ] = m_spans[ idx - 1 ];
+        idx--;
+      }
+
+      m_spans[ idx ] = { first, end };
+      m_count++;
+
+      /*-----------------------------------------------------------------------
+      Coalesce anything that now overlaps or touches
+      -----------------------------------------------------------------------*/
+      size_t out = 0;
+      for( size_t i = 1; i < m_count; i++ )
+      {
+        if( m_spans[ i ].first <= m_spans[ out ].end )
+        {
+          m_spans[ out ].end = ( m_spans[ i ].end > m_spans[ out ].end ) ? m_spans[ i ].end : m_spans[ out ].end;
+        }
+        else
+        {
+          m_spans[ ++out ] = m_spans[ i ];
+        }
+      }
+      m_count = out + 1;
+
+      /*-----------------------------------------------------------------------
+      Over capacity, so give up some precision
+      -----------------------------------------------------------------------*/
+      if( m_count > MAX_SPANS )
+      {
+        size_t   best     = 0;
+        uint32_t best_gap = UINT32_MAX;
+        for( size_t i = 0; ( i + 1 ) < m_count; i++ )
+        {
+          const uint32_t gap = m_spans[ i + 1 ].first - m_spans[ i ].end;
+          if( gap < best_gap )
+          {
+            best     = i;
+            best_gap = gap;
+          }
+        }
+
+        m_spans[ best ].end = m_spans[ best + 1 ].end;
+        for( size_t i = best + 1; ( i + 1 ) < m_count; i++ )
+        {
+          m_spans[ i ] = m_spans[ i + 1 ];
+        }
+        m_count--;
+      }
+    }
+
+    /**
+     * @brief Adds every span of another region to this one
+     *
+     * @param other   Region to merge in
+     */
+    void merge( const DirtyRegion &other )
+    {
+      for( size_t i = 0; i < other.m_count; i++ )
+      {
+        add( other.m_spans[ i ].first, other.m_spans[ i ].end );
+      }
+    }
+
+    /**
+     * @brief Number of spans in the region
+     * @return size_t
+     */
+    size_t size() const
+    {
+      return m_count;
+    }
+
+    /**
+     * @brief Checks if nothing is dirty
+     * @return bool
+     */
+    bool empty() const
+    {
+      return m_count == 0;
+    }
+
+    /**
+     * @brief Accesses a span
+     *
+     * @param idx   Span index, less than size()
+     * @return const Span&
+     */
+    const Span &operator[]( const size_t idx ) const
+    {
+      return m_spans[ idx ];
+    }
+
+    /**
+     * @brief Total number of LEDs covered by the region
+     * @return uint32_t
+     */
+    uint32_t pixels() const
+    {
+      uint32_t total = 0;
+      for( size_t i = 0; i < m_count; i++ )
+      {
+        total += m_spans[ i ].end - m_spans[ i ].first;
+      }
+
+      return total;
+    }
+
+  private:
+    Span   m_spans[ MAX_SPANS + 1 ];
+    size_t m_count;
+  };
+
+}    // namespace LED
+
+#endif /* !HOLLY_JOLLY_DIRTY_REGION_HPP */
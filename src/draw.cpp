@@ -0,0 +1,203 @@
+/******************************************************************************
+ *  File Name:
+ *    draw.cpp
+ *
+ *  Description:
+ *    Anti-aliased drawing onto the render canvas at sub-LED positions
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "draw.hpp"
+#include "pico/platform.h"
+#include "projection.hpp"
+#include "ws2812.hpp"
+#include <algorithm>
+
+namespace Draw
+{
+  /*---------------------------------------------------------------------------
+  Aliases
+  ---------------------------------------------------------------------------*/
+
+  using FixedPoint::q16_t;
+
+  /*---------------------------------------------------------------------------
+  Static Functions
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Combines a shape's color with an LED
+   *
+   * @param dst       Color already on the canvas
+   * @param color     Shape's color
+   * @param coverage  How much of the LED the shape covers, 0 to 256
+   * @param blend     How to combine them
+   * @return uint32_t
+   */
+  static __force_inline uint32_t blend_pixel( const uint32_t dst, const uint32_t color, const uint32_t coverage, const Blend blend )
+  {
+    if( blend == BLEND_ADD )
+    {
+      return FixedPoint::addColor( dst, FixedPoint::scaleColor( color, coverage ) );
+    }
+
+    return FixedPoint::lerpColor( dst, color, coverage );
+  }
+
+
+  /**
+   * @brief Blends a shape into every LED that [start, end) overlaps
+   *
+   * Inlined into each RAM-resident primitive, since a template can't carry a
+   * section attribute.
+   *
+   * @param start   Start of the shape in LEDs
+   * @param end     End of the shape in LEDs
+   * @param blend   How to combine it with the canvas
+   * @param shade   Callable returning the shape's color at an LED index
+   */
+  template<typename Shader>
+  static __force_inline void draw_span( const q16_t start, const q16_t end, const Blend blend, Shader &&shade )
+  {
+    const q16_t lo = std::max<q16_t>( start, 0 );
+    const q16_t hi = std::min<q16_t>( end, FixedPoint::toQ16( LED::count() ) );
+    if( lo >= hi )
+    {
+      return;
+    }
+
+    /*-------------------------------------------------------------------------
+    Only the LEDs at either end can be partly covered. The edges are rounded
+    to 1/256 of an LED before taking the difference, so a fully covered LED
+    takes the shape's color exactly and the coverage of the LEDs either side
+    of an edge always adds up to one LED.
+    -------------------------------------------------------------------------*/
+    uint32_t *const buffer = LED::getRenderBuffer();
+    const uint32_t  first  = static_cast<uint32_t>( FixedPoint::fromQ16( lo ) );
+    const uint32_t  last   = static_cast<uint32_t>( FixedPoint::fromQ16( hi + FixedPoint::Q16_ONE - 1 ) );
+
+    for( uint32_t i = first; i < last; i++ )
+    {
+      const q16_t    led_lo   = std::max( lo, FixedPoint::toQ16( i ) );
+      const q16_t    led_hi   = std::min( hi, FixedPoint::toQ16( i + 1 ) );
+      const uint32_t coverage = static_cast<uint32_t>( ( ( led_hi + 0x80 ) >> 8 ) - ( ( led_lo + 0x80 ) >> 8 ) );
+
+      buffer[ i ] = blend_pixel( buffer[ i ], shade( i ), coverage, blend );
+    }
+
+    LED::markDirty( first, last - first );
+  }
+
+  /*---------------------------------------------------------------------------
+  Public Functions
+  ---------------------------------------------------------------------------*/
+
+  void __not_in_flash_func( point )( const q16_t position, const uint32_t color, const Blend blend )
+  {
+    if( blend != BLEND_ADD )
+    {
+      draw_span( position, position + FixedPoint::Q16_ONE, blend, [ color ]( const uint32_t ) { return color; } );
+      return;
+    }
+
+    /*-------------------------------------------------------------------------
+    Added light is split into one scaled share and the rest, rather than two
+    scaled shares that each round down. The two LEDs then always add up to
+    the full color, so a dim point doesn't flicker as it moves between them.
+    -------------------------------------------------------------------------*/
+    const int32_t  lower       = FixedPoint::fromQ16( position );
+    const uint32_t upper       = FixedPoint::scaleColor( color, ( ( position & ( FixedPoint::Q16_ONE - 1 ) ) + 0x80 ) >> 8 );
+    const uint32_t shares[ 2 ] = { color - upper, upper };
+
+    const int32_t first = std::max<int32_t>( lower, 0 );
+    const int32_t end   = std::min<int32_t>( lower + 2, LED::count() );
+    if( first >= end )
+    {
+      return;
+    }
+
+    uint32_t *const buffer = LED::getRenderBuffer();
+    for( int32_t i = first; i < end; i++ )
+    {
+      buffer[ i ] = FixedPoint::addColor( buffer[ i ], shares[ i - lower ] );
+    }
+
+    LED::markDirty( first, end - first );
+  }
+
+
+  void __not_in_flash_func( bar )( const q16_t start, const q16_t end, const uint32_t color, const Blend blend )
+  {
+    draw_span( start, end, blend, [ color ]( const uint32_t ) { return color; } );
+  }
+
+
+  void __not_in_flash_func( gradient )( const q16_t start, const q16_t end, const uint32_t from, const uint32_t to, const Blend blend )
+  {
+    if( end <= start )
+    {
+      return;
+    }
+
+    const int64_t length = end - start;
+
+    draw_span( start, end, blend, [ & ]( const uint32_t led ) {
+      const int64_t center = FixedPoint::toQ16( led ) + FixedPoint::Q16_HALF - start;
+      const int64_t t      = std::clamp<int64_t>( ( center << 8 ) / length, 0, 256 );
+
+      return FixedPoint::lerpColor( from, to, static_cast<uint32_t>( t ) );
+    } );
+  }
+
+
+  void __not_in_flash_func( fill )( const LED::Span &span, const uint32_t color )
+  {
+    const uint32_t end = std::min( span.end, LED::count() );
+    if( span.first >= end )
+    {
+      return;
+    }
+
+    uint32_t *const buffer = LED::getRenderBuffer();
+    std::fill( buffer + span.first, buffer + end, color );
+    LED::markDirty( span.first, end - span.first );
+  }
+
+
+  void __not_in_flash_func( band )( const Axis axis, const q16_t start, const q16_t end, const uint32_t color, const Blend blend )
+  {
+    if( end <= start )
+    {
+      return;
+    }
+
+    /*-------------------------------------------------------------------------
+    Layout positions are in 1/256ths of a pixel. Shift them up to 16.16 so
+    they line up with the band's edges.
+    -------------------------------------------------------------------------*/
+    uint32_t *const buffer = LED::getRenderBuffer();
+    const q16_t     width  = static_cast<q16_t>( Projection::footprint() << 8 );
+    const q16_t     half   = width / 2;
+
+    for( uint32_t i = 0; i < LED::count(); i++ )
+    {
+      const Projection::Position pos    = Projection::position( i );
+      const q16_t                center = static_cast<q16_t>( ( ( axis == AXIS_X ) ? pos.x : pos.y ) << 8 );
+      const q16_t                lo     = std::max( start, center - half );
+      const q16_t                hi     = std::min( end, center + half );
+
+      if( lo < hi )
+      {
+        const uint32_t coverage = ( static_cast<uint32_t>( hi - lo ) * 256u + ( width / 2 ) ) / width;
+
+        buffer[ i ] = blend_pixel( buffer[ i ], color, coverage, blend );
+        LED::markDirty( i );
+      }
+    }
+  }
+
+}    // namespace Draw
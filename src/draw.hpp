@@ -0,0 +1,119 @@
+/******************************************************************************
+ *  File Name:
+ *    draw.hpp
+ *
+ *  Description:
+ *    Anti-aliased drawing onto the render canvas at sub-LED positions
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+#pragma once
+#ifndef HOLLY_JOLLY_DRAW_HPP
+#define HOLLY_JOLLY_DRAW_HPP
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "dirty_region.hpp"
+#include "fixed_point.hpp"
+#include <cstdint>
+
+/*-----------------------------------------------------------------------------
+Positions along the string are in LEDs, 16.16 fixed point. LED i covers
+[ i, i + 1 ), so a shape that only partly covers an LED is blended into it by
+the fraction covered. Everything drawn is marked dirty, and only the LEDs a
+shape touches are read or written.
+-----------------------------------------------------------------------------*/
+
+namespace Draw
+{
+  /*---------------------------------------------------------------------------
+  Enumerations
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief How a shape is combined with what is already on the canvas
+   */
+  enum Blend : uint8_t
+  {
+    BLEND_REPLACE,    // Mix toward the shape's color by coverage, fully covered LEDs are replaced
+    BLEND_ADD,        // Add the shape's color scaled by coverage, saturating each channel
+  };
+
+  /**
+   * @brief Direction across the board layout, see Projection::Position
+   */
+  enum Axis : uint8_t
+  {
+    AXIS_X,    // Left to right
+    AXIS_Y,    // Top to bottom
+  };
+
+  /*---------------------------------------------------------------------------
+  Public Functions
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Draws a point one LED wide, split across the two LEDs it straddles
+   *
+   * When added, the two LEDs' shares always sum to the full color.
+   *
+   * @param position  Left edge of the point in LEDs
+   * @param color     Color at full coverage, 0x00BBRRGG
+   * @param blend     How to combine it with the canvas
+   */
+  void point( const FixedPoint::q16_t position, const uint32_t color, const Blend blend = BLEND_ADD );
+
+  /**
+   * @brief Draws a solid bar over [start, end)
+   *
+   * @param start   Start of the bar in LEDs
+   * @param end     End of the bar in LEDs
+   * @param color   Color at full coverage, 0x00BBRRGG
+   * @param blend   How to combine it with the canvas
+   */
+  void bar( const FixedPoint::q16_t start, const FixedPoint::q16_t end, const uint32_t color,
+            const Blend blend = BLEND_REPLACE );
+
+  /**
+   * @brief Draws a bar over [start, end) that fades from one color to another
+   *
+   * Each LED takes the color at its center.
+   *
+   * @param start   Start of the bar in LEDs
+   * @param end     End of the bar in LEDs
+   * @param from    Color at start, 0x00BBRRGG
+   * @param to      Color at end, 0x00BBRRGG
+   * @param blend   How to combine it with the canvas
+   */
+  void gradient( const FixedPoint::q16_t start, const FixedPoint::q16_t end, const uint32_t from, const uint32_t to,
+                 const Blend blend = BLEND_REPLACE );
+
+  /**
+   * @brief Sets whole LEDs to a color, with no blending
+   *
+   * @param span    LEDs to set, clamped to the string
+   * @param color   Color to set, 0x00BBRRGG
+   */
+  void fill( const LED::Span &span, const uint32_t color );
+
+  /**
+   * @brief Draws a band across the board layout, from start to end along an axis
+   *
+   * Each LED is blended by how much of its footprint lies inside the band, so
+   * a band moving across the board lights LEDs smoothly as it reaches them.
+   * This looks at every LED, but only writes the ones it covers.
+   *
+   * @param axis    Direction the band's edges are measured along
+   * @param start   Start of the band in image pixels, see Projection::IMAGE_SIZE
+   * @param end     End of the band in image pixels
+   * @param color   Color at full coverage, 0x00BBRRGG
+   * @param blend   How to combine it with the canvas
+   */
+  void band( const Axis axis, const FixedPoint::q16_t start, const FixedPoint::q16_t end, const uint32_t color,
+             const Blend blend = BLEND_REPLACE );
+
+}    // namespace Draw
+
+#endif /* !HOLLY_JOLLY_DRAW_HPP */
@@ -0,0 +1,231 @@
+/******************************************************************************
+ *  File Name:
+ *    envelope.hpp
+ *
+ *  Description:
+ *    Bank of per-LED brightness envelopes for fades, glows and twinkles
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+#pragma once
+#ifndef HOLLY_JOLLY_ENVELOPE_HPP
+#define HOLLY_JOLLY_ENVELOPE_HPP
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "fixed_point.hpp"
+#include "pico/platform.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace Animator
+{
+  /*---------------------------------------------------------------------------
+  Classes
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Attack/decay envelope for every LED in a string
+   *
+   * Each envelope ramps its level up at the attack rate until fully lit, then
+   * down at the decay rate until dark, then sits idle until triggered again.
+   * Rates are in levels per 1024 us, and the part of a step below one level is
+   * carried to the next update, so a fade takes the same time at any frame rate.
+   *
+   * State is kept as parallel arrays rather than a struct per LED, so there is
+   * no padding and update() streams through each array once. The update has
+   * no per-phase branches: the direction, target and next phase all come from
+   * small tables indexed by the phase.
+   *
+   * @tparam COUNT  Number of envelopes
+   */
+  template<size_t COUNT>
+  class EnvelopeBank
+  {
+  public:
+    /**
+     * @brief Where an envelope is in its cycle
+     */
+    enum Phase : uint8_t
+    {
+      PHASE_IDLE,      // Dark, waiting for a trigger
+      PHASE_ATTACK,    // Rising toward LEVEL_MAX
+      PHASE_DECAY,     // Falling toward zero
+
+      PHASE_COUNT
+    };
+
+    static constexpr uint16_t LEVEL_MAX = UINT16_MAX;    // Fully lit
+    static constexpr uint32_t MAX_DT_US = UINT16_MAX;    // Longest step update() takes at once, keeping it in 32-bit math
+
+    EnvelopeBank()
+    {
+      clear();
+    }
+
+    /**
+     * @brief Converts the time for a full swing between dark and fully lit into a rate
+     *
+     * @param duration_us   Time to swing from zero to LEVEL_MAX, about 1 ms to 67 s
+     * @return uint16_t
+     */
+    static constexpr uint16_t rateFromUs( const uint32_t duration_us )
+    {
+      const uint64_t rate = ( static_cast<uint64_t>( LEVEL_MAX ) << 10 ) / std::max<uint32_t>( duration_us, 1 );
+      return static_cast<uint16_t>( std::clamp<uint64_t>( rate, 1, UINT16_MAX ) );
+    }
+
+    /**
+     * @brief Number of envelopes in the bank
+     * @return size_t
+     */
+    static constexpr size_t size()
+    {
+      return COUNT;
+    }
+
+    /**
+     * @brief Darkens and idles every envelope
+     */
+    void clear()
+    {
+      std::fill( m_level, m_level + COUNT, 0 );
+      std::fill( m_frac, m_frac + COUNT, 0 );
+      std::fill( m_phase, m_phase + COUNT, PHASE_IDLE );
+      std::fill( m_attack, m_attack + COUNT, 1 );
+      std::fill( m_decay, m_decay + COUNT, 1 );
+    }
+
+    /**
+     * @brief Starts an envelope rising from wherever it currently is
+     *
+     * @param idx       Envelope to trigger
+     * @param attack    Rising rate, from rateFromUs()
+     * @param decay     Falling rate, from rateFromUs()
+     */
+    void trigger( const size_t idx, const uint16_t attack, const uint16_t decay )
+    {
+      start( idx, m_level[ idx ], PHASE_ATTACK, attack, decay );
+    }
+
+    /**
+     * @brief Puts an envelope in an exact state, e.g. to randomize a starting pattern
+     *
+     * @param idx       Envelope to set
+     * @param level     Level to start from
+     * @param phase     Phase to start in
+     * @param attack    Rising rate, from rateFromUs()
+     * @param decay     Falling rate, from rateFromUs()
+     */
+    void start( const size_t idx, const uint16_t level, const Phase phase, const uint16_t attack, const uint16_t decay )
+    {
+      m_level[ idx ]  = level;
+      m_frac[ idx ]   = 0;
+      m_phase[ idx ]  = phase;
+      m_attack[ idx ] = attack;
+      m_decay[ idx ]  = decay;
+    }
+
+    /**
+     * @brief Advances every envelope, or just those in [first, end)
+     *
+     * Disjoint ranges touch disjoint memory, so they can be updated in parallel.
+     * Always inlined, so it runs from RAM when called from a function placed
+     * there. A section attribute here would be dropped, since this is a template.
+     *
+     * @param dt_us   Time elapsed since the last update
+     * @param first   First envelope to update
+     * @param end     One past the last envelope to update
+     */
+    __force_inline void update( const uint32_t dt_us, const size_t first = 0, const size_t end = COUNT )
+    {
+      const uint32_t dt = std::min( dt_us, MAX_DT_US );
+
+      for( size_t i = first; i < end; i++ )
+      {
+        const uint32_t phase = m_phase[ i ];
+        const uint32_t rate  = ( phase == PHASE_ATTACK ) ? m_attack[ i ] : m_decay[ i ];
+        const uint32_t move  = ( rate * dt ) + m_frac[ i ];    // Can't overflow, see MAX_DT_US
+        const int32_t  step  = static_cast<int32_t>( move >> 10 ) * DIRECTION[ phase ];
+        const int32_t  level = std::clamp<int32_t>( m_level[ i ] + step, 0, LEVEL_MAX );
+
+        m_level[ i ] = static_cast<uint16_t>( level );
+        m_frac[ i ]  = static_cast<uint16_t>( move & FRAC_MASK );
+        m_phase[ i ] = NEXT_PHASE[ phase ][ level == TARGET[ phase ] ];
+      }
+    }
+
+    /**
+     * @brief Draws every LED, or just those in [first, end), as its color scaled by its envelope
+     *
+     * Always inlined, like update().
+     *
+     * @param colors  Full brightness color of each LED, 0x00BBRRGG
+     * @param buffer  LED buffer to draw into
+     * @param first   First LED to draw
+     * @param end     One past the last LED to draw
+     */
+    __force_inline void render( const uint32_t *const colors, uint32_t *const buffer, const size_t first = 0,
+                                const size_t end = COUNT ) const
+    {
+      for( size_t i = first; i < end; i++ )
+      {
+        buffer[ i ] = FixedPoint::scaleColor( colors[ i ], ( m_level[ i ] + 0x80u ) >> 8 );
+      }
+    }
+
+    /**
+     * @brief Current level of an envelope, 0 to LEVEL_MAX
+     */
+    uint16_t level( const size_t idx ) const
+    {
+      return m_level[ idx ];
+    }
+
+    /**
+     * @brief Current phase of an envelope
+     */
+    Phase phase( const size_t idx ) const
+    {
+      return static_cast<Phase>( m_phase[ idx ] );
+    }
+
+    /**
+     * @brief Checks if an envelope has finished and can be triggered again
+     */
+    bool idle( const size_t idx ) const
+    {
+      return m_phase[ idx ] == PHASE_IDLE;
+    }
+
+  private:
+    /*-------------------------------------------------------------------------
+    Per-phase behavior. Idle never moves and can never reach its target, so it
+    stays idle until triggered.
+    -------------------------------------------------------------------------*/
+    static constexpr int32_t DIRECTION[ PHASE_COUNT ] = { 0, 1, -1 };
+    static constexpr int32_t TARGET[ PHASE_COUNT ]    = { -1, LEVEL_MAX, 0 };
+    static constexpr uint8_t NEXT_PHASE[ PHASE_COUNT ][ 2 ] = {
+      { PHASE_IDLE, PHASE_IDLE },
+      { PHASE_ATTACK, PHASE_DECAY },
+      { PHASE_DECAY, PHASE_IDLE },
+    };
+
+    static constexpr uint32_t FRAC_MASK = ( 1u << 10 ) - 1;    // Part of a step below one level
+
+    static_assert( ( static_cast<uint64_t>( UINT16_MAX ) * MAX_DT_US ) + FRAC_MASK <= UINT32_MAX,
+                   "A full step plus the carried fraction must fit in 32 bits" );
+
+    uint16_t m_level[ COUNT ];     // Brightness, 0 to LEVEL_MAX
+    uint16_t m_frac[ COUNT ];      // Carried part of a level, in 1/1024ths
+    uint16_t m_attack[ COUNT ];    // Rising rate in levels per 1024 us
+    uint16_t m_decay[ COUNT ];     // Falling rate in levels per 1024 us
+    uint8_t  m_phase[ COUNT ];     // One of Phase
+  };
+
+}    // namespace Animator
+
+#endif /* !HOLLY_JOLLY_ENVELOPE_HPP */
@@ -0,0 +1,163 @@
+/******************************************************************************
+ *  File Name:
+ *    fixed_point.hpp
+ *
+ *  Description:
+ *    Integer fixed point math and interpolation helpers. The M0+ has no FPU,
+ *    so anything run per LED per frame should stick to these.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+#pragma once
+#ifndef HOLLY_JOLLY_FIXED_POINT_HPP
+#define HOLLY_JOLLY_FIXED_POINT_HPP
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include <cstdint>
+
+namespace FixedPoint
+{
+  /*---------------------------------------------------------------------------
+  Aliases
+  ---------------------------------------------------------------------------*/
+
+  using q16_t = int32_t;    // Signed 16.16 fixed point
+
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr int   Q16_SHIFT = 16;
+  static constexpr q16_t Q16_ONE   = 1 << Q16_SHIFT;
+  static constexpr q16_t Q16_HALF  = Q16_ONE >> 1;
+
+  /*---------------------------------------------------------------------------
+  Public Functions
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Converts an integer to 16.16 fixed point
+   *
+   * @param value   Integer to convert
+   * @return q16_t
+   */
+  static constexpr q16_t toQ16( const int32_t value )
+  {
+    return static_cast<q16_t>( static_cast<uint32_t>( value ) << Q16_SHIFT );
+  }
+
+  /**
+   * @brief Truncates a 16.16 fixed point number to an integer
+   *
+   * @param value   Fixed point number to convert
+   * @return int32_t
+   */
+  static constexpr int32_t fromQ16( const q16_t value )
+  {
+    return value >> Q16_SHIFT;
+  }
+
+  /**
+   * @brief Multiplies two 16.16 fixed point numbers
+   *
+   * @param a   Left operand
+   * @param b   Right operand
+   * @return q16_t
+   */
+  static constexpr q16_t mul( const q16_t a, const q16_t b )
+  {
+    return static_cast<q16_t>( ( static_cast<int64_t>( a ) * b ) >> Q16_SHIFT );
+  }
+
+  /**
+   * @brief Converts a duration in microseconds into seconds as 16.16 fixed point
+   *
+   * @param us  Duration in microseconds
+   * @return q16_t
+   */
+  static constexpr q16_t secondsFromUs( const uint32_t us )
+  {
+    return static_cast<q16_t>( ( static_cast<uint64_t>( us ) << Q16_SHIFT ) / 1'000'000u );
+  }
+
+  /**
+   * @brief Linear interpolation between two 8-bit values
+   *
+   * @param a   Value when t == 0
+   * @param b   Value when t == 256
+   * @param t   Interpolation factor, 0 to 256
+   * @return uint8_t
+   */
+  static constexpr uint8_t lerp8( const uint8_t a, const uint8_t b, const uint32_t t )
+  {
+    return static_cast<uint8_t>( a + ( ( ( static_cast<int32_t>( b ) - a ) * static_cast<int32_t>( t ) ) >> 8 ) );
+  }
+
+  /**
+   * @brief Linear interpolation between two packed 0x00BBRRGG colors
+   *
+   * @param a   Color when t == 0
+   * @param b   Color when t == 256
+   * @param t   Interpolation factor, 0 to 256
+   * @return uint32_t
+   */
+  static constexpr uint32_t lerpColor( const uint32_t a, const uint32_t b, const uint32_t t )
+  {
+    return ( static_cast<uint32_t>( lerp8( a >> 16, b >> 16, t ) ) << 16 ) |
+           ( static_cast<uint32_t>( lerp8( a >> 8, b >> 8, t ) ) << 8 ) | lerp8( a, b, t );
+  }
+
+  /**
+   * @brief Scales an 8-bit value by an 8-bit fraction, where 256 means 1.0
+   *
+   * @param value   Value to scale
+   * @param scale   Scale factor, 0 to 256
+   * @return uint8_t
+   */
+  static constexpr uint8_t scale8( const uint8_t value, const uint32_t scale )
+  {
+    return static_cast<uint8_t>( ( value * scale ) >> 8 );
+  }
+
+  /**
+   * @brief Scales every channel of a packed 0x00BBRRGG color
+   *
+   * Blue and green are 16 bits apart, so both fit in one multiply without
+   * overflowing into each other. Red gets a multiply of its own.
+   *
+   * @param color   Color to scale
+   * @param scale   Scale factor, 0 to 256
+   * @return uint32_t
+   */
+  static constexpr uint32_t scaleColor( const uint32_t color, const uint32_t scale )
+  {
+    return ( ( ( ( color & 0x00FF00FF ) * scale ) >> 8 ) & 0x00FF00FF ) |
+           ( ( ( ( color & 0x0000FF00 ) * scale ) >> 8 ) & 0x0000FF00 );
+  }
+
+  /**
+   * @brief Adds two packed 0x00BBRRGG colors, clamping each channel at 255
+   *
+   * @param a   Left operand
+   * @param b   Right operand
+   * @return uint32_t
+   */
+  static constexpr uint32_t addColor( const uint32_t a, const uint32_t b )
+  {
+    /*-------------------------------------------------------------------------
+    Add with a spare bit above each channel, then turn any carry into a
+    saturated 0xFF for that channel.
+    -------------------------------------------------------------------------*/
+    const uint32_t even  = ( a & 0x00FF00FF ) + ( b & 0x00FF00FF );
+    const uint32_t odd   = ( ( a >> 8 ) & 0x000000FF ) + ( ( b >> 8 ) & 0x000000FF );
+    const uint32_t carry = ( ( even & 0x01000100 ) >> 8 ) * 0xFF;
+
+    return ( ( even | carry ) & 0x00FF00FF ) | ( ( ( odd > 0xFF ) ? 0xFF : odd ) << 8 );
+  }
+
+}    // namespace FixedPoint
+
+#endif /* !HOLLY_JOLLY_FIXED_POINT_HPP */
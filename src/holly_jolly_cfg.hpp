@@ -32,22 +32,6 @@ static constexpr uint32_t COLOR_PURPLE  = 0x8000FF;
 static constexpr uint32_t COLOR_LIME    = 0x00FF80;
 static constexpr uint32_t COLOR_PINK    = 0xFF0080;
 
-static constexpr uint32_t COLOR_LIST[] =
-{
-  COLOR_RED,
-  COLOR_GREEN,
-  COLOR_BLUE,
-  COLOR_YELLOW,
-  COLOR_MAGENTA,
-  COLOR_CYAN,
-  COLOR_ORANGE,
-  COLOR_PURPLE,
-  COLOR_LIME,
-  COLOR_PINK
-};
-
-static constexpr uint32_t COLOR_LIST_SIZE = sizeof( COLOR_LIST ) / sizeof( COLOR_LIST[ 0 ] );
-
 /**
  * @brief Periodic refresh rate of the animation system
  *
@@ -56,4 +40,73 @@ static constexpr uint32_t COLOR_LIST_SIZE = sizeof( COLOR_LIST ) / sizeof( COLOR
  */
 static constexpr uint32_t FRAME_REFRESH_RATE_MS = 10;
 
+/**
+ * @brief Number of LEDs in the string
+ *
+ * Set with the HOLLY_JOLLY_LED_COUNT CMake variable, which also sizes the
+ * generated projection map. The board has 32.
+ */
+#ifndef HOLLY_JOLLY_LED_COUNT
+#define HOLLY_JOLLY_LED_COUNT 32
+#endif
+
+/**
+ * @brief WS2812 wire timing profile to boot with, an LED::TimingProfile value
+ *
+ * Set with the HOLLY_JOLLY_WS2812_TIMING CMake option. Faster profiles are
+ * checked against the system clock at boot, and the driver falls back to
+ * 800kHz if they would put a pulse out of spec.
+ */
+#ifndef HOLLY_JOLLY_WS2812_TIMING
+#define HOLLY_JOLLY_WS2812_TIMING 0
+#endif
+
+/**
+ * @brief Start in OUTPUT_MAX_RATE, pushing frames as fast as the wire takes them
+ *
+ * Set with the HOLLY_JOLLY_OUTPUT_MAX_RATE CMake option. Otherwise frames are
+ * paced at FRAME_REFRESH_RATE_MS.
+ */
+#ifndef HOLLY_JOLLY_OUTPUT_MAX_RATE
+#define HOLLY_JOLLY_OUTPUT_MAX_RATE 0
+#endif
+
+/**
+ * @brief Render on both cores
+ *
+ * Core1 runs the render worker instead of the USB debugger, and per-LED work
+ * is split between the two cores. Set with the HOLLY_JOLLY_PARALLEL_RENDER
+ * CMake option. Strings of 16 LEDs or more are split, but the time saved
+ * only matters for strings of a few hundred LEDs or more.
+ */
+#ifndef HOLLY_JOLLY_PARALLEL_RENDER
+#define HOLLY_JOLLY_PARALLEL_RENDER 0
+#endif
+static constexpr bool PARALLEL_RENDER = ( HOLLY_JOLLY_PARALLEL_RENDER != 0 );
+
+/**
+ * @brief Stream every presented frame to a host over USB CDC
+ *
+ * Core1 runs the USB stack for the mirror instead of the USB debugger. Set
+ * with the HOLLY_JOLLY_USB_MIRROR CMake option, see tools/mirror_decode.py.
+ */
+#ifndef HOLLY_JOLLY_USB_MIRROR
+#define HOLLY_JOLLY_USB_MIRROR 0
+#endif
+static constexpr bool USB_MIRROR = ( HOLLY_JOLLY_USB_MIRROR != 0 );
+
+static_assert( !( PARALLEL_RENDER && USB_MIRROR ), "Core1 can render or run the mirror, not both" );
+
+/**
+ * @brief Drive clocked APA102/SK9822 LEDs instead of WS2812s
+ *
+ * Set with the HOLLY_JOLLY_LED_APA102 CMake option, which builds apa102.cpp
+ * in place of ws2812.cpp. Brightness moves into the LEDs' own 5-bit global
+ * brightness field instead of being scaled into every color.
+ */
+#ifndef HOLLY_JOLLY_LED_APA102
+#define HOLLY_JOLLY_LED_APA102 0
+#endif
+static constexpr bool LED_APA102 = ( HOLLY_JOLLY_LED_APA102 != 0 );
+
 #endif  /* !HOLLY_JOLLY_CONFIG_HPP_HPP */
@@ -1,8 +1,13 @@
 #include "animator.hpp"
 #include "buttons.hpp"
 #include "holly_jolly_cfg.hpp"
+#include "mirror.hpp"
+#include "parallel.hpp"
 #include "pico/multicore.h"
 #include "pico_debug.h"
+#include "sync.hpp"
+#include "telemetry.hpp"
+#include "trace.hpp"
 #include "ws2812.hpp"
 #include <cstring>
 
@@ -14,19 +19,82 @@ static void core0_entry()
   ---------------------------------------------------------------------------*/
   LED::initialize();
   Buttons::initialize();
+  Sync::initialize();
   Animator::initialize();
 
+  absolute_time_t next_frame = make_timeout_time_ms( FRAME_REFRESH_RATE_MS );
   while( 1 )
   {
-    sleep_ms( FRAME_REFRESH_RATE_MS );
+    const bool unlocked = ( LED::getOutputMode() == LED::OUTPUT_MAX_RATE );
+
+    /*-------------------------------------------------------------------------
+    Sleep until the next frame is due or the button or sync drivers have work
+    queued. Debounced edges and received sync frames signal an event, so they
+    are handled as soon as they arrive rather than on the next frame tick. In
+    max rate mode the frame deadline is replaced by the latch timer, which also
+    signals an event.
+    -------------------------------------------------------------------------*/
+    if( !unlocked )
+    {
+      const absolute_time_t wake = absolute_time_min( Buttons::nextDeadline(), Sync::nextDeadline() );
+      best_effort_wfe_or_timeout( absolute_time_min( next_frame, wake ) );
+    }
+    else if( !LED::readyForFrame() )
+    {
+      best_effort_wfe_or_timeout( absolute_time_min( Buttons::nextDeadline(), Sync::nextDeadline() ) );
+    }
+
     Buttons::process();
-    Animator::process();
+    Sync::process();
+
+    if( unlocked )
+    {
+      /*-----------------------------------------------------------------------
+      Render as soon as the previous frame has been handed to the wire. The
+      LED driver inserts exactly the reset latch gap between frames.
+      -----------------------------------------------------------------------*/
+      if( LED::readyForFrame() )
+      {
+        Animator::process();
+      }
+    }
+    else if( time_reached( next_frame ) )
+    {
+      /*-----------------------------------------------------------------------
+      Keep frames on a fixed cadence. If we fell more than a whole period
+      behind, resynchronize instead of bursting frames to catch up. The
+      animation clock absorbs the lost time, so motion stays on pace.
+      -----------------------------------------------------------------------*/
+      next_frame = delayed_by_ms( next_frame, FRAME_REFRESH_RATE_MS );
+      if( time_reached( next_frame ) )
+      {
+        Telemetry::recordDeadlineMiss();
+        next_frame = make_timeout_time_ms( FRAME_REFRESH_RATE_MS );
+      }
+
+      Animator::process();
+    }
+
+    Telemetry::updateStackStats();
   }
 }
 
 
 static void core1_entry()
 {
+  /*---------------------------------------------------------------------------
+  Core1 does one job: share the rendering load, mirror the display, or serve
+  the USB debugger
+  ---------------------------------------------------------------------------*/
+  if constexpr( PARALLEL_RENDER )
+  {
+    Parallel::workerEntry();
+  }
+  else if constexpr( USB_MIRROR )
+  {
+    Mirror::serviceEntry();
+  }
+
   /*---------------------------------------------------------------------------
   Initialize the USB port
   ---------------------------------------------------------------------------*/
@@ -45,7 +113,23 @@ int main()
   Initialize system resources
   ---------------------------------------------------------------------------*/
   timer_hw->dbgpause = 0;    // Do not pause the timer during debug
-  pico_debug_configure_clocks();
+
+  /*---------------------------------------------------------------------------
+  The debugger needs its USB clock setup. When core1 does something else,
+  stay at the faster SDK default system clock.
+  ---------------------------------------------------------------------------*/
+  if constexpr( !PARALLEL_RENDER && !USB_MIRROR )
+  {
+    pico_debug_configure_clocks();
+  }
+
+  Telemetry::initialize();    // Starts the cycle counter the trace times itself with
+  Trace::initialize();
+
+  /*---------------------------------------------------------------------------
+  Paint the stacks for high-water tracking while core1 is still parked
+  ---------------------------------------------------------------------------*/
+  Telemetry::paintStacks();
 
   /*---------------------------------------------------------------------------
   Start the secondary core
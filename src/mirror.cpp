@@ -0,0 +1,281 @@
+/******************************************************************************
+ *  File Name:
+ *    mirror.cpp
+ *
+ *  Description:
+ *    Live mirror of the presented frames, streamed over USB CDC
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "mirror.hpp"
+#include "spsc_queue.hpp"
+#include "telemetry.hpp"
+#include "tusb.h"
+#include "ws2812.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace Mirror
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr uint32_t COLOR_MASK = 0x00FFFFFF;    // Bits of each LED that are sent
+  static constexpr uint32_t RUN_MAX    = 128;           // Most LEDs a single token can cover
+  static constexpr uint8_t  TOKEN_DATA = 0x80;          // Set on tokens followed by changed LEDs
+  static constexpr size_t   PUMP_CHUNK = 64;            // Bytes moved into the CDC port per write
+
+  /**
+   * @brief Largest a coded frame can get, when every LED changed
+   */
+  static constexpr size_t MAX_FRAME_BYTES =
+      sizeof( Header ) + ( LED::count() * 3 ) + ( ( LED::count() + RUN_MAX - 1 ) / RUN_MAX );
+
+  /**
+   * @brief Smallest power of two that holds at least a few worst case frames
+   */
+  static constexpr size_t queue_size()
+  {
+    size_t size = 1024;
+    while( size < ( 4 * MAX_FRAME_BYTES ) )
+    {
+      size <<= 1;
+    }
+
+    return size;
+  }
+
+  static_assert( LED::count() <= UINT16_MAX, "LED count must fit the stream header" );
+
+  /*---------------------------------------------------------------------------
+  Static Data
+  ---------------------------------------------------------------------------*/
+
+  static Util::SPSCQueue<uint8_t, queue_size()> s_queue;      // Coded frames waiting for the host, core0 to core1
+  static std::atomic<bool>     s_host_open;                   // A host has the port open, set by pump()
+  static std::atomic<uint32_t> s_key_requests( 1 );           // Bumped by pump() each time the host needs a key frame
+  static std::atomic<uint32_t> s_key_served;                  // Request the last queued key frame answered, set by capture()
+  static uint32_t              s_sent[ LED::count() ];        // Last frame queued, what the host will end up with
+  static uint8_t               s_frame[ MAX_FRAME_BYTES ];    // Frame being coded
+  static uint16_t              s_sequence;
+  static uint32_t              s_since_key;
+  static Stats                 s_stats;
+
+  /*---------------------------------------------------------------------------
+  Static Functions
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Run length codes the XOR of a frame against a reference
+   *
+   * @param frame       Colors to code
+   * @param reference   Colors the host already has, or nullptr for black
+   * @param out         Where to write the payload, at least MAX_FRAME_BYTES
+   * @return size_t     Payload length
+   */
+  static size_t encode( const uint32_t *const frame, const uint32_t *const reference, uint8_t *const out )
+  {
+    const uint32_t count = LED::count();
+    uint8_t       *p     = out;
+    uint8_t       *skip  = nullptr;    // Last token if it was a skip, trimmed if nothing follows
+    uint32_t       i     = 0;
+
+    auto delta = [ & ]( const uint32_t idx ) {
+      return ( frame[ idx ] ^ ( reference ? reference[ idx ] : 0 ) ) & COLOR_MASK;
+    };
+
+    while( i < count )
+    {
+      uint32_t run = 0;
+      while( ( i < count ) && ( run < RUN_MAX ) && ( delta( i ) == 0 ) )
+      {
+        run++;
+        i++;
+      }
+
+      if( run != 0 )
+      {
+        skip = p;
+        *p++ = static_cast<uint8_t>( run - 1 );
+        continue;
+      }
+
+      uint8_t *const token = p++;
+      while( ( i < count ) && ( run < RUN_MAX ) && ( delta( i ) != 0 ) )
+      {
+        const uint32_t d = delta( i );
+        *p++             = static_cast<uint8_t>( d >> 16 );
+        *p++             = static_cast<uint8_t>( d >> 8 );
+        *p++             = static_cast<uint8_t>( d );
+        run++;
+        i++;
+      }
+
+      *token = static_cast<uint8_t>( TOKEN_DATA | ( run - 1 ) );
+      skip   = nullptr;
+    }
+
+    /*-------------------------------------------------------------------------
+    Unchanged LEDs at the end are implied, so a static frame is just a header
+    -------------------------------------------------------------------------*/
+    if( skip )
+    {
+      p = skip;
+    }
+
+    return static_cast<size_t>( p - out );
+  }
+
+  /*---------------------------------------------------------------------------
+  Public Functions
+  ---------------------------------------------------------------------------*/
+
+  void capture( const uint32_t *const frame )
+  {
+    s_sequence++;
+    if( !s_host_open.load( std::memory_order_acquire ) )
+    {
+      return;
+    }
+
+    /*-------------------------------------------------------------------------
+    Code the frame behind room for its header, against what the host has
+    -------------------------------------------------------------------------*/
+    const uint32_t start     = Telemetry::cycles();
+    const uint32_t requested = s_key_requests.load( std::memory_order_acquire );
+    const bool     rejoined  = ( requested != s_key_served.load( std::memory_order_relaxed ) );
+    const bool     key       = rejoined || ( s_since_key >= KEY_INTERVAL );
+    const size_t   length    = encode( frame, key ? nullptr : s_sent, s_frame + sizeof( Header ) );
+    const uint32_t cycles    = Telemetry::cyclesSince( start );
+
+    const Header header = { MIRROR_MAGIC,
+                            s_sequence,
+                            static_cast<uint8_t>( key ? FLAG_KEY : 0 ),
+                            0,
+                            static_cast<uint16_t>( LED::count() ),
+                            static_cast<uint16_t>( length ),
+                            static_cast<uint16_t>( std::min<uint32_t>( cycles, UINT16_MAX ) ) };
+    memcpy( s_frame, &header, sizeof( header ) );
+
+    s_stats.encode_cycles     = cycles;
+    s_stats.encode_cycles_max = std::max( s_stats.encode_cycles_max, cycles );
+
+    /*-------------------------------------------------------------------------
+    A new request means pump() has stopped reading until it is answered, and
+    whatever is queued was meant for a host that has since gone, maybe cut
+    off partway through a frame. Drop it so the key frame starts the stream.
+    -------------------------------------------------------------------------*/
+    if( rejoined )
+    {
+      s_queue.reset();
+    }
+
+    /*-------------------------------------------------------------------------
+    Queue all of it or none of it. A dropped frame leaves s_sent alone, so the
+    next one is still coded against what the host will have.
+    -------------------------------------------------------------------------*/
+    const size_t total = sizeof( Header ) + length;
+    if( s_queue.space() < total )
+    {
+      s_stats.frames_dropped++;
+      return;
+    }
+
+    for( size_t i = 0; i < total; i++ )
+    {
+      s_queue.push( s_frame[ i ] );
+    }
+
+    memcpy( s_sent, frame, sizeof( s_sent ) );
+    s_since_key = key ? 0 : ( s_since_key + 1 );
+
+    /*-------------------------------------------------------------------------
+    Only answer the request this frame was coded for, which lets pump() read
+    again. If it asked again while the frame was being queued, the mismatch
+    makes the next frame a key frame too.
+    -------------------------------------------------------------------------*/
+    if( key )
+    {
+      s_key_served.store( requested, std::memory_order_release );
+    }
+
+    s_stats.frames_sent++;
+    s_stats.bytes_sent += total;
+  }
+
+
+  void serviceEntry()
+  {
+    tusb_init();
+
+    while( true )
+    {
+      tud_task();
+      pump();
+    }
+  }
+
+
+  void pump()
+  {
+    /*-------------------------------------------------------------------------
+    With no host listening, ask for the next frame to start fresh for whoever
+    opens the port. Only this core writes the request count, so a plain load
+    and store will do where the M0+ has no atomic read-modify-write. The
+    queue is left alone, since core0 may be pushing into it; capture() drops
+    what is in it when it answers.
+    -------------------------------------------------------------------------*/
+    if( !tud_cdc_connected() )
+    {
+      s_host_open.store( false, std::memory_order_release );
+      s_key_requests.store( s_key_requests.load( std::memory_order_relaxed ) + 1, std::memory_order_release );
+      return;
+    }
+
+    s_host_open.store( true, std::memory_order_release );
+
+    /*-------------------------------------------------------------------------
+    Nothing is read until the key frame for the latest request is queued, so
+    capture() can safely empty the queue before queueing it
+    -------------------------------------------------------------------------*/
+    if( s_key_served.load( std::memory_order_acquire ) != s_key_requests.load( std::memory_order_relaxed ) )
+    {
+      return;
+    }
+
+    uint8_t  chunk[ PUMP_CHUNK ];
+    uint32_t room = tud_cdc_write_available();
+
+    while( room != 0 )
+    {
+      size_t n = 0;
+      while( ( n < std::min<size_t>( room, PUMP_CHUNK ) ) && s_queue.pop( chunk[ n ] ) )
+      {
+        n++;
+      }
+
+      if( n == 0 )
+      {
+        break;
+      }
+
+      tud_cdc_write( chunk, static_cast<uint32_t>( n ) );
+      room -= static_cast<uint32_t>( n );
+    }
+
+    tud_cdc_write_flush();
+  }
+
+
+  Stats getStats()
+  {
+    return s_stats;
+  }
+
+}    // namespace Mirror
@@ -0,0 +1,116 @@
+/******************************************************************************
+ *  File Name:
+ *    mirror.hpp
+ *
+ *  Description:
+ *    Live mirror of the presented frames, streamed over USB CDC
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+#pragma once
+#ifndef HOLLY_JOLLY_MIRROR_HPP
+#define HOLLY_JOLLY_MIRROR_HPP
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include <cstdint>
+
+/*-----------------------------------------------------------------------------
+Stream format, decoded by tools/mirror_decode.py. Each presented frame is a
+Header followed by its payload. The payload is XORed against the last frame
+that was sent, then run length coded as a series of tokens:
+
+  0x00 - 0x7F   Skip the next ( token + 1 ) LEDs, they did not change
+  0x80 - 0xFF   The next ( token - 0x7F ) LEDs changed. Each one is followed
+                by three bytes, XORed into its 0x00BBRRGG color high byte first
+
+LEDs past the end of the payload did not change. Key frames are coded
+against black, so a host joining mid-stream can start from the next one.
+-----------------------------------------------------------------------------*/
+
+namespace Mirror
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr uint16_t MIRROR_MAGIC = 0x4D48;     // "HM" on the wire
+  static constexpr uint8_t  FLAG_KEY     = 1u << 0;    // Payload is coded against black
+
+  /**
+   * @brief Frames between key frames, one second at the default frame rate
+   */
+  static constexpr uint32_t KEY_INTERVAL = 100;
+
+  /*---------------------------------------------------------------------------
+  Structures
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Start of every frame on the wire, little endian
+   */
+  struct Header
+  {
+    uint16_t magic;            // MIRROR_MAGIC
+    uint16_t sequence;         // Counts every presented frame, so gaps are frames that were dropped
+    uint8_t  flags;            // FLAG_ bits
+    uint8_t  reserved;         // Always zero
+    uint16_t leds;             // Number of LEDs in the string
+    uint16_t length;           // Payload bytes following this header
+    uint16_t encode_cycles;    // CPU cycles spent coding this frame, saturating
+  };
+
+  static_assert( sizeof( Header ) == 12, "Header layout is part of the stream format" );
+
+  /**
+   * @brief Running totals of what the mirror has done
+   */
+  struct Stats
+  {
+    uint32_t frames_sent;          // Frames queued for the host
+    uint32_t frames_dropped;       // Frames skipped because the host wasn't keeping up
+    uint32_t bytes_sent;           // Bytes queued for the host, headers included
+    uint32_t encode_cycles;        // Cycles spent coding the last frame
+    uint32_t encode_cycles_max;    // Worst case cycles spent coding a frame
+  };
+
+  /*---------------------------------------------------------------------------
+  Public Functions
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Codes a presented frame and queues it for the host
+   *
+   * Never waits on USB. If the queue doesn't have room for the whole frame it
+   * is dropped, and the next one is coded against the last frame that was
+   * actually sent. Nothing is coded while no host has the port open.
+   *
+   * @param frame   LED::count() colors, 0x00BBRRGG
+   */
+  void capture( const uint32_t *const frame );
+
+  /**
+   * @brief Runs the USB stack and feeds it queued frames. Never returns.
+   *
+   * Launch this on core1 in place of the USB debugger to mirror frames.
+   */
+  void serviceEntry();
+
+  /**
+   * @brief Moves as many queued bytes into the CDC port as it will take
+   *
+   * Must be called from the context that runs tud_task().
+   */
+  void pump();
+
+  /**
+   * @brief Gets the mirror statistics
+   * @return Stats
+   */
+  Stats getStats();
+
+}    // namespace Mirror
+
+#endif /* !HOLLY_JOLLY_MIRROR_HPP */
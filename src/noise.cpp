@@ -0,0 +1,257 @@
+/******************************************************************************
+ *  File Name:
+ *    noise.cpp
+ *
+ *  Description:
+ *    Integer value and gradient (Perlin) noise for smoothly varying effects
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "noise.hpp"
+#include "pico/platform.h"
+#include <algorithm>
+
+namespace Noise
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr int32_t FRAC_BITS = 12;                // Precision of the position within a cell
+  static constexpr int32_t FRAC_ONE  = 1 << FRAC_BITS;    // One whole cell at that precision
+
+  /*---------------------------------------------------------------------------
+  Output scaling for each dimension: the largest gain that clamps no more
+  than 1 in 10,000 samples. sim/tests/noise_test.cpp derives these again
+  from dense samples and fails if they drift.
+  ---------------------------------------------------------------------------*/
+  static constexpr int32_t PERLIN1_GAIN = 2;
+  static constexpr int32_t PERLIN2_GAIN = 9;
+  static constexpr int32_t PERLIN3_GAIN = 9;
+
+  /*---------------------------------------------------------------------------
+  Tables
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Ken Perlin's reference permutation, used to hash lattice points
+   */
+  static constexpr uint8_t PERM[ 256 ] = {
+    151, 160, 137, 91,  90,  15,  131, 13,  201, 95,  96,  53,  194, 233, 7,   225, 140, 36,  103, 30,  69,  142,
+    8,   99,  37,  240, 21,  10,  23,  190, 6,   148, 247, 120, 234, 75,  0,   26,  197, 62,  94,  252, 219, 203,
+    117, 35,  11,  32,  57,  177, 33,  88,  237, 149, 56,  87,  174, 20,  125, 136, 171, 168, 68,  175, 74,  165,
+    71,  134, 139, 48,  27,  166, 77,  146, 158, 231, 83,  111, 229, 122, 60,  211, 133, 230, 220, 105, 92,  41,
+    55,  46,  245, 40,  244, 102, 143, 54,  65,  25,  63,  161, 1,   216, 80,  73,  209, 76,  132, 187, 208, 89,
+    18,  169, 200, 196, 135, 130, 116, 188, 159, 86,  164, 100, 109, 198, 173, 186, 3,   64,  52,  217, 226, 250,
+    124, 123, 5,   202, 38,  147, 118, 126, 255, 82,  85,  212, 207, 206, 59,  227, 47,  16,  58,  17,  182, 189,
+    28,  42,  223, 183, 170, 213, 119, 248, 152, 2,   44,  154, 163, 70,  221, 153, 101, 155, 167, 43,  172, 9,
+    129, 22,  39,  253, 19,  98,  108, 110, 79,  113, 224, 232, 178, 185, 112, 104, 218, 246, 97,  228, 251, 34,
+    242, 193, 238, 210, 144, 12,  191, 179, 162, 241, 81,  51,  145, 235, 249, 14,  239, 107, 49,  192, 214, 31,
+    181, 199, 106, 157, 184, 84,  204, 176, 115, 121, 50,  45,  127, 4,   150, 254, 138, 236, 205, 93,  222, 114,
+    67,  29,  24,  72,  243, 141, 128, 195, 78,  66,  215, 61,  156, 180
+  };
+
+  /**
+   * @brief Gradient directions, picked by the low bits of a lattice hash
+   */
+  struct Gradient
+  {
+    int8_t x;
+    int8_t y;
+    int8_t z;
+  };
+
+  static constexpr Gradient GRAD2[ 8 ] = {
+    { 1, 1, 0 }, { -1, 1, 0 }, { 1, -1, 0 }, { -1, -1, 0 }, { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 },
+  };
+
+  static constexpr Gradient GRAD3[ 16 ] = {
+    { 1, 1, 0 },  { -1, 1, 0 },  { 1, -1, 0 }, { -1, -1, 0 }, { 1, 0, 1 },  { -1, 0, 1 },  { 1, 0, -1 }, { -1, 0, -1 },
+    { 0, 1, 1 },  { 0, -1, 1 },  { 0, 1, -1 }, { 0, -1, -1 }, { 1, 1, 0 },  { 0, -1, 1 },  { -1, 1, 0 }, { 0, -1, -1 },
+  };
+
+  static constexpr bool is_permutation()
+  {
+    bool seen[ 256 ] = {};
+    for( const uint8_t value : PERM )
+    {
+      if( seen[ value ] )
+      {
+        return false;
+      }
+      seen[ value ] = true;
+    }
+
+    return true;
+  }
+
+  static_assert( is_permutation(), "PERM must contain every byte exactly once" );
+
+  /*---------------------------------------------------------------------------
+  Static Functions
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Hashes lattice coordinates down to a byte
+   */
+  static __force_inline uint8_t hash( const uint32_t x )
+  {
+    return PERM[ x & 0xFF ];
+  }
+
+  static __force_inline uint8_t hash( const uint32_t x, const uint32_t y )
+  {
+    return PERM[ ( hash( x ) + y ) & 0xFF ];
+  }
+
+  static __force_inline uint8_t hash( const uint32_t x, const uint32_t y, const uint32_t z )
+  {
+    return PERM[ ( hash( x, y ) + z ) & 0xFF ];
+  }
+
+  /**
+   * @brief Position within a cell, 0 to FRAC_ONE - 1
+   */
+  static __force_inline int32_t frac( const uint32_t coord )
+  {
+    return static_cast<int32_t>( ( coord & 0xFFFF ) >> ( 16 - FRAC_BITS ) );
+  }
+
+  /**
+   * @brief Smoothstep, 3t^2 - 2t^3, so the noise has no creases at cell edges
+   */
+  static __force_inline int32_t fade( const int32_t t )
+  {
+    const int32_t t2 = ( t * t ) >> FRAC_BITS;
+    return ( t2 * ( 3 * FRAC_ONE - 2 * t ) ) >> FRAC_BITS;
+  }
+
+  static __force_inline int32_t lerp( const int32_t a, const int32_t b, const int32_t t )
+  {
+    return a + ( ( ( b - a ) * t ) >> FRAC_BITS );
+  }
+
+  static __force_inline int32_t grad1( const uint8_t h, const int32_t dx )
+  {
+    const int32_t slope = ( h & 7 ) + 1;
+    return ( h & 8 ) ? -slope * dx : slope * dx;
+  }
+
+  static __force_inline int32_t grad2( const uint8_t h, const int32_t dx, const int32_t dy )
+  {
+    const Gradient &g = GRAD2[ h & 7 ];
+    return g.x * dx + g.y * dy;
+  }
+
+  static __force_inline int32_t grad3( const uint8_t h, const int32_t dx, const int32_t dy, const int32_t dz )
+  {
+    const Gradient &g = GRAD3[ h & 15 ];
+    return g.x * dx + g.y * dy + g.z * dz;
+  }
+
+  static __force_inline int16_t saturate( const int32_t value )
+  {
+    return static_cast<int16_t>( std::clamp<int32_t>( value, INT16_MIN, INT16_MAX ) );
+  }
+
+  /*---------------------------------------------------------------------------
+  Public Functions
+  ---------------------------------------------------------------------------*/
+
+  uint8_t __not_in_flash_func( value1 )( const uint32_t x )
+  {
+    const uint32_t xi = x >> 16;
+    const int32_t  u  = fade( frac( x ) );
+
+    return static_cast<uint8_t>( lerp( hash( xi ), hash( xi + 1 ), u ) );
+  }
+
+
+  uint8_t __not_in_flash_func( value2 )( const uint32_t x, const uint32_t y )
+  {
+    const uint32_t xi = x >> 16;
+    const uint32_t yi = y >> 16;
+    const int32_t  u  = fade( frac( x ) );
+    const int32_t  v  = fade( frac( y ) );
+
+    const int32_t bottom = lerp( hash( xi, yi ), hash( xi + 1, yi ), u );
+    const int32_t top    = lerp( hash( xi, yi + 1 ), hash( xi + 1, yi + 1 ), u );
+
+    return static_cast<uint8_t>( lerp( bottom, top, v ) );
+  }
+
+
+  uint8_t __not_in_flash_func( value3 )( const uint32_t x, const uint32_t y, const uint32_t z )
+  {
+    const uint32_t xi = x >> 16;
+    const uint32_t yi = y >> 16;
+    const uint32_t zi = z >> 16;
+    const int32_t  u  = fade( frac( x ) );
+    const int32_t  v  = fade( frac( y ) );
+    const int32_t  w  = fade( frac( z ) );
+
+    const int32_t near_bottom = lerp( hash( xi, yi, zi ), hash( xi + 1, yi, zi ), u );
+    const int32_t near_top    = lerp( hash( xi, yi + 1, zi ), hash( xi + 1, yi + 1, zi ), u );
+    const int32_t far_bottom  = lerp( hash( xi, yi, zi + 1 ), hash( xi + 1, yi, zi + 1 ), u );
+    const int32_t far_top     = lerp( hash( xi, yi + 1, zi + 1 ), hash( xi + 1, yi + 1, zi + 1 ), u );
+
+    return static_cast<uint8_t>( lerp( lerp( near_bottom, near_top, v ), lerp( far_bottom, far_top, v ), w ) );
+  }
+
+
+  int16_t __not_in_flash_func( perlin1 )( const uint32_t x )
+  {
+    const uint32_t xi = x >> 16;
+    const int32_t  dx = frac( x );
+    const int32_t  u  = fade( dx );
+
+    return saturate( lerp( grad1( hash( xi ), dx ), grad1( hash( xi + 1 ), dx - FRAC_ONE ), u ) * PERLIN1_GAIN );
+  }
+
+
+  int16_t __not_in_flash_func( perlin2 )( const uint32_t x, const uint32_t y )
+  {
+    const uint32_t xi = x >> 16;
+    const uint32_t yi = y >> 16;
+    const int32_t  dx = frac( x );
+    const int32_t  dy = frac( y );
+    const int32_t  u  = fade( dx );
+    const int32_t  v  = fade( dy );
+
+    const int32_t bottom = lerp( grad2( hash( xi, yi ), dx, dy ), grad2( hash( xi + 1, yi ), dx - FRAC_ONE, dy ), u );
+    const int32_t top    = lerp( grad2( hash( xi, yi + 1 ), dx, dy - FRAC_ONE ),
+                                 grad2( hash( xi + 1, yi + 1 ), dx - FRAC_ONE, dy - FRAC_ONE ), u );
+
+    return saturate( lerp( bottom, top, v ) * PERLIN2_GAIN );
+  }
+
+
+  int16_t __not_in_flash_func( perlin3 )( const uint32_t x, const uint32_t y, const uint32_t z )
+  {
+    const uint32_t xi = x >> 16;
+    const uint32_t yi = y >> 16;
+    const uint32_t zi = z >> 16;
+    const int32_t  dx = frac( x );
+    const int32_t  dy = frac( y );
+    const int32_t  dz = frac( z );
+    const int32_t  u  = fade( dx );
+    const int32_t  v  = fade( dy );
+    const int32_t  w  = fade( dz );
+
+    const int32_t near_bottom = lerp( grad3( hash( xi, yi, zi ), dx, dy, dz ),
+                                      grad3( hash( xi + 1, yi, zi ), dx - FRAC_ONE, dy, dz ), u );
+    const int32_t near_top    = lerp( grad3( hash( xi, yi + 1, zi ), dx, dy - FRAC_ONE, dz ),
+                                      grad3( hash( xi + 1, yi + 1, zi ), dx - FRAC_ONE, dy - FRAC_ONE, dz ), u );
+    const int32_t far_bottom  = lerp( grad3( hash( xi, yi, zi + 1 ), dx, dy, dz - FRAC_ONE ),
+                                      grad3( hash( xi + 1, yi, zi + 1 ), dx - FRAC_ONE, dy, dz - FRAC_ONE ), u );
+    const int32_t far_top     = lerp( grad3( hash( xi, yi + 1, zi + 1 ), dx, dy - FRAC_ONE, dz - FRAC_ONE ),
+                                      grad3( hash( xi + 1, yi + 1, zi + 1 ), dx - FRAC_ONE, dy - FRAC_ONE, dz - FRAC_ONE ), u );
+
+    return saturate( lerp( lerp( near_bottom, near_top, v ), lerp( far_bottom, far_top, v ), w ) * PERLIN3_GAIN );
+  }
+
+}    // namespace Noise
@@ -0,0 +1,72 @@
+/******************************************************************************
+ *  File Name:
+ *    noise.hpp
+ *
+ *  Description:
+ *    Integer value and gradient (Perlin) noise for smoothly varying effects
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+#pragma once
+#ifndef HOLLY_JOLLY_NOISE_HPP
+#define HOLLY_JOLLY_NOISE_HPP
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include <cstdint>
+
+namespace Noise
+{
+  /*---------------------------------------------------------------------------
+  Coordinates are unsigned 16.16 fixed point, so one lattice cell is 0x10000.
+  Noise repeats every 256 cells, which also makes it seamless when a
+  coordinate wraps around 32 bits. Nothing in here uses floats or divides,
+  and each sample is a fixed number of integer operations.
+  ---------------------------------------------------------------------------*/
+
+  static constexpr uint32_t CELL = 1u << 16;    // Size of one lattice cell
+
+  /*---------------------------------------------------------------------------
+  Public Functions
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Value noise, interpolating random values at each lattice point
+   *
+   * Cheaper than Perlin noise but blobbier.
+   *
+   * @return uint8_t    Noise from 0 to 255
+   */
+  uint8_t value1( const uint32_t x );
+  uint8_t value2( const uint32_t x, const uint32_t y );
+  uint8_t value3( const uint32_t x, const uint32_t y, const uint32_t z );
+
+  /**
+   * @brief Gradient noise, interpolating random slopes at each lattice point
+   *
+   * Zero at every lattice point, with features that look more natural than
+   * value noise. Gradients come from a fixed table, as in Perlin's improved
+   * noise.
+   *
+   * @return int16_t    Noise, roughly -32768 to 32767 and centered on zero
+   */
+  int16_t perlin1( const uint32_t x );
+  int16_t perlin2( const uint32_t x, const uint32_t y );
+  int16_t perlin3( const uint32_t x, const uint32_t y, const uint32_t z );
+
+  /**
+   * @brief Maps gradient noise onto an LED level
+   *
+   * @param noise       Output of one of the perlin functions
+   * @return uint8_t    0 to 255, with 128 where the noise is zero
+   */
+  static constexpr uint8_t toLevel( const int16_t noise )
+  {
+    return static_cast<uint8_t>( ( static_cast<int32_t>( noise ) + 32768 ) >> 8 );
+  }
+
+}    // namespace Noise
+
+#endif /* !HOLLY_JOLLY_NOISE_HPP */
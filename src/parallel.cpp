@@ -0,0 +1,108 @@
+/******************************************************************************
+ *  File Name:
+ *    parallel.cpp
+ *
+ *  Description:
+ *    Splits per-LED work across both cores
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "hardware/sync.h"
+#include "parallel.hpp"
+#include "pico/multicore.h"
+#include "pico/platform.h"
+
+namespace Parallel
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr uint32_t FIFO_JOB_READY = 0x4A4F4221;    // Core0 to core1: s_job holds work
+  static constexpr uint32_t FIFO_JOB_DONE  = 0x444F4E45;    // Core1 to core0: s_job has been run
+
+  /*---------------------------------------------------------------------------
+  Structures
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Part of a range handed to core1
+   */
+  struct Job
+  {
+    RangeFn  fn;
+    void    *context;
+    uint32_t first;
+    uint32_t end;
+  };
+
+  /*---------------------------------------------------------------------------
+  Static Data
+  ---------------------------------------------------------------------------*/
+
+  static Job           s_job;             // Only written by core0 while core1 is idle
+  static volatile bool s_worker_ready;    // Set by core1 once it is waiting for work
+
+  /*---------------------------------------------------------------------------
+  Public Functions
+  ---------------------------------------------------------------------------*/
+
+  void __not_in_flash_func( workerEntry )()
+  {
+    s_worker_ready = true;
+
+    while( true )
+    {
+      if( multicore_fifo_pop_blocking() != FIFO_JOB_READY )
+      {
+        continue;
+      }
+
+      __dmb();
+      s_job.fn( s_job.context, s_job.first, s_job.end );
+      __dmb();
+
+      multicore_fifo_push_blocking( FIFO_JOB_DONE );
+    }
+  }
+
+
+  bool workerReady()
+  {
+    return s_worker_ready;
+  }
+
+
+  void __not_in_flash_func( run )( const RangeFn fn, void *const context, const uint32_t count )
+  {
+    if( !s_worker_ready || ( count < ( 2 * MIN_SPLIT ) ) )
+    {
+      fn( context, 0, count );
+      return;
+    }
+
+    /*-------------------------------------------------------------------------
+    Hand the upper half to core1 and do the lower half here. The FIFO word
+    back from core1 is the barrier: once it arrives every write core1 made is
+    visible, so the caller can go straight on to use the results.
+    -------------------------------------------------------------------------*/
+    const uint32_t split = count / 2;
+
+    s_job = { fn, context, split, count };
+    __dmb();
+    multicore_fifo_push_blocking( FIFO_JOB_READY );
+
+    fn( context, 0, split );
+
+    while( multicore_fifo_pop_blocking() != FIFO_JOB_DONE )
+    {
+      continue;
+    }
+    __dmb();
+  }
+
+}    // namespace Parallel
@@ -0,0 +1,96 @@
+/******************************************************************************
+ *  File Name:
+ *    parallel.hpp
+ *
+ *  Description:
+ *    Splits per-LED work across both cores
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+#pragma once
+#ifndef HOLLY_JOLLY_PARALLEL_HPP
+#define HOLLY_JOLLY_PARALLEL_HPP
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include <cstdint>
+#include <type_traits>
+
+namespace Parallel
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Smallest range worth handing to core1
+   *
+   * A round trip through the SIO FIFOs is a few register accesses and a wake
+   * from WFE on each core, which a handful of LEDs of render and post-process
+   * work pays for. Strings shorter than twice this stay on core0, so 32 LEDs
+   * still split. sim/tests/parallel_test.cpp reports what each half costs.
+   */
+  static constexpr uint32_t MIN_SPLIT = 8;
+
+  /*---------------------------------------------------------------------------
+  Aliases
+  ---------------------------------------------------------------------------*/
+
+  using RangeFn = void ( * )( void *context, const uint32_t first, const uint32_t end );
+
+  /*---------------------------------------------------------------------------
+  Public Functions
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Runs the render worker. Never returns.
+   *
+   * Launch this on core1 in place of the USB debugger to render on both cores.
+   */
+  void workerEntry();
+
+  /**
+   * @brief Checks if core1 is running the render worker
+   * @return bool
+   */
+  bool workerReady();
+
+  /**
+   * @brief Runs a function over [0, count), split across both cores if the worker is running
+   *
+   * Core1 takes the upper half of the range while core0 runs the lower half,
+   * then core0 waits for core1 to finish before returning. The function must
+   * only write its own part of any shared buffer and must not touch anything
+   * that isn't safe to use from two cores at once, such as rand().
+   *
+   * @param fn        Function to run on each part of the range
+   * @param context   Passed through to fn
+   * @param count     Length of the range
+   */
+  void run( const RangeFn fn, void *const context, const uint32_t count );
+
+  /**
+   * @brief Runs a callable over [0, count), split across both cores if the worker is running
+   *
+   * See run() for the rules the callable must follow.
+   *
+   * @param count   Length of the range
+   * @param fn      Callable taking ( uint32_t first, uint32_t end )
+   */
+  template<typename Fn>
+  void forEach( const uint32_t count, Fn &&fn )
+  {
+    using Callable = std::remove_reference_t<Fn>;
+
+    const RangeFn trampoline = []( void *context, const uint32_t first, const uint32_t end ) {
+      ( *static_cast<Callable *>( context ) )( first, end );
+    };
+
+    run( trampoline, const_cast<void *>( static_cast<const void *>( &fn ) ), count );
+  }
+
+}    // namespace Parallel
+
+#endif /* !HOLLY_JOLLY_PARALLEL_HPP */
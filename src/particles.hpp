@@ -0,0 +1,196 @@
+/******************************************************************************
+ *  File Name:
+ *    particles.hpp
+ *
+ *  Description:
+ *    Fixed capacity particle system for effects like sparks and snow
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+#pragma once
+#ifndef HOLLY_JOLLY_PARTICLES_HPP
+#define HOLLY_JOLLY_PARTICLES_HPP
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "fixed_point.hpp"
+#include "pico/platform.h"
+#include "ws2812.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace Animator
+{
+  /*---------------------------------------------------------------------------
+  Classes
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Pool of particles moving along the LED string
+   *
+   * Particles are stored as parallel arrays so the update loop streams
+   * through memory. Live particles are always packed at the front: spawning
+   * appends and retiring swaps the last live particle into the hole, so both
+   * are O(1) and nothing is ever allocated.
+   *
+   * Positions are in LEDs and velocities in LEDs per second, both 16.16 fixed
+   * point. Each particle fades out linearly over its lifetime.
+   *
+   * @tparam CAPACITY   Maximum number of live particles
+   */
+  template<size_t CAPACITY>
+  class ParticleSystem
+  {
+  public:
+    static_assert( CAPACITY <= UINT16_MAX, "Particle count must fit in 16 bits" );
+
+    /**
+     * @brief Longest lifetime a particle can have, so fades stay in 32-bit math
+     */
+    static constexpr uint32_t MAX_LIFETIME_US = ( 1u << 24 ) - 1;
+
+    ParticleSystem() : m_count( 0 )
+    {
+    }
+
+    /**
+     * @brief Retires every particle
+     */
+    void clear()
+    {
+      m_count = 0;
+    }
+
+    /**
+     * @brief Number of live particles
+     * @return size_t
+     */
+    size_t size() const
+    {
+      return m_count;
+    }
+
+    /**
+     * @brief Maximum number of live particles
+     * @return size_t
+     */
+    static constexpr size_t capacity()
+    {
+      return CAPACITY;
+    }
+
+    /**
+     * @brief Adds a new particle
+     *
+     * @param position      Starting position in LEDs, 16.16 fixed point
+     * @param velocity      LEDs per second, 16.16 fixed point
+     * @param lifetime_us   Time until the particle has faded out completely, up to MAX_LIFETIME_US
+     * @param color         Color at full brightness, 0x00BBRRGG
+     * @return bool         False if the pool is full
+     */
+    bool spawn( const FixedPoint::q16_t position, const FixedPoint::q16_t velocity, const uint32_t lifetime_us,
+                const uint32_t color )
+    {
+      if( ( m_count >= CAPACITY ) || ( lifetime_us == 0 ) )
+      {
+        return false;
+      }
+
+      m_position[ m_count ]  = position;
+      m_velocity[ m_count ]  = velocity;
+      m_remaining[ m_count ] = std::min( lifetime_us, MAX_LIFETIME_US );
+      m_lifetime[ m_count ]  = m_remaining[ m_count ];
+      m_color[ m_count ]     = color;
+      m_count++;
+      return true;
+    }
+
+    /**
+     * @brief Moves every particle and retires the ones that expired or left the string
+     *
+     * Always inlined, so it runs from RAM inside Sparks::process(). This is a
+     * template, so a section attribute of its own would be dropped.
+     *
+     * @param dt_us   Time elapsed since the last update
+     */
+    __force_inline void update( const uint32_t dt_us )
+    {
+      const FixedPoint::q16_t dt  = FixedPoint::secondsFromUs( dt_us );
+      const FixedPoint::q16_t end = FixedPoint::toQ16( LED::count() );
+
+      size_t i = 0;
+      while( i < m_count )
+      {
+        m_position[ i ] += FixedPoint::mul( m_velocity[ i ], dt );
+
+        const bool expired  = m_remaining[ i ] <= dt_us;
+        const bool off_edge = ( m_position[ i ] < -FixedPoint::Q16_ONE ) || ( m_position[ i ] >= end );
+
+        if( expired || off_edge )
+        {
+          retire( i );
+        }
+        else
+        {
+          m_remaining[ i ] -= dt_us;
+          i++;
+        }
+      }
+    }
+
+    /**
+     * @brief Additively draws every particle into an LED buffer
+     *
+     * A particle between two LEDs is split across both by its fractional
+     * position, so motion stays smooth at low speeds. Always inlined, like
+     * update().
+     *
+     * @param buffer  LED buffer to draw into, LED::count() entries
+     */
+    __force_inline void render( uint32_t *const buffer ) const
+    {
+      for( size_t i = 0; i < m_count; i++ )
+      {
+        const uint32_t fade  = ( m_remaining[ i ] << 8 ) / m_lifetime[ i ];
+        const uint32_t color = FixedPoint::scaleColor( m_color[ i ], fade );
+
+        const int32_t  led  = FixedPoint::fromQ16( m_position[ i ] );
+        const uint32_t frac = static_cast<uint32_t>( m_position[ i ] & ( FixedPoint::Q16_ONE - 1 ) ) >> 8;
+
+        if( led >= 0 )
+        {
+          buffer[ led ] = FixedPoint::addColor( buffer[ led ], FixedPoint::scaleColor( color, 256 - frac ) );
+        }
+
+        if( ( led + 1 ) < static_cast<int32_t>( LED::count() ) )
+        {
+          buffer[ led + 1 ] = FixedPoint::addColor( buffer[ led + 1 ], FixedPoint::scaleColor( color, frac ) );
+        }
+      }
+    }
+
+  private:
+    FixedPoint::q16_t m_position[ CAPACITY ];
+    FixedPoint::q16_t m_velocity[ CAPACITY ];
+    uint32_t          m_remaining[ CAPACITY ];    // Lifetime left in microseconds
+    uint32_t          m_lifetime[ CAPACITY ];     // Total lifetime in microseconds
+    uint32_t          m_color[ CAPACITY ];
+    size_t            m_count;
+
+    __force_inline void retire( const size_t idx )
+    {
+      m_count--;
+      m_position[ idx ]  = m_position[ m_count ];
+      m_velocity[ idx ]  = m_velocity[ m_count ];
+      m_remaining[ idx ] = m_remaining[ m_count ];
+      m_lifetime[ idx ]  = m_lifetime[ m_count ];
+      m_color[ idx ]     = m_color[ m_count ];
+    }
+  };
+
+}    // namespace Animator
+
+#endif /* !HOLLY_JOLLY_PARTICLES_HPP */
@@ -0,0 +1,132 @@
+/******************************************************************************
+ *  File Name:
+ *    post_process.hpp
+ *
+ *  Description:
+ *    Per-pixel post-processing applied between the render canvas and the
+ *    buffer handed to the LED driver.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+#pragma once
+#ifndef HOLLY_JOLLY_POST_PROCESS_HPP
+#define HOLLY_JOLLY_POST_PROCESS_HPP
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "dirty_region.hpp"
+#include "fixed_point.hpp"
+#include "pico/platform.h"
+#include "ws2812.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace Animator
+{
+  /*---------------------------------------------------------------------------
+  Post-Processing Stages
+
+  A stage is any type with `uint32_t operator()( uint32_t color ) const` that
+  takes and returns a packed 0x00BBRRGG color. Stages only see one pixel at a
+  time and hold whatever parameters they need as members.
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Scales every channel by a global brightness
+   */
+  struct BrightnessStage
+  {
+    uint32_t scale = 256;    // Brightness from 0 to 256, where 256 leaves colors unchanged
+
+    uint32_t operator()( const uint32_t color ) const
+    {
+      return FixedPoint::scaleColor( color, scale );
+    }
+  };
+
+  /**
+   * @brief Drops anything outside of the 24 bits the LEDs understand
+   *
+   * The GRB byte order the wire expects is produced by the DMA byte swap while
+   * the frame is transferred, so it costs nothing here.
+   */
+  struct FormatStage
+  {
+    uint32_t operator()( const uint32_t color ) const
+    {
+      return color & LED::WS2812_DATA_MSK;
+    }
+  };
+
+  /*---------------------------------------------------------------------------
+  Classes
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Compile time chain of post-processing stages
+   *
+   * Every stage is applied to a pixel before moving on to the next one, so the
+   * canvas is read once and the output written once no matter how many stages
+   * there are. Adding a stage only adds its arithmetic to the loop.
+   *
+   * @tparam Stages   Stages in the order they are applied
+   */
+  template<typename... Stages>
+  class Pipeline
+  {
+  public:
+    /**
+     * @brief Accesses a stage to update its parameters
+     * @return T&
+     */
+    template<typename T>
+    T &stage()
+    {
+      return std::get<T>( m_stages );
+    }
+
+    /**
+     * @brief Runs every stage over a span of LEDs
+     *
+     * Always inlined, so the pass runs from RAM when called from a function
+     * placed there. See Animator::present_frame().
+     *
+     * @param src     Render canvas to read from
+     * @param dst     Buffer to write the processed colors to
+     * @param span    LEDs to process
+     */
+    __force_inline void run( const uint32_t *const src, uint32_t *const dst, const LED::Span &span ) const
+    {
+      for( uint32_t i = span.first; i < span.end; i++ )
+      {
+        dst[ i ] = apply( src[ i ], std::index_sequence_for<Stages...>{} );
+      }
+    }
+
+  private:
+    std::tuple<Stages...> m_stages;
+
+    template<size_t... Is>
+    uint32_t apply( uint32_t color, std::index_sequence<Is...> ) const
+    {
+      ( ( color = std::get<Is>( m_stages )( color ) ), ... );
+      return color;
+    }
+  };
+
+  /**
+   * @brief Post-processing applied to every frame before it is displayed
+   *
+   * LEDs with their own brightness control skip the brightness stage.
+   */
+  using PostProcess = std::conditional_t<LED::HARDWARE_BRIGHTNESS, Pipeline<FormatStage>,
+                                         Pipeline<BrightnessStage, FormatStage>>;
+
+}    // namespace Animator
+
+#endif /* !HOLLY_JOLLY_POST_PROCESS_HPP */
@@ -0,0 +1,76 @@
+/******************************************************************************
+ *  File Name:
+ *    projection.cpp
+ *
+ *  Description:
+ *    Projects square images onto the physical layout of the LEDs
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "projection.hpp"
+#include "pico/platform.h"
+#include "projection_map.hpp"
+#include "ws2812.hpp"
+
+namespace Projection
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr uint32_t IMAGE_MASK = IMAGE_SIZE - 1;
+
+  static_assert( ( IMAGE_SIZE & IMAGE_MASK ) == 0, "Image size must be a power of two" );
+  static_assert( MAP_IMAGE_SIZE == IMAGE_SIZE, "Projection map was generated for a different image size" );
+  static_assert( MAP_LED_COUNT == LED::count(), "Projection map was generated for a different HOLLY_JOLLY_LED_COUNT" );
+  static_assert( MAP_WEIGHT_ONE == 256, "Accumulation below assumes weights out of 256" );
+
+  /*---------------------------------------------------------------------------
+  Public Functions
+  ---------------------------------------------------------------------------*/
+
+  void __not_in_flash_func( project )( const uint32_t *const image, const uint32_t scroll_x, const uint32_t scroll_y,
+                                       uint32_t *const buffer )
+  {
+    for( uint32_t led = 0; led < MAP_LED_COUNT; led++ )
+    {
+      /*-----------------------------------------------------------------------
+      Weights sum to 256 and channels are at most 255, so each channel sum fits
+      in 16 bits. Blue and green share one accumulator, packed in the same
+      lanes as scaleColor() uses, which saves a multiply per tap.
+      -----------------------------------------------------------------------*/
+      uint32_t acc_bg = 0;
+      uint32_t acc_r  = 0;
+
+      for( uint32_t t = MAP_ROWS[ led ]; t < MAP_ROWS[ led + 1 ]; t++ )
+      {
+        const Tap     &tap   = MAP_TAPS[ t ];
+        const uint32_t x     = ( tap.x + scroll_x ) & IMAGE_MASK;
+        const uint32_t y     = ( tap.y + scroll_y ) & IMAGE_MASK;
+        const uint32_t color = image[ y * IMAGE_SIZE + x ];
+
+        acc_bg += ( color & 0x00FF00FF ) * tap.weight;
+        acc_r  += ( color & 0x0000FF00 ) * tap.weight;
+      }
+
+      buffer[ led ] = ( ( acc_bg >> 8 ) & 0x00FF00FF ) | ( ( acc_r >> 8 ) & 0x0000FF00 );
+    }
+  }
+
+
+  Position __not_in_flash_func( position )( const uint32_t led )
+  {
+    return MAP_CENTERS[ led ];
+  }
+
+
+  uint32_t footprint()
+  {
+    return MAP_FOOTPRINT_Q8;
+  }
+
+}    // namespace Projection
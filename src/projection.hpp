@@ -0,0 +1,90 @@
+/******************************************************************************
+ *  File Name:
+ *    projection.hpp
+ *
+ *  Description:
+ *    Projects square images onto the physical layout of the LEDs
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+#pragma once
+#ifndef HOLLY_JOLLY_PROJECTION_HPP
+#define HOLLY_JOLLY_PROJECTION_HPP
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include <cstdint>
+
+namespace Projection
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Width and height of source images. Must be a power of two so
+   * scrolling can wrap with a mask.
+   */
+  static constexpr uint32_t IMAGE_SIZE = 64;
+
+  /*---------------------------------------------------------------------------
+  Structures
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief One source pixel's contribution to an LED
+   */
+  struct Tap
+  {
+    uint8_t  x;         // Pixel column
+    uint8_t  y;         // Pixel row
+    uint16_t weight;    // Share of the LED's color, out of 256
+  };
+
+  /**
+   * @brief Where an LED sits on the source image, in 1/256ths of a pixel
+   */
+  struct Position
+  {
+    uint16_t x;    // Column, growing to the right
+    uint16_t y;    // Row, growing downward
+  };
+
+  /*---------------------------------------------------------------------------
+  Public Functions
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Samples an image at every LED's position on the board
+   *
+   * Each LED averages the patch of image it covers, using weights generated
+   * at build time from the pick and place file. The cost only depends on the
+   * number of LEDs and the size of their patches, not on the image size.
+   *
+   * @param image     IMAGE_SIZE x IMAGE_SIZE pixels, row major, 0x00BBRRGG
+   * @param scroll_x  Columns to shift the image left by, wrapping around
+   * @param scroll_y  Rows to shift the image up by, wrapping around
+   * @param buffer    LED buffer to write, LED::count() entries
+   */
+  void project( const uint32_t *const image, const uint32_t scroll_x, const uint32_t scroll_y, uint32_t *const buffer );
+
+  /**
+   * @brief Gets the center of an LED's footprint on the source image
+   *
+   * @param led   LED index, less than LED::count()
+   * @return Position
+   */
+  Position position( const uint32_t led );
+
+  /**
+   * @brief Width of the square footprint each LED covers on the source image
+   *
+   * @return uint32_t   Width in 1/256ths of a pixel
+   */
+  uint32_t footprint();
+
+}    // namespace Projection
+
+#endif /* !HOLLY_JOLLY_PROJECTION_HPP */
@@ -0,0 +1,143 @@
+/******************************************************************************
+ *  File Name:
+ *    spsc_queue.hpp
+ *
+ *  Description:
+ *    Lock-free single producer, single consumer ring buffer. Intended for
+ *    handing data from an ISR to the main loop without disabling interrupts.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+#pragma once
+#ifndef HOLLY_JOLLY_SPSC_QUEUE_HPP
+#define HOLLY_JOLLY_SPSC_QUEUE_HPP
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Util
+{
+  /*---------------------------------------------------------------------------
+  Classes
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Fixed capacity ring buffer safe for exactly one writer and one reader
+   *
+   * The head index is only ever written by the producer and the tail index is
+   * only ever written by the consumer, so no locking is required. Indices are
+   * free running and wrap naturally, which is why the capacity must be a power
+   * of two.
+   *
+   * @tparam T      Element type. Should be small and trivially copyable.
+   * @tparam SIZE   Number of elements the queue can hold
+   */
+  template<typename T, size_t SIZE>
+  class SPSCQueue
+  {
+    static_assert( ( SIZE != 0 ) && ( ( SIZE & ( SIZE - 1 ) ) == 0 ), "Queue size must be a power of two" );
+
+  public:
+    SPSCQueue() : m_head( 0 ), m_tail( 0 )
+    {
+    }
+
+    /**
+     * @brief Producer side: push a new element into the queue
+     *
+     * @param item  Element to copy in
+     * @return bool True if queued, false if the queue was full
+     */
+    bool push( const T &item )
+    {
+      const uint32_t head = m_head.load( std::memory_order_relaxed );
+      if( ( head - m_tail.load( std::memory_order_acquire ) ) >= SIZE )
+      {
+        return false;
+      }
+
+      m_data[ head & ( SIZE - 1 ) ] = item;
+      m_head.store( head + 1, std::memory_order_release );
+      return true;
+    }
+
+    /**
+     * @brief Consumer side: pop the oldest element from the queue
+     *
+     * @param item  Output for the popped element
+     * @return bool True if an element was popped, false if the queue was empty
+     */
+    bool pop( T &item )
+    {
+      const uint32_t tail = m_tail.load( std::memory_order_relaxed );
+      if( tail == m_head.load( std::memory_order_acquire ) )
+      {
+        return false;
+      }
+
+      item = m_data[ tail & ( SIZE - 1 ) ];
+      m_tail.store( tail + 1, std::memory_order_release );
+      return true;
+    }
+
+    /**
+     * @brief Checks if there is anything waiting to be consumed
+     * @return bool
+     */
+    bool empty() const
+    {
+      return m_tail.load( std::memory_order_acquire ) == m_head.load( std::memory_order_acquire );
+    }
+
+    /**
+     * @brief Producer side: number of elements that can be pushed before the queue is full
+     * @return size_t
+     */
+    size_t space() const
+    {
+      return SIZE - ( m_head.load( std::memory_order_relaxed ) - m_tail.load( std::memory_order_acquire ) );
+    }
+
+    /**
+     * @brief Consumer side: discard everything currently in the queue
+     */
+    void clear()
+    {
+      m_tail.store( m_head.load( std::memory_order_acquire ), std::memory_order_release );
+    }
+
+    /**
+     * @brief Producer side: discard everything currently in the queue
+     *
+     * This writes the consumer's index, so it is only safe while the consumer
+     * is known not to be popping, e.g. while it waits on a flag the producer
+     * sets after this call.
+     */
+    void reset()
+    {
+      m_tail.store( m_head.load( std::memory_order_relaxed ), std::memory_order_release );
+    }
+
+    /**
+     * @brief Total number of elements the queue can hold
+     * @return size_t
+     */
+    static constexpr size_t capacity()
+    {
+      return SIZE;
+    }
+
+  private:
+    std::atomic<uint32_t> m_head;    // Next slot to write, owned by the producer
+    std::atomic<uint32_t> m_tail;    // Next slot to read, owned by the consumer
+    T                     m_data[ SIZE ];
+  };
+
+}    // namespace Util
+
+#endif /* !HOLLY_JOLLY_SPSC_QUEUE_HPP */
@@ -0,0 +1,272 @@
+/******************************************************************************
+ *  File Name:
+ *    sync.cpp
+ *
+ *  Description:
+ *    Keeps several Holly Jolly trees showing the same animation in step over
+ *    a daisy chained UART link.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "sync.hpp"
+#include "animator.hpp"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "hardware/uart.h"
+#include "pico/time.h"
+#include "spsc_queue.hpp"
+#include "sync_protocol.hpp"
+
+namespace Sync
+{
+  /*---------------------------------------------------------------------------
+  Each tree listens to the one upstream on RX and repeats its own state to the
+  one downstream on TX. A tree that hears nothing is the leader, and every
+  follower re-broadcasts what it adopted, so the chain can be any length and
+  the leader is simply whichever tree is first.
+  ---------------------------------------------------------------------------*/
+
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr uint     s_pin_uart_tx       = 0;
+  static constexpr uint     s_pin_uart_rx       = 1;
+  static constexpr uint     s_baud_rate         = 115'200;
+  static constexpr uint32_t s_tx_period_us      = 100'000;      // Time between periodic broadcasts
+  static constexpr uint32_t s_leader_timeout_us = 1'000'000;    // Silence upstream before taking the lead
+  static constexpr size_t   s_rx_queue_size     = 4;
+
+  /**
+   * @brief Time between the sender reading its clock and the receiver's
+   * timestamp, which is dominated by shifting the frame out at 10 bits a byte.
+   */
+  static constexpr uint32_t s_transit_us = ( SYNC_FRAME_SIZE * 10 * 1'000'000 ) / s_baud_rate;
+
+  /*---------------------------------------------------------------------------
+  Structures
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Frame decoded by the RX interrupt
+   */
+  struct RxFrame
+  {
+    SyncState state;    // Decoded contents
+    uint64_t  rx_us;    // Local time the last byte was read
+  };
+
+  /*---------------------------------------------------------------------------
+  Static Variables
+  ---------------------------------------------------------------------------*/
+
+  static uart_inst_t *const                        s_uart = uart0;
+  static Decoder                                   s_decoder;
+  static Util::SPSCQueue<RxFrame, s_rx_queue_size> s_rx_queue;
+  static ClockSlew                                 s_clock;
+  static SyncState                                 s_last_sent;
+  static uint64_t                                  s_next_tx_us;
+  static uint64_t                                  s_last_rx_us;
+  static bool                                      s_have_upstream;
+  static LinkStats                                 s_stats;
+  static volatile uint32_t                         s_rx_dropped;
+
+  /*---------------------------------------------------------------------------
+  Static Function Definitions
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Drains the RX FIFO through the decoder, queueing complete frames
+   */
+  static void irqh_uart_rx()
+  {
+    while( uart_is_readable( s_uart ) )
+    {
+      if( !s_decoder.push( static_cast<uint8_t>( uart_getc( s_uart ) ) ) )
+      {
+        continue;
+      }
+
+      if( s_rx_queue.push( { s_decoder.state(), time_us_64() } ) )
+      {
+        __sev();    // Wake the main loop if it's parked in WFE
+      }
+      else
+      {
+        s_rx_dropped = s_rx_dropped + 1;
+      }
+    }
+  }
+
+
+  /**
+   * @brief Snapshot of what this tree is currently showing
+   *
+   * @param clock_us  Shared clock to stamp the state with
+   * @return SyncState
+   */
+  static SyncState local_state( const uint64_t clock_us )
+  {
+    SyncState state;
+    state.clock_us   = static_cast<uint32_t>( clock_us );
+    state.seed       = Animator::getAnimationSeed();
+    state.generation = Animator::getGeneration();
+    state.animation  = Animator::getAnimation();
+    state.palette    = Animator::getPalette();
+    state.brightness = Animator::getBrightness();
+    return state;
+  }
+
+
+  /**
+   * @brief Checks if the visible parts of two states differ
+   */
+  static bool state_changed( const SyncState &a, const SyncState &b )
+  {
+    return ( a.generation != b.generation ) || ( a.animation != b.animation ) || ( a.palette != b.palette ) ||
+           ( a.brightness != b.brightness );
+  }
+
+
+  /**
+   * @brief Adopts the state sent from upstream
+   *
+   * @param frame   Frame to apply
+   */
+  static void apply( const RxFrame &frame )
+  {
+    const SyncState &state = frame.state;
+
+    if( ( state.generation != Animator::getGeneration() ) || ( state.animation != Animator::getAnimation() ) )
+    {
+      Animator::startAnimation( state.animation, state.seed, state.generation );
+    }
+
+    if( state.palette != Animator::getPalette() )
+    {
+      Animator::setPalette( static_cast<Color::PaletteId>( state.palette ) );
+    }
+
+    if( state.brightness != Animator::getBrightness() )
+    {
+      Animator::setBrightness( state.brightness );
+    }
+
+    /*-------------------------------------------------------------------------
+    Work out where our clock was when the frame arrived, then compare against
+    where the sender's clock would have been by then.
+    -------------------------------------------------------------------------*/
+    const uint64_t local_us  = time_us_64();
+    const uint64_t shared_us = to_us_since_boot( now() ) - ( local_us - frame.rx_us );
+    const int32_t  error_us  = clockError( state, s_transit_us, shared_us );
+
+    s_clock.correct( error_us );
+    s_stats.last_error = error_us;
+  }
+
+  /*---------------------------------------------------------------------------
+  Public Functions
+  ---------------------------------------------------------------------------*/
+
+  void initialize()
+  {
+    /*-------------------------------------------------------------------------
+    Reset the link state
+    -------------------------------------------------------------------------*/
+    s_rx_queue.clear();
+    s_clock         = ClockSlew();
+    s_decoder       = Decoder();
+    s_last_sent     = {};
+    s_next_tx_us    = 0;
+    s_last_rx_us    = 0;
+    s_have_upstream = false;
+    s_stats         = {};
+    s_rx_dropped    = 0;
+
+    /*-------------------------------------------------------------------------
+    Configure the UART. The FIFOs stay enabled so a whole frame can be queued
+    for transmit without blocking the frame loop.
+    -------------------------------------------------------------------------*/
+    uart_init( s_uart, s_baud_rate );
+    uart_set_format( s_uart, 8, 1, UART_PARITY_NONE );
+    uart_set_fifo_enabled( s_uart, true );
+    gpio_set_function( s_pin_uart_tx, GPIO_FUNC_UART );
+    gpio_set_function( s_pin_uart_rx, GPIO_FUNC_UART );
+    gpio_pull_up( s_pin_uart_rx );    // Idle high when nothing is plugged in upstream
+
+    irq_set_exclusive_handler( UART0_IRQ, irqh_uart_rx );
+    irq_set_enabled( UART0_IRQ, true );
+    uart_set_irq_enables( s_uart, true, false );
+  }
+
+
+  void process()
+  {
+    /*-------------------------------------------------------------------------
+    Apply everything upstream sent since the last call
+    -------------------------------------------------------------------------*/
+    RxFrame frame;
+    while( s_rx_queue.pop( frame ) )
+    {
+      apply( frame );
+      s_last_rx_us    = frame.rx_us;
+      s_have_upstream = true;
+      s_stats.rx_frames++;
+    }
+
+    const uint64_t local_us = time_us_64();
+    if( s_have_upstream && ( ( local_us - s_last_rx_us ) > s_leader_timeout_us ) )
+    {
+      s_have_upstream = false;
+    }
+
+    /*-------------------------------------------------------------------------
+    Pass our state downstream periodically, and right away if it changed so
+    followers switch animations within a frame of us.
+    -------------------------------------------------------------------------*/
+    const SyncState state = local_state( to_us_since_boot( now() ) );
+    if( ( local_us >= s_next_tx_us ) || state_changed( state, s_last_sent ) )
+    {
+      uint8_t      buffer[ SYNC_FRAME_SIZE ];
+      const size_t size = encode( state, buffer );
+
+      uart_write_blocking( s_uart, buffer, size );    // Fits in the TX FIFO, so this doesn't wait
+
+      s_last_sent  = state;
+      s_next_tx_us = local_us + s_tx_period_us;
+      s_stats.tx_frames++;
+    }
+  }
+
+
+  absolute_time_t nextDeadline()
+  {
+    return from_us_since_boot( s_next_tx_us );
+  }
+
+
+  absolute_time_t now()
+  {
+    return from_us_since_boot( s_clock.now( time_us_64() ) );
+  }
+
+
+  bool isLeader()
+  {
+    return !s_have_upstream;
+  }
+
+
+  LinkStats getLinkStats()
+  {
+    LinkStats stats  = s_stats;
+    stats.rx_dropped = s_rx_dropped;
+    return stats;
+  }
+
+}    // namespace Sync
@@ -0,0 +1,89 @@
+/******************************************************************************
+ *  File Name:
+ *    sync.hpp
+ *
+ *  Description:
+ *    Keeps several Holly Jolly trees showing the same animation in step over
+ *    a daisy chained UART link.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+#pragma once
+#ifndef HOLLY_JOLLY_SYNC_HPP
+#define HOLLY_JOLLY_SYNC_HPP
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "pico/types.h"
+#include <cstdint>
+
+namespace Sync
+{
+  /*---------------------------------------------------------------------------
+  Structures
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Link health counters
+   */
+  struct LinkStats
+  {
+    uint32_t rx_frames;     // Valid frames received from upstream
+    uint32_t rx_dropped;    // Frames lost because the receive queue was full
+    uint32_t tx_frames;     // Frames sent downstream
+    int32_t  last_error;    // Clock error measured from the last frame, in microseconds
+  };
+
+  /*---------------------------------------------------------------------------
+  Public Functions
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Configures the UART link and starts listening upstream
+   */
+  void initialize();
+
+  /**
+   * @brief Applies state received from upstream and sends ours downstream
+   *
+   * A tree that hasn't heard from upstream recently is the leader, so the
+   * first tree in the chain leads with no configuration needed.
+   */
+  void process();
+
+  /**
+   * @brief Gets the next time process() has work to do
+   *
+   * Received frames also signal an event, so the main loop wakes for those.
+   *
+   * @return absolute_time_t
+   */
+  absolute_time_t nextDeadline();
+
+  /**
+   * @brief Reads the shared animation clock
+   *
+   * Follows the leader's clock, with corrections slewed in so it never jumps
+   * or runs backwards in normal operation.
+   *
+   * @return absolute_time_t
+   */
+  absolute_time_t now();
+
+  /**
+   * @brief Checks if this tree is driving the chain
+   * @return bool
+   */
+  bool isLeader();
+
+  /**
+   * @brief Gets the link health counters
+   * @return LinkStats
+   */
+  LinkStats getLinkStats();
+
+}    // namespace Sync
+
+#endif /* !HOLLY_JOLLY_SYNC_HPP */
@@ -0,0 +1,163 @@
+/******************************************************************************
+ *  File Name:
+ *    sync_protocol.cpp
+ *
+ *  Description:
+ *    Wire format and clock slewing for keeping several trees in step
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "sync_protocol.hpp"
+#include <algorithm>
+
+namespace Sync
+{
+  /*---------------------------------------------------------------------------
+  Static Functions
+  ---------------------------------------------------------------------------*/
+
+  static void put_u32( uint8_t *const out, const uint32_t value )
+  {
+    out[ 0 ] = static_cast<uint8_t>( value );
+    out[ 1 ] = static_cast<uint8_t>( value >> 8 );
+    out[ 2 ] = static_cast<uint8_t>( value >> 16 );
+    out[ 3 ] = static_cast<uint8_t>( value >> 24 );
+  }
+
+  static uint32_t get_u32( const uint8_t *const in )
+  {
+    return static_cast<uint32_t>( in[ 0 ] ) | ( static_cast<uint32_t>( in[ 1 ] ) << 8 ) |
+           ( static_cast<uint32_t>( in[ 2 ] ) << 16 ) | ( static_cast<uint32_t>( in[ 3 ] ) << 24 );
+  }
+
+  /*---------------------------------------------------------------------------
+  Public Functions
+  ---------------------------------------------------------------------------*/
+
+  uint8_t crc8( const uint8_t *const data, const size_t size )
+  {
+    uint8_t crc = 0;
+    for( size_t i = 0; i < size; i++ )
+    {
+      crc ^= data[ i ];
+      for( int bit = 0; bit < 8; bit++ )
+      {
+        crc = static_cast<uint8_t>( ( crc & 0x80 ) ? ( ( crc << 1 ) ^ 0x07 ) : ( crc << 1 ) );
+      }
+    }
+
+    return crc;
+  }
+
+
+  size_t encode( const SyncState &state, uint8_t *const out )
+  {
+    /*-------------------------------------------------------------------------
+    Little endian payload, CRC over the length and payload
+    -------------------------------------------------------------------------*/
+    out[ 0 ] = SYNC_SOF_0;
+    out[ 1 ] = SYNC_SOF_1;
+    out[ 2 ] = SYNC_PAYLOAD_SIZE;
+
+    uint8_t *const payload = &out[ 3 ];
+    put_u32( &payload[ 0 ], state.clock_us );
+    put_u32( &payload[ 4 ], state.seed );
+    payload[ 8 ]  = state.generation;
+    payload[ 9 ]  = state.animation;
+    payload[ 10 ] = state.palette;
+    payload[ 11 ] = state.brightness;
+
+    out[ SYNC_FRAME_SIZE - 1 ] = crc8( &out[ 2 ], SYNC_PAYLOAD_SIZE + 1 );
+    return SYNC_FRAME_SIZE;
+  }
+
+
+  int32_t clockError( const SyncState &state, const uint32_t transit_us, const uint64_t shared_us )
+  {
+    return static_cast<int32_t>( state.clock_us + transit_us - static_cast<uint32_t>( shared_us ) );
+  }
+
+  /*---------------------------------------------------------------------------
+  Decoder
+  ---------------------------------------------------------------------------*/
+
+  bool Decoder::push( const uint8_t byte )
+  {
+    /*-------------------------------------------------------------------------
+    Hunt for the start of frame, then collect the rest of the bytes
+    -------------------------------------------------------------------------*/
+    if( ( m_index == 0 ) && ( byte != SYNC_SOF_0 ) )
+    {
+      return false;
+    }
+
+    if( ( m_index == 1 ) && ( byte != SYNC_SOF_1 ) )
+    {
+      m_index = ( byte == SYNC_SOF_0 ) ? 1 : 0;
+      return false;
+    }
+
+    if( ( m_index == 2 ) && ( byte != SYNC_PAYLOAD_SIZE ) )
+    {
+      m_index = 0;
+      return false;
+    }
+
+    m_frame[ m_index++ ] = byte;
+    if( m_index < SYNC_FRAME_SIZE )
+    {
+      return false;
+    }
+
+    m_index = 0;
+    if( crc8( &m_frame[ 2 ], SYNC_PAYLOAD_SIZE + 1 ) != m_frame[ SYNC_FRAME_SIZE - 1 ] )
+    {
+      return false;
+    }
+
+    const uint8_t *const payload = &m_frame[ 3 ];
+    m_state.clock_us   = get_u32( &payload[ 0 ] );
+    m_state.seed       = get_u32( &payload[ 4 ] );
+    m_state.generation = payload[ 8 ];
+    m_state.animation  = payload[ 9 ];
+    m_state.palette    = payload[ 10 ];
+    m_state.brightness = payload[ 11 ];
+    return true;
+  }
+
+  /*---------------------------------------------------------------------------
+  ClockSlew
+  ---------------------------------------------------------------------------*/
+
+  uint64_t ClockSlew::now( const uint64_t local_us )
+  {
+    /*-------------------------------------------------------------------------
+    Move the applied offset toward the target by no more than a fraction of
+    the time that has passed, so the shared clock never runs backwards.
+    -------------------------------------------------------------------------*/
+    const int64_t elapsed   = static_cast<int64_t>( local_us - m_last_local_us );
+    const int64_t max_slew  = elapsed / SLEW_DIVISOR;
+    const int64_t remaining = m_target_us - m_offset_us;
+
+    m_offset_us += std::clamp( remaining, -max_slew, max_slew );
+    m_last_local_us = local_us;
+
+    return static_cast<uint64_t>( static_cast<int64_t>( local_us ) + m_offset_us );
+  }
+
+
+  void ClockSlew::correct( const int64_t error_us )
+  {
+    m_target_us = m_offset_us + error_us;
+
+    if( ( error_us > STEP_US ) || ( error_us < -STEP_US ) )
+    {
+      m_offset_us = m_target_us;
+    }
+  }
+
+}    // namespace Sync
@@ -0,0 +1,174 @@
+/******************************************************************************
+ *  File Name:
+ *    sync_protocol.hpp
+ *
+ *  Description:
+ *    Wire format and clock slewing for keeping several trees in step. Nothing
+ *    in here touches the hardware, so it builds and runs the same on a host.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+#pragma once
+#ifndef HOLLY_JOLLY_SYNC_PROTOCOL_HPP
+#define HOLLY_JOLLY_SYNC_PROTOCOL_HPP
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include <cstddef>
+#include <cstdint>
+
+namespace Sync
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr uint8_t  SYNC_SOF_0        = 0xA5;    // First start of frame byte
+  static constexpr uint8_t  SYNC_SOF_1        = 0x5A;    // Second start of frame byte
+  static constexpr size_t   SYNC_PAYLOAD_SIZE = 12;      // Encoded size of a SyncState
+  static constexpr size_t   SYNC_FRAME_SIZE   = 2 + 1 + SYNC_PAYLOAD_SIZE + 1;    // SOF, length, payload, CRC
+
+  /*---------------------------------------------------------------------------
+  Structures
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Everything a follower needs to draw the same frame as its upstream
+   */
+  struct SyncState
+  {
+    uint32_t clock_us;      // Sender's animation clock when the frame was sent
+    uint32_t seed;          // Random seed the current animation was started with
+    uint8_t  generation;    // Changes every time the sender starts an animation
+    uint8_t  animation;     // Index of the running animation
+    uint8_t  palette;       // Color theme
+    uint8_t  brightness;    // Global brightness, 0 to 255
+  };
+
+  /*---------------------------------------------------------------------------
+  Public Functions
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief CRC-8 (poly 0x07) over a block of bytes
+   *
+   * @param data    Bytes to check
+   * @param size    Number of bytes
+   * @return uint8_t
+   */
+  uint8_t crc8( const uint8_t *const data, const size_t size );
+
+  /**
+   * @brief Encodes a state into a complete frame
+   *
+   * @param state   State to send
+   * @param out     Buffer of at least SYNC_FRAME_SIZE bytes
+   * @return size_t Number of bytes written
+   */
+  size_t encode( const SyncState &state, uint8_t *const out );
+
+  /**
+   * @brief Error of a follower's shared clock against a frame from upstream
+   *
+   * Only the low 32 bits of the clock are sent, which is plenty since the
+   * error is always far below 35 minutes.
+   *
+   * @param state       Frame received from upstream
+   * @param transit_us  Time between the sender reading its clock and the last byte arriving
+   * @param shared_us   Follower's shared clock when the last byte arrived
+   * @return int32_t    Sender's clock minus the follower's, positive if the follower is behind
+   */
+  int32_t clockError( const SyncState &state, const uint32_t transit_us, const uint64_t shared_us );
+
+  /*---------------------------------------------------------------------------
+  Classes
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Byte at a time frame decoder
+   *
+   * Resynchronizes on the start of frame bytes after any corruption, so a
+   * follower can be plugged in mid-stream.
+   */
+  class Decoder
+  {
+  public:
+    Decoder() : m_index( 0 )
+    {
+    }
+
+    /**
+     * @brief Feeds one received byte through the decoder
+     *
+     * @param byte    Byte off the wire
+     * @return bool   True if this byte completed a valid frame
+     */
+    bool push( const uint8_t byte );
+
+    /**
+     * @brief State from the last valid frame
+     * @return const SyncState&
+     */
+    const SyncState &state() const
+    {
+      return m_state;
+    }
+
+  private:
+    uint8_t   m_frame[ SYNC_FRAME_SIZE ];
+    size_t    m_index;
+    SyncState m_state;
+  };
+
+  /**
+   * @brief Offset from the local clock to the shared animation clock
+   *
+   * Corrections are slewed in by running the clock slightly fast or slow,
+   * so animations never see time jump. Errors too large to slew in a
+   * reasonable time are stepped instead.
+   */
+  class ClockSlew
+  {
+  public:
+    static constexpr int64_t SLEW_DIVISOR = 16;         // Clock runs up to 1/16th fast or slow while correcting
+    static constexpr int64_t STEP_US      = 250'000;    // Errors larger than this are stepped, not slewed
+
+    ClockSlew() : m_offset_us( 0 ), m_target_us( 0 ), m_last_local_us( 0 )
+    {
+    }
+
+    /**
+     * @brief Reads the shared clock, advancing any correction in progress
+     *
+     * @param local_us    Local monotonic time
+     * @return uint64_t
+     */
+    uint64_t now( const uint64_t local_us );
+
+    /**
+     * @brief Corrects the clock toward a reference
+     *
+     * @param error_us    Reference clock minus this clock, measured at the same instant
+     */
+    void correct( const int64_t error_us );
+
+    /**
+     * @brief Correction still waiting to be slewed in
+     * @return int64_t
+     */
+    int64_t pending() const
+    {
+      return m_target_us - m_offset_us;
+    }
+
+  private:
+    int64_t  m_offset_us;        // Offset currently applied
+    int64_t  m_target_us;        // Offset being slewed toward
+    uint64_t m_last_local_us;    // Local time of the last now() call
+  };
+
+}    // namespace Sync
+
+#endif /* !HOLLY_JOLLY_SYNC_PROTOCOL_HPP */
@@ -0,0 +1,227 @@
+/******************************************************************************
+ *  File Name:
+ *    telemetry.cpp
+ *
+ *  Description:
+ *    Lightweight runtime measurements of the frame pipeline
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "hardware/structs/systick.h"
+#include "hardware/structs/xip_ctrl.h"
+#include "pico/platform.h"
+#include "telemetry.hpp"
+#include <algorithm>
+#include <cstddef>
+
+/*-----------------------------------------------------------------------------
+Stack bounds from the SDK linker script
+-----------------------------------------------------------------------------*/
+extern "C" uint32_t __StackBottom;
+extern "C" uint32_t __StackTop;
+extern "C" uint32_t __StackOneBottom;
+extern "C" uint32_t __StackOneTop;
+
+namespace Telemetry
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr uint32_t SYSTICK_MAX     = 0x00FFFFFF;    // SysTick is a 24-bit down counter
+  static constexpr uint32_t SYSTICK_ENABLE  = 1u << 0;       // Counter enable
+  static constexpr uint32_t SYSTICK_CLK_CPU = 1u << 2;       // Count processor clock cycles
+  static constexpr uint32_t STACK_PAINT     = 0xC0DEFACE;    // Pattern left in stack memory that was never used
+  static constexpr size_t   STACK_MARGIN    = 16;            // Words left unpainted below the painter's frame
+
+  /*---------------------------------------------------------------------------
+  Static Data
+  ---------------------------------------------------------------------------*/
+
+  static FrameStats s_frame_stats;
+  static uint32_t   s_last_present_us;
+  static StackStats s_stack_stats;
+  static CacheStats s_cache_stats;
+
+  /*---------------------------------------------------------------------------
+  Static Functions
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Measures how much of a painted stack has been used
+   *
+   * Stacks grow down, so the first word from the bottom that no longer holds
+   * the paint marks the deepest point reached.
+   *
+   * @param bottom  Lowest address of the stack
+   * @param top     One past the highest address of the stack
+   * @return uint32_t Bytes used
+   */
+  static uint32_t stack_used( const uint32_t *const bottom, const uint32_t *const top )
+  {
+    const uint32_t *p = bottom;
+    while( ( p < top ) && ( *p == STACK_PAINT ) )
+    {
+      p++;
+    }
+
+    return static_cast<uint32_t>( ( top - p ) * sizeof( uint32_t ) );
+  }
+
+  /*---------------------------------------------------------------------------
+  Public Functions
+  ---------------------------------------------------------------------------*/
+
+  void initialize()
+  {
+    s_frame_stats     = {};
+    s_cache_stats     = {};
+    s_last_present_us = 0;
+
+    /*-------------------------------------------------------------------------
+    Free run the SysTick off the processor clock with no interrupt
+    -------------------------------------------------------------------------*/
+    systick_hw->csr = 0;
+    systick_hw->rvr = SYSTICK_MAX;
+    systick_hw->cvr = 0;
+    systick_hw->csr = SYSTICK_ENABLE | SYSTICK_CLK_CPU;
+  }
+
+
+  uint32_t cycles()
+  {
+    return systick_hw->cvr;
+  }
+
+
+  uint32_t cyclesSince( const uint32_t start )
+  {
+    /*-------------------------------------------------------------------------
+    SysTick counts down, so the elapsed time is start - now modulo 2^24
+    -------------------------------------------------------------------------*/
+    return ( start - systick_hw->cvr ) & SYSTICK_MAX;
+  }
+
+
+  void recordDispatch( const uint32_t cycles )
+  {
+    s_frame_stats.frames++;
+    s_frame_stats.dispatch_cycles = cycles;
+    if( cycles > s_frame_stats.dispatch_cycles_max )
+    {
+      s_frame_stats.dispatch_cycles_max = cycles;
+    }
+  }
+
+
+  void beginFrame()
+  {
+    /*-------------------------------------------------------------------------
+    The counters saturate rather than wrap, so clear them instead of keeping
+    a running total. Writing any value clears a counter.
+    -------------------------------------------------------------------------*/
+    xip_ctrl_hw->ctr_hit = 0;
+    xip_ctrl_hw->ctr_acc = 0;
+  }
+
+
+  void recordFrame( const uint32_t cycles )
+  {
+    const uint32_t hits     = xip_ctrl_hw->ctr_hit;
+    const uint32_t accesses = xip_ctrl_hw->ctr_acc;
+
+    s_frame_stats.frame_cycles = cycles;
+    if( cycles > s_frame_stats.frame_cycles_max )
+    {
+      s_frame_stats.frame_cycles_max = cycles;
+    }
+
+    s_cache_stats.accesses = accesses;
+    s_cache_stats.hits     = hits;
+    if( ( accesses - hits ) > s_cache_stats.misses_max )
+    {
+      s_cache_stats.misses_max = accesses - hits;
+    }
+  }
+
+
+  void recordDeadlineMiss()
+  {
+    s_frame_stats.deadline_misses++;
+  }
+
+
+  void __not_in_flash_func( recordPresent )( const uint32_t timestamp_us )
+  {
+    s_frame_stats.frames_presented++;
+    s_frame_stats.present_interval_us = timestamp_us - s_last_present_us;
+    s_last_present_us                 = timestamp_us;
+  }
+
+
+  FrameStats getFrameStats()
+  {
+    FrameStats stats = s_frame_stats;
+    if( stats.present_interval_us != 0 )
+    {
+      stats.present_fps = 1'000'000u / stats.present_interval_us;
+    }
+
+    return stats;
+  }
+
+
+  CacheStats getCacheStats()
+  {
+    CacheStats stats = s_cache_stats;
+    if( stats.accesses != 0 )
+    {
+      stats.hit_rate_permille = static_cast<uint32_t>( ( static_cast<uint64_t>( stats.hits ) * 1000u ) / stats.accesses );
+    }
+
+    return stats;
+  }
+
+
+  void paintStacks()
+  {
+    /*-------------------------------------------------------------------------
+    Core1 isn't running yet, so its whole stack is free. Core0 is running on
+    its stack right now, so stop a little short of this frame.
+    -------------------------------------------------------------------------*/
+    for( uint32_t *p = &__StackOneBottom; p < &__StackOneTop; p++ )
+    {
+      *p = STACK_PAINT;
+    }
+
+    volatile uint32_t marker = 0;
+    const uintptr_t   frame  = reinterpret_cast<uintptr_t>( &marker ) - ( STACK_MARGIN * sizeof( uint32_t ) );
+    uint32_t *const   limit  = std::min( reinterpret_cast<uint32_t *>( frame ), &__StackTop );
+    for( uint32_t *p = &__StackBottom; p < limit; p++ )
+    {
+      *p = STACK_PAINT;
+    }
+
+    s_stack_stats.core0_size = static_cast<uint32_t>( ( &__StackTop - &__StackBottom ) * sizeof( uint32_t ) );
+    s_stack_stats.core1_size = static_cast<uint32_t>( ( &__StackOneTop - &__StackOneBottom ) * sizeof( uint32_t ) );
+    updateStackStats();
+  }
+
+
+  void updateStackStats()
+  {
+    s_stack_stats.core0_used = stack_used( &__StackBottom, &__StackTop );
+    s_stack_stats.core1_used = stack_used( &__StackOneBottom, &__StackOneTop );
+  }
+
+
+  StackStats getStackStats()
+  {
+    return s_stack_stats;
+  }
+
+}    // namespace Telemetry
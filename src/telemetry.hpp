@@ -0,0 +1,167 @@
+/******************************************************************************
+ *  File Name:
+ *    telemetry.hpp
+ *
+ *  Description:
+ *    Lightweight runtime measurements of the frame pipeline
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+#pragma once
+#ifndef HOLLY_JOLLY_TELEMETRY_HPP
+#define HOLLY_JOLLY_TELEMETRY_HPP
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include <cstdint>
+
+namespace Telemetry
+{
+  /*---------------------------------------------------------------------------
+  Structures
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Per-frame cost of the animation system
+   *
+   * All cycle counts are in CPU clock cycles as measured by the core's SysTick.
+   */
+  struct FrameStats
+  {
+    uint32_t frames;                 // Number of times the animator has run
+    uint32_t dispatch_cycles;        // Cycles spent in the last animation process() call
+    uint32_t dispatch_cycles_max;    // Worst case cycles spent in an animation process() call
+    uint32_t frame_cycles;           // Cycles spent on the last frame, dispatch through swap
+    uint32_t frame_cycles_max;       // Worst case cycles spent on a frame
+    uint32_t deadline_misses;        // Frames that started a full period or more late
+    uint32_t frames_presented;       // Frames that made it onto the wire and latched
+    uint32_t present_interval_us;    // Time between the last two latched frames
+    uint32_t present_fps;            // Achieved output frame rate, from present_interval_us
+  };
+
+  /**
+   * @brief XIP flash cache behavior during animator frames
+   *
+   * The cache counters are shared by both cores and every other bus master
+   * reading flash, so they cover everything that ran during the frame. In a
+   * copy_to_ram build they should stay close to zero.
+   */
+  struct CacheStats
+  {
+    uint32_t accesses;             // Cached flash reads during the last frame
+    uint32_t hits;                 // Of those, reads that hit in the cache
+    uint32_t misses_max;           // Worst case misses in a single frame
+    uint32_t hit_rate_permille;    // Cache hits per thousand accesses in the last frame
+  };
+
+  /**
+   * @brief Deepest stack use seen on each core, found by stack painting
+   */
+  struct StackStats
+  {
+    uint32_t core0_used;    // High-water mark of the core0 stack in bytes
+    uint32_t core0_size;    // Size of the core0 stack in bytes
+    uint32_t core1_used;    // High-water mark of the core1 stack in bytes
+    uint32_t core1_size;    // Size of the core1 stack in bytes
+  };
+
+  /*---------------------------------------------------------------------------
+  Public Functions
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Starts the cycle counter on the calling core
+   */
+  void initialize();
+
+  /**
+   * @brief Reads the free running cycle counter
+   *
+   * The counter is only 24 bits wide, so use cyclesSince() to compute
+   * intervals rather than subtracting raw values.
+   *
+   * @return uint32_t
+   */
+  uint32_t cycles();
+
+  /**
+   * @brief Computes the number of cycles elapsed since a previous cycles() call
+   *
+   * @param start   Value returned from cycles()
+   * @return uint32_t
+   */
+  uint32_t cyclesSince( const uint32_t start );
+
+  /**
+   * @brief Records the cost of a single animation dispatch
+   *
+   * @param cycles  Cycles spent in the animation's process() call
+   */
+  void recordDispatch( const uint32_t cycles );
+
+  /**
+   * @brief Starts measuring a frame by clearing the XIP cache counters
+   */
+  void beginFrame();
+
+  /**
+   * @brief Records the cost of a whole frame and its XIP cache use
+   *
+   * @param cycles  Cycles spent since the frame's beginFrame() call
+   */
+  void recordFrame( const uint32_t cycles );
+
+  /**
+   * @brief Records that a frame started late enough to skip a frame period
+   */
+  void recordDeadlineMiss();
+
+  /**
+   * @brief Records that a frame finished latching into the LEDs
+   *
+   * Safe to call from an ISR. Runs from RAM, since the latch ISR calls it.
+   *
+   * @param timestamp_us  Time the latch completed
+   */
+  void recordPresent( const uint32_t timestamp_us );
+
+  /**
+   * @brief Gets a snapshot of the current frame statistics
+   * @return FrameStats
+   */
+  FrameStats getFrameStats();
+
+  /**
+   * @brief Gets the XIP cache counters from the last frame
+   * @return CacheStats
+   */
+  CacheStats getCacheStats();
+
+  /**
+   * @brief Fills both core stacks with a known pattern
+   *
+   * Must be called from core0 before core1 is launched. Only the part of the
+   * core0 stack below the caller's frame is painted.
+   */
+  void paintStacks();
+
+  /**
+   * @brief Rescans the painted stacks for their high-water marks
+   *
+   * Only the untouched part of each stack is read, so this gets cheaper as
+   * the stacks fill. The results are kept in a static so a debugger attached
+   * over USB can read them while the firmware runs.
+   */
+  void updateStackStats();
+
+  /**
+   * @brief Gets the stack high-water marks from the last update
+   * @return StackStats
+   */
+  StackStats getStackStats();
+
+}    // namespace Telemetry
+
+#endif /* !HOLLY_JOLLY_TELEMETRY_HPP */
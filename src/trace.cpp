@@ -0,0 +1,105 @@
+/******************************************************************************
+ *  File Name:
+ *    trace.cpp
+ *
+ *  Description:
+ *    Per-core ring buffer of timestamped events
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+#include "pico/platform.h"
+#include "telemetry.hpp"
+#include "trace.hpp"
+#include <cstring>
+
+namespace Trace
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr uint32_t CALIBRATION_EVENTS = 64;    // record() calls timed at boot
+
+  /*---------------------------------------------------------------------------
+  Static Data
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief The trace. A debugger attached over USB can freeze and dump it with
+   *   (gdb) set var Trace::s_trace.enabled = 0
+   *   (gdb) dump binary value trace.bin Trace::s_trace
+   * and tools/trace_to_perfetto.py converts the dump for viewing.
+   */
+  static Buffer s_trace;
+
+  /*---------------------------------------------------------------------------
+  Public Functions
+  ---------------------------------------------------------------------------*/
+
+  void initialize()
+  {
+    memset( &s_trace, 0, sizeof( s_trace ) );
+    s_trace.magic   = TRACE_MAGIC;
+    s_trace.version = TRACE_VERSION;
+    s_trace.depth   = TRACE_DEPTH;
+    s_trace.cores   = TRACE_CORES;
+    s_trace.enabled = 1;
+
+    /*-------------------------------------------------------------------------
+    Time a burst of events, call overhead and all, then drop them
+    -------------------------------------------------------------------------*/
+    const uint32_t start = Telemetry::cycles();
+    for( uint32_t i = 0; i < CALIBRATION_EVENTS; i++ )
+    {
+      record( EVENT_FRAME_BEGIN, static_cast<uint16_t>( i ) );
+    }
+    const uint32_t cycles = Telemetry::cyclesSince( start );
+
+    memset( s_trace.head, 0, sizeof( s_trace.head ) );
+    memset( s_trace.records, 0, sizeof( s_trace.records ) );
+    s_trace.record_cycles = static_cast<uint16_t>( cycles / CALIBRATION_EVENTS );
+  }
+
+
+  void __not_in_flash_func( record )( const EventId event, const uint16_t arg )
+  {
+    if( !s_trace.enabled )
+    {
+      return;
+    }
+
+    /*-------------------------------------------------------------------------
+    Only this core writes this ring, so the only thing to guard against is an
+    ISR on this core claiming a slot. The timestamp is read under the same
+    mask as the increment, so an ISR can't slip a later event into an earlier
+    slot and the ring stays in time order. Filling the slot after that can't
+    collide with anyone.
+    -------------------------------------------------------------------------*/
+    const uint     core      = get_core_num();
+    const uint32_t irq_state = save_and_disable_interrupts();
+    const uint32_t timestamp = time_us_32();
+    const uint32_t slot      = s_trace.head[ core ]++;
+    restore_interrupts( irq_state );
+
+    s_trace.records[ core ][ slot & ( TRACE_DEPTH - 1 ) ] = { timestamp, arg, event, 0 };
+  }
+
+
+  void setEnabled( const bool enabled )
+  {
+    s_trace.enabled = enabled ? 1 : 0;
+  }
+
+
+  const Buffer &getBuffer()
+  {
+    return s_trace;
+  }
+
+}    // namespace Trace
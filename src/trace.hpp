@@ -0,0 +1,131 @@
+/******************************************************************************
+ *  File Name:
+ *    trace.hpp
+ *
+ *  Description:
+ *    Per-core ring buffer of timestamped events for seeing how IRQs, frames
+ *    and the LED wire line up in time
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+#pragma once
+#ifndef HOLLY_JOLLY_TRACE_HPP
+#define HOLLY_JOLLY_TRACE_HPP
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include <cstddef>
+#include <cstdint>
+
+namespace Trace
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr uint32_t TRACE_MAGIC   = 0x52544A48;    // "HJTR" in memory, marks the start of a dump
+  static constexpr uint16_t TRACE_VERSION = 2;             // Bumped whenever Buffer or EventId changes
+  static constexpr size_t   TRACE_CORES   = 2;             // One ring per core
+  static constexpr size_t   TRACE_DEPTH   = 1024;          // Events kept per core, must be a power of two
+
+  static_assert( ( TRACE_DEPTH & ( TRACE_DEPTH - 1 ) ) == 0, "Trace depth must be a power of two" );
+
+  /*---------------------------------------------------------------------------
+  Enumerations
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Things worth putting on a timeline. The meaning of the argument
+   * recorded with each is given alongside it.
+   *
+   * Append only: tools/trace_to_perfetto.py decodes these by value.
+   */
+  enum EventId : uint8_t
+  {
+    EVENT_FRAME_BEGIN,         // Animator started a frame. Animation index.
+    EVENT_FRAME_END,           // Animator finished a frame. 1 if it drew something.
+    EVENT_SWAP,                // Frame handed to the LED driver. 1 if queued behind the frame on the wire.
+    EVENT_DMA_START,           // DMA started streaming a frame to the PIO
+    EVENT_DMA_DONE,            // DMA finished reading the display buffer
+    EVENT_LATCH,               // Frame finished shifting out and latched into the LEDs
+    EVENT_BUTTON_EDGE,         // First GPIO edge of a button transition. Key.
+    EVENT_BUTTON_SETTLED,      // Debounce confirmed a transition. Key | pressed << 8.
+    EVENT_DISPATCH,            // Gesture callback about to run. Key | gesture << 8.
+    EVENT_ANIMATION_SWITCH,    // A new animation was started. Animation index.
+
+    EVENT_COUNT
+  };
+
+  /*---------------------------------------------------------------------------
+  Structures
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief One traced event
+   */
+  struct Record
+  {
+    uint32_t timestamp_us;    // Low 32 bits of the system timer
+    uint16_t arg;             // Event specific, see EventId
+    uint8_t  event;           // One of EventId
+    uint8_t  reserved;
+  };
+
+  /**
+   * @brief Everything the host needs to decode a trace, laid out to be dumped
+   * from memory as-is by a debugger
+   */
+  struct Buffer
+  {
+    uint32_t          magic;                                    // TRACE_MAGIC once initialized
+    uint16_t          version;                                  // TRACE_VERSION
+    uint16_t          depth;                                    // TRACE_DEPTH
+    uint16_t          cores;                                    // TRACE_CORES
+    uint16_t          record_cycles;                            // Cost of one record() call, measured at boot
+    volatile uint32_t enabled;                                  // Clear to freeze the trace before dumping it
+    uint32_t          head[ TRACE_CORES ];                      // Events ever written per core. Ring index is head % depth.
+    Record            records[ TRACE_CORES ][ TRACE_DEPTH ];    // Per-core rings
+  };
+
+  /*---------------------------------------------------------------------------
+  Public Functions
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Empties the trace and starts recording
+   *
+   * Times a burst of record() calls on the way, so the cost of tracing is in
+   * every dump. Call after Telemetry::initialize(), which starts the cycle
+   * counter, and before either core records anything.
+   */
+  void initialize();
+
+  /**
+   * @brief Appends an event to the calling core's ring, overwriting the oldest
+   *
+   * Safe to call from any core and from ISRs. Each core only writes its own
+   * ring, and interrupts are held off just long enough to claim a slot.
+   *
+   * @param event   What happened
+   * @param arg     Event specific detail, see EventId
+   */
+  void record( const EventId event, const uint16_t arg = 0 );
+
+  /**
+   * @brief Starts or stops recording, e.g. to freeze the rings around a glitch
+   *
+   * @param enabled   True to record events
+   */
+  void setEnabled( const bool enabled );
+
+  /**
+   * @brief Gets the trace buffer, for writing it out
+   * @return const Buffer&
+   */
+  const Buffer &getBuffer();
+
+}    // namespace Trace
+
+#endif /* !HOLLY_JOLLY_TRACE_HPP */
@@ -14,8 +14,15 @@ Includes
 #include "hardware/clocks.h"
 #include "hardware/dma.h"
 #include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "pico/platform.h"
+#include "pico/time.h"
+#include "telemetry.hpp"
+#include "trace.hpp"
 #include "ws2812.hpp"
 #include "ws2812.pio.h"
+#include "ws2812_timing.hpp"
+#include <algorithm>
 #include <cstring>
 
 /*---------------------------------------------------------------------------
@@ -30,26 +37,84 @@ namespace LED
   Constants
   ---------------------------------------------------------------------------*/
 
-  static constexpr uint FREQ_800KHZ     = 800'000;    // 800kHz data rate
-  static constexpr uint PIO_SM          = 0;          // PIO state machine index
-  static constexpr uint WS2812_DATA_PIN = 23;         // GPIO pin to drive the LEDs
+  static constexpr uint PIO_SM          = 0;     // PIO state machine index
+  static constexpr uint WS2812_DATA_PIN = 23;    // GPIO pin to drive the LEDs
+
+  /*---------------------------------------------------------------------------
+  Structures
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Everything needed to load and validate a timing profile
+   */
+  struct ProfileConfig
+  {
+    uint32_t             bit_rate_hz;                          // Data rate on the wire
+    const pio_program_t *program;                              // PIO program to load
+    pio_sm_config        ( *default_config )( uint offset );    // Generated config getter for the program
+    uint32_t             wrap_target;                          // Program wrap target, relative to the load offset
+    uint32_t             wrap;                                 // Program wrap, relative to the load offset
+    PioProgram           model;                                // Encoding the cycle model is run against
+  };
+
+  /*---------------------------------------------------------------------------
+  Timing Profiles
+  ---------------------------------------------------------------------------*/
+
+  static constexpr PioProgram WS2812_MODEL      = assembleWS2812Program( ws2812_T1, ws2812_T2, ws2812_T3 );
+  static constexpr PioProgram WS2812_FAST_MODEL = assembleWS2812Program( ws2812_fast_T1, ws2812_fast_T2, ws2812_fast_T3 );
+
+  static const ProfileConfig s_profiles[ TIMING_PROFILE_COUNT ] = {
+    /* TIMING_800KHZ  */ { 800'000, &ws2812_program, ws2812_program_get_default_config, ws2812_wrap_target, ws2812_wrap,
+                           WS2812_MODEL },
+    /* TIMING_1MHZ    */ { 1'000'000, &ws2812_fast_program, ws2812_fast_program_get_default_config, ws2812_fast_wrap_target,
+                           ws2812_fast_wrap, WS2812_FAST_MODEL },
+    /* TIMING_1200KHZ */ { 1'200'000, &ws2812_fast_program, ws2812_fast_program_get_default_config, ws2812_fast_wrap_target,
+                           ws2812_fast_wrap, WS2812_FAST_MODEL },
+  };
+
+  /*---------------------------------------------------------------------------
+  The standard profiles must hold at both clock configurations the board runs
+  with: the SDK default and the 48MHz USB clock used by pico-debug. Faster
+  profiles are only checked at runtime against the actual clock.
+  ---------------------------------------------------------------------------*/
+  static constexpr ProgramTiming WS2812_TIMING      = emulateWS2812Program( WS2812_MODEL, ws2812_wrap_target, ws2812_wrap );
+  static constexpr ProgramTiming WS2812_FAST_TIMING = emulateWS2812Program( WS2812_FAST_MODEL, ws2812_fast_wrap_target,
+                                                                            ws2812_fast_wrap );
+
+  static_assert( validateTiming( WS2812_TIMING, 800'000, 125'000'000, WS2812B_2020_LIMITS ), "800kHz out of spec" );
+  static_assert( validateTiming( WS2812_TIMING, 800'000, 48'000'000, WS2812B_2020_LIMITS ), "800kHz out of spec" );
+  static_assert( validateTiming( WS2812_FAST_TIMING, 1'000'000, 125'000'000, WS2812B_2020_LIMITS ), "1MHz out of spec" );
+  static_assert( validateTiming( WS2812_FAST_TIMING, 1'000'000, 48'000'000, WS2812B_2020_LIMITS ), "1MHz out of spec" );
 
   /*---------------------------------------------------------------------------
   Variables
   ---------------------------------------------------------------------------*/
 
-  static uint32_t  s_raw_led_buffer[ 2 ][ WS2812_NUM_LEDS ];    // Double buffered LED data
-  static uint32_t *sp_render_buffer;                            // Pointer to the current render buffer
-  static uint32_t *sp_display_buffer;                           // Pointer to the current display buffer
+  static uint32_t    s_canvas[ WS2812_NUM_LEDS ];               // Render canvas, persists between frames
+  static uint32_t    s_raw_led_buffer[ 2 ][ WS2812_NUM_LEDS ];  // Double buffered LED data
+  static uint32_t   *sp_back_buffer;                            // Pointer to the buffer being prepared
+  static uint32_t   *sp_display_buffer;                         // Pointer to the current display buffer
+  static DirtyRegion s_dirty;                                   // Canvas changes since the last swap
+  static DirtyRegion s_prev_dirty;                              // Canvas changes in the frame before that
   static int       s_dma_channel;                               // DMA channel for transferring data to the PIO
+  static int       s_pio_offset;                                // Load address of the PIO program, negative if none
+  static uint8_t   s_timing_profile;                            // Profile currently driving the data line
+  static uint8_t   s_output_mode;                               // How the main loop paces frames
+
+  static volatile bool s_wire_idle;       // Latch satisfied and nothing on the wire, a transfer may start now
+  static volatile bool s_frame_queued;    // A swapped frame is waiting for the latch gap to elapse
 
   /*---------------------------------------------------------------------------
   Static Function Declarations
   ---------------------------------------------------------------------------*/
 
-  static void dma_complete_callback();
-  static void init_pio();
-  static void init_dma();
+  static void    dma_complete_callback();
+  static int64_t latch_complete_callback( alarm_id_t id, void *user_data );
+  static void    start_transfer();
+  static bool    profile_is_valid( const TimingProfile profile );
+  static void    init_pio( const TimingProfile profile );
+  static void    init_dma();
 
   /*---------------------------------------------------------------------------
   Public Functions
@@ -61,16 +126,23 @@ namespace LED
     Initialize the LED buffers and set the initial buffer pointers
     -------------------------------------------------------------------------*/
     s_dma_channel     = 0;
-    sp_render_buffer  = &s_raw_led_buffer[ 0 ][ 0 ];
+    s_pio_offset      = -1;
+    s_timing_profile  = TIMING_800KHZ;
+    s_output_mode     = WS2812_DEFAULT_OUTPUT_MODE;
+    s_wire_idle       = true;
+    s_frame_queued    = false;
+    sp_back_buffer    = &s_raw_led_buffer[ 0 ][ 0 ];
     sp_display_buffer = &s_raw_led_buffer[ 1 ][ 0 ];
-    memset( sp_render_buffer, 0, sizeof( uint32_t ) * WS2812_NUM_LEDS );
-    memset( sp_display_buffer, 0, sizeof( uint32_t ) * WS2812_NUM_LEDS );
+    memset( s_canvas, 0, sizeof( s_canvas ) );
+    memset( s_raw_led_buffer, 0, sizeof( s_raw_led_buffer ) );
+    s_dirty.clear();
+    s_prev_dirty.clear();
 
     /*-------------------------------------------------------------------------
     Initialize the PIO and DMA peripherals
     -------------------------------------------------------------------------*/
     init_dma();
-    init_pio();
+    init_pio( profile_is_valid( WS2812_DEFAULT_TIMING ) ? WS2812_DEFAULT_TIMING : TIMING_800KHZ );
 
     /*-------------------------------------------------------------------------
     Start the first frame transfer by clearing the display buffer
@@ -81,7 +153,37 @@ namespace LED
 
   uint32_t *getRenderBuffer()
   {
-    return sp_render_buffer;
+    return s_canvas;
+  }
+
+
+  void markDirty( const uint32_t first, const uint32_t count )
+  {
+    if( first < WS2812_NUM_LEDS )
+    {
+      s_dirty.add( first, first + std::min( count, WS2812_NUM_LEDS - first ) );
+    }
+  }
+
+
+  void markAllDirty()
+  {
+    s_dirty.clear();
+    s_dirty.add( 0, WS2812_NUM_LEDS );
+  }
+
+
+  DirtyRegion getDamage()
+  {
+    DirtyRegion damage = s_dirty;
+    damage.merge( s_prev_dirty );
+    return damage;
+  }
+
+
+  uint32_t *getBackBuffer()
+  {
+    return sp_back_buffer;
   }
 
 
@@ -94,17 +196,106 @@ namespace LED
   void swapBuffers()
   {
     /*---------------------------------------------------------------------------
-    Wait for the current frame to finish before swapping buffers and kicking off
-    a transfer of the next frame.
+    Wait for the DMA to finish reading the display buffer so it can be handed
+    back for rendering. The data may still be shifting out of the PIO. The
+    latch alarm can start a queued frame between the wait and the swap, so
+    only go ahead once the DMA is seen idle with interrupts off.
     ---------------------------------------------------------------------------*/
-    dma_channel_wait_for_finish_blocking( s_dma_channel );
+    uint32_t irq_state = 0;
+    while( true )
+    {
+      dma_channel_wait_for_finish_blocking( s_dma_channel );
+
+      irq_state = save_and_disable_interrupts();
+      if( !dma_channel_is_busy( s_dma_channel ) )
+      {
+        break;
+      }
+
+      restore_interrupts( irq_state );
+    }
+
+    /*---------------------------------------------------------------------------
+    The buffer coming back was last brought up to date one frame before the
+    one being displayed, so remember both frames' worth of changes.
+    ---------------------------------------------------------------------------*/
+    s_prev_dirty = s_dirty;
+    s_dirty.clear();
 
-    uint32_t *p_temp  = sp_render_buffer;
-    sp_render_buffer  = sp_display_buffer;
+    /*---------------------------------------------------------------------------
+    Swap and either start the transfer now or leave it for the latch alarm to
+    start the instant the reset gap has elapsed. If a frame was already queued
+    it is replaced by this newer one.
+    ---------------------------------------------------------------------------*/
+    uint32_t *p_temp  = sp_back_buffer;
+    sp_back_buffer    = sp_display_buffer;
     sp_display_buffer = p_temp;
 
-    dma_channel_set_trans_count( s_dma_channel, WS2812_NUM_LEDS, false );
-    dma_channel_set_read_addr( s_dma_channel, sp_display_buffer, true );
+    Trace::record( Trace::EVENT_SWAP, !s_wire_idle );
+    if( s_wire_idle )
+    {
+      start_transfer();
+    }
+    else
+    {
+      s_frame_queued = true;
+    }
+
+    restore_interrupts( irq_state );
+  }
+
+
+  bool readyForFrame()
+  {
+    return !s_frame_queued;
+  }
+
+
+  void setOutputMode( const OutputMode mode )
+  {
+    s_output_mode = mode;
+  }
+
+
+  OutputMode getOutputMode()
+  {
+    return static_cast<OutputMode>( s_output_mode );
+  }
+
+
+  bool setTimingProfile( const TimingProfile profile )
+  {
+    if( !profile_is_valid( profile ) )
+    {
+      return false;
+    }
+
+    /*-------------------------------------------------------------------------
+    Let the frame in flight finish shifting out and latch before swapping
+    programs. Holding off the idle flag keeps swapBuffers() from starting a
+    transfer against a half configured state machine.
+    -------------------------------------------------------------------------*/
+    while( !s_wire_idle )
+    {
+      tight_loop_contents();
+    }
+
+    s_wire_idle = false;
+    init_pio( profile );
+    s_wire_idle = true;
+    return true;
+  }
+
+
+  TimingProfile getTimingProfile()
+  {
+    return static_cast<TimingProfile>( s_timing_profile );
+  }
+
+
+  uint32_t frameTimeUs()
+  {
+    return LED::frameTimeUs( s_profiles[ s_timing_profile ].bit_rate_hz, WS2812_NUM_LEDS, WS2812B_2020_LIMITS );
   }
 
 
@@ -112,27 +303,80 @@ namespace LED
   {
     dma_channel_wait_for_finish_blocking( s_dma_channel );
 
-    memset( sp_render_buffer, 0, sizeof( uint32_t ) * WS2812_NUM_LEDS );
+    memset( s_canvas, 0, sizeof( s_canvas ) );
+    memset( sp_back_buffer, 0, sizeof( uint32_t ) * WS2812_NUM_LEDS );
     memset( sp_display_buffer, 0, sizeof( uint32_t ) * WS2812_NUM_LEDS );
+    markAllDirty();
   }
 
   /*---------------------------------------------------------------------------
   Static Functions
   ---------------------------------------------------------------------------*/
 
+  /**
+   * @brief Checks a timing profile against the datasheet at the current clock
+   *
+   * @param profile   Profile to check
+   * @return bool     True if the profile is safe to use
+   */
+  static bool profile_is_valid( const TimingProfile profile )
+  {
+    if( profile >= TIMING_PROFILE_COUNT )
+    {
+      return false;
+    }
+
+    const ProfileConfig &cfg = s_profiles[ profile ];
+
+    /*-------------------------------------------------------------------------
+    Make sure the model describes the machine code that will actually run. If
+    someone edits the .pio file without updating the model, refuse to trust it.
+    -------------------------------------------------------------------------*/
+    if( cfg.program->length != cfg.model.size() )
+    {
+      return false;
+    }
+
+    for( size_t i = 0; i < cfg.model.size(); i++ )
+    {
+      if( cfg.program->instructions[ i ] != cfg.model[ i ] )
+      {
+        return false;
+      }
+    }
+
+    const ProgramTiming timing = emulateWS2812Program( cfg.model, cfg.wrap_target, cfg.wrap );
+    return validateTiming( timing, cfg.bit_rate_hz, clock_get_hz( clk_sys ), WS2812B_2020_LIMITS );
+  }
+
+
   /**
    * @brief Initializes the PIO (Programmable I/O) for controlling WS2812 LEDs.
+   *
+   * @param profile   Timing profile to load
    */
-  static void init_pio()
+  static void init_pio( const TimingProfile profile )
   {
+    const ProfileConfig &profile_cfg = s_profiles[ profile ];
+
+    // Unload the previous program if switching profiles
+    if( s_pio_offset >= 0 )
+    {
+      pio_sm_set_enabled( PIO_INSTANCE, PIO_SM, false );
+      pio_remove_program( PIO_INSTANCE, s_profiles[ s_timing_profile ].program, s_pio_offset );
+      s_pio_offset = -1;
+    }
+
     // Load the program into the pio peripheral
-    uint pio_pgm_offset = pio_add_program( PIO_INSTANCE, &ws2812_program );
+    uint pio_pgm_offset = pio_add_program( PIO_INSTANCE, profile_cfg.program );
+    s_pio_offset        = static_cast<int>( pio_pgm_offset );
+    s_timing_profile    = profile;
 
     // Initialize the GPIO pin that will be used to drive the WS2812 LEDs
     pio_gpio_init( PIO_INSTANCE, WS2812_DATA_PIN );
     pio_sm_set_consecutive_pindirs( PIO_INSTANCE, PIO_SM, WS2812_DATA_PIN, 1, true );
 
-    pio_sm_config cfg = ws2812_program_get_default_config( pio_pgm_offset );
+    pio_sm_config cfg = profile_cfg.default_config( pio_pgm_offset );
 
     // Set base pin to act on when the sideset command is executed
     sm_config_set_sideset_pins( &cfg, WS2812_DATA_PIN );
@@ -145,11 +389,13 @@ namespace LED
     // Set the FIFO join to TX so that the TX FIFO is used
     sm_config_set_fifo_join( &cfg, PIO_FIFO_JOIN_TX );
 
-    // Configure the PIO clock so that programmed cycle times are correct. These
-    // literals are coming from the PIO program generated by the pioasm tool.
-    int   cycles_per_bit = ws2812_T1 + ws2812_T2 + ws2812_T3;
-    float div            = clock_get_hz( clk_sys ) / ( FREQ_800KHZ * cycles_per_bit );
-    sm_config_set_clkdiv( &cfg, div );
+    // Configure the PIO clock so that programmed cycle times are correct. The
+    // cycles per bit come from the emulated program and the divider is computed
+    // in 16.8 fixed point, matching the hardware register.
+    const ProgramTiming timing = emulateWS2812Program( profile_cfg.model, profile_cfg.wrap_target, profile_cfg.wrap );
+    const uint32_t cycles_per_bit = timing.zero.high + timing.zero.low;
+    const uint32_t div            = pioClockDivider( clock_get_hz( clk_sys ), profile_cfg.bit_rate_hz, cycles_per_bit );
+    sm_config_set_clkdiv_int_frac( &cfg, static_cast<uint16_t>( div >> 8 ), static_cast<uint8_t>( div & 0xFF ) );
 
     // Initialize and enable the PIO state machine
     pio_sm_init( PIO_INSTANCE, PIO_SM, pio_pgm_offset, &cfg );
@@ -198,7 +444,6 @@ namespace LED
 
     // Assign the DMA channel to write to the PIO TX FIFO
     dma_channel_configure( s_dma_channel, &dma_cfg, &PIO_INSTANCE->txf[ PIO_SM ], nullptr, 0, false );
-    dma_channel_start( s_dma_channel );
 
     /*---------------------------------------------------------------------------
     Handle the transfer complete event
@@ -210,10 +455,75 @@ namespace LED
 
 
   /**
-   * @brief Acknowledge the DMA transfer complete event
+   * @brief Acknowledge the DMA transfer complete event and time the reset latch
+   *
+   * The DMA completes once the last word is in the PIO FIFO, so the remaining
+   * words still have to shift out before the line can be held low for the
+   * latch period. A one shot alarm covers both.
    */
-  static void dma_complete_callback()
+  static void __not_in_flash_func( dma_complete_callback )()
   {
     dma_channel_acknowledge_irq0( s_dma_channel );
+    Trace::record( Trace::EVENT_DMA_DONE );
+
+    const uint32_t bit_rate_hz = s_profiles[ s_timing_profile ].bit_rate_hz;
+    const uint32_t words       = pio_sm_get_tx_fifo_level( PIO_INSTANCE, PIO_SM ) + 1;    // FIFO plus the OSR
+    const uint32_t drain_us    = ( words * WS2812_BITS_PER_LED * 1'000'000u + bit_rate_hz - 1 ) / bit_rate_hz;
+
+    if( add_alarm_in_us( drain_us + WS2812B_2020_LIMITS.reset_min_us, latch_complete_callback, nullptr, true ) < 0 )
+    {
+      /*-----------------------------------------------------------------------
+      No alarm available. Fall back to the worst case wait right here.
+      -----------------------------------------------------------------------*/
+      busy_wait_us( fifoDrainTimeUs( bit_rate_hz ) + WS2812B_2020_LIMITS.reset_min_us );
+      latch_complete_callback( 0, nullptr );
+    }
+  }
+
+
+  /**
+   * @brief Runs once the reset latch gap after a frame has elapsed
+   *
+   * Starts the next frame immediately if one was queued, which is what lets
+   * frames go out back to back at the highest rate the wire supports.
+   *
+   * @param id          Alarm that fired
+   * @param user_data   Unused
+   * @return int64_t    Always zero, the alarm is one shot
+   */
+  static int64_t __not_in_flash_func( latch_complete_callback )( alarm_id_t id, void *user_data )
+  {
+    ( void )id;
+    ( void )user_data;
+
+    Telemetry::recordPresent( time_us_32() );
+    Trace::record( Trace::EVENT_LATCH );
+
+    if( s_frame_queued )
+    {
+      s_frame_queued = false;
+      start_transfer();
+    }
+    else
+    {
+      s_wire_idle = true;
+    }
+
+    __sev();    // Wake the frame loop if it's waiting on the wire
+    return 0;
+  }
+
+
+  /**
+   * @brief Kicks off the DMA transfer of the display buffer to the PIO
+   *
+   * Must be called with interrupts disabled or from the latch alarm.
+   */
+  static void __not_in_flash_func( start_transfer )()
+  {
+    s_wire_idle = false;
+    Trace::record( Trace::EVENT_DMA_START );
+    dma_channel_set_trans_count( s_dma_channel, WS2812_NUM_LEDS, false );
+    dma_channel_set_read_addr( s_dma_channel, sp_display_buffer, true );
   }
 }    // namespace LED
@@ -4,7 +4,8 @@
  *
  *  Description:
  *    Driver for interacting with the raw WS2812 LED strip on the board. This
- *    provides an interface for interacting with the frame buffers.
+ *    provides an interface for interacting with the frame buffers. A build
+ *    with HOLLY_JOLLY_LED_APA102 implements it for clocked LEDs instead.
  *
  *  2024 | Brandon Braun | brandonbraun653@protonmail.com
  *****************************************************************************/
@@ -16,6 +17,8 @@
 /*-----------------------------------------------------------------------------
 Includes
 -----------------------------------------------------------------------------*/
+#include "dirty_region.hpp"
+#include "holly_jolly_cfg.hpp"
 #include <cstdint>
 
 namespace LED
@@ -24,11 +27,57 @@ namespace LED
   Constants
   ---------------------------------------------------------------------------*/
 
-  static constexpr uint32_t WS2812_NUM_LEDS  = 32;            // Number of LEDs in the string
-  static constexpr uint32_t WS2812_BLUE_MSK  = 0x00FF0000;    // Bitmask for the blue channel
-  static constexpr uint32_t WS2812_RED_MSK   = 0x0000FF00;    // Bitmask for the red channel
-  static constexpr uint32_t WS2812_GREEN_MSK = 0x000000FF;    // Bitmask for the green channel
-  static constexpr uint32_t WS2812_DATA_MSK  = 0x00FFFFFF;    // Bitmask for all color data
+  static constexpr uint32_t WS2812_NUM_LEDS  = HOLLY_JOLLY_LED_COUNT;    // Number of LEDs in the string
+  static constexpr uint32_t WS2812_BLUE_MSK  = 0x00FF0000;               // Bitmask for the blue channel
+  static constexpr uint32_t WS2812_RED_MSK   = 0x0000FF00;               // Bitmask for the red channel
+  static constexpr uint32_t WS2812_GREEN_MSK = 0x000000FF;               // Bitmask for the green channel
+  static constexpr uint32_t WS2812_DATA_MSK  = 0x00FFFFFF;               // Bitmask for all color data
+
+  /**
+   * @brief The LEDs scale their own brightness, see setGlobalBrightness()
+   */
+  static constexpr bool HARDWARE_BRIGHTNESS = LED_APA102;
+
+  /*---------------------------------------------------------------------------
+  Enumerations
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Wire timing profiles for the LED data line
+   *
+   * Faster profiles shorten the time to push a frame out, which matters for
+   * long strings. Each profile is checked against the chipset datasheet with
+   * the PIO cycle model before it is used, see ws2812_timing.hpp.
+   */
+  enum TimingProfile : uint8_t
+  {
+    TIMING_800KHZ,     // Standard WS2812 rate, valid at any expected system clock
+    TIMING_1MHZ,       // 25% faster
+    TIMING_1200KHZ,    // 50% faster, only meets the datasheet at some system clocks
+
+    TIMING_PROFILE_COUNT
+  };
+
+  /**
+   * @brief How the frame loop paces new frames
+   */
+  enum OutputMode : uint8_t
+  {
+    OUTPUT_PACED,       // One frame every FRAME_REFRESH_RATE_MS
+    OUTPUT_MAX_RATE,    // A new frame as soon as the wire can take it, for POV and high speed effects
+  };
+
+  /**
+   * @brief Profile selected at boot, see HOLLY_JOLLY_WS2812_TIMING
+   */
+  static constexpr TimingProfile WS2812_DEFAULT_TIMING = static_cast<TimingProfile>( HOLLY_JOLLY_WS2812_TIMING );
+
+  /**
+   * @brief Output mode selected at boot, see HOLLY_JOLLY_OUTPUT_MAX_RATE
+   */
+  static constexpr OutputMode WS2812_DEFAULT_OUTPUT_MODE = HOLLY_JOLLY_OUTPUT_MAX_RATE ? OUTPUT_MAX_RATE : OUTPUT_PACED;
+
+  static_assert( WS2812_DEFAULT_TIMING < TIMING_PROFILE_COUNT, "HOLLY_JOLLY_WS2812_TIMING is not a profile" );
 
   /*---------------------------------------------------------------------------
   Public Functions
@@ -41,6 +90,40 @@ namespace LED
    */
   void initialize();
 
+  /**
+   * @brief Switches the data line to a different timing profile
+   *
+   * The profile is run through the PIO cycle model at the current system
+   * clock and rejected if any pulse would fall outside the datasheet limits.
+   * Clocked LEDs run at a fixed data clock and only accept the default.
+   *
+   * @param profile   Profile to switch to
+   * @return bool     True if the profile was validated and applied
+   */
+  bool setTimingProfile( const TimingProfile profile );
+
+  /**
+   * @brief Gets the timing profile currently driving the data line
+   * @return TimingProfile
+   */
+  TimingProfile getTimingProfile();
+
+  /**
+   * @brief Time on the wire for one full frame, including the reset latch
+   * @return uint32_t   Microseconds
+   */
+  uint32_t frameTimeUs();
+
+  /**
+   * @brief Sets the brightness the LEDs apply to every color themselves
+   *
+   * Takes effect from the next swap. Only available when HARDWARE_BRIGHTNESS
+   * is set, otherwise brightness is scaled into the colors by post-processing.
+   *
+   * @param scale   Brightness from 0 to 256, where 256 is full
+   */
+  void setGlobalBrightness( const uint32_t scale );
+
   /**
    * @brief Total number of LEDs in the string
    * @return uint
@@ -51,17 +134,55 @@ namespace LED
   }
 
   /**
-   * @brief Get a pointer to the current render buffer
+   * @brief Get a pointer to the render canvas
    *
    * This buffer is sized to hold a single 32-bit color value for each LED in the string.
    * The total number of LEDs can be queried with the count() function.
    *
    * The data format for proper display is 0x00BBRRGG.
    *
+   * The canvas is never swapped out, so whatever was drawn last frame is still
+   * there. Only redraw what changes, and report it with markDirty() so that
+   * post-processing can skip everything else.
+   *
    * @return uint32_t*
    */
   uint32_t *getRenderBuffer();
 
+  /**
+   * @brief Marks a range of LEDs on the render canvas as changed this frame
+   *
+   * @param first   First LED that changed
+   * @param count   Number of LEDs that changed, clamped to the string length
+   */
+  void markDirty( const uint32_t first, const uint32_t count = 1 );
+
+  /**
+   * @brief Marks the whole render canvas as changed this frame
+   */
+  void markAllDirty();
+
+  /**
+   * @brief Gets the LEDs of the back buffer that no longer match the canvas
+   *
+   * The back buffer was last written two frames ago, so this covers what was
+   * marked dirty this frame and the frame before it. Everything outside of
+   * these spans is already correct and can be left alone.
+   *
+   * @return DirtyRegion
+   */
+  DirtyRegion getDamage();
+
+  /**
+   * @brief Get a pointer to the buffer that will be displayed on the next swap
+   *
+   * Post-processed output of the render canvas goes here. Its contents are
+   * the frame from two swaps ago, see getDamage().
+   *
+   * @return uint32_t*
+   */
+  uint32_t *getBackBuffer();
+
   /**
    * @brief Get a read-only pointer to the current display buffer
    *
@@ -71,14 +192,40 @@ namespace LED
   const uint32_t *getDisplayBuffer();
 
   /**
-   * @brief Swap the render buffer with the display buffer.
+   * @brief Swap the back buffer with the display buffer.
    *
-   * This will cause the new display buffer to be rendered to the LEDs.
+   * This will cause the new display buffer to be rendered to the LEDs. The
+   * transfer starts immediately if the reset latch from the previous frame
+   * has elapsed, otherwise it is started by the latch timer the moment it
+   * does. Only blocks while the previous frame is still being read by DMA.
    */
   void swapBuffers();
 
   /**
-   * @brief Resets both the render and display buffers to all zeros.
+   * @brief Checks if a new frame can be swapped in without replacing one
+   * that is still waiting for the wire
+   *
+   * @return bool
+   */
+  bool readyForFrame();
+
+  /**
+   * @brief Selects how the frame loop paces new frames
+   *
+   * @param mode  Output mode to use
+   */
+  void setOutputMode( const OutputMode mode );
+
+  /**
+   * @brief Gets the current output mode
+   * @return OutputMode
+   */
+  OutputMode getOutputMode();
+
+  /**
+   * @brief Resets the render canvas and both display buffers to all zeros.
+   *
+   * Everything is marked dirty, so the next frame rebuilds the whole string.
    */
   void resetBuffers();
 
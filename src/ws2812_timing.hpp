@@ -0,0 +1,432 @@
+/******************************************************************************
+ *  File Name:
+ *    ws2812_timing.hpp
+ *
+ *  Description:
+ *    Cycle model of the ws2812 PIO program and its DMA feed. Everything here
+ *    is constexpr and free of SDK dependencies, so timing profiles can be
+ *    checked against the LED datasheet at compile time, at boot against the
+ *    real system clock, or on a host machine.
+ *
+ *  2024 | Brandon Braun | brandonbraun653@protonmail.com
+ *****************************************************************************/
+
+#pragma once
+#ifndef HOLLY_JOLLY_WS2812_TIMING_HPP
+#define HOLLY_JOLLY_WS2812_TIMING_HPP
+
+/*-----------------------------------------------------------------------------
+Includes
+-----------------------------------------------------------------------------*/
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace LED
+{
+  /*---------------------------------------------------------------------------
+  Constants
+  ---------------------------------------------------------------------------*/
+
+  static constexpr size_t   WS2812_PROGRAM_LENGTH = 4;     // Instructions in the ws2812 PIO program
+  static constexpr uint32_t WS2812_BITS_PER_LED   = 24;    // GRB, 8 bits each
+  static constexpr uint32_t PIO_TX_FIFO_DEPTH     = 8;     // Joined TX FIFO depth in words
+  static constexpr uint32_t DMA_WORST_CASE_CYCLES = 64;    // Pessimistic sys clocks for DMA to land one word in the FIFO
+
+  /*---------------------------------------------------------------------------
+  Aliases
+  ---------------------------------------------------------------------------*/
+
+  using PioProgram = std::array<uint16_t, WS2812_PROGRAM_LENGTH>;
+
+  /*---------------------------------------------------------------------------
+  Structures
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Allowed pulse widths for a chipset, in nanoseconds
+   */
+  struct ChipsetLimits
+  {
+    uint32_t t0h_min, t0h_max;    // High time of a 0 bit
+    uint32_t t0l_min, t0l_max;    // Low time of a 0 bit
+    uint32_t t1h_min, t1h_max;    // High time of a 1 bit
+    uint32_t t1l_min, t1l_max;    // Low time of a 1 bit
+    uint32_t reset_min_us;        // Low time that latches the data into the LEDs
+  };
+
+  /**
+   * @brief Length of the high and low phase of one bit on the wire, in PIO cycles
+   */
+  struct BitCycles
+  {
+    uint32_t high;
+    uint32_t low;
+  };
+
+  /**
+   * @brief Result of running the PIO program through the emulator
+   */
+  struct ProgramTiming
+  {
+    bool      valid;    // Program only used supported instructions and was deterministic
+    BitCycles zero;     // Waveform of a 0 bit
+    BitCycles one;      // Waveform of a 1 bit
+  };
+
+  /**
+   * @brief Worst case pulse widths once PIO cycles are mapped onto real time
+   */
+  struct PulseRange
+  {
+    uint32_t min_ns;
+    uint32_t max_ns;
+  };
+
+  /*---------------------------------------------------------------------------
+  Datasheet Limits
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief WS2812B-2020 as fitted to the board (D1-D32)
+   */
+  static constexpr ChipsetLimits WS2812B_2020_LIMITS = {
+    220, 380,     /* T0H */
+    580, 1600,    /* T0L */
+    580, 1600,    /* T1H */
+    220, 420,     /* T1L */
+    280           /* RES */
+  };
+
+  /*---------------------------------------------------------------------------
+  PIO Assembly
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Assembles the ws2812 program exactly as pioasm does for ws2812.pio
+   *
+   * Having the encoding here lets the firmware check at boot that the program
+   * being emulated is the program that was loaded.
+   *
+   * @param t1  Cycles the line is high for every bit
+   * @param t2  Additional cycles high for a 1 bit, or low for a 0 bit
+   * @param t3  Cycles the line is low before every bit
+   * @return PioProgram
+   */
+  static constexpr PioProgram assembleWS2812Program( const uint32_t t1, const uint32_t t2, const uint32_t t3 )
+  {
+    /*-------------------------------------------------------------------------
+    Delay/side-set field is bits 12:8. With ".side_set 1" the side-set value
+    takes bit 12 and the delay takes bits 11:8.
+    -------------------------------------------------------------------------*/
+    auto ds = []( const uint32_t side, const uint32_t cycles ) -> uint16_t {
+      return static_cast<uint16_t>( ( side << 12 ) | ( ( cycles - 1 ) << 8 ) );
+    };
+
+    return { {
+        static_cast<uint16_t>( 0x6021 | ds( 1, t3 ) ),    // out x, 1        side 1 [T3 - 1]
+        static_cast<uint16_t>( 0x0023 | ds( 0, t1 ) ),    // jmp !x do_zero  side 0 [T1 - 1]
+        static_cast<uint16_t>( 0x0000 | ds( 0, t2 ) ),    // jmp bitloop     side 0 [T2 - 1]
+        static_cast<uint16_t>( 0xA042 | ds( 1, t2 ) ),    // nop             side 1 [T2 - 1]
+    } };
+  }
+
+  /*---------------------------------------------------------------------------
+  PIO Emulation
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Runs a ws2812 style PIO program cycle by cycle and measures the wire
+   *
+   * Supports the subset of the instruction set the LED programs use: OUT to X,
+   * JMP (always, !X, X--), and MOV Y, Y as a nop, with one non-optional side-set
+   * pin and OSR shifting out MSB first with autopull. The output is inverted to
+   * match the MOSFET level shifter on the board.
+   *
+   * A fixed bit pattern is clocked through, assuming the DMA always keeps the
+   * FIFO fed. Every 0 and every 1 must produce identical waveforms for the
+   * result to be valid.
+   *
+   * @param program       Machine code
+   * @param wrap_target   Address execution wraps to
+   * @param wrap          Address execution wraps from
+   * @return ProgramTiming
+   */
+  static constexpr ProgramTiming emulateWS2812Program( const PioProgram &program, const uint32_t wrap_target,
+                                                       const uint32_t wrap )
+  {
+    constexpr uint8_t  pattern[]    = { 0, 1, 1, 0, 0, 1, 0, 1, 0 };    // Last bit only terminates the one before it
+    constexpr uint32_t pattern_len  = sizeof( pattern );
+    constexpr uint32_t max_pulses   = pattern_len + 1;
+    constexpr uint32_t cycle_budget = 1024;
+
+    ProgramTiming result = {};
+
+    uint32_t high_runs[ max_pulses ] = {};
+    uint32_t low_runs[ max_pulses ]  = {};
+    uint32_t num_high                = 0;
+    uint32_t num_low                 = 0;
+
+    uint32_t pc        = wrap_target;
+    uint32_t x         = 0;
+    uint32_t next_bit  = 0;
+    bool     level     = false;
+    uint32_t run       = 0;
+    bool     first_run = true;
+
+    for( uint32_t cycle = 0; cycle < cycle_budget; )
+    {
+      if( pc >= program.size() )
+      {
+        return result;
+      }
+
+      const uint16_t instr   = program[ pc ];
+      const uint32_t opcode  = instr >> 13;
+      const uint32_t side    = ( instr >> 12 ) & 0x1;
+      const uint32_t delay   = ( instr >> 8 ) & 0xF;
+      const bool     line    = ( side == 0 );    // Inverted by the MOSFET
+      uint32_t       next_pc = ( pc == wrap ) ? wrap_target : pc + 1;
+
+      /*-----------------------------------------------------------------------
+      Execute
+      -----------------------------------------------------------------------*/
+      if( opcode == 0 ) /* JMP */
+      {
+        const uint32_t cond = ( instr >> 5 ) & 0x7;
+        const uint32_t addr = instr & 0x1F;
+        bool           take = false;
+
+        if( cond == 0 )
+        {
+          take = true;
+        }
+        else if( cond == 1 )
+        {
+          take = ( x == 0 );
+        }
+        else if( cond == 2 )
+        {
+          take = ( x != 0 );
+          x--;
+        }
+        else
+        {
+          return result;
+        }
+
+        next_pc = take ? addr : next_pc;
+      }
+      else if( opcode == 3 ) /* OUT */
+      {
+        const uint32_t dest  = ( instr >> 5 ) & 0x7;
+        const uint32_t count = instr & 0x1F;
+        if( ( dest != 1 ) || ( count != 1 ) )
+        {
+          return result;
+        }
+
+        /*---------------------------------------------------------------------
+        Autopull would stall here with the side-set applied. That idle low is
+        the reset latch, so the pattern is complete.
+        ---------------------------------------------------------------------*/
+        if( next_bit >= pattern_len )
+        {
+          break;
+        }
+
+        x = pattern[ next_bit++ ];
+      }
+      else if( instr != ( ( instr & 0x1F00 ) | 0xA042 ) ) /* Only MOV Y, Y */
+      {
+        return result;
+      }
+
+      /*-----------------------------------------------------------------------
+      Drive the line for the instruction plus its delay cycles
+      -----------------------------------------------------------------------*/
+      const uint32_t cycles = 1 + delay;
+      if( ( line != level ) && !first_run )
+      {
+        if( level )
+        {
+          high_runs[ num_high++ ] = run;
+        }
+        else
+        {
+          low_runs[ num_low++ ] = run;
+        }
+
+        run = 0;
+      }
+
+      if( num_high >= max_pulses || num_low >= max_pulses )
+      {
+        return result;
+      }
+
+      first_run = false;
+      level     = line;
+      run += cycles;
+      cycle += cycles;
+      pc = next_pc;
+    }
+
+    /*-------------------------------------------------------------------------
+    Each bit is one high pulse and the low run after it. The first low run is
+    the lead in before bit 0 and the final bit has no trailing run, so there
+    should be exactly one low run per high pulse.
+    -------------------------------------------------------------------------*/
+    if( ( num_high != pattern_len ) || ( num_low != pattern_len ) )
+    {
+      return result;
+    }
+
+    bool seen[ 2 ] = { false, false };
+    for( uint32_t i = 0; ( i + 1 ) < pattern_len; i++ )
+    {
+      const BitCycles bit = { high_runs[ i ], low_runs[ i + 1 ] };
+      BitCycles      &ref = pattern[ i ] ? result.one : result.zero;
+
+      if( seen[ pattern[ i ] ] && ( ( ref.high != bit.high ) || ( ref.low != bit.low ) ) )
+      {
+        return result;
+      }
+
+      seen[ pattern[ i ] ] = true;
+      ref                  = bit;
+    }
+
+    result.valid = seen[ 0 ] && seen[ 1 ] && ( ( result.zero.high + result.zero.low ) == ( result.one.high + result.one.low ) );
+    return result;
+  }
+
+  /*---------------------------------------------------------------------------
+  Clock Mapping
+  ---------------------------------------------------------------------------*/
+
+  /**
+   * @brief Computes the PIO clock divider as 16.8 fixed point
+   *
+   * @param sys_hz          System clock frequency
+   * @param bit_rate_hz     Desired bit rate on the wire
+   * @param cycles_per_bit  PIO cycles per bit
+   * @return uint32_t       Divider, 256 == 1.0. Zero if out of range.
+   */
+  static constexpr uint32_t pioClockDivider( const uint32_t sys_hz, const uint32_t bit_rate_hz,
+                                             const uint32_t cycles_per_bit )
+  {
+    const uint64_t pio_hz = static_cast<uint64_t>( bit_rate_hz ) * cycles_per_bit;
+    if( pio_hz == 0 )
+    {
+      return 0;
+    }
+
+    const uint64_t div = ( ( static_cast<uint64_t>( sys_hz ) << 8 ) + ( pio_hz / 2 ) ) / pio_hz;
+    return ( ( div >= 256 ) && ( div < ( 65536ull << 8 ) ) ) ? static_cast<uint32_t>( div ) : 0;
+  }
+
+  /**
+   * @brief Bounds the real duration of a number of PIO cycles
+   *
+   * With a fractional divider the PIO clock enable dithers between floor(div)
+   * and ceil(div) system clocks, so n cycles last floor(n * div) or
+   * ceil(n * div) system clocks.
+   *
+   * @param cycles    PIO cycles
+   * @param div       Clock divider from pioClockDivider()
+   * @param sys_hz    System clock frequency
+   * @return PulseRange
+   */
+  static constexpr PulseRange pulseRange( const uint32_t cycles, const uint32_t div, const uint32_t sys_hz )
+  {
+    const uint64_t sys_x256 = static_cast<uint64_t>( cycles ) * div;
+    const uint64_t sys_min  = sys_x256 >> 8;
+    const uint64_t sys_max  = ( sys_x256 + 255 ) >> 8;
+
+    return { static_cast<uint32_t>( ( sys_min * 1'000'000'000ull ) / sys_hz ),
+             static_cast<uint32_t>( ( sys_max * 1'000'000'000ull + sys_hz - 1 ) / sys_hz ) };
+  }
+
+  /**
+   * @brief Checks a pulse range fits inside datasheet limits
+   */
+  static constexpr bool withinLimits( const PulseRange &range, const uint32_t min_ns, const uint32_t max_ns )
+  {
+    return ( range.min_ns >= min_ns ) && ( range.max_ns <= max_ns );
+  }
+
+  /**
+   * @brief Validates a PIO program at a bit rate and system clock against a chipset
+   *
+   * Besides the pulse widths, this checks that the DMA can refill the FIFO
+   * faster than the PIO drains it, so the line never stalls mid frame.
+   *
+   * @param timing        Emulated program timing
+   * @param bit_rate_hz   Bit rate on the wire
+   * @param sys_hz        System clock frequency
+   * @param limits        Chipset datasheet limits
+   * @return bool         True if every pulse is within limits
+   */
+  static constexpr bool validateTiming( const ProgramTiming &timing, const uint32_t bit_rate_hz, const uint32_t sys_hz,
+                                        const ChipsetLimits &limits )
+  {
+    if( !timing.valid )
+    {
+      return false;
+    }
+
+    const uint32_t cycles_per_bit = timing.zero.high + timing.zero.low;
+    const uint32_t div            = pioClockDivider( sys_hz, bit_rate_hz, cycles_per_bit );
+    if( div == 0 )
+    {
+      return false;
+    }
+
+    /*-------------------------------------------------------------------------
+    One FIFO word drains in 24 bits. The DMA has to beat that comfortably.
+    -------------------------------------------------------------------------*/
+    const uint64_t word_sys_cycles = ( static_cast<uint64_t>( WS2812_BITS_PER_LED ) * cycles_per_bit * div ) >> 8;
+    if( word_sys_cycles <= DMA_WORST_CASE_CYCLES )
+    {
+      return false;
+    }
+
+    return withinLimits( pulseRange( timing.zero.high, div, sys_hz ), limits.t0h_min, limits.t0h_max ) &&
+           withinLimits( pulseRange( timing.zero.low, div, sys_hz ), limits.t0l_min, limits.t0l_max ) &&
+           withinLimits( pulseRange( timing.one.high, div, sys_hz ), limits.t1h_min, limits.t1h_max ) &&
+           withinLimits( pulseRange( timing.one.low, div, sys_hz ), limits.t1l_min, limits.t1l_max );
+  }
+
+  /**
+   * @brief Time to shift a frame out of the FIFO once the DMA transfer completes
+   *
+   * The DMA finishes when the last word lands in the FIFO, not when it leaves
+   * the pin. Up to a full FIFO plus the OSR are still in flight at that point.
+   *
+   * @param bit_rate_hz   Bit rate on the wire
+   * @return uint32_t     Microseconds, rounded up
+   */
+  static constexpr uint32_t fifoDrainTimeUs( const uint32_t bit_rate_hz )
+  {
+    const uint64_t bits = static_cast<uint64_t>( PIO_TX_FIFO_DEPTH + 1 ) * WS2812_BITS_PER_LED;
+    return static_cast<uint32_t>( ( bits * 1'000'000ull + bit_rate_hz - 1 ) / bit_rate_hz );
+  }
+
+  /**
+   * @brief Total wire time for a frame, including the reset latch
+   *
+   * @param bit_rate_hz   Bit rate on the wire
+   * @param num_leds      Number of LEDs in the string
+   * @param limits        Chipset datasheet limits
+   * @return uint32_t     Microseconds, rounded up
+   */
+  static constexpr uint32_t frameTimeUs( const uint32_t bit_rate_hz, const uint32_t num_leds, const ChipsetLimits &limits )
+  {
+    const uint64_t bits = static_cast<uint64_t>( num_leds ) * WS2812_BITS_PER_LED;
+    return static_cast<uint32_t>( ( bits * 1'000'000ull + bit_rate_hz - 1 ) / bit_rate_hz ) + limits.reset_min_us;
+  }
+
+}    // namespace LED
+
+#endif /* !HOLLY_JOLLY_WS2812_TIMING_HPP */
@@ -0,0 +1,410 @@
+#!/usr/bin/env python3
+"""
+Memory footprint report for the HollyJolly firmware.
+
+Reads the linked ELF, the linker map and the per-function stack usage emitted
+by GCC (-fstack-usage, plus -fcallgraph-info=su when available) and reports:
+
+  * flash and RAM totals, and per-module .text/.data/.bss
+  * the largest symbols in the image
+  * worst-case static stack depth from each core's entry point
+
+Exits non-zero if any configured budget is exceeded, so it can gate the build.
+
+2024 | Brandon Braun | brandonbraun653@protonmail.com
+"""
+
+import argparse
+import os
+import re
+import shutil
+import struct
+import subprocess
+import sys
+from collections import defaultdict
+
+# ------------------------------------------------------------------------------
+# RP2040 memory map
+# ------------------------------------------------------------------------------
+FLASH_BASE = 0x10000000
+FLASH_END = 0x11000000
+RAM_BASE = 0x20000000
+RAM_END = 0x20042000
+
+# Registers the core pushes onto the interrupted stack on exception entry
+EXCEPTION_FRAME_BYTES = 32
+
+SHF_ALLOC = 0x2
+SHT_NOBITS = 8
+SHT_SYMTAB = 2
+STT_OBJECT = 1
+STT_FUNC = 2
+
+# Output sections of the SDK linker scripts, grouped by the column they count toward
+DATA_SECTIONS = {".data", ".scratch_x", ".scratch_y"}
+BSS_SECTIONS = {".bss", ".uninitialized_data", ".ram_vector_table", ".heap", ".stack_dummy", ".stack1_dummy"}
+SKIP_SECTIONS = {".comment", ".ARM.attributes", "/DISCARD/"}
+
+
+# ------------------------------------------------------------------------------
+# ELF parsing
+# ------------------------------------------------------------------------------
+class Elf:
+    """Just enough of a 32-bit little endian ELF reader for sections and symbols"""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+
+        if self.data[:4] != b"\x7fELF" or self.data[4] != 1 or self.data[5] != 1:
+            raise ValueError(f"{path} is not a 32-bit little endian ELF")
+
+        shoff, = struct.unpack_from("<I", self.data, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from("<HHH", self.data, 0x2E)
+
+        raw = [struct.unpack_from("<IIIIIIIIII", self.data, shoff + i * shentsize) for i in range(shnum)]
+        names = raw[shstrndx]
+
+        self.sections = []
+        for name, sh_type, flags, addr, offset, size, link, _, _, entsize in raw:
+            self.sections.append({
+                "name": self._string(names[4], name),
+                "type": sh_type,
+                "flags": flags,
+                "addr": addr,
+                "offset": offset,
+                "size": size,
+                "link": link,
+                "entsize": entsize,
+            })
+
+    def _string(self, table_offset, idx):
+        start = table_offset + idx
+        return self.data[start:self.data.index(b"\0", start)].decode("utf-8", "replace")
+
+    def symbols(self):
+        """Yields (name, address, size, type) for every sized object and function"""
+        for sec in self.sections:
+            if sec["type"] != SHT_SYMTAB:
+                continue
+
+            strtab = self.sections[sec["link"]]["offset"]
+            for i in range(sec["size"] // sec["entsize"]):
+                name, value, size, info, _, _ = struct.unpack_from("<IIIBBH", self.data, sec["offset"] + i * sec["entsize"])
+                sym_type = info & 0xF
+                if size and sym_type in (STT_OBJECT, STT_FUNC):
+                    yield self._string(strtab, name), value & ~1, size, sym_type
+
+
+def demangle(names):
+    """Demangles C++ names in one c++filt call, if one is installed"""
+    tool = shutil.which("arm-none-eabi-c++filt") or shutil.which("c++filt")
+    if not tool or not names:
+        return {n: n for n in names}
+
+    out = subprocess.run([tool], input="\n".join(names), capture_output=True, text=True).stdout.splitlines()
+    return dict(zip(names, out)) if len(out) == len(names) else {n: n for n in names}
+
+
+# ------------------------------------------------------------------------------
+# Linker map parsing
+# ------------------------------------------------------------------------------
+INPUT_SECTION = re.compile(r"^ (\S+)?\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+OUTPUT_SECTION = re.compile(r"^(\.\S+|/DISCARD/)")
+
+
+def module_name(obj):
+    """Reduces an object path like .../animator.cpp.obj or libfoo.a(bar.o) to a module name"""
+    member = re.search(r"\(([^)]+)\)$", obj)
+    name = os.path.basename(member.group(1) if member else obj)
+    return re.sub(r"\.(obj|o)$", "", name)
+
+
+def parse_map(path):
+    """Returns {module: {"text": n, "data": n, "bss": n}} from a GNU ld map file"""
+    modules = defaultdict(lambda: {"text": 0, "data": 0, "bss": 0})
+    in_memory_map = False
+    output = None
+    pending = None
+
+    with open(path, "r", errors="replace") as f:
+        for line in f:
+            line = line.rstrip("\n")
+            if line.startswith("Linker script and memory map"):
+                in_memory_map = True
+                continue
+            if not in_memory_map:
+                continue
+
+            match = OUTPUT_SECTION.match(line)
+            if match:
+                output = match.group(1)
+                continue
+
+            if output is None or output in SKIP_SECTIONS or output.startswith(".debug"):
+                continue
+
+            # Long input section names push the address onto the next line
+            if re.match(r"^ \S+$", line):
+                pending = line.strip()
+                continue
+
+            match = INPUT_SECTION.match(line)
+            if not match or (match.group(1) is None and pending is None):
+                pending = None
+                continue
+
+            pending = None
+            size = int(match.group(3), 16)
+            obj = match.group(4).strip()
+            if size == 0 or obj.startswith("*fill*") or "load address" in obj:
+                continue
+
+            if output in DATA_SECTIONS:
+                column = "data"
+            elif output in BSS_SECTIONS:
+                column = "bss"
+            else:
+                column = "text"
+            modules[module_name(obj)][column] += size
+
+    return modules
+
+
+# ------------------------------------------------------------------------------
+# Stack analysis
+# ------------------------------------------------------------------------------
+SU_LINE = re.compile(r"^(?P<loc>[^:]+:\d+:\d+):(?P<name>.*)\t(?P<bytes>\d+)\t(?P<kind>\S+)$")
+CI_NODE = re.compile(r'node:\s*\{\s*title:\s*"(?P<title>[^"]+)"\s*label:\s*"(?P<label>[^"]*)"')
+CI_EDGE = re.compile(r'edge:\s*\{\s*sourcename:\s*"(?P<src>[^"]+)"\s*targetname:\s*"(?P<dst>[^"]+)"')
+CI_BYTES = re.compile(r"\\n(\d+) bytes \((\w+)")
+
+
+class CallGraph:
+    def __init__(self):
+        self.frames = {}                  # title -> bytes
+        self.dynamic = set()              # titles with variable sized frames
+        self.labels = {}                  # title -> function signature
+        self.edges = defaultdict(set)     # title -> callee titles
+
+    def load_su(self, path):
+        with open(path, "r", errors="replace") as f:
+            for line in f:
+                match = SU_LINE.match(line.rstrip("\n"))
+                if not match:
+                    continue
+                name = match.group("name")
+                self.labels.setdefault(name, name)
+                self.frames[name] = max(self.frames.get(name, 0), int(match.group("bytes")))
+                if match.group("kind") != "static":
+                    self.dynamic.add(name)
+
+    def load_ci(self, path):
+        with open(path, "r", errors="replace") as f:
+            text = f.read()
+
+        for match in CI_NODE.finditer(text):
+            title = match.group("title")
+            label = match.group("label")
+            self.labels[title] = label.split("\\n")[0]
+            stack = CI_BYTES.search(label)
+            if stack:
+                self.frames[title] = int(stack.group(1))
+                if stack.group(2) != "static":
+                    self.dynamic.add(title)
+
+        for match in CI_EDGE.finditer(text):
+            self.edges[match.group("src")].add(match.group("dst"))
+
+    def find(self, spec):
+        """Finds functions by mangled name, or by name within the signature"""
+        if spec in self.labels:
+            return [spec]
+
+        pattern = re.compile(r"(^|[\s:*&])" + re.escape(spec) + r"\(")
+        return [t for t, label in self.labels.items() if pattern.search(label)]
+
+    def worst_path(self, root):
+        """
+        Returns (depth, path, caveats) for the deepest static call chain from root.
+        Recursion, indirect calls and functions without stack info can't be
+        bounded statically, so they're listed as caveats.
+        """
+        memo = {}
+        caveats = set()
+
+        def visit(node, stack):
+            if node in memo:
+                return memo[node]
+            if node in stack:
+                caveats.add(f"recursion through {self.labels.get(node, node)}")
+                return 0, []
+            if node == "__indirect_call":
+                caveats.add("indirect calls")
+                return 0, []
+            if node not in self.frames:
+                caveats.add(f"no stack info for {self.labels.get(node, node)}")
+            if node in self.dynamic:
+                caveats.add(f"dynamic frame in {self.labels.get(node, node)}")
+
+            stack.add(node)
+            best_depth, best_path = 0, []
+            for callee in self.edges.get(node, ()):
+                depth, path = visit(callee, stack)
+                if depth > best_depth:
+                    best_depth, best_path = depth, path
+            stack.discard(node)
+
+            memo[node] = (self.frames.get(node, 0) + best_depth, [node] + best_path)
+            return memo[node]
+
+        depth, path = visit(root, set())
+        return depth, path, sorted(caveats)
+
+
+# ------------------------------------------------------------------------------
+# Report
+# ------------------------------------------------------------------------------
+def parse_budget(items):
+    budgets = {}
+    for item in items or []:
+        key, _, value = item.partition("=")
+        budgets[key] = int(value, 0)
+    return budgets
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--elf", required=True, help="Linked firmware image")
+    parser.add_argument("--map", help="Linker map file, for the per-module breakdown")
+    parser.add_argument("--objects", help="Directory searched for .su and .ci files")
+    parser.add_argument("--entry", action="append", default=[], metavar="NAME=FUNC",
+                        help="Core entry point to measure stack depth from, e.g. core0=main")
+    parser.add_argument("--isr-prefix", default="irqh_",
+                        help="Name prefix of interrupt handlers, whose depth adds to core0")
+    parser.add_argument("--isr", action="append", default=[], metavar="FUNC",
+                        help="Other function that runs in interrupt context, e.g. an alarm or DMA callback")
+    parser.add_argument("--flash-budget", type=lambda v: int(v, 0), help="Max flash image size in bytes")
+    parser.add_argument("--ram-budget", type=lambda v: int(v, 0), help="Max static RAM use in bytes")
+    parser.add_argument("--stack-budget", action="append", metavar="NAME=BYTES",
+                        help="Max worst-case stack depth for an entry point")
+    parser.add_argument("--top", type=int, default=15, help="Number of largest symbols to list")
+    args = parser.parse_args()
+
+    errors = []
+
+    # --------------------------------------------------------------------------
+    # Totals from the section headers
+    # --------------------------------------------------------------------------
+    elf = Elf(args.elf)
+    flash = 0
+    ram = 0
+    for sec in elf.sections:
+        if not sec["flags"] & SHF_ALLOC or sec["size"] == 0:
+            continue
+        if sec["type"] != SHT_NOBITS:
+            flash += sec["size"]    # Everything with contents is loaded from flash, including .data
+        if RAM_BASE <= sec["addr"] < RAM_END:
+            ram += sec["size"]
+
+    print("Memory")
+    print(f"  flash  {flash:8d} bytes" + (f"  / {args.flash_budget} budget" if args.flash_budget else ""))
+    print(f"  ram    {ram:8d} bytes" + (f"  / {args.ram_budget} budget" if args.ram_budget else ""))
+    if args.flash_budget and flash > args.flash_budget:
+        errors.append(f"flash use of {flash} bytes exceeds the budget of {args.flash_budget}")
+    if args.ram_budget and ram > args.ram_budget:
+        errors.append(f"RAM use of {ram} bytes exceeds the budget of {args.ram_budget}")
+
+    # --------------------------------------------------------------------------
+    # Per-module breakdown
+    # --------------------------------------------------------------------------
+    if args.map and os.path.exists(args.map):
+        modules = parse_map(args.map)
+        print("\nModules                                       text     data      bss")
+        for name, cols in sorted(modules.items(), key=lambda kv: -sum(kv[1].values())):
+            print(f"  {name:40s} {cols['text']:8d} {cols['data']:8d} {cols['bss']:8d}")
+
+    # --------------------------------------------------------------------------
+    # Largest symbols
+    # --------------------------------------------------------------------------
+    symbols = sorted(elf.symbols(), key=lambda s: -s[2])[:args.top]
+    names = demangle([s[0] for s in symbols])
+    print(f"\nLargest symbols")
+    for name, addr, size, sym_type in symbols:
+        region = "ram" if RAM_BASE <= addr < RAM_END else "flash"
+        kind = "func" if sym_type == STT_FUNC else "data"
+        print(f"  {size:8d}  {region:5s} {kind}  {names[name]}")
+
+    # --------------------------------------------------------------------------
+    # Worst-case static stack depth
+    # --------------------------------------------------------------------------
+    if args.objects:
+        graph = CallGraph()
+        have_ci = False
+        for root, _, files in os.walk(args.objects):
+            for file in files:
+                if file.endswith(".su"):
+                    graph.load_su(os.path.join(root, file))
+                elif file.endswith(".ci"):
+                    graph.load_ci(os.path.join(root, file))
+                    have_ci = True
+
+        stack_budgets = parse_budget(args.stack_budget)
+
+        print("\nStack")
+        if not have_ci:
+            print("  No call graph found (needs -fcallgraph-info=su). Depths are the entry frame only.")
+
+        # Handlers found by prefix, plus the callbacks the SDK calls from its own handlers
+        isr_titles = set()
+        for title, label in graph.labels.items():
+            fn = re.search(r"([\w:~]+)\(", label)
+            if fn and fn.group(1).split("::")[-1].startswith(args.isr_prefix):
+                isr_titles.add(title)
+        for spec in args.isr:
+            found = graph.find(spec)
+            if not found:
+                print(f"  interrupt handler {spec} not found")
+            isr_titles.update(found)
+
+        # Priorities are all left at the default, so handlers never nest and the deepest one is the cost
+        isr_depth = 0
+        isr_name = None
+        for title in isr_titles:
+            depth, _, _ = graph.worst_path(title)
+            depth += EXCEPTION_FRAME_BYTES
+            if depth > isr_depth:
+                isr_depth, isr_name = depth, graph.labels.get(title, title)
+
+        if isr_name:
+            print(f"  interrupts  {isr_depth:6d} bytes  deepest: {isr_name}")
+
+        for entry in args.entry:
+            core, _, spec = entry.partition("=")
+            found = graph.find(spec)
+            if not found:
+                print(f"  {core:10s}  entry point {spec} not found")
+                continue
+
+            depth, path, caveats = graph.worst_path(found[0])
+            if core == "core0":
+                depth += isr_depth    # Interrupts all run on core0 and stack on top of whatever it was doing
+
+            budget = stack_budgets.get(core)
+            print(f"  {core:10s}  {depth:6d} bytes" + (f"  / {budget} budget" if budget else ""))
+            for node in path:
+                print(f"      {graph.frames.get(node, 0):6d}  {graph.labels.get(node, node)}")
+            for caveat in caveats:
+                print(f"      warning: {caveat}")
+
+            if budget and depth > budget:
+                errors.append(f"{core} stack depth of {depth} bytes exceeds the budget of {budget}")
+
+    for error in errors:
+        print(f"error: {error}", file=sys.stderr)
+
+    return 1 if errors else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
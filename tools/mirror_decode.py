@@ -0,0 +1,240 @@
+#!/usr/bin/env python3
+"""
+Decodes the HollyJolly USB mirror stream and shows the frames it carries.
+
+Build the firmware with -DHOLLY_JOLLY_USB_MIRROR=ON and point this at the
+board's CDC port, or at a file written by the host simulator with --mirror:
+
+  tools/mirror_decode.py --input /dev/ttyACM0
+  tools/mirror_decode.py --input mirror.bin --ppm frames/
+
+Frames are drawn as a row of colored blocks in a truecolor terminal, or
+written as one PPM image per frame. A summary of frame rate, bandwidth,
+frames missed and the board's encode cost is printed at the end, or on
+Ctrl-C when reading a live port.
+
+2024 | Brandon Braun | brandonbraun653@protonmail.com
+"""
+
+import argparse
+import os
+import struct
+import sys
+import time
+
+# ------------------------------------------------------------------------------
+# Stream format, must match src/mirror.hpp
+# ------------------------------------------------------------------------------
+MIRROR_MAGIC = 0x4D48
+FLAG_KEY = 1 << 0
+TOKEN_DATA = 0x80
+RUN_MAX = 128
+
+HEADER = struct.Struct("<HHBBHHH")    # magic, sequence, flags, reserved, leds, length, encode_cycles
+MAGIC_BYTES = struct.pack("<H", MIRROR_MAGIC)
+
+MAX_LEDS = 4096
+READ_SIZE = 4096
+
+
+class Stats:
+    def __init__(self):
+        self.frames = 0
+        self.key_frames = 0
+        self.dropped = 0    # Sequence gaps, dropped by the board or lost in transit
+        self.skipped_bytes = 0
+        self.bytes = 0
+        self.encode_cycles = []
+        self.last_sequence = None
+        self.start = time.monotonic()
+
+    def record(self, header, size):
+        _, sequence, flags, _, _, _, cycles = header
+        if self.last_sequence is not None:
+            self.dropped += (sequence - self.last_sequence - 1) & 0xFFFF
+
+        self.last_sequence = sequence
+        self.frames += 1
+        self.key_frames += bool(flags & FLAG_KEY)
+        self.bytes += size
+        self.encode_cycles.append(cycles)
+
+    def summary(self, live):
+        lines = [
+            f"frames            {self.frames} ({self.key_frames} key)",
+            f"frames missed     {self.dropped}",
+            f"bytes             {self.bytes} ({self.bytes / max(self.frames, 1):.1f} per frame)",
+        ]
+
+        if live:
+            elapsed = max(time.monotonic() - self.start, 1e-6)
+            lines.append(f"fps               {self.frames / elapsed:.1f}")
+            lines.append(f"bytes/s           {self.bytes / elapsed:.0f}")
+
+        if self.encode_cycles:
+            mean = sum(self.encode_cycles) / len(self.encode_cycles)
+            lines.append(f"encode cycles     mean {mean:.0f}, max {max(self.encode_cycles)}")
+
+        if self.skipped_bytes:
+            lines.append(f"resync skipped    {self.skipped_bytes} bytes")
+
+        return lines
+
+
+def open_input(path):
+    """Opens the stream, putting a serial port into raw mode so bytes arrive untouched"""
+    f = open(path, "rb", buffering=0)
+    live = os.isatty(f.fileno())
+    if live:
+        import tty
+        tty.setraw(f.fileno())
+
+    return f, live
+
+
+def decode_payload(payload, frame):
+    """Applies a payload to the frame in place. Returns False if it doesn't fit the frame."""
+    i = 0
+    led = 0
+    while i < len(payload):
+        token = payload[i]
+        i += 1
+        count = (token & (TOKEN_DATA - 1)) + 1
+        if led + count > len(frame):
+            return False
+
+        if not token & TOKEN_DATA:
+            led += count
+            continue
+
+        if i + 3 * count > len(payload):
+            return False
+
+        for _ in range(count):
+            frame[led] ^= (payload[i] << 16) | (payload[i + 1] << 8) | payload[i + 2]
+            i += 3
+            led += 1
+
+    return True
+
+
+def frames(stream, stats):
+    """
+    Yields every frame in the stream, resyncing on the magic if bytes go missing.
+    Frames the board dropped never left it, so the frames after them still
+    decode. Bytes lost on the way mean a frame is missing from the chain, so
+    nothing more is shown until the next key frame.
+    """
+    buf = bytearray()
+    frame = None
+
+    while True:
+        chunk = stream.read(READ_SIZE)
+        if not chunk:
+            return
+
+        buf += chunk
+        while True:
+            start = buf.find(MAGIC_BYTES)
+            if start < 0:
+                keep = 1 if buf.endswith(MAGIC_BYTES[:1]) else 0
+                if len(buf) > keep:
+                    stats.skipped_bytes += len(buf) - keep
+                    frame = None
+                    del buf[:len(buf) - keep]
+                break
+
+            if start:
+                stats.skipped_bytes += start
+                frame = None
+                del buf[:start]
+            if len(buf) < HEADER.size:
+                break
+
+            header = HEADER.unpack_from(buf)
+            _, _, flags, reserved, leds, length, _ = header
+            if reserved != 0 or not 0 < leds <= MAX_LEDS or length > 3 * leds + (leds + RUN_MAX - 1) // RUN_MAX:
+                stats.skipped_bytes += 1
+                frame = None
+                del buf[:1]
+                continue
+
+            size = HEADER.size + length
+            if len(buf) < size:
+                break
+
+            payload = bytes(buf[HEADER.size:size])
+            if flags & FLAG_KEY:
+                candidate = [0] * leds
+            elif frame is not None and len(frame) == leds:
+                candidate = list(frame)
+            else:
+                candidate = None    # Joined mid-stream, wait for a key frame
+
+            if candidate is not None and not decode_payload(payload, candidate):
+                stats.skipped_bytes += 1
+                frame = None
+                del buf[:1]
+                continue
+
+            del buf[:size]
+            stats.record(header, size)
+            if candidate is not None:
+                frame = candidate
+                yield frame
+
+
+def rgb(color, gain):
+    """Splits a 0x00BBRRGG color into (r, g, b), scaled for viewing"""
+    b = (color >> 16) & 0xFF
+    r = (color >> 8) & 0xFF
+    g = color & 0xFF
+    return tuple(min(255, int(c * gain)) for c in (r, g, b))
+
+
+def show_terminal(frame, gain):
+    blocks = "".join("\x1b[38;2;%d;%d;%dm██" % rgb(color, gain) for color in frame)
+    sys.stdout.write("\r" + blocks + "\x1b[0m")
+    sys.stdout.flush()
+
+
+def write_ppm(directory, index, frame, gain, scale):
+    row = b"".join(bytes(rgb(color, gain)) * scale for color in frame)
+    path = os.path.join(directory, f"frame_{index:06d}.ppm")
+    with open(path, "wb") as f:
+        f.write(b"P6\n%d %d\n255\n" % (len(frame) * scale, scale))
+        f.write(row * scale)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--input", required=True, help="CDC serial port of the board, or a captured stream")
+    parser.add_argument("--ppm", help="Directory to write one PPM image per frame, instead of drawing in the terminal")
+    parser.add_argument("--gain", type=float, default=1.0, help="Multiply colors by this to see dim frames (default 1)")
+    parser.add_argument("--scale", type=int, default=8, help="Pixels per LED in PPM images (default 8)")
+    args = parser.parse_args()
+
+    if args.ppm:
+        os.makedirs(args.ppm, exist_ok=True)
+
+    stats = Stats()
+    stream, live = open_input(args.input)
+    try:
+        for index, frame in enumerate(frames(stream, stats)):
+            if args.ppm:
+                write_ppm(args.ppm, index, frame, args.gain, args.scale)
+            else:
+                show_terminal(frame, args.gain)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        stream.close()
+
+    if not args.ppm:
+        print()
+
+    print("\n".join(stats.summary(live)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,202 @@
+#!/usr/bin/env python3
+"""
+Generates the sparse resampling matrix used to project images onto the tree.
+
+Each LED is given a square footprint on the source image, one LED spacing
+wide, centered on where the LED sits on the board. Its color is the area
+weighted average of every image pixel the footprint overlaps. The weights are
+written out as a compressed sparse row matrix with Q8 weights summing to 256
+for every LED, so projecting a frame costs a handful of multiplies per LED no
+matter how large the image is. The center of each footprint is written out
+too, for drawing shapes over the layout directly.
+
+The map is always generated for the configured number of LEDs. When that
+differs from the number placed on the board, the string is assumed to be laid
+out as a serpentine grid instead, as on a typical LED matrix.
+
+2024 | Brandon Braun | brandonbraun653@protonmail.com
+"""
+
+import argparse
+import csv
+import math
+import os
+import re
+import statistics
+
+
+def load_leds(path, prefix):
+    """Returns [(x, y)] in millimeters for designators PREFIX1..PREFIXn, in chain order"""
+    leds = {}
+    with open(path, newline="", encoding="utf-8-sig") as f:
+        for row in csv.DictReader(f):
+            match = re.fullmatch(prefix + r"(\d+)", row["Designator"])
+            if match:
+                leds[int(match.group(1))] = (float(row["Mid X"]), float(row["Mid Y"]))
+
+    if sorted(leds) != list(range(1, len(leds) + 1)):
+        raise SystemExit(f"{path}: {prefix} designators are not numbered 1..n")
+
+    return [leds[i] for i in range(1, len(leds) + 1)]
+
+
+def grid_layout(count, pitch=10.0):
+    """Returns [(x, y)] in millimeters for a serpentine grid of count LEDs, as close to square as fits"""
+    cols = math.ceil(math.sqrt(count))
+    leds = []
+    for i in range(count):
+        row, col = divmod(i, cols)
+        if row % 2:
+            col = cols - 1 - col
+        leds.append((col * pitch, -row * pitch))
+    return leds
+
+
+def overlap(a0, a1, b0, b1):
+    return max(0.0, min(a1, b1) - max(a0, b0))
+
+
+def quantize(weights, total):
+    """Rounds weights to integers summing to exactly total, by largest remainder"""
+    scaled = [w * total for w in weights]
+    ints = [math.floor(s) for s in scaled]
+    order = sorted(range(len(scaled)), key=lambda i: scaled[i] - ints[i], reverse=True)
+    for i in order[:total - sum(ints)]:
+        ints[i] += 1
+    return ints
+
+
+def build(leds, size, weight_one):
+    """Returns (footprint_px, centers, rows) where each row is [(x, y, weight)] for one LED"""
+    xs = [p[0] for p in leds]
+    ys = [p[1] for p in leds]
+
+    # Typical distance between neighbouring LEDs sets how much image each one averages
+    spacing = statistics.median(min((math.dist(a, b) for b in leds if b is not a), default=1.0) for a in leds)
+
+    # Fit the LEDs plus half a footprint of margin into the image, keeping the aspect ratio
+    extent = max(max(xs) - min(xs), max(ys) - min(ys)) + spacing
+    scale = size / extent
+    cx = (max(xs) + min(xs)) / 2
+    cy = (max(ys) + min(ys)) / 2
+    half = spacing * scale / 2
+
+    centers = []
+    rows = []
+    for x_mm, y_mm in leds:
+        # Board Y grows upward, image rows grow downward
+        u = (x_mm - cx) * scale + size / 2
+        v = (cy - y_mm) * scale + size / 2
+        centers.append((u, v))
+
+        taps = []
+        for py in range(max(0, math.floor(v - half)), min(size, math.ceil(v + half))):
+            for px in range(max(0, math.floor(u - half)), min(size, math.ceil(u + half))):
+                area = overlap(u - half, u + half, px, px + 1) * overlap(v - half, v + half, py, py + 1)
+                if area > 0:
+                    taps.append((px, py, area))
+
+        total = sum(t[2] for t in taps)
+        weights = quantize([t[2] / total for t in taps], weight_one)
+        rows.append([(px, py, w) for (px, py, _), w in zip(taps, weights) if w > 0])
+
+    return spacing * scale, centers, rows
+
+
+def emit(path, size, weight_one, footprint, centers, rows, source, layout):
+    offsets = [0]
+    for row in rows:
+        offsets.append(offsets[-1] + len(row))
+
+    lines = [
+        "/******************************************************************************",
+        " *  File Name:",
+        " *    projection_map.hpp",
+        " *",
+        " *  Description:",
+        f" *    Generated by tools/projection_map.py from {source}.",
+        f" *    Layout: {layout}.",
+        " *    Do not edit.",
+        " *****************************************************************************/",
+        "",
+        "#pragma once",
+        "#ifndef HOLLY_JOLLY_PROJECTION_MAP_HPP",
+        "#define HOLLY_JOLLY_PROJECTION_MAP_HPP",
+        "",
+        '#include "projection.hpp"',
+        "",
+        "namespace Projection",
+        "{",
+        f"  static constexpr uint32_t MAP_IMAGE_SIZE   = {size};",
+        f"  static constexpr uint32_t MAP_WEIGHT_ONE   = {weight_one};",
+        f"  static constexpr uint32_t MAP_LED_COUNT    = {len(rows)};",
+        f"  static constexpr uint32_t MAP_TAP_COUNT    = {offsets[-1]};",
+        f"  static constexpr uint32_t MAP_FOOTPRINT_PX = {round(footprint)};",
+        f"  static constexpr uint32_t MAP_FOOTPRINT_Q8 = {round(footprint * 256)};",
+        "",
+        "  /**",
+        "   * @brief Center of each LED's footprint, in 1/256ths of a pixel",
+        "   */",
+        "  static constexpr Position MAP_CENTERS[ MAP_LED_COUNT ] = {",
+    ]
+    for i in range(0, len(centers), 6):
+        lines.append("    " + " ".join(f"{{ {round(u * 256)}, {round(v * 256)} }}," for u, v in centers[i:i + 6]))
+    lines += [
+        "  };",
+        "",
+        "  /**",
+        "   * @brief First tap of each LED in MAP_TAPS. LED i uses taps MAP_ROWS[ i ] to MAP_ROWS[ i + 1 ] - 1.",
+        "   */",
+        "  static constexpr uint16_t MAP_ROWS[ MAP_LED_COUNT + 1 ] = {",
+    ]
+    for i in range(0, len(offsets), 12):
+        lines.append("    " + ", ".join(str(o) for o in offsets[i:i + 12]) + ",")
+    lines += [
+        "  };",
+        "",
+        "  static constexpr Tap MAP_TAPS[ MAP_TAP_COUNT ] = {",
+    ]
+    for led, row in enumerate(rows):
+        lines.append(f"    // LED {led}")
+        for i in range(0, len(row), 6):
+            lines.append("    " + " ".join(f"{{ {x}, {y}, {w} }}," for x, y, w in row[i:i + 6]))
+    lines += [
+        "  };",
+        "",
+        "}    // namespace Projection",
+        "",
+        "#endif /* !HOLLY_JOLLY_PROJECTION_MAP_HPP */",
+        "",
+    ]
+
+    with open(path, "w") as f:
+        f.write("\n".join(lines))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--positions", required=True, help="Pick and place CSV with the LED positions")
+    parser.add_argument("--output", required=True, help="Header to write")
+    parser.add_argument("--prefix", default="D", help="Designator prefix of the LEDs")
+    parser.add_argument("--size", type=int, default=64, help="Width and height of the source images")
+    parser.add_argument("--count", type=int, help="LEDs in the string, defaults to the number on the board")
+    args = parser.parse_args()
+
+    weight_one = 256
+    leds = load_leds(args.positions, args.prefix)
+    layout = f"{len(leds)} LEDs as placed on the board"
+    if args.count is not None and args.count != len(leds):
+        if args.count < 1:
+            raise SystemExit("--count must be at least 1")
+        print(f"projection_map: {args.count} LEDs configured but {len(leds)} placed, using a serpentine grid")
+        leds = grid_layout(args.count)
+        layout = f"{len(leds)} LEDs on a serpentine grid, since the board places a different number"
+
+    footprint, centers, rows = build(leds, args.size, weight_one)
+    repo = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    source = os.path.relpath(os.path.abspath(args.positions), repo).replace(os.sep, "/")
+    emit(args.output, args.size, weight_one, footprint, centers, rows, source, layout)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,237 @@
+#!/usr/bin/env python3
+"""
+Converts a HollyJolly trace dump to Chrome trace JSON for Perfetto or chrome://tracing.
+
+The firmware keeps a ring of timestamped events per core (src/trace.hpp).
+With a debugger attached, freeze and dump it with:
+
+  (gdb) set var Trace::s_trace.enabled = 0
+  (gdb) dump binary value trace.bin Trace::s_trace
+
+The host simulator writes the same dump with --trace. The timeline shows each
+core's frames, the LED wire (DMA and latch), button IRQs, and a latency span
+from every button edge to the first frame that could show its effect on the
+LEDs. A summary of the same is printed to stdout.
+
+2024 | Brandon Braun | brandonbraun653@protonmail.com
+"""
+
+import argparse
+import json
+import statistics
+import struct
+import sys
+
+# ------------------------------------------------------------------------------
+# Dump format, must match src/trace.hpp
+# ------------------------------------------------------------------------------
+TRACE_MAGIC = 0x52544A48
+TRACE_VERSION = 2
+
+HEADER = struct.Struct("<IHHHHI")    # magic, version, depth, cores, record_cycles, enabled
+RECORD = struct.Struct("<IHBB")      # timestamp_us, arg, event, reserved
+
+EVENT_NAMES = [
+    "frame_begin",
+    "frame_end",
+    "swap",
+    "dma_start",
+    "dma_done",
+    "latch",
+    "button_edge",
+    "button_settled",
+    "dispatch",
+    "animation_switch",
+]
+EVENT = {name: i for i, name in enumerate(EVENT_NAMES)}
+
+KEY_NAMES = ["bright", "action"]
+GESTURE_NAMES = ["press", "short", "long", "double", "repeat"]
+
+# Timeline tracks within each core
+TRACK_FRAMES = 0
+TRACK_BUTTONS = 1
+TRACK_WIRE = 2
+TRACK_NAMES = ["frames", "buttons", "LED wire"]
+TRACKS_PER_CORE = 10
+LATENCY_TID = 1000
+
+
+def name_of(names, idx):
+    return names[idx] if idx < len(names) else str(idx)
+
+
+def load(path):
+    """
+    Returns (events, record_cycles). Events are (timestamp_us, core, event, arg),
+    oldest first, with timestamps unwrapped.
+    """
+    with open(path, "rb") as f:
+        data = f.read()
+
+    if len(data) < HEADER.size:
+        raise SystemExit(f"{path}: too short to be a trace dump")
+
+    magic, version, depth, cores, record_cycles, enabled = HEADER.unpack_from(data, 0)
+    if magic != TRACE_MAGIC:
+        raise SystemExit(f"{path}: bad magic 0x{magic:08x}, not a trace dump or tracing was never initialized")
+    if version != TRACE_VERSION:
+        raise SystemExit(f"{path}: trace version {version}, this tool reads version {TRACE_VERSION}")
+
+    heads = struct.unpack_from(f"<{cores}I", data, HEADER.size)
+    base = HEADER.size + 4 * cores
+    if len(data) < base + cores * depth * RECORD.size:
+        raise SystemExit(f"{path}: truncated, expected {cores} rings of {depth} events")
+    if enabled:
+        print("warning: trace was still recording when dumped, the newest events may be torn", file=sys.stderr)
+
+    per_core = []
+    for core in range(cores):
+        count = min(heads[core], depth)
+        ring = base + core * depth * RECORD.size
+        events = []
+        prev_raw = None
+        now = 0
+        for n in range(heads[core] - count, heads[core]):
+            raw, arg, event, _ = RECORD.unpack_from(data, ring + (n % depth) * RECORD.size)
+            if prev_raw is not None:
+                # Unwrap the 32-bit timer by stepping modulo 2^32. Each ring is
+                # in time order, so a step back only comes from a torn record,
+                # and is kept small rather than read as a 71 minute jump.
+                delta = (raw - prev_raw) & 0xFFFFFFFF
+                now += delta - (1 << 32) if delta >= (1 << 31) else delta
+            else:
+                now = raw
+            prev_raw = raw
+            events.append((now, core, event, arg))
+        per_core.append(events)
+
+    # Every core reads the same timer. Line their wraps up with core 0's.
+    ref = next((e[-1][0] for e in per_core if e), 0)
+    merged = []
+    for events in per_core:
+        if events:
+            shift = round((ref - events[-1][0]) / (1 << 32)) * (1 << 32)
+            merged += [(t + shift, c, e, a) for t, c, e, a in events]
+
+    merged.sort(key=lambda e: e[0])
+    if merged:
+        start = merged[0][0]
+        merged = [(t - start, c, e, a) for t, c, e, a in merged]
+    return merged, record_cycles
+
+
+def convert(events, record_cycles):
+    """Returns (chrome trace events, summary lines)"""
+    out = []
+    used_tids = set()
+
+    def tid(core, track):
+        value = core * TRACKS_PER_CORE + track
+        used_tids.add((value, f"core{core} {TRACK_NAMES[track]}"))
+        return value
+
+    def instant(ts, core, track, name, args=None, scope="t"):
+        out.append({"ph": "i", "s": scope, "name": name, "ts": ts, "pid": 0, "tid": tid(core, track),
+                    "args": args or {}})
+
+    def span(begin, end, core, track, name, args=None):
+        out.append({"ph": "X", "name": name, "ts": begin, "dur": end - begin, "pid": 0, "tid": tid(core, track),
+                    "args": args or {}})
+
+    frame_open = {}          # core -> (ts, animation)
+    dma_open = None          # ts of the DMA start
+    drain_open = None        # ts of the DMA finishing, until the latch
+    edges = {}               # key -> ts of the latest edge
+    waiting = []             # Latency spans waiting for their frame: [edge, dispatch, key, gesture, latches left]
+    latencies = []
+    frame_times = []
+    queued_swaps = 0
+    latency_id = 0
+
+    for ts, core, event, arg in events:
+        if event == EVENT["frame_begin"]:
+            frame_open[core] = (ts, arg)
+        elif event == EVENT["frame_end"]:
+            if core in frame_open:
+                begin, animation = frame_open.pop(core)
+                span(begin, ts, core, TRACK_FRAMES, "frame", {"animation": animation, "drew": bool(arg)})
+                frame_times.append(ts - begin)
+        elif event == EVENT["swap"]:
+            instant(ts, core, TRACK_FRAMES, "swap", {"queued": bool(arg)})
+            queued_swaps += bool(arg)
+            for entry in waiting:
+                if entry[4] is None:
+                    entry[4] = 2 if arg else 1
+        elif event == EVENT["dma_start"]:
+            dma_open = ts
+        elif event == EVENT["dma_done"]:
+            if dma_open is not None:
+                span(dma_open, ts, core, TRACK_WIRE, "dma")
+            dma_open = None
+            drain_open = ts
+        elif event == EVENT["latch"]:
+            if drain_open is not None:
+                span(drain_open, ts, core, TRACK_WIRE, "drain + latch")
+            drain_open = None
+            for entry in waiting:
+                if entry[4] is not None:
+                    entry[4] -= 1
+            for edge, dispatch, key, gesture, left in [e for e in waiting if e[4] == 0]:
+                name = f"{name_of(KEY_NAMES, key)} {name_of(GESTURE_NAMES, gesture)} to photon"
+                args = {"edge_to_dispatch_us": dispatch - edge, "dispatch_to_latch_us": ts - dispatch}
+                out.append({"ph": "b", "cat": "latency", "name": name, "id": latency_id, "ts": edge, "pid": 0,
+                            "tid": LATENCY_TID, "args": args})
+                out.append({"ph": "e", "cat": "latency", "name": name, "id": latency_id, "ts": ts, "pid": 0,
+                            "tid": LATENCY_TID})
+                latency_id += 1
+                latencies.append((name, ts - edge))
+            waiting = [e for e in waiting if e[4] != 0]
+        elif event == EVENT["button_edge"]:
+            instant(ts, core, TRACK_BUTTONS, f"{name_of(KEY_NAMES, arg)} edge")
+            edges[arg] = ts
+        elif event == EVENT["button_settled"]:
+            key, pressed = arg & 0xFF, arg >> 8
+            instant(ts, core, TRACK_BUTTONS, f"{name_of(KEY_NAMES, key)} {'down' if pressed else 'up'}")
+        elif event == EVENT["dispatch"]:
+            key, gesture = arg & 0xFF, arg >> 8
+            instant(ts, core, TRACK_FRAMES, f"{name_of(KEY_NAMES, key)} {name_of(GESTURE_NAMES, gesture)}")
+            if key in edges:
+                waiting.append([edges.pop(key), ts, key, gesture, None])
+        elif event == EVENT["animation_switch"]:
+            instant(ts, core, TRACK_FRAMES, f"animation {arg}", scope="g")
+        else:
+            instant(ts, core, TRACK_FRAMES, f"event {event}", {"arg": arg})
+
+    for value, name in sorted(used_tids):
+        out.append({"ph": "M", "name": "thread_name", "pid": 0, "tid": value, "args": {"name": name}})
+    if latencies:
+        out.append({"ph": "M", "name": "thread_name", "pid": 0, "tid": LATENCY_TID, "args": {"name": "latency"}})
+    out.append({"ph": "M", "name": "process_name", "pid": 0, "args": {"name": "HollyJolly"}})
+
+    summary = [f"{len(events)} events over {events[-1][0] / 1e3:.1f} ms" if events else "no events"]
+    summary.append(f"record(): {record_cycles} cycles per event, timed at boot" if record_cycles
+                   else "record(): cost not measured, no cycle counter")
+    if frame_times:
+        summary.append(f"frames: {len(frame_times)}, mean {statistics.mean(frame_times):.0f} us, "
+                       f"max {max(frame_times)} us, {queued_swaps} swaps queued behind the wire")
+    for name, latency in latencies:
+        summary.append(f"{name}: {latency / 1e3:.2f} ms")
+    return out, summary
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--input", required=True, help="Binary dump of Trace::s_trace")
+    parser.add_argument("--output", required=True, help="Chrome trace JSON to write")
+    args = parser.parse_args()
+
+    trace, summary = convert(*load(args.input))
+    with open(args.output, "w") as f:
+        json.dump({"traceEvents": trace, "displayTimeUnit": "ms"}, f)
+
+    print("\n".join(summary))
+
+
+if __name__ == "__main__":
+    main()